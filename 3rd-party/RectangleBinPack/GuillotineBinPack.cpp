@@ -7,6 +7,8 @@
 */
 #include <utility>
 #include <iostream>
+#include <limits>
+#include <cstring>
 
 #include <cassert>
 
@@ -0,0 +1,168 @@
+#include <cstdlib>
+#include <vector>
+
+#include "benchmark.h"
+
+#include "SkylineBinPack.h"
+#include "MaxRectsBinPack.h"
+#include "GuillotineBinPack.h"
+#include "ShelfBinPack.h"
+
+using namespace RectangleBinPack;
+
+/*
+ * Glyph size distributions modelled after what the icedcoffee glyph cache
+ * inserts into its texture atlases: glyph bitmaps plus one pixel of padding
+ * on each side, inserted one at a time in the order they are first used.
+ */
+
+static const long kAtlasSize = 1024;
+static const long kGlyphPadding = 2;
+
+static float random_scalar(float min, float max)
+{
+    return min + (float)rand() / (float)RAND_MAX * (max - min);
+}
+
+/* Printable ASCII in regular, bold, italic and bold italic at the given font size */
+static std::vector<RectSize> latin_glyphs(long fontSize)
+{
+    std::vector<RectSize> glyphs;
+    srand(1);
+    for (int face = 0; face < 4; ++face) {
+        for (int c = 0; c < 95; ++c) {
+            RectSize size;
+            size.width = (long)(fontSize * random_scalar(0.2f, 0.8f)) + kGlyphPadding;
+            size.height = (long)(fontSize * random_scalar(0.1f, 1.0f)) + kGlyphPadding;
+            glyphs.push_back(size);
+        }
+    }
+    return glyphs;
+}
+
+/* Latin text mixing font sizes from 12 to 72 pixels, as in UIs with headings and body text */
+static std::vector<RectSize> mixed_latin_glyphs(long count)
+{
+    static const long fontSizes[] = { 12, 14, 16, 18, 24, 32, 48, 72 };
+    std::vector<RectSize> glyphs;
+    srand(2);
+    for (long i = 0; i < count; ++i) {
+        long fontSize = fontSizes[rand() % (sizeof(fontSizes) / sizeof(fontSizes[0]))];
+        RectSize size;
+        size.width = (long)(fontSize * random_scalar(0.2f, 0.8f)) + kGlyphPadding;
+        size.height = (long)(fontSize * random_scalar(0.1f, 1.0f)) + kGlyphPadding;
+        glyphs.push_back(size);
+    }
+    return glyphs;
+}
+
+/* Ideographs are close to square and fill most of the em box */
+static std::vector<RectSize> cjk_glyphs(long fontSize)
+{
+    std::vector<RectSize> glyphs;
+    srand(3);
+    for (int i = 0; i < 1500; ++i) {
+        RectSize size;
+        size.width = (long)(fontSize * random_scalar(0.85f, 1.0f)) + kGlyphPadding;
+        size.height = (long)(fontSize * random_scalar(0.85f, 1.0f)) + kGlyphPadding;
+        glyphs.push_back(size);
+    }
+    return glyphs;
+}
+
+struct SkylineBottomLeft {
+    SkylineBinPack bin;
+    void Init() { bin.Init(kAtlasSize, kAtlasSize, false); }
+    Rect Insert(const RectSize &s) { return bin.Insert(s.width, s.height, SkylineBinPack::LevelBottomLeft); }
+};
+
+struct SkylineMinWaste {
+    SkylineBinPack bin;
+    void Init() { bin.Init(kAtlasSize, kAtlasSize, true); }
+    Rect Insert(const RectSize &s) { return bin.Insert(s.width, s.height, SkylineBinPack::LevelMinWasteFit); }
+};
+
+struct MaxRectsBestShortSideFit {
+    MaxRectsBinPack bin;
+    void Init() { bin.Init(kAtlasSize, kAtlasSize); }
+    Rect Insert(const RectSize &s) { return bin.Insert(s.width, s.height, MaxRectsBinPack::RectBestShortSideFit); }
+};
+
+struct MaxRectsBestAreaFit {
+    MaxRectsBinPack bin;
+    void Init() { bin.Init(kAtlasSize, kAtlasSize); }
+    Rect Insert(const RectSize &s) { return bin.Insert(s.width, s.height, MaxRectsBinPack::RectBestAreaFit); }
+};
+
+struct GuillotineBestAreaFit {
+    GuillotineBinPack bin;
+    void Init() { bin.Init(kAtlasSize, kAtlasSize); }
+    Rect Insert(const RectSize &s)
+    {
+        return bin.Insert(s.width, s.height, true, GuillotineBinPack::RectBestAreaFit,
+                          GuillotineBinPack::SplitShorterLeftoverAxis);
+    }
+};
+
+struct ShelfBestAreaFit {
+    ShelfBinPack bin;
+    void Init() { bin.Init(kAtlasSize, kAtlasSize, true); }
+    Rect Insert(const RectSize &s) { return bin.Insert(s.width, s.height, ShelfBinPack::ShelfBestAreaFit); }
+};
+
+/*
+ * Packs all glyphs into an empty atlas per iteration. Reports the occupancy of the atlas
+ * area up to the topmost packed glyph, which is what determines how many more glyphs fit,
+ * and the number of glyphs that did not fit at all.
+ */
+template <class Packer>
+static void pack_glyphs(benchmark::State& state, const std::vector<RectSize> &glyphs)
+{
+    Packer packer;
+    long usedHeight = 0, usedArea = 0, rejected = 0;
+    while (state.KeepRunning()) {
+        packer.Init();
+        usedHeight = usedArea = rejected = 0;
+        for (size_t i = 0; i < glyphs.size(); ++i) {
+            Rect rect = packer.Insert(glyphs[i]);
+            if (rect.height == 0) {
+                ++rejected;
+            } else {
+                usedArea += rect.width * rect.height;
+                if (rect.y + rect.height > usedHeight) {
+                    usedHeight = rect.y + rect.height;
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * glyphs.size());
+    state.counters["occupancy"] = usedHeight ? (double)usedArea / (kAtlasSize * usedHeight) : 0;
+    state.counters["rejected"] = (double)rejected;
+}
+
+#define BINPACK_BENCHMARKS(Packer) \
+    static void Packer##_latin(benchmark::State& state) \
+    { \
+        pack_glyphs<Packer>(state, latin_glyphs(state.range(0))); \
+    } \
+    BENCHMARK_ARG(Packer##_latin, 12); \
+    BENCHMARK_ARG(Packer##_latin, 24); \
+    BENCHMARK_ARG(Packer##_latin, 48); \
+    static void Packer##_mixed_latin(benchmark::State& state) \
+    { \
+        pack_glyphs<Packer>(state, mixed_latin_glyphs(state.range(0))); \
+    } \
+    BENCHMARK_ARG(Packer##_mixed_latin, 1000); \
+    static void Packer##_cjk(benchmark::State& state) \
+    { \
+        pack_glyphs<Packer>(state, cjk_glyphs(state.range(0))); \
+    } \
+    BENCHMARK_ARG(Packer##_cjk, 16); \
+    BENCHMARK_ARG(Packer##_cjk, 24)
+
+BINPACK_BENCHMARKS(SkylineBottomLeft);
+BINPACK_BENCHMARKS(SkylineMinWaste);
+BINPACK_BENCHMARKS(MaxRectsBestShortSideFit);
+BINPACK_BENCHMARKS(MaxRectsBestAreaFit);
+BINPACK_BENCHMARKS(GuillotineBestAreaFit);
+BINPACK_BENCHMARKS(ShelfBestAreaFit);
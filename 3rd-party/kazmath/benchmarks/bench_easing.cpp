@@ -0,0 +1,139 @@
+#include <cmath>
+#include <vector>
+
+#include "benchmark.h"
+
+#include "icEasing.h"
+
+/*
+ * Compares the iterative cubic bezier solver used by icedcoffee's animation timing functions
+ * with lookup tables of different sizes. Each iteration evaluates a curve at 1024 uniformly
+ * spaced time factors, as a frame with 1024 running animations would. The max_error counter
+ * reports the largest deviation from a double precision reference solution.
+ */
+
+static const size_t kEvaluations = 1024;
+
+struct Curve {
+    float c0x, c0y, c1x, c1y;
+};
+
+static const Curve kEase = { 0.25f, 0.1f, 0.25f, 1.0f };
+static const Curve kEaseIn = { 0.42f, 0.0f, 1.0f, 1.0f };
+static const Curve kEaseInOut = { 0.42f, 0.0f, 0.58f, 1.0f };
+/* Nearly vertical in the middle, where Newton's method converges slowly */
+static const Curve kSteep = { 0.9f, 0.0f, 0.1f, 1.0f };
+
+static double reference_bezier(double t, double u, double v)
+{
+    return ((1 - 3 * v + 3 * u) * t * t + (3 * v - 6 * u) * t + 3 * u) * t;
+}
+
+static double reference_evaluate(const Curve &c, double x)
+{
+    double lo = 0, hi = 1, t = x;
+    for (int i = 0; i < 60; ++i) {
+        t = 0.5 * (lo + hi);
+        if (reference_bezier(t, c.c0x, c.c1x) < x) {
+            lo = t;
+        } else {
+            hi = t;
+        }
+    }
+    return reference_bezier(t, c.c0y, c.c1y);
+}
+
+static kmVec2 make_vec2(float x, float y)
+{
+    kmVec2 v;
+    v.x = x;
+    v.y = y;
+    return v;
+}
+
+template <class Evaluator>
+static void evaluate_curve(benchmark::State& state, const Curve &c, const Evaluator &evaluate)
+{
+    std::vector<float> xs(kEvaluations), ys(kEvaluations);
+    for (size_t i = 0; i < kEvaluations; ++i) {
+        xs[i] = (float)i / (float)(kEvaluations - 1);
+    }
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < kEvaluations; ++i) {
+            ys[i] = evaluate(xs[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    double maxError = 0;
+    for (size_t i = 0; i < kEvaluations; ++i) {
+        double error = std::fabs(ys[i] - reference_evaluate(c, xs[i]));
+        if (error > maxError) {
+            maxError = error;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kEvaluations);
+    state.counters["max_error"] = maxError;
+}
+
+struct IterativeEvaluator {
+    kmVec2 c0, c1;
+    float operator()(float x) const { return icCubicBezierEvaluateIterative(x, c0, c1); }
+};
+
+struct LinearLookupEvaluator {
+    const float *values;
+    unsigned int count;
+    float operator()(float x) const { return icEasingTableLookupLinear(values, count, x); }
+};
+
+struct CubicLookupEvaluator {
+    const float *values;
+    const float *tangents;
+    unsigned int count;
+    float operator()(float x) const { return icEasingTableLookupCubic(values, tangents, count, x); }
+};
+
+static void iterative(benchmark::State& state, const Curve &c)
+{
+    IterativeEvaluator evaluator = { make_vec2(c.c0x, c.c0y), make_vec2(c.c1x, c.c1y) };
+    evaluate_curve(state, c, evaluator);
+}
+
+static void lookup(benchmark::State& state, const Curve &c, bool cubic)
+{
+    unsigned int count = (unsigned int)state.range(0);
+    std::vector<float> values(count), tangents(count);
+    icEasingTableBakeCubicBezier(&values[0], count, make_vec2(c.c0x, c.c0y), make_vec2(c.c1x, c.c1y));
+    icEasingTableComputeTangents(&tangents[0], &values[0], count);
+    if (cubic) {
+        CubicLookupEvaluator evaluator = { &values[0], &tangents[0], count };
+        evaluate_curve(state, c, evaluator);
+    } else {
+        LinearLookupEvaluator evaluator = { &values[0], count };
+        evaluate_curve(state, c, evaluator);
+    }
+}
+
+#define EASING_BENCHMARKS(Name, curve) \
+    static void easing_iterative_##Name(benchmark::State& state) \
+    { \
+        iterative(state, curve); \
+    } \
+    BENCHMARK(easing_iterative_##Name); \
+    static void easing_lut_linear_##Name(benchmark::State& state) \
+    { \
+        lookup(state, curve, false); \
+    } \
+    BENCHMARK_ARG(easing_lut_linear_##Name, 64); \
+    BENCHMARK_ARG(easing_lut_linear_##Name, 256); \
+    static void easing_lut_cubic_##Name(benchmark::State& state) \
+    { \
+        lookup(state, curve, true); \
+    } \
+    BENCHMARK_ARG(easing_lut_cubic_##Name, 64); \
+    BENCHMARK_ARG(easing_lut_cubic_##Name, 256)
+
+EASING_BENCHMARKS(ease, kEase);
+EASING_BENCHMARKS(ease_in, kEaseIn);
+EASING_BENCHMARKS(ease_in_out, kEaseInOut);
+EASING_BENCHMARKS(steep, kSteep);
@@ -0,0 +1,204 @@
+#include <cstdlib>
+#include <vector>
+
+#include "benchmark.h"
+
+#include "../kazmath/utility.h"
+#include "../kazmath/vec3.h"
+#include "../kazmath/mat4.h"
+#include "../kazmath/quaternion.h"
+#include "../kazmath/plane.h"
+#include "../kazmath/aabb.h"
+
+static float random_scalar(float min, float max)
+{
+    return min + (float)rand() / (float)RAND_MAX * (max - min);
+}
+
+/* A typical node transform: rotation about an arbitrary axis, non-uniform scale and translation */
+static void random_transform(kmMat4* pOut)
+{
+    kmVec3 axis;
+    kmVec3Fill(&axis, random_scalar(-1, 1), random_scalar(-1, 1), random_scalar(-1, 1));
+    kmVec3Normalize(&axis, &axis);
+
+    kmMat4 rotation, scale, translation;
+    kmMat4RotationAxisAngle(&rotation, &axis, random_scalar(0, 2 * kmPI));
+    kmMat4Scaling(&scale, random_scalar(0.5f, 2), random_scalar(0.5f, 2), random_scalar(0.5f, 2));
+    kmMat4Translation(&translation, random_scalar(-500, 500), random_scalar(-500, 500),
+                      random_scalar(-500, 500));
+    kmMat4Multiply(pOut, &rotation, &scale);
+    kmMat4Multiply(pOut, &translation, pOut);
+}
+
+static void mat4_multiply(benchmark::State& state)
+{
+    kmMat4 a, b, result;
+    srand(1);
+    random_transform(&a);
+    random_transform(&b);
+    while (state.KeepRunning()) {
+        kmMat4Multiply(&result, &a, &b);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(mat4_multiply);
+
+static void mat4_multiply_array(benchmark::State& state)
+{
+    const size_t count = (size_t)state.range(0);
+    std::vector<kmMat4> children(count), results(count);
+    kmMat4 parent;
+    srand(1);
+    random_transform(&parent);
+    for (size_t i = 0; i < count; ++i) {
+        random_transform(&children[i]);
+    }
+    while (state.KeepRunning()) {
+        kmMat4MultiplyArray(&results[0], &parent, &children[0], (kmUint)count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_ARG(mat4_multiply_array, 64);
+BENCHMARK_ARG(mat4_multiply_array, 1024);
+
+static void mat4_inverse(benchmark::State& state)
+{
+    kmMat4 m, result;
+    srand(1);
+    random_transform(&m);
+    while (state.KeepRunning()) {
+        kmMat4Inverse(&result, &m);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(mat4_inverse);
+
+static void mat4_affine_inverse(benchmark::State& state)
+{
+    kmMat4 m, result;
+    srand(1);
+    random_transform(&m);
+    while (state.KeepRunning()) {
+        kmMat4AffineInverse(&result, &m);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(mat4_affine_inverse);
+
+static void mat4_look_at(benchmark::State& state)
+{
+    kmVec3 eye, center, up;
+    kmVec3Fill(&eye, 0, 0, 500);
+    kmVec3Fill(&center, 0, 0, 0);
+    kmVec3Fill(&up, 0, 1, 0);
+    kmMat4 result;
+    while (state.KeepRunning()) {
+        kmMat4LookAt(&result, &eye, &center, &up);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(mat4_look_at);
+
+static void vec3_transform_array(benchmark::State& state)
+{
+    const size_t count = (size_t)state.range(0);
+    std::vector<kmVec3> vertices(count), results(count);
+    kmMat4 m;
+    srand(1);
+    random_transform(&m);
+    for (size_t i = 0; i < count; ++i) {
+        kmVec3Fill(&vertices[i], random_scalar(-100, 100), random_scalar(-100, 100), 0);
+    }
+    while (state.KeepRunning()) {
+        kmVec3TransformArray(&results[0], &vertices[0], (kmUint)count, &m);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_ARG(vec3_transform_array, 4);
+BENCHMARK_ARG(vec3_transform_array, 1024);
+
+static void quaternion_slerp(benchmark::State& state)
+{
+    kmVec3 axis1, axis2;
+    kmVec3Fill(&axis1, 0, 0, 1);
+    kmVec3Fill(&axis2, 0, 1, 0);
+    kmQuaternion q1, q2, result;
+    kmQuaternionRotationAxis(&q1, &axis1, 0.3f);
+    kmQuaternionRotationAxis(&q2, &axis2, 1.2f);
+    float t = 0;
+    while (state.KeepRunning()) {
+        kmQuaternionSlerp(&result, &q1, &q2, t);
+        benchmark::DoNotOptimize(result);
+        t = t < 1.0f ? t + 0.001f : 0.0f;
+    }
+}
+BENCHMARK(quaternion_slerp);
+
+static void aabb_contains_point(benchmark::State& state)
+{
+    const size_t count = 1024;
+    std::vector<kmVec3> points(count);
+    kmVec3 centre;
+    kmVec3Fill(&centre, 0, 0, 0);
+    kmAABB box;
+    kmAABBInitialize(&box, &centre, 100, 100, 100);
+    srand(1);
+    for (size_t i = 0; i < count; ++i) {
+        kmVec3Fill(&points[i], random_scalar(-100, 100), random_scalar(-100, 100),
+                   random_scalar(-100, 100));
+    }
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        int contains = kmAABBContainsPoint(&box, &points[i++ & (count - 1)]);
+        benchmark::DoNotOptimize(contains);
+    }
+}
+BENCHMARK(aabb_contains_point);
+
+static void aabb_contains_aabb(benchmark::State& state)
+{
+    const size_t count = 1024;
+    std::vector<kmAABB> boxes(count);
+    kmVec3 centre;
+    kmVec3Fill(&centre, 0, 0, 0);
+    kmAABB container;
+    kmAABBInitialize(&container, &centre, 100, 100, 100);
+    srand(1);
+    for (size_t i = 0; i < count; ++i) {
+        kmVec3Fill(&centre, random_scalar(-100, 100), random_scalar(-100, 100),
+                   random_scalar(-100, 100));
+        kmAABBInitialize(&boxes[i], &centre, random_scalar(1, 50), random_scalar(1, 50),
+                         random_scalar(1, 50));
+    }
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        kmEnum contains = kmAABBContainsAABB(&container, &boxes[i++ & (count - 1)]);
+        benchmark::DoNotOptimize(contains);
+    }
+}
+BENCHMARK(aabb_contains_aabb);
+
+static void plane_classify_point(benchmark::State& state)
+{
+    const size_t count = 1024;
+    std::vector<kmVec3> points(count);
+    kmVec3 point, normal;
+    kmVec3Fill(&point, 0, 0, 0);
+    kmVec3Fill(&normal, 0, 0, 1);
+    kmPlane plane;
+    kmPlaneFromPointNormal(&plane, &point, &normal);
+    srand(1);
+    for (size_t i = 0; i < count; ++i) {
+        kmVec3Fill(&points[i], random_scalar(-100, 100), random_scalar(-100, 100),
+                   random_scalar(-100, 100));
+    }
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        POINT_CLASSIFICATION classification = kmPlaneClassifyPoint(&plane, &points[i++ & (count - 1)]);
+        benchmark::DoNotOptimize(classification);
+    }
+}
+BENCHMARK(plane_classify_point);
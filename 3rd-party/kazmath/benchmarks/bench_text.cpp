@@ -0,0 +1,222 @@
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#include "benchmark.h"
+
+#include "icTextBackend.h"
+#include "SkylineBinPack.h"
+
+using namespace RectangleBinPack;
+
+/*
+ * Measures the stages of icedcoffee's glyph pipeline using the FreeType text backend, so that
+ * text heavy scenes can be profiled without CoreText: shaping paragraphs, retrieving glyph
+ * bounds, rasterizing glyph bitmaps and filling a glyph cache atlas. The font may be chosen
+ * using the IC_BENCHMARK_FONT environment variable; if it cannot be loaded, the benchmarks
+ * report skipped=1.
+ */
+
+static const char *kDefaultFont = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+static const long kAtlasSize = 1024;
+static const long kGlyphMargin = 2; /* IC_GLYPH_RECTANGLE_MARGIN */
+
+static const char *kParagraph =
+    "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt "
+    "ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco "
+    "laboris nisi ut aliquip ex ea commodo consequat. Duis aute irure dolor in reprehenderit in "
+    "voluptate velit esse cillum dolore eu fugiat nulla pariatur. Excepteur sint occaecat "
+    "cupidatat non proident, sunt in culpa qui officia deserunt mollit anim id est laborum. ";
+
+static const icTextBackend *backend()
+{
+    return icTextBackendFreeType();
+}
+
+static icTextFace *create_face(float sizeInPixels)
+{
+    const char *path = getenv("IC_BENCHMARK_FONT");
+    return backend()->createFaceWithFile(path ? path : kDefaultFont, sizeInPixels);
+}
+
+static std::vector<uint16_t> utf16_text(size_t paragraphs)
+{
+    std::vector<uint16_t> text;
+    for (size_t i = 0; i < paragraphs; ++i) {
+        for (const char *c = kParagraph; *c; ++c) {
+            text.push_back((uint16_t)*c);
+        }
+    }
+    return text;
+}
+
+static std::vector<uint16_t> ascii_glyphs(icTextFace *face)
+{
+    std::vector<uint16_t> characters;
+    for (uint16_t c = 32; c < 127; ++c) {
+        characters.push_back(c);
+    }
+    std::vector<icShapedGlyph> shaped(characters.size() * 2);
+    size_t count = backend()->shape(face, &characters[0], characters.size(), &shaped[0],
+                                    shaped.size());
+    std::vector<uint16_t> glyphs;
+    for (size_t i = 0; i < count && i < shaped.size(); ++i) {
+        glyphs.push_back(shaped[i].glyph);
+    }
+    return glyphs;
+}
+
+/* Shapes a document of the given number of paragraphs as a single run, as ICTextFrame would */
+static void text_shape(benchmark::State& state)
+{
+    icTextFace *face = create_face(16);
+    std::vector<uint16_t> text = utf16_text((size_t)state.range(0));
+    std::vector<icShapedGlyph> glyphs(text.size() * 2);
+    while (state.KeepRunning()) {
+        if (!face) {
+            continue;
+        }
+        size_t count = backend()->shape(face, &text[0], text.size(), &glyphs[0], glyphs.size());
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * text.size());
+    state.counters["skipped"] = face ? 0 : 1;
+    backend()->releaseFace(face);
+}
+BENCHMARK_ARG(text_shape, 1);
+BENCHMARK_ARG(text_shape, 100);
+
+/* Retrieves the bounds of printable ASCII glyphs, as ICGlyphRunMetrics does for each run */
+static void text_glyph_bounds(benchmark::State& state)
+{
+    icTextFace *face = create_face((float)state.range(0));
+    std::vector<uint16_t> glyphs;
+    if (face) {
+        glyphs = ascii_glyphs(face);
+    }
+    std::vector<icGlyphBounds> bounds(glyphs.size());
+    while (state.KeepRunning()) {
+        if (!face) {
+            continue;
+        }
+        backend()->getGlyphBounds(face, &glyphs[0], glyphs.size(), &bounds[0]);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * glyphs.size());
+    state.counters["skipped"] = face ? 0 : 1;
+    backend()->releaseFace(face);
+}
+BENCHMARK_ARG(text_glyph_bounds, 16);
+
+struct GlyphBitmap {
+    uint16_t glyph;
+    float x, y;
+    long width, height;
+};
+
+/* Computes bitmap sizes and pen positions the way ICGlyphCache does for alpha glyph textures */
+static std::vector<GlyphBitmap> glyph_bitmaps(icTextFace *face, const std::vector<uint16_t> &glyphs)
+{
+    std::vector<icGlyphBounds> bounds(glyphs.size());
+    backend()->getGlyphBounds(face, &glyphs[0], glyphs.size(), &bounds[0]);
+    std::vector<GlyphBitmap> bitmaps;
+    for (size_t i = 0; i < glyphs.size(); ++i) {
+        GlyphBitmap b;
+        b.glyph = glyphs[i];
+        b.x = kGlyphMargin - bounds[i].x;
+        b.y = kGlyphMargin - bounds[i].y;
+        b.width = (long)ceilf(bounds[i].width) + kGlyphMargin * 2;
+        b.height = (long)ceilf(bounds[i].height) + kGlyphMargin * 2;
+        bitmaps.push_back(b);
+    }
+    return bitmaps;
+}
+
+/* Rasterizes printable ASCII glyphs into individual alpha bitmaps */
+static void text_rasterize(benchmark::State& state)
+{
+    icTextFace *face = create_face((float)state.range(0));
+    std::vector<GlyphBitmap> bitmaps;
+    if (face) {
+        bitmaps = glyph_bitmaps(face, ascii_glyphs(face));
+    }
+    std::vector<uint8_t> data;
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < bitmaps.size(); ++i) {
+            const GlyphBitmap &b = bitmaps[i];
+            data.assign((size_t)(b.width * b.height), 0);
+            backend()->rasterizeGlyph(face, b.glyph, b.x, b.y, &data[0], (size_t)b.width,
+                                      (size_t)b.height, (size_t)b.width, 1);
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * bitmaps.size());
+    state.counters["skipped"] = face ? 0 : 1;
+    backend()->releaseFace(face);
+}
+BENCHMARK_ARG(text_rasterize, 12);
+BENCHMARK_ARG(text_rasterize, 24);
+BENCHMARK_ARG(text_rasterize, 48);
+
+/*
+ * Fills an empty atlas with printable ASCII glyphs in four sizes, as ICGlyphCache does when
+ * caching glyphs: rasterize, pack using skyline min waste and copy the bitmap into the atlas.
+ */
+static void text_glyph_cache_fill(benchmark::State& state)
+{
+    static const float kSizes[] = { 12, 16, 24, 32 };
+    std::vector<icTextFace *> faces;
+    std::vector<std::vector<GlyphBitmap> > bitmaps;
+    for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+        icTextFace *face = create_face(kSizes[i]);
+        if (face) {
+            faces.push_back(face);
+            bitmaps.push_back(glyph_bitmaps(face, ascii_glyphs(face)));
+        }
+    }
+    
+    std::vector<uint8_t> atlas((size_t)(kAtlasSize * kAtlasSize));
+    std::vector<uint8_t> data;
+    SkylineBinPack packer;
+    size_t glyphCount = 0;
+    long usedArea = 0;
+    while (state.KeepRunning()) {
+        packer.Init(kAtlasSize, kAtlasSize, true);
+        glyphCount = 0;
+        usedArea = 0;
+        for (size_t f = 0; f < faces.size(); ++f) {
+            for (size_t i = 0; i < bitmaps[f].size(); ++i) {
+                const GlyphBitmap &b = bitmaps[f][i];
+                data.assign((size_t)(b.width * b.height), 0);
+                backend()->rasterizeGlyph(faces[f], b.glyph, b.x, b.y, &data[0],
+                                          (size_t)b.width, (size_t)b.height, (size_t)b.width, 1);
+                Rect rect = packer.Insert(b.width, b.height, SkylineBinPack::LevelMinWasteFit);
+                if (rect.height == 0) {
+                    continue;
+                }
+                bool rotated = rect.width != b.width;
+                for (long y = 0; y < rect.height; ++y) {
+                    uint8_t *row = &atlas[(size_t)((rect.y + y) * kAtlasSize + rect.x)];
+                    if (!rotated) {
+                        memcpy(row, &data[(size_t)(y * b.width)], (size_t)b.width);
+                    } else {
+                        for (long x = 0; x < rect.width; ++x) {
+                            row[x] = data[(size_t)(x * b.width + y)];
+                        }
+                    }
+                }
+                usedArea += rect.width * rect.height;
+                ++glyphCount;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * glyphCount);
+    state.counters["skipped"] = faces.empty() ? 1 : 0;
+    state.counters["occupancy"] = (double)usedArea / (kAtlasSize * kAtlasSize);
+    for (size_t i = 0; i < faces.size(); ++i) {
+        backend()->releaseFace(faces[i]);
+    }
+}
+BENCHMARK(text_glyph_cache_fill);
@@ -0,0 +1,250 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include "../kazmath/utility.h"
+
+namespace benchmark {
+
+namespace {
+
+struct Benchmark {
+    std::string name;
+    Function function;
+    long arg;
+};
+
+struct Result {
+    std::string name;
+    size_t iterations;
+    double realTime; /* nanoseconds per iteration */
+    double cpuTime;  /* nanoseconds per iteration */
+    double itemsPerSecond;
+    std::map<std::string, double> counters;
+};
+
+std::vector<Benchmark> &registeredBenchmarks()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+double wallSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double cpuSeconds()
+{
+    return (double)std::clock() / CLOCKS_PER_SEC;
+}
+
+std::string jsonEscape(const std::string &s)
+{
+    std::string result;
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '"' || s[i] == '\\') {
+            result += '\\';
+        }
+        result += s[i];
+    }
+    return result;
+}
+
+void writeJSON(FILE *out, const std::vector<Result> &results, double minTime)
+{
+    char date[64];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"date\": \"%s\",\n", date);
+#if defined(KM_USE_SSE)
+    fprintf(out, "    \"kazmath_simd\": \"sse\",\n");
+#elif defined(KM_USE_NEON)
+    fprintf(out, "    \"kazmath_simd\": \"neon\",\n");
+#else
+    fprintf(out, "    \"kazmath_simd\": \"none\",\n");
+#endif
+    fprintf(out, "    \"min_time\": %g\n", minTime);
+    fprintf(out, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"name\": \"%s\",\n", jsonEscape(r.name).c_str());
+        fprintf(out, "      \"iterations\": %lu,\n", (unsigned long)r.iterations);
+        fprintf(out, "      \"real_time\": %.4f,\n", r.realTime);
+        fprintf(out, "      \"cpu_time\": %.4f,\n", r.cpuTime);
+        fprintf(out, "      \"time_unit\": \"ns\"");
+        if (r.itemsPerSecond > 0) {
+            fprintf(out, ",\n      \"items_per_second\": %.4f", r.itemsPerSecond);
+        }
+        for (std::map<std::string, double>::const_iterator it = r.counters.begin();
+             it != r.counters.end(); ++it) {
+            fprintf(out, ",\n      \"%s\": %.6f", jsonEscape(it->first).c_str(), it->second);
+        }
+        fprintf(out, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+void writeConsole(FILE *out, const Result &r)
+{
+    fprintf(out, "%-48s %14.1f ns %14.1f ns %12lu", r.name.c_str(), r.realTime, r.cpuTime,
+            (unsigned long)r.iterations);
+    for (std::map<std::string, double>::const_iterator it = r.counters.begin();
+         it != r.counters.end(); ++it) {
+        fprintf(out, " %s=%g", it->first.c_str(), it->second);
+    }
+    fprintf(out, "\n");
+}
+
+const char *flagValue(const char *arg, const char *flag)
+{
+    size_t length = strlen(flag);
+    if (strncmp(arg, flag, length) == 0 && arg[length] == '=') {
+        return arg + length + 1;
+    }
+    return NULL;
+}
+
+} // namespace
+
+State::State(size_t maxIterations, long arg)
+: iterations_(0), maxIterations_(maxIterations), arg_(arg), running_(false),
+  realStart_(0), cpuStart_(0), realTime_(0), cpuTime_(0), itemsProcessed_(0)
+{
+}
+
+void State::StartTimer()
+{
+    if (!running_) {
+        realStart_ = wallSeconds();
+        cpuStart_ = cpuSeconds();
+        running_ = true;
+    }
+}
+
+void State::StopTimer()
+{
+    if (running_) {
+        realTime_ += wallSeconds() - realStart_;
+        cpuTime_ += cpuSeconds() - cpuStart_;
+        running_ = false;
+    }
+}
+
+void State::PauseTiming()
+{
+    StopTimer();
+}
+
+void State::ResumeTiming()
+{
+    StartTimer();
+}
+
+Registrar::Registrar(const char *name, Function function)
+{
+    Benchmark b = { name, function, 0 };
+    registeredBenchmarks().push_back(b);
+}
+
+Registrar::Registrar(const char *name, Function function, long arg)
+{
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "/%ld", arg);
+    Benchmark b = { std::string(name) + suffix, function, arg };
+    registeredBenchmarks().push_back(b);
+}
+
+int RunSpecifiedBenchmarks(int argc, char *argv[])
+{
+    const char *filter = "";
+    const char *outPath = NULL;
+    double minTime = 0.2;
+    bool json = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *value;
+        if ((value = flagValue(argv[i], "--benchmark_filter"))) {
+            filter = value;
+        } else if ((value = flagValue(argv[i], "--benchmark_min_time"))) {
+            minTime = atof(value);
+        } else if ((value = flagValue(argv[i], "--benchmark_format"))) {
+            json = strcmp(value, "json") == 0;
+        } else if ((value = flagValue(argv[i], "--benchmark_out"))) {
+            outPath = value;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!json) {
+        printf("%-48s %17s %17s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+    }
+
+    std::vector<Result> results;
+    const std::vector<Benchmark> &benchmarks = registeredBenchmarks();
+    for (size_t i = 0; i < benchmarks.size(); ++i) {
+        const Benchmark &b = benchmarks[i];
+        if (b.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        /* Grow the iteration count until the run takes long enough to be measured reliably */
+        size_t iterations = 1;
+        for (;;) {
+            State state(iterations, b.arg);
+            b.function(state);
+            if (state.realTime() >= minTime || iterations >= 1000000000) {
+                Result r;
+                r.name = b.name;
+                r.iterations = state.iterations();
+                r.realTime = state.realTime() * 1e9 / r.iterations;
+                r.cpuTime = state.cpuTime() * 1e9 / r.iterations;
+                r.itemsPerSecond = state.itemsProcessed() && state.realTime() > 0 ?
+                    state.itemsProcessed() / state.realTime() : 0;
+                r.counters = state.counters;
+                results.push_back(r);
+                if (!json) {
+                    writeConsole(stdout, r);
+                }
+                break;
+            }
+            double multiplier = state.realTime() > 0 ? minTime * 1.4 / state.realTime() : 10.0;
+            if (multiplier > 10.0) {
+                multiplier = 10.0;
+            }
+            size_t next = (size_t)(iterations * multiplier);
+            iterations = next > iterations ? next : iterations + 1;
+        }
+    }
+
+    if (json) {
+        writeJSON(stdout, results, minTime);
+    }
+    if (outPath) {
+        FILE *out = fopen(outPath, "w");
+        if (!out) {
+            fprintf(stderr, "Could not open %s\n", outPath);
+            return 1;
+        }
+        writeJSON(out, results, minTime);
+        fclose(out);
+    }
+    return 0;
+}
+
+} // namespace benchmark
+
+int main(int argc, char *argv[])
+{
+    return benchmark::RunSpecifiedBenchmarks(argc, argv);
+}
@@ -0,0 +1,121 @@
+/*
+ * Minimal micro benchmark harness
+ *
+ * Benchmarks are plain functions taking a State reference and looping while
+ * State::KeepRunning() returns true. The harness calibrates the number of
+ * iterations until a run takes at least the configured minimum time, then
+ * reports the time per iteration. Output is either a human readable table or
+ * JSON in the format written by Google Benchmark, so existing tooling for
+ * comparing runs across releases can be used on the results.
+ *
+ * Command line options:
+ *   --benchmark_filter=<substring>   Run only benchmarks whose name contains <substring>
+ *   --benchmark_min_time=<seconds>   Minimum run time per benchmark (default 0.2)
+ *   --benchmark_format=console|json  Output format for stdout (default console)
+ *   --benchmark_out=<file>           Additionally write JSON results to <file>
+ */
+
+#ifndef KAZMATH_BENCHMARK_H_INCLUDED
+#define KAZMATH_BENCHMARK_H_INCLUDED
+
+#include <stddef.h>
+#include <map>
+#include <string>
+
+namespace benchmark {
+
+class State {
+public:
+    explicit State(size_t maxIterations, long arg);
+
+    /* Returns true while the benchmark loop should continue running */
+    bool KeepRunning()
+    {
+        if (iterations_ < maxIterations_) {
+            if (iterations_ == 0) {
+                StartTimer();
+            }
+            ++iterations_;
+            return true;
+        }
+        StopTimer();
+        return false;
+    }
+
+    /* The argument the benchmark was registered with */
+    long range(int) const { return arg_; }
+
+    size_t iterations() const { return iterations_; }
+
+    /* Excludes setup work inside the benchmark loop from the measurement */
+    void PauseTiming();
+    void ResumeTiming();
+
+    /* Number of items processed, reported as items_per_second */
+    void SetItemsProcessed(size_t items) { itemsProcessed_ = items; }
+
+    /* User defined counters reported alongside timings, e.g. atlas occupancy */
+    std::map<std::string, double> counters;
+
+    double realTime() const { return realTime_; }
+    double cpuTime() const { return cpuTime_; }
+    size_t itemsProcessed() const { return itemsProcessed_; }
+
+private:
+    void StartTimer();
+    void StopTimer();
+
+    size_t iterations_;
+    size_t maxIterations_;
+    long arg_;
+    bool running_;
+    double realStart_;
+    double cpuStart_;
+    double realTime_;
+    double cpuTime_;
+    size_t itemsProcessed_;
+};
+
+typedef void (*Function)(State &);
+
+/* Registers a benchmark function, used by the BENCHMARK macros */
+struct Registrar {
+    Registrar(const char *name, Function function);
+    Registrar(const char *name, Function function, long arg);
+};
+
+/* Prevents the compiler from optimizing away the computation of value */
+template <class T> inline void DoNotOptimize(T const &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    volatile const T *p = &value;
+    (void)p;
+#endif
+}
+
+/* Forces the compiler to flush pending writes to memory */
+inline void ClobberMemory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+int RunSpecifiedBenchmarks(int argc, char *argv[]);
+
+} // namespace benchmark
+
+#define BENCHMARK_CONCAT2(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT2(a, b)
+
+/* Registers function as a benchmark */
+#define BENCHMARK(function) \
+    static benchmark::Registrar BENCHMARK_CONCAT(benchmark_registrar_, __COUNTER__)(#function, function)
+
+/* Registers function as a benchmark named function/arg, arg is available via State::range(0) */
+#define BENCHMARK_ARG(function, arg) \
+    static benchmark::Registrar BENCHMARK_CONCAT(benchmark_registrar_, __COUNTER__)(#function, function, arg)
+
+#endif /* KAZMATH_BENCHMARK_H_INCLUDED */
@@ -23,39 +23,78 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#define _POSIX_C_SOURCE 200112L // posix_memalign
+
 #include <stdlib.h>
 #include <memory.h>
 #include <assert.h>
 #include <stdio.h>
 
-#define INITIAL_SIZE 30
-#define INCREMENT 50
-
 #include "mat4stack.h"
 
 void km_mat4_stack_initialize(km_mat4_stack* stack) {
-	stack->stack = (kmMat4*) malloc(sizeof(kmMat4) * INITIAL_SIZE); //allocate the memory
-	stack->capacity = INITIAL_SIZE; //Set the capacity to 10
+	stack->stack = stack->inline_stack;
+	stack->capacity = KM_MAT4_STACK_CAPACITY;
 	stack->top = NULL; //Set the top to NULL
 	stack->item_count = 0;
 };
 
+//Doubles the capacity of the stack, moving its items to cache line aligned heap storage.
+//Returns 0 if memory could not be allocated, in which case the stack is left unchanged.
+static int km_mat4_stack_grow(km_mat4_stack* stack)
+{
+    void* memory = NULL;
+    int capacity = stack->capacity * 2;
+    if (posix_memalign(&memory, 64, sizeof(kmMat4) * capacity) != 0) {
+        return 0;
+    }
+
+    memcpy(memory, stack->stack, sizeof(kmMat4) * stack->item_count);
+    if (stack->stack != stack->inline_stack) {
+        free(stack->stack);
+    }
+    stack->stack = (kmMat4*) memory;
+    stack->capacity = capacity;
+    stack->top = stack->item_count ? &stack->stack[stack->item_count - 1] : NULL;
+    return 1;
+}
+
 void km_mat4_stack_push(km_mat4_stack* stack, const kmMat4* item)
 {
+    //Copy the item first, as it may point into the storage freed when growing the stack
+    kmMat4 copy;
+    kmMat4Assign(&copy, item);
+
+    if (stack->item_count == stack->capacity && !km_mat4_stack_grow(stack)) {
+        assert(0 && "Matrix stack overflow");
+        return;
+    }
+
     stack->top = &stack->stack[stack->item_count];
-    kmMat4Assign(stack->top, item);
+    kmMat4Assign(stack->top, &copy);
     stack->item_count++;
+}
+
+void km_mat4_stack_push_multiply(km_mat4_stack* stack, const kmMat4* item)
+{
+    assert(stack->item_count && "Cannot multiply with the top of an empty stack");
 
-    if(stack->item_count >= stack->capacity)
-    {
-		kmMat4* temp = NULL;
-        stack->capacity += INCREMENT;
-        temp = stack->stack;
-        stack->stack = (kmMat4*) malloc(stack->capacity*sizeof(kmMat4));
-        memcpy(stack->stack, temp, sizeof(kmMat4)*(stack->capacity - INCREMENT));
-        free(temp);
-        stack->top = &stack->stack[stack->item_count - 1];
+    kmMat4 copy;
+    if (stack->item_count == stack->capacity) {
+        //Copy the item first, as it may point into the storage freed when growing the stack
+        kmMat4Assign(&copy, item);
+        item = &copy;
+        if (!km_mat4_stack_grow(stack)) {
+            assert(0 && "Matrix stack overflow");
+            return;
+        }
     }
+
+    //Write the product directly to the new top instead of copying the old top first
+    kmMat4* newTop = &stack->stack[stack->item_count];
+    kmMat4Multiply(newTop, stack->top, item);
+    stack->top = newTop;
+    stack->item_count++;
 }
 
 void km_mat4_stack_pop(km_mat4_stack* stack, kmMat4* pOut)
@@ -63,12 +102,15 @@ void km_mat4_stack_pop(km_mat4_stack* stack, kmMat4* pOut)
     assert(stack->item_count && "Cannot pop an empty stack");
 
     stack->item_count--;
-    stack->top = &stack->stack[stack->item_count - 1];
+    stack->top = stack->item_count ? &stack->stack[stack->item_count - 1] : NULL;
 }
 
 void km_mat4_stack_release(km_mat4_stack* stack) {
-    free(stack->stack);
+    if (stack->stack != stack->inline_stack) {
+        free(stack->stack);
+    }
+	stack->stack = stack->inline_stack;
+	stack->capacity = KM_MAT4_STACK_CAPACITY;
 	stack->top = NULL;
 	stack->item_count = 0;
-	stack->capacity = 0;
 }
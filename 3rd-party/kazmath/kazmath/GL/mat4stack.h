@@ -28,11 +28,25 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../mat4.h"
 
+/*
+ * Matrix stacks store up to KM_MAT4_STACK_CAPACITY items inline, so pushing does not allocate
+ * memory for typical scene graph depths. Deeper stacks grow on the heap. The capacity determines
+ * the layout of km_mat4_stack and thus must not be redefined by clients.
+ */
+#define KM_MAT4_STACK_CAPACITY 128
+
+#if defined(__GNUC__) || defined(__clang__)
+#define KM_CACHE_ALIGNED __attribute__((aligned(64)))
+#else
+#define KM_CACHE_ALIGNED
+#endif
+
 typedef struct km_mat4_stack {
+	kmMat4 inline_stack[KM_MAT4_STACK_CAPACITY] KM_CACHE_ALIGNED; //The inline items, each matrix occupies one cache line
+	kmMat4* stack; //The items, either inline_stack or heap storage if the stack has grown
 	int capacity; //The total item capacity
 	int item_count; //The number of items
 	kmMat4* top;
-	kmMat4* stack;
 } km_mat4_stack;
 
 #ifdef __cplusplus
@@ -41,6 +55,7 @@ extern "C" {
 
 void km_mat4_stack_initialize(km_mat4_stack* stack);
 void km_mat4_stack_push(km_mat4_stack* stack, const kmMat4* item);
+void km_mat4_stack_push_multiply(km_mat4_stack* stack, const kmMat4* item); /** Pushes top * item */
 void km_mat4_stack_pop(km_mat4_stack* stack, kmMat4* pOut);
 void km_mat4_stack_release(km_mat4_stack* stack);
 
@@ -23,6 +23,8 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#define _POSIX_C_SOURCE 200112L // posix_memalign
+
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
@@ -34,272 +36,281 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // ---
 // Begin additions by Tobias Lensing for icedcoffee-framework.org
 
-typedef struct km_mat4_stack_context {
+// The matrix stacks of a context are initialized when the context is registered, so that
+// stack operations do not need to check for lazy initialization. Contexts are allocated
+// with cache line alignment, see km_mat4_stack.
+struct km_mat4_stack_context {
     km_mat4_stack modelview_matrix_stack;
     km_mat4_stack projection_matrix_stack;
     km_mat4_stack texture_matrix_stack;
     km_mat4_stack* current_stack;
-    unsigned char initialized;
     void *contextRef;
-    struct km_mat4_stack_context_list *entry;
-} km_mat4_stack_context;
+    struct km_mat4_stack_context *prev;
+    struct km_mat4_stack_context *next;
+};
 
-typedef struct km_mat4_stack_context_list {
-    km_mat4_stack_context context;
-    struct km_mat4_stack_context_list *prev;
-    struct km_mat4_stack_context_list *next;
-} km_mat4_stack_context_list;
+typedef struct km_mat4_stack_context km_mat4_stack_context;
 
 static pthread_key_t current_context_key;
-static km_mat4_stack_context_list *contexts;
-static unsigned char initialized = 0;
+static pthread_once_t current_context_key_once = PTHREAD_ONCE_INIT;
+static km_mat4_stack_context *contexts;
 static pthread_mutex_t contexts_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-void lazyInitialize()
+static void createCurrentContextKey(void)
 {
-    if (!initialized) {
-        pthread_key_create(&current_context_key, NULL);
-        initialized = 1;
-    }
+    pthread_key_create(&current_context_key, NULL);
 }
 
-km_mat4_stack_context *lookUpContext(void *contextRef)
+static void lazyInitialize(void)
 {
-    lazyInitialize();
-    
-    if (contexts) {
-        km_mat4_stack_context_list *entry = contexts;
-        pthread_mutex_lock(&contexts_mutex);
-        do {
-            if (entry->context.contextRef == contextRef) {
-                pthread_mutex_unlock(&contexts_mutex);
-                return &entry->context;
-            }
-        } while ((entry = entry->next));
-        pthread_mutex_unlock(&contexts_mutex);
+    pthread_once(&current_context_key_once, createCurrentContextKey);
+}
+
+// Must be called with contexts_mutex locked
+static km_mat4_stack_context *lookUpContext(void *contextRef)
+{
+    km_mat4_stack_context *context;
+    for (context = contexts; context; context = context->next) {
+        if (context->contextRef == contextRef) {
+            return context;
+        }
     }
-    
     return NULL;
 }
 
-km_mat4_stack_context *registerContext(void *contextRef)
+static km_mat4_stack_context *createContext(void *contextRef)
 {
+    void *memory = NULL;
+    km_mat4_stack_context *context;
+    kmMat4 identity;
+
+    if (posix_memalign(&memory, 64, sizeof(km_mat4_stack_context)) != 0) {
+        return NULL;
+    }
+    context = (km_mat4_stack_context *)memory;
+    memset(context, 0, sizeof(km_mat4_stack_context));
+    context->contextRef = contextRef;
+
+    km_mat4_stack_initialize(&context->modelview_matrix_stack);
+    km_mat4_stack_initialize(&context->projection_matrix_stack);
+    km_mat4_stack_initialize(&context->texture_matrix_stack);
+    context->current_stack = &context->modelview_matrix_stack;
+
+    //Make sure that each stack has the identity matrix
+    kmMat4Identity(&identity);
+    km_mat4_stack_push(&context->modelview_matrix_stack, &identity);
+    km_mat4_stack_push(&context->projection_matrix_stack, &identity);
+    km_mat4_stack_push(&context->texture_matrix_stack, &identity);
+
+    return context;
+}
+
+kmGLContext *kmGLGetContext(void *contextRef)
+{
+    km_mat4_stack_context *context;
+
     lazyInitialize();
-    
-    km_mat4_stack_context *existingContext = lookUpContext(contextRef);
-    if (!existingContext) {
-        km_mat4_stack_context_list *entry = contexts;
-        km_mat4_stack_context_list *last = NULL;
-        
-        pthread_mutex_lock(&contexts_mutex);
-        if (entry) {
-            do {
-                last = entry;
-            } while((entry = entry->next));
-        }
-        pthread_mutex_unlock(&contexts_mutex);
-        
-        km_mat4_stack_context_list *newEntry = (km_mat4_stack_context_list *)malloc(sizeof(km_mat4_stack_context_list));
-        memset(newEntry, 0, sizeof(km_mat4_stack_context_list));
-        newEntry->context.contextRef = contextRef;
-        newEntry->context.entry = newEntry;
-        newEntry->prev = last;
-        
-        pthread_mutex_lock(&contexts_mutex);
-        if (last) {
-            last->next = newEntry;
-        }
-        if (!contexts) {
-            contexts = newEntry;
+
+    pthread_mutex_lock(&contexts_mutex);
+    context = lookUpContext(contextRef);
+    if (!context) {
+        context = createContext(contextRef);
+        if (context) {
+            context->next = contexts;
+            if (contexts) {
+                contexts->prev = context;
+            }
+            contexts = context;
         }
-        pthread_mutex_unlock(&contexts_mutex);
-        
-        return &newEntry->context;
     }
-    
-    return existingContext;
+    pthread_mutex_unlock(&contexts_mutex);
+
+    return context;
 }
 
 void kmGLSetCurrentContext(void *contextRef)
 {
-    km_mat4_stack_context *current_context = registerContext(contextRef);
+    km_mat4_stack_context *current_context = kmGLGetContext(contextRef);
     pthread_setspecific(current_context_key, current_context);
 }
 
 void *kmGLGetCurrentContext()
 {
-    return ((km_mat4_stack_context *)pthread_getspecific(current_context_key))->contextRef;
+    return kmGLGetCurrentContextHandle()->contextRef;
+}
+
+kmGLContext *kmGLGetCurrentContextHandle()
+{
+    km_mat4_stack_context *current_context;
+
+    lazyInitialize();
+    current_context = pthread_getspecific(current_context_key);
+    assert(current_context != NULL && "No context set");
+    return current_context;
 }
 
-void kmGLClearContext(km_mat4_stack_context *context)
+static void kmGLClearContext(km_mat4_stack_context *context)
 {
-    // Unlink current context from linked list
-    if (context->entry->prev)
-        context->entry->prev->next = context->entry->next;
-	
+    // Unlink context from linked list
+    pthread_mutex_lock(&contexts_mutex);
+    if (context->prev)
+        context->prev->next = context->next;
+    else
+        contexts = context->next;
+    if (context->next)
+        context->next->prev = context->prev;
+    pthread_mutex_unlock(&contexts_mutex);
+
     //Clear the matrix stacks
-	km_mat4_stack_release(&context->modelview_matrix_stack);
-	km_mat4_stack_release(&context->projection_matrix_stack);
-	km_mat4_stack_release(&context->texture_matrix_stack);
-    
-	//Delete the matrices
-	context->initialized = 0;
-    
-    //Set the current stack to point nowhere
-	context->current_stack = NULL;
-    
-    // Free the list entry, including its stacks
-    free(context->entry);
+    km_mat4_stack_release(&context->modelview_matrix_stack);
+    km_mat4_stack_release(&context->projection_matrix_stack);
+    km_mat4_stack_release(&context->texture_matrix_stack);
+
+    free(context);
 }
 
 void kmGLClearCurrentContext()
 {
-    kmGLClearContext(pthread_getspecific(current_context_key));
+    kmGLClearContext(kmGLGetCurrentContextHandle());
     pthread_setspecific(current_context_key, NULL);
 }
 
 void kmGLClearAllContexts()
 {
-    km_mat4_stack_context_list *entry = contexts;
-    do {
-        kmGLClearContext(&entry->context);
-    } while ((entry = entry->next));
-    
+    lazyInitialize();
+
+    while (contexts) {
+        kmGLClearContext(contexts);
+    }
+
     pthread_setspecific(current_context_key, NULL);
 }
 
-// End additions by Tobias Lensing for icedcoffee-framework.org
-// ---
+static km_mat4_stack* stackForMode(kmGLContext *context, kmGLEnum mode)
+{
+	switch(mode)
+	{
+		case KM_GL_MODELVIEW:
+			return &context->modelview_matrix_stack;
+		case KM_GL_PROJECTION:
+			return &context->projection_matrix_stack;
+		case KM_GL_TEXTURE:
+			return &context->texture_matrix_stack;
+		default:
+			assert(0 && "Invalid matrix mode specified"); //TODO: Proper error handling
+			return NULL;
+	}
+}
 
-km_mat4_stack_context *lazyInitializeCurrentContext()
+void kmGLContextMatrixMode(kmGLContext *context, kmGLEnum mode)
 {
-    km_mat4_stack_context *current_context = pthread_getspecific(current_context_key);
-    
-    assert(current_context != NULL && "No context set");
-    
-	if (current_context && !current_context->initialized) {
-		kmMat4 identity; //Temporary identity matrix
+	km_mat4_stack *stack = stackForMode(context, mode);
+	if (stack) {
+		context->current_stack = stack;
+	}
+}
 
-		//Initialize all 3 stacks
-		//modelview_matrix_stack = (km_mat4_stack*) malloc(sizeof(km_mat4_stack));
-		km_mat4_stack_initialize(&current_context->modelview_matrix_stack);
+void kmGLContextPushMatrix(kmGLContext *context)
+{
+	//Duplicate the top of the stack (i.e the current matrix)
+	km_mat4_stack_push(context->current_stack, context->current_stack->top);
+}
 
-		//projection_matrix_stack = (km_mat4_stack*) malloc(sizeof(km_mat4_stack));
-		km_mat4_stack_initialize(&current_context->projection_matrix_stack);
+void kmGLContextPushMultMatrix(kmGLContext *context, const kmMat4* pIn)
+{
+	km_mat4_stack_push_multiply(context->current_stack, pIn);
+}
 
-		//texture_matrix_stack = (km_mat4_stack*) malloc(sizeof(km_mat4_stack));
-		km_mat4_stack_initialize(&current_context->texture_matrix_stack);
+void kmGLContextPopMatrix(kmGLContext *context)
+{
+	km_mat4_stack_pop(context->current_stack, NULL);
+}
 
-		current_context->current_stack = &current_context->modelview_matrix_stack;
-		current_context->initialized = 1;
+void kmGLContextLoadIdentity(kmGLContext *context)
+{
+	kmMat4Identity(context->current_stack->top); //Replace the top matrix with the identity matrix
+}
 
-		kmMat4Identity(&identity);
+void kmGLContextLoadMatrix(kmGLContext *context, const kmMat4* pIn)
+{
+	kmMat4Assign(context->current_stack->top, pIn);
+}
 
-		//Make sure that each stack has the identity matrix
-		km_mat4_stack_push(&current_context->modelview_matrix_stack, &identity);
-		km_mat4_stack_push(&current_context->projection_matrix_stack, &identity);
-		km_mat4_stack_push(&current_context->texture_matrix_stack, &identity);
-	}
-    
-    return current_context;
+void kmGLContextMultMatrix(kmGLContext *context, const kmMat4* pIn)
+{
+	kmMat4Multiply(context->current_stack->top, context->current_stack->top, pIn);
 }
 
-void kmGLMatrixMode(kmGLEnum mode)
+const kmMat4* kmGLContextGetMatrixPtr(kmGLContext *context, kmGLEnum mode)
 {
-	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
+	km_mat4_stack *stack = stackForMode(context, mode);
+	return stack ? stack->top : NULL;
+}
 
-	switch(mode)
-	{
-		case KM_GL_MODELVIEW:
-			current_context->current_stack = &current_context->modelview_matrix_stack;
-		break;
-		case KM_GL_PROJECTION:
-			current_context->current_stack = &current_context->projection_matrix_stack;
-		break;
-		case KM_GL_TEXTURE:
-			current_context->current_stack = &current_context->texture_matrix_stack;
-		break;
-		default:
-			assert(0 && "Invalid matrix mode specified"); //TODO: Proper error handling
-		break;
+void kmGLContextGetMatrix(kmGLContext *context, kmGLEnum mode, kmMat4* pOut)
+{
+	const kmMat4 *top = kmGLContextGetMatrixPtr(context, mode);
+	if (top) {
+		kmMat4Assign(pOut, top);
 	}
 }
 
-void kmGLPushMatrix(void)
+// End additions by Tobias Lensing for icedcoffee-framework.org
+// ---
+
+void kmGLMatrixMode(kmGLEnum mode)
 {
-	kmMat4 top;
+	kmGLContextMatrixMode(kmGLGetCurrentContextHandle(), mode);
+}
 
-	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
+void kmGLPushMatrix(void)
+{
+	kmGLContextPushMatrix(kmGLGetCurrentContextHandle());
+}
 
-	//Duplicate the top of the stack (i.e the current matrix)	
-	kmMat4Assign(&top, current_context->current_stack->top);
-	km_mat4_stack_push(current_context->current_stack, &top);
+void kmGLPushMultMatrix(const kmMat4* pIn)
+{
+	kmGLContextPushMultMatrix(kmGLGetCurrentContextHandle(), pIn);
 }
 
 void kmGLPopMatrix(void)
 {
-	km_mat4_stack_context *current_context = pthread_getspecific(current_context_key);
-    assert(current_context->initialized && "Cannot Pop empty matrix stack");
-	//No need to lazy initialize, you shouldnt be popping first anyway!
-	km_mat4_stack_pop(current_context->current_stack, NULL);
+	kmGLContextPopMatrix(kmGLGetCurrentContextHandle());
 }
 
 void kmGLLoadIdentity()
 {
-	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
-	kmMat4Identity(current_context->current_stack->top); //Replace the top matrix with the identity matrix
+	kmGLContextLoadIdentity(kmGLGetCurrentContextHandle());
 }
 
 void kmGLMultMatrix(const kmMat4* pIn)
 {
-	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
-	kmMat4Multiply(current_context->current_stack->top, current_context->current_stack->top, pIn);
+	kmGLContextMultMatrix(kmGLGetCurrentContextHandle(), pIn);
 }
 
 void kmGLLoadMatrix(const kmMat4* pIn)
 {
-	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
-	kmMat4Assign(current_context->current_stack->top, pIn);
+	kmGLContextLoadMatrix(kmGLGetCurrentContextHandle(), pIn);
 }
 
 void kmGLGetMatrix(kmGLEnum mode, kmMat4* pOut)
 {
-	km_mat4_stack_context *current_context = lazyInitializeCurrentContext();
-
-	switch(mode)
-	{
-		case KM_GL_MODELVIEW:
-			kmMat4Assign(pOut, current_context->modelview_matrix_stack.top);
-		break;
-		case KM_GL_PROJECTION:
-			kmMat4Assign(pOut, current_context->projection_matrix_stack.top);
-		break;
-		case KM_GL_TEXTURE:
-			kmMat4Assign(pOut, current_context->texture_matrix_stack.top);
-		break;
-		default:
-			assert(1 && "Invalid matrix mode specified"); //TODO: Proper error handling
-		break;
-	}
+	kmGLContextGetMatrix(kmGLGetCurrentContextHandle(), mode, pOut);
 }
 
 void kmGLTranslatef(float x, float y, float z)
 {
-    km_mat4_stack_context *current_context = pthread_getspecific(current_context_key);
-
 	kmMat4 translation;
 
 	//Create a rotation matrix using the axis and the angle
 	kmMat4Translation(&translation,x,y,z);
 
 	//Multiply the rotation matrix by the current matrix
-	kmMat4Multiply(current_context->current_stack->top, current_context->current_stack->top, &translation);
+	kmGLMultMatrix(&translation);
 }
 
 void kmGLRotatef(float angle, float x, float y, float z)
 {
-    km_mat4_stack_context *current_context = pthread_getspecific(current_context_key);
-
 	kmVec3 axis;
 	kmMat4 rotation;
 
@@ -310,14 +321,12 @@ void kmGLRotatef(float angle, float x, float y, float z)
 	kmMat4RotationAxisAngle(&rotation, &axis, kmDegreesToRadians(angle));
 
 	//Multiply the rotation matrix by the current matrix
-	kmMat4Multiply(current_context->current_stack->top, current_context->current_stack->top, &rotation);
+	kmGLMultMatrix(&rotation);
 }
 
 void kmGLScalef(float x, float y, float z)
 {
-    km_mat4_stack_context *current_context = pthread_getspecific(current_context_key);
-
 	kmMat4 scaling;
 	kmMat4Scaling(&scaling, x, y, z);
-	kmMat4Multiply(current_context->current_stack->top, current_context->current_stack->top, &scaling);
+	kmGLMultMatrix(&scaling);
 }
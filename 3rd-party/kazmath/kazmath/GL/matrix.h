@@ -45,7 +45,31 @@ void *kmGLGetCurrentContext();
 void kmGLClearCurrentContext();
 void kmGLClearAllContexts();
 
+/*
+ * Matrix stack context handles
+ *
+ * The kmGL* functions below look up the current thread's context using thread local storage
+ * on every call. Code performing many stack operations in a row (e.g. while traversing a
+ * scene graph) should retrieve the context handle once and use the kmGLContext* functions,
+ * which operate on the given context directly and never lock or allocate memory.
+ */
+typedef struct km_mat4_stack_context kmGLContext;
+
+kmGLContext *kmGLGetContext(void *contextRef); /** Returns the context for contextRef, registering it if necessary */
+kmGLContext *kmGLGetCurrentContextHandle(); /** Returns the context set for the current thread */
+
+void kmGLContextMatrixMode(kmGLContext *context, kmGLEnum mode);
+void kmGLContextPushMatrix(kmGLContext *context);
+void kmGLContextPushMultMatrix(kmGLContext *context, const kmMat4* pIn); /** Pushes the current matrix multiplied by pIn */
+void kmGLContextPopMatrix(kmGLContext *context);
+void kmGLContextLoadIdentity(kmGLContext *context);
+void kmGLContextLoadMatrix(kmGLContext *context, const kmMat4* pIn);
+void kmGLContextMultMatrix(kmGLContext *context, const kmMat4* pIn);
+void kmGLContextGetMatrix(kmGLContext *context, kmGLEnum mode, kmMat4* pOut);
+const kmMat4* kmGLContextGetMatrixPtr(kmGLContext *context, kmGLEnum mode); /** Returns the top of the given stack, valid until the next stack operation */
+
 void kmGLPushMatrix(void);
+void kmGLPushMultMatrix(const kmMat4* pIn);
 void kmGLPopMatrix(void);
 void kmGLMatrixMode(kmGLEnum mode);
 void kmGLLoadIdentity(void);
@@ -37,6 +37,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "quaternion.h"
 #include "plane.h"
 
+#if defined(KM_USE_SSE)
+#include <xmmintrin.h>
+#elif defined(KM_USE_NEON)
+#include <arm_neon.h>
+#endif
+
 /**
  * Fills a kmMat4 structure with the values from a 16
  * element array of kmScalars
@@ -177,6 +183,59 @@ kmMat4* const kmMat4Inverse(kmMat4* pOut, const kmMat4* pM)
     kmMat4Assign(pOut, &inv);
     return pOut;
 }
+
+/**
+ * Calculates the inverse of the affine transform pM and stores the result in
+ * pOut. Instead of running a general Gauss-Jordan elimination, the upper 3x3
+ * part is inverted using its cofactors and the translation is transformed
+ * by the inverted 3x3 part. Falls back to kmMat4Inverse if pM is not affine,
+ * i.e. if its last row is not (0, 0, 0, 1).
+ * @Return Returns NULL if there is no inverse, else pOut
+ */
+kmMat4* const kmMat4AffineInverse(kmMat4* pOut, const kmMat4* pM)
+{
+    const kmScalar *m = pM->mat;
+    kmScalar c0, c1, c2, det, invDet;
+    kmScalar r[16];
+
+    if (m[3] != 0.0f || m[7] != 0.0f || m[11] != 0.0f || m[15] != 1.0f) {
+        return kmMat4Inverse(pOut, pM);
+    }
+
+    /* Cofactors of the first row */
+    c0 = m[5] * m[10] - m[6] * m[9];
+    c1 = m[6] * m[8] - m[4] * m[10];
+    c2 = m[4] * m[9] - m[5] * m[8];
+
+    det = m[0] * c0 + m[1] * c1 + m[2] * c2;
+    if (det == 0.0f) {
+        return NULL;
+    }
+    invDet = 1.0f / det;
+
+    r[0] = c0 * invDet;
+    r[1] = (m[2] * m[9] - m[1] * m[10]) * invDet;
+    r[2] = (m[1] * m[6] - m[2] * m[5]) * invDet;
+    r[3] = 0.0f;
+
+    r[4] = c1 * invDet;
+    r[5] = (m[0] * m[10] - m[2] * m[8]) * invDet;
+    r[6] = (m[2] * m[4] - m[0] * m[6]) * invDet;
+    r[7] = 0.0f;
+
+    r[8] = c2 * invDet;
+    r[9] = (m[1] * m[8] - m[0] * m[9]) * invDet;
+    r[10] = (m[0] * m[5] - m[1] * m[4]) * invDet;
+    r[11] = 0.0f;
+
+    r[12] = -(r[0] * m[12] + r[4] * m[13] + r[8] * m[14]);
+    r[13] = -(r[1] * m[12] + r[5] * m[13] + r[9] * m[14]);
+    r[14] = -(r[2] * m[12] + r[6] * m[13] + r[10] * m[14]);
+    r[15] = 1.0f;
+
+    memcpy(pOut->mat, r, sizeof(kmScalar) * 16);
+    return pOut;
+}
 /**
  * Returns KM_TRUE if pIn is an identity matrix
  * KM_FALSE otherwise
@@ -208,11 +267,78 @@ kmMat4* const kmMat4Transpose(kmMat4* pOut, const kmMat4* pIn)
     return pOut;
 }
 
+#if defined(KM_USE_SSE)
+
+/* Computes pM1 * col for the column starting at pCol, with pM1's columns in c0..c3 */
+static inline __m128 kmMat4MultiplyColumnSSE(__m128 c0, __m128 c1, __m128 c2, __m128 c3,
+                                             const kmScalar* pCol)
+{
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(pCol[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(pCol[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(pCol[2])));
+    return _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(pCol[3])));
+}
+
+#elif defined(KM_USE_NEON)
+
+/* Computes pM1 * col for the column starting at pCol, with pM1's columns in c0..c3 */
+static inline float32x4_t kmMat4MultiplyColumnNEON(float32x4_t c0, float32x4_t c1,
+                                                   float32x4_t c2, float32x4_t c3,
+                                                   const kmScalar* pCol)
+{
+    /* Separate multiply and add (no vmlaq/vfmaq) to match the rounding of the scalar path */
+    float32x4_t r = vmulq_n_f32(c0, pCol[0]);
+    r = vaddq_f32(r, vmulq_n_f32(c1, pCol[1]));
+    r = vaddq_f32(r, vmulq_n_f32(c2, pCol[2]));
+    return vaddq_f32(r, vmulq_n_f32(c3, pCol[3]));
+}
+
+#endif
+
 /**
  * Multiplies pM1 with pM2, stores the result in pOut, returns pOut
  */
 kmMat4* const kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 {
+#if defined(KM_USE_SSE)
+	const kmScalar *m1 = pM1->mat, *m2 = pM2->mat;
+	__m128 c0 = _mm_loadu_ps(&m1[0]);
+	__m128 c1 = _mm_loadu_ps(&m1[4]);
+	__m128 c2 = _mm_loadu_ps(&m1[8]);
+	__m128 c3 = _mm_loadu_ps(&m1[12]);
+
+	/* Compute all columns before storing, pOut may alias pM1 or pM2 */
+	__m128 r0 = kmMat4MultiplyColumnSSE(c0, c1, c2, c3, &m2[0]);
+	__m128 r1 = kmMat4MultiplyColumnSSE(c0, c1, c2, c3, &m2[4]);
+	__m128 r2 = kmMat4MultiplyColumnSSE(c0, c1, c2, c3, &m2[8]);
+	__m128 r3 = kmMat4MultiplyColumnSSE(c0, c1, c2, c3, &m2[12]);
+
+	_mm_storeu_ps(&pOut->mat[0], r0);
+	_mm_storeu_ps(&pOut->mat[4], r1);
+	_mm_storeu_ps(&pOut->mat[8], r2);
+	_mm_storeu_ps(&pOut->mat[12], r3);
+
+	return pOut;
+#elif defined(KM_USE_NEON)
+	const kmScalar *m1 = pM1->mat, *m2 = pM2->mat;
+	float32x4_t c0 = vld1q_f32(&m1[0]);
+	float32x4_t c1 = vld1q_f32(&m1[4]);
+	float32x4_t c2 = vld1q_f32(&m1[8]);
+	float32x4_t c3 = vld1q_f32(&m1[12]);
+
+	/* Compute all columns before storing, pOut may alias pM1 or pM2 */
+	float32x4_t r0 = kmMat4MultiplyColumnNEON(c0, c1, c2, c3, &m2[0]);
+	float32x4_t r1 = kmMat4MultiplyColumnNEON(c0, c1, c2, c3, &m2[4]);
+	float32x4_t r2 = kmMat4MultiplyColumnNEON(c0, c1, c2, c3, &m2[8]);
+	float32x4_t r3 = kmMat4MultiplyColumnNEON(c0, c1, c2, c3, &m2[12]);
+
+	vst1q_f32(&pOut->mat[0], r0);
+	vst1q_f32(&pOut->mat[4], r1);
+	vst1q_f32(&pOut->mat[8], r2);
+	vst1q_f32(&pOut->mat[12], r3);
+
+	return pOut;
+#else
 	kmScalar mat[16];
 
 	const kmScalar *m1 = pM1->mat, *m2 = pM2->mat;
@@ -240,6 +366,71 @@ kmMat4* const kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 
 	memcpy(pOut->mat, mat, sizeof(kmScalar)*16);
 
+	return pOut;
+#endif
+}
+
+/**
+ * Multiplies pM1 with each of the count matrices in pM2 and stores the
+ * results in the corresponding elements of pOut, returns pOut.
+ * pOut may be equal to pM2, but must not otherwise overlap pM2.
+ */
+kmMat4* const kmMat4MultiplyArray(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2, kmUint count)
+{
+	kmUint i;
+#if defined(KM_USE_SSE)
+	kmMat4 m1Copy;
+	__m128 c0, c1, c2, c3;
+
+	/* pM1 may live inside pOut */
+	memcpy(&m1Copy, pM1, sizeof(kmMat4));
+	c0 = _mm_loadu_ps(&m1Copy.mat[0]);
+	c1 = _mm_loadu_ps(&m1Copy.mat[4]);
+	c2 = _mm_loadu_ps(&m1Copy.mat[8]);
+	c3 = _mm_loadu_ps(&m1Copy.mat[12]);
+
+	for (i = 0; i < count; ++i) {
+		const kmScalar *m2 = pM2[i].mat;
+		__m128 r0 = kmMat4MultiplyColumnSSE(c0, c1, c2, c3, &m2[0]);
+		__m128 r1 = kmMat4MultiplyColumnSSE(c0, c1, c2, c3, &m2[4]);
+		__m128 r2 = kmMat4MultiplyColumnSSE(c0, c1, c2, c3, &m2[8]);
+		__m128 r3 = kmMat4MultiplyColumnSSE(c0, c1, c2, c3, &m2[12]);
+		_mm_storeu_ps(&pOut[i].mat[0], r0);
+		_mm_storeu_ps(&pOut[i].mat[4], r1);
+		_mm_storeu_ps(&pOut[i].mat[8], r2);
+		_mm_storeu_ps(&pOut[i].mat[12], r3);
+	}
+#elif defined(KM_USE_NEON)
+	kmMat4 m1Copy;
+	float32x4_t c0, c1, c2, c3;
+
+	/* pM1 may live inside pOut */
+	memcpy(&m1Copy, pM1, sizeof(kmMat4));
+	c0 = vld1q_f32(&m1Copy.mat[0]);
+	c1 = vld1q_f32(&m1Copy.mat[4]);
+	c2 = vld1q_f32(&m1Copy.mat[8]);
+	c3 = vld1q_f32(&m1Copy.mat[12]);
+
+	for (i = 0; i < count; ++i) {
+		const kmScalar *m2 = pM2[i].mat;
+		float32x4_t r0 = kmMat4MultiplyColumnNEON(c0, c1, c2, c3, &m2[0]);
+		float32x4_t r1 = kmMat4MultiplyColumnNEON(c0, c1, c2, c3, &m2[4]);
+		float32x4_t r2 = kmMat4MultiplyColumnNEON(c0, c1, c2, c3, &m2[8]);
+		float32x4_t r3 = kmMat4MultiplyColumnNEON(c0, c1, c2, c3, &m2[12]);
+		vst1q_f32(&pOut[i].mat[0], r0);
+		vst1q_f32(&pOut[i].mat[4], r1);
+		vst1q_f32(&pOut[i].mat[8], r2);
+		vst1q_f32(&pOut[i].mat[12], r3);
+	}
+#else
+	kmMat4 m1Copy;
+
+	/* pM1 may live inside pOut */
+	kmMat4Assign(&m1Copy, pM1);
+	for (i = 0; i < count; ++i) {
+		kmMat4Multiply(&pOut[i], &m1Copy, &pM2[i]);
+	}
+#endif
 	return pOut;
 }
 
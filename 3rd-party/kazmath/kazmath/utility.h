@@ -74,6 +74,21 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define KM_CONTAINS_PARTIAL 1
 #define KM_CONTAINS_ALL 2
 
+/*
+ * SIMD code paths for the hot matrix and vector functions are selected at compile time based on
+ * the target instruction set. SSE is part of the x86-64 baseline and NEON is available on all
+ * ARMv7-A devices with a VFP/NEON unit, so no run-time dispatch is required. Define KM_NO_SIMD to
+ * force the scalar code paths. The SIMD paths perform the same multiplications and additions in
+ * the same order as the scalar paths and thus produce bit-identical results.
+ */
+#if !defined(KM_NO_SIMD) && !defined(USE_DOUBLE_PRECISION)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define KM_USE_SSE 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define KM_USE_NEON 1
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
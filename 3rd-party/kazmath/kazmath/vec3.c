@@ -35,6 +35,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mat4.h"
 #include "vec3.h"
 
+#if defined(KM_USE_SSE)
+#include <xmmintrin.h>
+#elif defined(KM_USE_NEON)
+#include <arm_neon.h>
+#endif
+
 /**
  * Fill a kmVec3 structure using 3 floating point values
  * The result is store in pOut, returns pOut
@@ -159,6 +165,41 @@ kmVec3* kmVec3Subtract(kmVec3* pOut, const kmVec3* pV1, const kmVec3* pV2)
   * Transforms vector (x, y, z, 1) by a given matrix. The result
   * is stored in pOut. pOut is returned.
   */
+#if defined(KM_USE_SSE)
+
+/* Transforms (x, y, z, 1) by the matrix columns c0..c3 and stores x, y, z of the result */
+static inline void kmVec3TransformSSE(kmVec3* pOut, const kmVec3* pV,
+                                      __m128 c0, __m128 c1, __m128 c2, __m128 c3)
+{
+	__m128 r = _mm_mul_ps(c0, _mm_set1_ps(pV->x));
+	r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(pV->y)));
+	r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(pV->z)));
+	r = _mm_add_ps(r, c3);
+
+	/* Store exactly three floats, kmVec3 is not padded */
+	_mm_storel_pi((__m64*)pOut->data, r);
+	_mm_store_ss(&pOut->data[2], _mm_movehl_ps(r, r));
+}
+
+#elif defined(KM_USE_NEON)
+
+/* Transforms (x, y, z, 1) by the matrix columns c0..c3 and stores x, y, z of the result */
+static inline void kmVec3TransformNEON(kmVec3* pOut, const kmVec3* pV, float32x4_t c0,
+                                       float32x4_t c1, float32x4_t c2, float32x4_t c3)
+{
+	/* Separate multiply and add (no vmlaq/vfmaq) to match the rounding of the scalar path */
+	float32x4_t r = vmulq_n_f32(c0, pV->x);
+	r = vaddq_f32(r, vmulq_n_f32(c1, pV->y));
+	r = vaddq_f32(r, vmulq_n_f32(c2, pV->z));
+	r = vaddq_f32(r, c3);
+
+	/* Store exactly three floats, kmVec3 is not padded */
+	vst1_f32(pOut->data, vget_low_f32(r));
+	vst1q_lane_f32(&pOut->data[2], r, 2);
+}
+
+#endif
+
 kmVec3* kmVec3Transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
 {
 	/*
@@ -167,6 +208,15 @@ kmVec3* kmVec3Transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
 		Out = (bx, by, bz)
 	*/
 
+#if defined(KM_USE_SSE)
+	kmVec3TransformSSE(pOut, pV,
+	                   _mm_loadu_ps(&pM->mat[0]), _mm_loadu_ps(&pM->mat[4]),
+	                   _mm_loadu_ps(&pM->mat[8]), _mm_loadu_ps(&pM->mat[12]));
+#elif defined(KM_USE_NEON)
+	kmVec3TransformNEON(pOut, pV,
+	                    vld1q_f32(&pM->mat[0]), vld1q_f32(&pM->mat[4]),
+	                    vld1q_f32(&pM->mat[8]), vld1q_f32(&pM->mat[12]));
+#else
 	kmVec3 v;
 
 	v.x = pV->x * pM->mat[0] + pV->y * pM->mat[4] + pV->z * pM->mat[8] + pM->mat[12];
@@ -176,10 +226,45 @@ kmVec3* kmVec3Transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
 	pOut->x = v.x;
 	pOut->y = v.y;
 	pOut->z = v.z;
+#endif
 
 	return pOut;
 }
 
+/**
+ * Transforms each of the count vectors in pV (assuming w=1) by pM and stores
+ * the results in the corresponding elements of pOut, returns pOut.
+ * pOut may be equal to pV, but must not otherwise overlap pV.
+ */
+kmVec3* kmVec3TransformArray(kmVec3* pOut, const kmVec3* pV, kmUint count, const kmMat4* pM)
+{
+	kmUint i;
+#if defined(KM_USE_SSE)
+	__m128 c0 = _mm_loadu_ps(&pM->mat[0]);
+	__m128 c1 = _mm_loadu_ps(&pM->mat[4]);
+	__m128 c2 = _mm_loadu_ps(&pM->mat[8]);
+	__m128 c3 = _mm_loadu_ps(&pM->mat[12]);
+
+	for (i = 0; i < count; ++i) {
+		kmVec3TransformSSE(&pOut[i], &pV[i], c0, c1, c2, c3);
+	}
+#elif defined(KM_USE_NEON)
+	float32x4_t c0 = vld1q_f32(&pM->mat[0]);
+	float32x4_t c1 = vld1q_f32(&pM->mat[4]);
+	float32x4_t c2 = vld1q_f32(&pM->mat[8]);
+	float32x4_t c3 = vld1q_f32(&pM->mat[12]);
+
+	for (i = 0; i < count; ++i) {
+		kmVec3TransformNEON(&pOut[i], &pV[i], c0, c1, c2, c3);
+	}
+#else
+	for (i = 0; i < count; ++i) {
+		kmVec3Transform(&pOut[i], &pV[i], pM);
+	}
+#endif
+	return pOut;
+}
+
 kmVec3* kmVec3InverseTransform(kmVec3* pOut, const kmVec3* pVect, const kmMat4* pM)
 {
 	kmVec3 v1, v2;
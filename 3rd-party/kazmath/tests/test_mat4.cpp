@@ -3,6 +3,7 @@
 #include <memory.h>
 #include <unittest++/UnitTest++.h>
 #include "../kazmath/mat4.h"
+#include "../kazmath/vec3.h"
 
 void print_matrix4(const kmMat4* mat)
 {
@@ -51,3 +52,107 @@ TEST(test_mat4_transpose) {
     CHECK(kmMat4AreEqual(&transpose, &result));
 }
 
+/* Scalar reference implementation used to check SIMD code paths for bit-compatibility */
+static void reference_mat4_multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
+{
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            float v = pM1->mat[r] * pM2->mat[c*4];
+            v = v + pM1->mat[r+4] * pM2->mat[c*4+1];
+            v = v + pM1->mat[r+8] * pM2->mat[c*4+2];
+            v = v + pM1->mat[r+12] * pM2->mat[c*4+3];
+            pOut->mat[c*4+r] = v;
+        }
+    }
+}
+
+static void random_matrix4(kmMat4* pOut)
+{
+    for (int i = 0; i < 16; ++i) {
+        pOut->mat[i] = (float)rand() / (float)RAND_MAX * 200.0f - 100.0f;
+    }
+}
+
+TEST(test_mat4_multiply_bit_compatible) {
+    srand(1);
+    for (int i = 0; i < 1000; ++i) {
+        kmMat4 a, b, expected, result;
+        random_matrix4(&a);
+        random_matrix4(&b);
+
+        reference_mat4_multiply(&expected, &a, &b);
+        CHECK(&result == kmMat4Multiply(&result, &a, &b));
+        CHECK(0 == memcmp(expected.mat, result.mat, sizeof(kmMat4)));
+    }
+}
+
+TEST(test_mat4_multiply_aliased) {
+    kmMat4 a, b, expected;
+    srand(2);
+    random_matrix4(&a);
+    random_matrix4(&b);
+    reference_mat4_multiply(&expected, &a, &b);
+
+    kmMat4 left = a;
+    kmMat4Multiply(&left, &left, &b);
+    CHECK(0 == memcmp(expected.mat, left.mat, sizeof(kmMat4)));
+
+    kmMat4 right = b;
+    kmMat4Multiply(&right, &a, &right);
+    CHECK(0 == memcmp(expected.mat, right.mat, sizeof(kmMat4)));
+}
+
+TEST(test_mat4_multiply_array) {
+    const int count = 33;
+    kmMat4 parent, children[count], results[count];
+    srand(3);
+    random_matrix4(&parent);
+    for (int i = 0; i < count; ++i) {
+        random_matrix4(&children[i]);
+    }
+
+    CHECK(results == kmMat4MultiplyArray(results, &parent, children, count));
+    for (int i = 0; i < count; ++i) {
+        kmMat4 expected;
+        reference_mat4_multiply(&expected, &parent, &children[i]);
+        CHECK(0 == memcmp(expected.mat, results[i].mat, sizeof(kmMat4)));
+    }
+
+    /* In place */
+    kmMat4MultiplyArray(children, &parent, children, count);
+    CHECK(0 == memcmp(results, children, sizeof(results)));
+}
+
+TEST(test_mat4_affine_inverse) {
+    kmMat4 rotation, scale, translation, transform;
+    kmVec3 axis;
+    kmVec3Fill(&axis, 0.3f, -0.5f, 0.8f);
+    kmVec3Normalize(&axis, &axis);
+    kmMat4RotationAxisAngle(&rotation, &axis, 0.7f);
+    kmMat4Scaling(&scale, 2.0f, 0.5f, 3.0f);
+    kmMat4Translation(&translation, 10.0f, -20.0f, 5.0f);
+    kmMat4Multiply(&transform, &rotation, &scale);
+    kmMat4Multiply(&transform, &translation, &transform);
+
+    kmMat4 expected, inverse;
+    CHECK(NULL != kmMat4Inverse(&expected, &transform));
+    CHECK(&inverse == kmMat4AffineInverse(&inverse, &transform));
+    CHECK(kmMat4AreEqual(&expected, &inverse));
+
+    kmMat4 product;
+    kmMat4Multiply(&product, &transform, &inverse);
+    kmMat4 identity;
+    kmMat4Identity(&identity);
+    CHECK(kmMat4AreEqual(&identity, &product));
+
+    /* Singular */
+    kmMat4Scaling(&scale, 1.0f, 0.0f, 1.0f);
+    CHECK(NULL == kmMat4AffineInverse(&inverse, &scale));
+
+    /* Projective matrices fall back to the general inverse */
+    kmMat4 projection;
+    kmMat4PerspectiveProjection(&projection, 60.0f, 1.5f, 0.1f, 100.0f);
+    CHECK(NULL != kmMat4Inverse(&expected, &projection));
+    CHECK(NULL != kmMat4AffineInverse(&inverse, &projection));
+    CHECK(kmMat4AreEqual(&expected, &inverse));
+}
@@ -0,0 +1,73 @@
+#include <unittest++/UnitTest++.h>
+#include "../kazmath/mat4.h"
+#include "../kazmath/GL/mat4stack.h"
+
+TEST(test_mat4_stack_push_pop) {
+    km_mat4_stack stack;
+    km_mat4_stack_initialize(&stack);
+
+    kmMat4 identity;
+    kmMat4Identity(&identity);
+    km_mat4_stack_push(&stack, &identity);
+    CHECK_EQUAL(1, stack.item_count);
+    CHECK(kmMat4IsIdentity(stack.top));
+
+    km_mat4_stack_pop(&stack, NULL);
+    CHECK_EQUAL(0, stack.item_count);
+    CHECK(NULL == stack.top);
+
+    km_mat4_stack_release(&stack);
+}
+
+TEST(test_mat4_stack_grows_beyond_inline_capacity) {
+    km_mat4_stack stack;
+    km_mat4_stack_initialize(&stack);
+
+    const int count = KM_MAT4_STACK_CAPACITY * 3 + 1;
+    kmMat4 translation;
+    kmMat4Translation(&translation, 0, 0, 0);
+    km_mat4_stack_push(&stack, &translation);
+    for (int i = 1; i < count; ++i) {
+        kmMat4Translation(&translation, 1, 0, 0);
+        km_mat4_stack_push_multiply(&stack, &translation);
+    }
+
+    CHECK_EQUAL(count, stack.item_count);
+    CHECK(stack.capacity >= count);
+    CHECK_CLOSE((float)(count - 1), stack.top->mat[12], 0.001f);
+
+    // Items pushed before growing the stack must have been preserved
+    for (int i = count - 1; i > 0; --i) {
+        km_mat4_stack_pop(&stack, NULL);
+        CHECK_CLOSE((float)(i - 1), stack.top->mat[12], 0.001f);
+    }
+
+    km_mat4_stack_release(&stack);
+    CHECK_EQUAL(KM_MAT4_STACK_CAPACITY, stack.capacity);
+    CHECK_EQUAL(0, stack.item_count);
+}
+
+TEST(test_mat4_stack_push_top_while_growing) {
+    km_mat4_stack stack;
+    km_mat4_stack_initialize(&stack);
+
+    // Pushing the top duplicates it, as kmGLPushMatrix does. The top points into the stack's
+    // storage, which is reallocated each time the stack grows.
+    kmMat4 translation;
+    kmMat4Translation(&translation, 1, 2, 3);
+    km_mat4_stack_push(&stack, &translation);
+    const int count = KM_MAT4_STACK_CAPACITY * 2 + 88;
+    for (int i = 1; i < count; ++i) {
+        km_mat4_stack_push(&stack, stack.top);
+        km_mat4_stack_push_multiply(&stack, stack.top);
+        km_mat4_stack_pop(&stack, NULL);
+    }
+
+    CHECK_EQUAL(count, stack.item_count);
+    for (int i = count; i > 0; --i) {
+        CHECK(kmMat4AreEqual(&translation, stack.top));
+        km_mat4_stack_pop(&stack, NULL);
+    }
+
+    km_mat4_stack_release(&stack);
+}
@@ -0,0 +1,88 @@
+#include <cstdlib>
+#include <memory.h>
+#include <unittest++/UnitTest++.h>
+
+#include "../kazmath/vec3.h"
+#include "../kazmath/mat4.h"
+#include "../kazmath/utility.h"
+
+/* Scalar reference implementation used to check SIMD code paths for bit-compatibility */
+static void reference_vec3_transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
+{
+    for (int r = 0; r < 3; ++r) {
+        float v = pV->x * pM->mat[r];
+        v = v + pV->y * pM->mat[r+4];
+        v = v + pV->z * pM->mat[r+8];
+        v = v + pM->mat[r+12];
+        pOut->data[r] = v;
+    }
+}
+
+static float random_scalar()
+{
+    return (float)rand() / (float)RAND_MAX * 200.0f - 100.0f;
+}
+
+TEST(test_vec3_transform) {
+    kmVec3 orig;
+    kmVec3Fill(&orig, 0.0f, 1.0f, 0.0f);
+
+    kmMat4 translate;
+    kmMat4Translation(&translate, 1.0f, 2.0f, 3.0f);
+
+    kmVec3 result;
+    kmVec3Transform(&result, &orig, &translate);
+
+    CHECK_CLOSE(1.0f, result.x, 0.001f);
+    CHECK_CLOSE(3.0f, result.y, 0.001f);
+    CHECK_CLOSE(3.0f, result.z, 0.001f);
+}
+
+TEST(test_vec3_transform_bit_compatible) {
+    srand(1);
+    for (int i = 0; i < 1000; ++i) {
+        kmMat4 m;
+        for (int j = 0; j < 16; ++j) {
+            m.mat[j] = random_scalar();
+        }
+        kmVec3 v, expected, result;
+        kmVec3Fill(&v, random_scalar(), random_scalar(), random_scalar());
+
+        reference_vec3_transform(&expected, &v, &m);
+        kmVec3Transform(&result, &v, &m);
+        CHECK(0 == memcmp(&expected, &result, sizeof(kmVec3)));
+
+        kmVec3Transform(&v, &v, &m);
+        CHECK(0 == memcmp(&expected, &v, sizeof(kmVec3)));
+    }
+}
+
+TEST(test_vec3_transform_array) {
+    const int count = 37;
+    kmVec3 vertices[count + 1], results[count + 1];
+    kmMat4 m;
+    srand(2);
+    for (int j = 0; j < 16; ++j) {
+        m.mat[j] = random_scalar();
+    }
+    for (int i = 0; i < count; ++i) {
+        kmVec3Fill(&vertices[i], random_scalar(), random_scalar(), random_scalar());
+    }
+
+    /* Sentinel to check that nothing is written past the end of the output */
+    kmVec3Fill(&results[count], 42.0f, 42.0f, 42.0f);
+
+    CHECK(results == kmVec3TransformArray(results, vertices, count, &m));
+    for (int i = 0; i < count; ++i) {
+        kmVec3 expected;
+        reference_vec3_transform(&expected, &vertices[i], &m);
+        CHECK(0 == memcmp(&expected, &results[i], sizeof(kmVec3)));
+    }
+    CHECK_EQUAL(42.0f, results[count].x);
+    CHECK_EQUAL(42.0f, results[count].y);
+    CHECK_EQUAL(42.0f, results[count].z);
+
+    /* In place */
+    kmVec3TransformArray(vertices, vertices, count, &m);
+    CHECK(0 == memcmp(results, vertices, sizeof(kmVec3) * count));
+}
@@ -33,7 +33,10 @@
  ICAnimatedShaderProgram automatically updates that time uniform with the current
  host view controller's ICHostViewController::elapsedTime value when the program is used.
  */
-@interface ICAnimatedShaderProgram : ICShaderProgram
+@interface ICAnimatedShaderProgram : ICShaderProgram {
+@protected
+    ICShaderUniformHandle _timeUniformHandle;
+}
 
 /**
  @brief Refreshes the ``time`` value and updates the receiver's uniforms
@@ -27,10 +27,30 @@
 
 @implementation ICAnimatedShaderProgram
 
+-   (id)initWithName:(NSString *)programName
+  vertexShaderString:(NSString *)vShaderString
+fragmentShaderString:(NSString *)fShaderString
+{
+    if ((self = [super initWithName:programName
+                 vertexShaderString:vShaderString
+               fragmentShaderString:fShaderString])) {
+        _timeUniformHandle = ICShaderUniformHandleInvalid;
+    }
+    return self;
+}
+
+- (BOOL)link
+{
+    BOOL linked = [super link];
+    // Resolve the time uniform's handle once, as the time is updated whenever the program is used
+    _timeUniformHandle = [self uniformHandleForName:@"time"];
+    return linked;
+}
+
 - (void)updateUniforms
 {
     float timeValue = (float)[[ICHostViewController currentHostViewController] elapsedTime];
-    [self setShaderValue:[ICShaderValue shaderValueWithFloat:timeValue] forUniform:@"time"];
+    [self setFloat:timeValue forUniformHandle:_timeUniformHandle];
 
     [super updateUniforms];
 }
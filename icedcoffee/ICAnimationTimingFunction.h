@@ -23,6 +23,25 @@
 
 #import <Foundation/Foundation.h>
 #import "icTypes.h"
+#import "icConfig.h"
+
+/**
+ @brief Defines how ICAnimationTimingFunction interpolates between the samples of its lookup table
+ */
+typedef enum _ICTimingFunctionInterpolation {
+    /** @brief No lookup table is baked, the timing function is evaluated for each transform */
+    ICTimingFunctionInterpolationNone = 0,
+    /** @brief Linear interpolation between lookup table samples */
+    ICTimingFunctionInterpolationLinear,
+    /** @brief Monotonic cubic Hermite interpolation between lookup table samples */
+    ICTimingFunctionInterpolationCubic
+} ICTimingFunctionInterpolation;
+
+#if IC_ENABLE_TIMING_FUNCTION_LOOKUP_TABLES
+#define IC_DEFAULT_TIMING_FUNCTION_INTERPOLATION ICTimingFunctionInterpolationCubic
+#else
+#define IC_DEFAULT_TIMING_FUNCTION_INTERPOLATION ICTimingFunctionInterpolationNone
+#endif
 
 /**
  @brief Implements an animation timing function
@@ -41,11 +60,27 @@
  a couple of convenience methods to create common predefined timing functions such as
  ICAnimationTimingFunction::linearTimingFunction, ICAnimationTimingFunction::easeInTimingFunction
  or ICAnimationTimingFunction::easeOutTimingFunction.
+ 
+ Solving the bezier curve for each transform is comparatively expensive. Timing functions may
+ therefore bake a lookup table of #IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE samples when created,
+ which ICAnimationTimingFunction::transform: interpolates as defined by
+ ICAnimationTimingFunction::interpolation. Lookup tables are shared by all timing functions of
+ the same class with the same parameters, up to #IC_MAX_SHARED_TIMING_FUNCTION_LOOKUP_TABLES
+ most recently used tables. Timing functions created using the convenience
+ methods bake lookup tables if #IC_ENABLE_TIMING_FUNCTION_LOOKUP_TABLES is activated.
+ 
+ Subclasses may implement other kinds of timing functions by overriding
+ ICAnimationTimingFunction::evaluate: and ICAnimationTimingFunction::lookupTableKey. See
+ ICSpringTimingFunction and ICKeyframeTimingFunction.
  */
 @interface ICAnimationTimingFunction : NSObject {
 @protected
     kmVec2 _c0;
     kmVec2 _c1;
+    ICTimingFunctionInterpolation _interpolation;
+    NSData *_lookupTable;
+    const float *_lookupValues;
+    const float *_lookupTangents;
 }
 
 /**
@@ -77,18 +112,77 @@
  */
 + (id)timingFunctionWithControlPointsC0:(kmVec2)c0 c1:(kmVec2)c1;
 
+/**
+ @brief Returns a new autoreleased animation timing function with the given control points
+ and lookup table interpolation
+ */
++ (id)timingFunctionWithControlPointsC0:(kmVec2)c0
+                                     c1:(kmVec2)c1
+                          interpolation:(ICTimingFunctionInterpolation)interpolation;
+
 /**
  @brief Initializes the receiver with the given control points
+ 
+ The receiver bakes a lookup table if #IC_ENABLE_TIMING_FUNCTION_LOOKUP_TABLES is activated.
  */
 - (id)initWithControlPointsC0:(kmVec2)c0 c1:(kmVec2)c1;
 
+/**
+ @brief Initializes the receiver with the given control points and lookup table interpolation
+ 
+ @param c0 The first control point of the bezier curve
+ @param c1 The second control point of the bezier curve
+ @param interpolation An ICTimingFunctionInterpolation value defining whether the receiver bakes
+ a lookup table and how it interpolates between the table's samples
+ */
+- (id)initWithControlPointsC0:(kmVec2)c0
+                           c1:(kmVec2)c1
+                interpolation:(ICTimingFunctionInterpolation)interpolation;
+
 /**
  @brief Returns the transformed time factor ``y`` for a given input time factor ``x``
+ 
+ Looks up ``x`` in the receiver's lookup table if the receiver has baked one, otherwise
+ returns the result of ICAnimationTimingFunction::evaluate:.
  */
 - (icTime)transform:(icTime)x;
 
+/**
+ @brief Evaluates the receiver's timing curve for the given input time factor ``x``
+ without using its lookup table
+ 
+ Subclasses implementing other kinds of timing functions must override this method.
+ */
+- (icTime)evaluate:(icTime)x;
+
+/**
+ @brief Returns a key identifying the receiver's timing curve, used to share lookup tables
+ 
+ Timing functions returning equal keys share the same lookup table. Subclasses adding
+ parameters must override this method and include all parameters affecting
+ ICAnimationTimingFunction::evaluate: in the key, or return nil if the lookup table
+ should not be shared.
+ */
+- (NSString *)lookupTableKey;
+
+/**
+ @brief Bakes the receiver's lookup table, or releases it if the receiver's interpolation is
+ ICTimingFunctionInterpolationNone
+ 
+ Subclasses must call this method whenever parameters affecting
+ ICAnimationTimingFunction::evaluate: change.
+ */
+- (void)updateLookupTable;
+
 @property (nonatomic, assign) kmVec2 c0;
 
 @property (nonatomic, assign) kmVec2 c1;
 
+/**
+ @brief Defines how the receiver interpolates between the samples of its lookup table
+ 
+ Setting this property bakes or releases the receiver's lookup table.
+ */
+@property (nonatomic, assign) ICTimingFunctionInterpolation interpolation;
+
 @end
@@ -22,54 +22,20 @@
 //
 
 #import "ICAnimationTimingFunction.h"
+#import "icEasing.h"
 
 
-// Inspired by
-// http://blog.greweb.fr/2012/02/bezier-curve-based-easing-functions-from-concept-to-implementation/
-
-
-static float icTermA(float u, float v)
-{
-    return 1.f - 3.f * v + 3.f * u;
-}
-
-static float icTermB(float u, float v)
-{
-    return 3.f * v - 6.f * u;
-}
-
-static float icTermC(float u)
-{
-    return 3.f * u;
-}
-
-static float icBezier(float t, float u, float v)
-{
-    return ((icTermA(u, v)*t + icTermB(u, v))*t + icTermC(u))*t;
-}
-
-static float icSlope(float t, float u, float v)
-{
-    return 3.f * icTermA(u, v)*t*t + 2.f * icTermB(u, v) * t + icTermC(u);
-}
-
-static float icTForX(float x, kmVec2 c0, kmVec2 c1)
-{
-    float t = x;
-    for (int i=0; i<8; i++) {
-        float slope = icSlope(t, c0.x, c1.x);
-        if (slope == 0.f)
-            return t;
-        float currentX = icBezier(t, c0.x, c1.x) - x;
-        t -= currentX / slope;
-    }
-    return t;
-}
+// Lookup tables shared by timing functions, keyed by ICAnimationTimingFunction::lookupTableKey.
+// Each table contains IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE values followed by as many tangents.
+// s_lookupTableKeys orders keys from least to most recently used to bound the number of tables.
+static NSMutableDictionary *s_lookupTables = nil;
+static NSMutableArray *s_lookupTableKeys = nil;
 
 
 @implementation ICAnimationTimingFunction
 
 @synthesize c0=_c0, c1=_c1;
+@synthesize interpolation = _interpolation;
 
 + (id)linearTimingFunction
 {
@@ -94,24 +60,146 @@ static float icTForX(float x, kmVec2 c0, kmVec2 c1)
     return [[[[self class] alloc] initWithControlPointsC0:c0 c1:c1] autorelease];
 }
 
++ (id)timingFunctionWithControlPointsC0:(kmVec2)c0
+                                     c1:(kmVec2)c1
+                          interpolation:(ICTimingFunctionInterpolation)interpolation
+{
+    return [[[[self class] alloc] initWithControlPointsC0:c0
+                                                       c1:c1
+                                            interpolation:interpolation] autorelease];
+}
+
 - (id)initWithControlPointsC0:(kmVec2)c0 c1:(kmVec2)c1
+{
+    return [self initWithControlPointsC0:c0
+                                      c1:c1
+                           interpolation:IC_DEFAULT_TIMING_FUNCTION_INTERPOLATION];
+}
+
+- (id)initWithControlPointsC0:(kmVec2)c0
+                           c1:(kmVec2)c1
+                interpolation:(ICTimingFunctionInterpolation)interpolation
 {
     if ((self = [super init])) {
         _c0 = c0;
         _c1 = c1;
+        _interpolation = interpolation;
+        [self updateLookupTable];
     }
     return self;
 }
 
+- (void)dealloc
+{
+    [_lookupTable release];
+    [super dealloc];
+}
+
+- (void)setC0:(kmVec2)c0
+{
+    _c0 = c0;
+    [self updateLookupTable];
+}
+
+- (void)setC1:(kmVec2)c1
+{
+    _c1 = c1;
+    [self updateLookupTable];
+}
+
+- (void)setInterpolation:(ICTimingFunctionInterpolation)interpolation
+{
+    _interpolation = interpolation;
+    [self updateLookupTable];
+}
+
 - (icTime)transform:(icTime)x
+{
+    switch (_interpolation) {
+        case ICTimingFunctionInterpolationLinear:
+            if (_lookupValues)
+                return icEasingTableLookupLinear(_lookupValues, IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE,
+                                                 (float)x);
+            break;
+        case ICTimingFunctionInterpolationCubic:
+            if (_lookupValues)
+                return icEasingTableLookupCubic(_lookupValues, _lookupTangents,
+                                                IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE, (float)x);
+            break;
+        default:
+            break;
+    }
+    return [self evaluate:x];
+}
+
+- (icTime)evaluate:(icTime)x
 {
     if (_c0.x == _c0.y && _c1.x == _c1.y) {
         return x; // linear
     }
     
-    float t = icTForX(x, _c0, _c1);
-    float y = icBezier(t, _c0.y, _c1.y);
-    return y;
+    return icCubicBezierEvaluate((float)x, _c0, _c1);
+}
+
+- (NSString *)lookupTableKey
+{
+    return [NSString stringWithFormat:@"%@ %a %a %a %a", NSStringFromClass([self class]),
+            _c0.x, _c0.y, _c1.x, _c1.y];
+}
+
+- (void)updateLookupTable
+{
+    [_lookupTable release];
+    _lookupTable = nil;
+    _lookupValues = NULL;
+    _lookupTangents = NULL;
+    
+    if (_interpolation == ICTimingFunctionInterpolationNone)
+        return;
+    
+    NSString *key = [self lookupTableKey];
+    if (key) {
+        @synchronized([ICAnimationTimingFunction class]) {
+            _lookupTable = [[s_lookupTables objectForKey:key] retain];
+            if (_lookupTable) {
+                // Mark the table as most recently used
+                [s_lookupTableKeys removeObject:key];
+                [s_lookupTableKeys addObject:key];
+            }
+        }
+    }
+    
+    if (!_lookupTable) {
+        const unsigned int count = IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE;
+        NSMutableData *table = [NSMutableData dataWithLength:2 * count * sizeof(float)];
+        float *values = (float *)[table mutableBytes];
+        for (unsigned int i=0; i<count; i++) {
+            values[i] = (float)[self evaluate:(icTime)i / (icTime)(count - 1)];
+        }
+        icEasingTableComputeTangents(values + count, values, count);
+        _lookupTable = [table retain];
+        
+        if (key) {
+            @synchronized([ICAnimationTimingFunction class]) {
+                if (!s_lookupTables) {
+                    s_lookupTables = [[NSMutableDictionary alloc] init];
+                    s_lookupTableKeys = [[NSMutableArray alloc] init];
+                }
+                if (![s_lookupTables objectForKey:key]) {
+                    while ([s_lookupTableKeys count] &&
+                           [s_lookupTableKeys count] >= IC_MAX_SHARED_TIMING_FUNCTION_LOOKUP_TABLES) {
+                        [s_lookupTables removeObjectForKey:[s_lookupTableKeys objectAtIndex:0]];
+                        [s_lookupTableKeys removeObjectAtIndex:0];
+                    }
+                    [s_lookupTableKeys addObject:key];
+                }
+                [s_lookupTables setObject:_lookupTable forKey:key];
+            }
+        }
+    }
+    
+    _lookupValues = (const float *)[_lookupTable bytes];
+    _lookupTangents = _lookupValues + IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE;
 }
 
 @end
@@ -22,6 +22,30 @@
 //
 
 #import "ICPropertyAnimation.h"
+#import "icTypes.h"
+
+/**
+ @brief Value types interpolated by ICBasicAnimation without boxing
+ */
+typedef enum _ICAnimationValueType {
+    ICAnimationValueTypeUnknown = 0,
+    ICAnimationValueTypeFloat,
+    ICAnimationValueTypeDouble,
+    ICAnimationValueTypeVec2,
+    ICAnimationValueTypeVec3,
+    ICAnimationValueTypeColor4B
+} ICAnimationValueType;
+
+/**
+ @brief An unboxed value interpolated by ICBasicAnimation
+ */
+typedef union _icAnimationValue {
+    float f;
+    double d;
+    kmVec2 vec2;
+    kmVec3 vec3;
+    icColor4B color4B;
+} icAnimationValue;
 
 /**
  @brief Implements a basic node property animation
@@ -29,6 +53,13 @@
  The ICBasicAnimation class implements a basic property animation on an ICNode object.
  It allows you to animate a given property value from a ICBasicAnimation::fromValue to
  a ICBasicAnimation::toValue within a certain ICBasicAnimation::duration.
+ 
+ Values may be NSNumber objects holding a float or double or NSValue objects holding a kmVec2,
+ kmVec3 or icColor4B. They are unboxed once when set and interpolated without creating any
+ objects. If the animation's key path is a single key, such as ``position``, ``scale``,
+ ``size``, ``rotationAngle`` or ``color``, and the target's class implements a setter for
+ that key taking the values' type, the animation calls the setter directly. The setter is
+ looked up once per target class. Other key paths are applied using key value coding.
  */
 @interface ICBasicAnimation : ICPropertyAnimation {
 @protected
@@ -37,6 +68,13 @@
     icTime _duration;
     icTime _currentDeltaTime;
     BOOL _isAnimating;
+    
+    ICAnimationValueType _valueType;
+    icAnimationValue _from;
+    icAnimationValue _to;
+    Class _boundClass;
+    SEL _setterSelector;
+    IMP _setter;
 }
 
 @property (nonatomic, retain) id fromValue;
@@ -21,16 +21,32 @@
 //  SOFTWARE.
 //
 
+#import <objc/runtime.h>
 #import "ICBasicAnimation.h"
 #import "ICNode.h"
 
-#define ANIMATE_NUMBER_PROPERTY(primitiveType, getterMethod, creationMethod, timeFactor) \
-    primitiveType from = [self.fromValue getterMethod]; \
-    primitiveType to = [self.toValue getterMethod]; \
-    primitiveType value = from + timeFactor * (to - from); \
-    [target setValue:[NSNumber creationMethod:value] forKeyPath:self.keyPath];
+#define INTERPOLATE(from, to, timeFactor) ((from) + (timeFactor) * ((to) - (from)))
 
 
+static const char *icAnimationValueTypeEncoding(ICAnimationValueType valueType)
+{
+    switch (valueType) {
+        case ICAnimationValueTypeFloat: return @encode(float);
+        case ICAnimationValueTypeDouble: return @encode(double);
+        case ICAnimationValueTypeVec2: return @encode(kmVec2);
+        case ICAnimationValueTypeVec3: return @encode(kmVec3);
+        case ICAnimationValueTypeColor4B: return @encode(icColor4B);
+        default: return NULL;
+    }
+}
+
+
+@interface ICBasicAnimation (Private)
+- (void)updateValueType;
+- (void)bindToTargetClass:(Class)targetClass;
+- (void)applyValue:(const icAnimationValue *)value toTarget:(ICNode *)target;
+@end
+
 @implementation ICBasicAnimation
 
 @synthesize fromValue = _fromValue;
@@ -53,6 +69,26 @@
     [super dealloc];
 }
 
+- (void)setKeyPath:(NSString *)keyPath
+{
+    [super setKeyPath:keyPath];
+    _boundClass = nil;
+}
+
+- (void)setFromValue:(id)fromValue
+{
+    [_fromValue release];
+    _fromValue = [fromValue retain];
+    [self updateValueType];
+}
+
+- (void)setToValue:(id)toValue
+{
+    [_toValue release];
+    _toValue = [toValue retain];
+    [self updateValueType];
+}
+
 - (void)processAnimationWithTarget:(ICNode *)target deltaTime:(icTime)dt
 {
     NSAssert(self.keyPath != nil, @"keyPath must not be nil");
@@ -74,71 +110,166 @@
     if (self.timingFunction) {
         timeFactor = [self.timingFunction transform:timeFactor];
     }
+    
+    icAnimationValue value;
+    switch (_valueType) {
+        case ICAnimationValueTypeFloat:
+            value.f = INTERPOLATE(_from.f, _to.f, (float)timeFactor);
+            break;
+        case ICAnimationValueTypeDouble:
+            value.d = INTERPOLATE(_from.d, _to.d, timeFactor);
+            break;
+        case ICAnimationValueTypeVec2:
+            value.vec2.x = INTERPOLATE(_from.vec2.x, _to.vec2.x, timeFactor);
+            value.vec2.y = INTERPOLATE(_from.vec2.y, _to.vec2.y, timeFactor);
+            break;
+        case ICAnimationValueTypeVec3:
+            value.vec3.x = INTERPOLATE(_from.vec3.x, _to.vec3.x, timeFactor);
+            value.vec3.y = INTERPOLATE(_from.vec3.y, _to.vec3.y, timeFactor);
+            value.vec3.z = INTERPOLATE(_from.vec3.z, _to.vec3.z, timeFactor);
+            break;
+        case ICAnimationValueTypeColor4B: {
+            float t = (float)timeFactor;
+            value.color4B.r = (float)_from.color4B.r + t * (float)(_to.color4B.r - _from.color4B.r);
+            value.color4B.g = (float)_from.color4B.g + t * (float)(_to.color4B.g - _from.color4B.g);
+            value.color4B.b = (float)_from.color4B.b + t * (float)(_to.color4B.b - _from.color4B.b);
+            value.color4B.a = (float)_from.color4B.a + t * (float)(_to.color4B.a - _from.color4B.a);
+            break;
+        }
+        default:
+            break;
+    }
+    
+    if (_valueType != ICAnimationValueTypeUnknown) {
+        [self applyValue:&value toTarget:target];
+    }
+    
+    if (_currentDeltaTime >= _duration) {
+        _isFinished = YES;
+        _isAnimating = NO;
+        if ([self.delegate respondsToSelector:@selector(animationDidStop:finished:)])
+            [self.delegate animationDidStop:self finished:YES];
+    }
+}
+
+@end
+
 
-    if ([self.fromValue isKindOfClass:[NSNumber class]] &&
-        [self.toValue isKindOfClass:[NSNumber class]]) {
+@implementation ICBasicAnimation (Private)
+
+// Unboxes fromValue and toValue, leaving the value type unknown if they are not of the
+// same supported type
+- (void)updateValueType
+{
+    _valueType = ICAnimationValueTypeUnknown;
+    _boundClass = nil;
+    
+    if (!_fromValue || !_toValue)
+        return;
+    
+    if ([_fromValue isKindOfClass:[NSNumber class]] &&
+        [_toValue isKindOfClass:[NSNumber class]]) {
         
-        if (0 == strcmp([self.fromValue objCType], "f")) {
-            ANIMATE_NUMBER_PROPERTY(float, floatValue, numberWithFloat, timeFactor);
-        } else if (0 == strcmp([self.fromValue objCType], "d")) {
-            ANIMATE_NUMBER_PROPERTY(double, doubleValue, numberWithDouble, timeFactor);
+        if (0 == strcmp([_fromValue objCType], @encode(float))) {
+            _valueType = ICAnimationValueTypeFloat;
+            _from.f = [_fromValue floatValue];
+            _to.f = [_toValue floatValue];
+        } else if (0 == strcmp([_fromValue objCType], @encode(double))) {
+            _valueType = ICAnimationValueTypeDouble;
+            _from.d = [_fromValue doubleValue];
+            _to.d = [_toValue doubleValue];
         }
         
-    } else if ([self.fromValue isKindOfClass:[NSValue class]] &&
-               [self.toValue isKindOfClass:[NSValue class]]) {
+    } else if ([_fromValue isKindOfClass:[NSValue class]] &&
+               [_toValue isKindOfClass:[NSValue class]]) {
         
-        const char *objCType = [self.fromValue objCType];
-        const char *objCTypeTo = [self.toValue objCType];
-        NSAssert(0 == strcmp(objCType, objCTypeTo),
+        const char *objCType = [_fromValue objCType];
+        NSAssert(0 == strcmp(objCType, [_toValue objCType]),
                  @"objCType of fromValue and toValue must match");
         
-        const char *vec2Type = @encode(kmVec2);
-        const char *vec3Type = @encode(kmVec3);
-        const char *color4BType = @encode(icColor4B);
-        
-        if (0 == strcmp(objCType, vec3Type)) {
-            
-            kmVec3 value, from, to;
-            [self.fromValue getValue:&from];
-            [self.toValue getValue:&to];
-            value.x = from.x + timeFactor * (to.x - from.x);
-            value.y = from.y + timeFactor * (to.y - from.y);
-            value.z = from.z + timeFactor * (to.z - from.z);
-            [target setValue:[NSValue valueWithBytes:&value objCType:vec3Type]
-                  forKeyPath:self.keyPath];
-            
-        } else if(0 == strcmp(objCType, vec2Type)) {
-            
-            kmVec2 value, from, to;
-            [self.fromValue getValue:&from];
-            [self.toValue getValue:&to];
-            value.x = from.x + timeFactor * (to.x - from.x);
-            value.y = from.y + timeFactor * (to.y - from.y);
-            [target setValue:[NSValue valueWithBytes:&value objCType:vec2Type]
-                  forKeyPath:self.keyPath];
-            
-        } else if(0 == strcmp(objCType, color4BType)) {
-            
-            icColor4B value, from, to;
-            [self.fromValue getValue:&from];
-            [self.toValue getValue:&to];
-            value.r = (float)from.r + (float)timeFactor * (float)(to.r - from.r);
-            value.g = (float)from.g + (float)timeFactor * (float)(to.g - from.g);
-            value.b = (float)from.b + (float)timeFactor * (float)(to.b - from.b);
-            value.a = (float)from.a + (float)timeFactor * (float)(to.a - from.a);
-            [target setValue:[NSValue valueWithBytes:&value objCType:color4BType]
-                  forKeyPath:self.keyPath];
-            
+        for (ICAnimationValueType valueType = ICAnimationValueTypeVec2;
+             valueType <= ICAnimationValueTypeColor4B;
+             valueType++) {
+            if (0 == strcmp(objCType, icAnimationValueTypeEncoding(valueType))) {
+                _valueType = valueType;
+                [_fromValue getValue:&_from];
+                [_toValue getValue:&_to];
+                break;
+            }
         }
-        
     }
+}
+
+// Binds the animation to the setter for keyPath if targetClass implements one taking the
+// animation's value type, which is equivalent to what key value coding would call
+- (void)bindToTargetClass:(Class)targetClass
+{
+    _boundClass = targetClass;
+    _setter = NULL;
     
-    if (_currentDeltaTime >= _duration) {
-        _isFinished = YES;
-        _isAnimating = NO;
-        if ([self.delegate respondsToSelector:@selector(animationDidStop:finished:)])
-            [self.delegate animationDidStop:self finished:YES];
+    NSString *key = _keyPath;
+    if (![key length] || [key rangeOfString:@"."].location != NSNotFound)
+        return;
+    
+    NSString *setterName = [NSString stringWithFormat:@"set%@%@:",
+                            [[key substringToIndex:1] uppercaseString],
+                            [key substringFromIndex:1]];
+    SEL selector = NSSelectorFromString(setterName);
+    Method method = class_getInstanceMethod(targetClass, selector);
+    if (!method || method_getNumberOfArguments(method) != 3)
+        return;
+    
+    char argumentType[256];
+    method_getArgumentType(method, 2, argumentType, sizeof(argumentType));
+    if (0 == strcmp(argumentType, icAnimationValueTypeEncoding(_valueType))) {
+        _setterSelector = selector;
+        _setter = method_getImplementation(method);
+    }
+}
+
+- (void)applyValue:(const icAnimationValue *)value toTarget:(ICNode *)target
+{
+    if (object_getClass(target) != _boundClass)
+        [self bindToTargetClass:object_getClass(target)];
+    
+    if (_setter) {
+        switch (_valueType) {
+            case ICAnimationValueTypeFloat:
+                ((void (*)(id, SEL, float))_setter)(target, _setterSelector, value->f);
+                break;
+            case ICAnimationValueTypeDouble:
+                ((void (*)(id, SEL, double))_setter)(target, _setterSelector, value->d);
+                break;
+            case ICAnimationValueTypeVec2:
+                ((void (*)(id, SEL, kmVec2))_setter)(target, _setterSelector, value->vec2);
+                break;
+            case ICAnimationValueTypeVec3:
+                ((void (*)(id, SEL, kmVec3))_setter)(target, _setterSelector, value->vec3);
+                break;
+            case ICAnimationValueTypeColor4B:
+                ((void (*)(id, SEL, icColor4B))_setter)(target, _setterSelector, value->color4B);
+                break;
+            default:
+                break;
+        }
+        return;
+    }
+    
+    // Arbitrary key paths fall back to key value coding
+    id boxedValue;
+    switch (_valueType) {
+        case ICAnimationValueTypeFloat:
+            boxedValue = [NSNumber numberWithFloat:value->f];
+            break;
+        case ICAnimationValueTypeDouble:
+            boxedValue = [NSNumber numberWithDouble:value->d];
+            break;
+        default:
+            boxedValue = [NSValue valueWithBytes:value
+                                        objCType:icAnimationValueTypeEncoding(_valueType)];
+            break;
     }
+    [target setValue:boxedValue forKeyPath:self.keyPath];
 }
 
 @end
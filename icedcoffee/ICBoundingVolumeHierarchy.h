@@ -0,0 +1,94 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import <Foundation/Foundation.h>
+#import "icTypes.h"
+#import "kazmath/aabb.h"
+
+/**
+ @brief Block type used to enumerate boxes intersected by a ray
+ 
+ @param index The index of the intersected box in the array the hierarchy was built from
+ @param distance The ray parameter at which the ray enters the box, where 0 corresponds to the
+ ray's origin and 1 to the point defined by the ray's direction member
+ */
+typedef void (^ICBoundingVolumeHierarchyRayBlock)(uint index, float distance);
+
+/**
+ @brief Defines a static bounding volume hierarchy of axis-aligned bounding boxes
+ 
+ ICBoundingVolumeHierarchy organizes a set of axis-aligned bounding boxes in a binary tree of
+ enclosing boxes, allowing for ray queries in logarithmic rather than linear time. The hierarchy
+ is built once from an array of boxes and cannot be modified afterwards. If the boxes change,
+ a new hierarchy must be built. Building is done by recursively splitting the set of boxes at
+ the median of their centers along the longest axis of the enclosing box, which is fast and
+ yields a balanced tree.
+ 
+ The hierarchy is used by ICScene to maintain a spatial index of its nodes for ray-based
+ picking (see ICNodeVisitorRayPicking).
+ */
+@interface ICBoundingVolumeHierarchy : NSObject {
+@protected
+    kmAABB *_boxes;
+    uint *_indices;
+    void *_nodes;
+    uint _count;
+    uint _nodeCount;
+}
+
+
+#pragma mark - Creating a Bounding Volume Hierarchy
+/** @name Creating a Bounding Volume Hierarchy */
+
+/**
+ @brief Initializes the receiver with the given boxes
+ 
+ @param boxes A C array of kmAABB structs. The receiver copies the boxes, so the array may be
+ freed after initialization.
+ @param count The number of boxes in the given array
+ */
+- (id)initWithBoxes:(const kmAABB *)boxes count:(uint)count;
+
+
+#pragma mark - Querying the Hierarchy
+/** @name Querying the Hierarchy */
+
+/**
+ @brief The number of boxes stored in the receiver
+ */
+@property (nonatomic, readonly) uint count;
+
+/**
+ @brief Enumerates all boxes intersected by the given ray
+ 
+ @param ray An icRay3 defining the ray to test the receiver's boxes with. As with rays computed
+ by ICScene::worldRayFromFramebufferLocation:, the ``direction`` member of the ray is interpreted
+ as a second point on the ray rather than a direction vector. Only the segment between
+ ``origin`` and ``direction`` is tested, which for rays unprojected from a framebuffer location
+ corresponds to the visible range between the camera's near and far clipping planes.
+ @param block A block called once for each intersected box. Boxes are not enumerated in any
+ particular order.
+ */
+- (void)enumerateBoxesIntersectingRay:(icRay3)ray usingBlock:(ICBoundingVolumeHierarchyRayBlock)block;
+
+@end
@@ -0,0 +1,226 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import "ICBoundingVolumeHierarchy.h"
+
+// Maximum number of boxes stored in a leaf node
+#define IC_BVH_MAX_LEAF_SIZE 4
+
+// Maximum depth of the hierarchy. Median splits halve the number of boxes per level, so this
+// is never reached for any realistic number of boxes.
+#define IC_BVH_MAX_DEPTH 64
+
+typedef struct _icBVHNode {
+    kmAABB aabb;
+    uint first; // index of the first entry for leaves, index of the left child for inner nodes
+    uint count; // number of entries for leaves, zero for inner nodes
+} icBVHNode;
+
+static inline float icAABBCenterComponent(const kmAABB *aabb, int axis)
+{
+    return (((float *)&aabb->min)[axis] + ((float *)&aabb->max)[axis]) * 0.5f;
+}
+
+static kmAABB icEnclosingAABB(const kmAABB *boxes, const uint *indices, uint count)
+{
+    kmAABB result = boxes[indices[0]];
+    uint i;
+    for (i=1; i<count; i++) {
+        const kmAABB *box = &boxes[indices[i]];
+        result.min.x = MIN(result.min.x, box->min.x);
+        result.min.y = MIN(result.min.y, box->min.y);
+        result.min.z = MIN(result.min.z, box->min.z);
+        result.max.x = MAX(result.max.x, box->max.x);
+        result.max.y = MAX(result.max.y, box->max.y);
+        result.max.z = MAX(result.max.z, box->max.z);
+    }
+    return result;
+}
+
+// Partially sorts indices so that the element at nth is the one that would be there if the
+// indices were fully sorted by box center along the given axis (Hoare's quickselect)
+static void icSelectByCenter(const kmAABB *boxes, uint *indices, uint count, uint nth, int axis)
+{
+    uint left = 0, right = count - 1;
+    while (left < right) {
+        float pivot = icAABBCenterComponent(&boxes[indices[(left + right) / 2]], axis);
+        uint i = left, j = right;
+        while (i <= j) {
+            while (icAABBCenterComponent(&boxes[indices[i]], axis) < pivot) i++;
+            while (icAABBCenterComponent(&boxes[indices[j]], axis) > pivot) j--;
+            if (i <= j) {
+                uint tmp = indices[i];
+                indices[i] = indices[j];
+                indices[j] = tmp;
+                i++;
+                if (j == 0)
+                    break;
+                j--;
+            }
+        }
+        if (nth <= j)
+            right = j;
+        else if (nth >= i)
+            left = i;
+        else
+            break;
+    }
+}
+
+// Returns the ray parameter at which the ray enters the box, or a negative value if the
+// segment [0,1] of the ray does not intersect the box (slab test)
+static inline float icRaySegmentIntersectsAABB(const kmVec3 *origin, const kmVec3 *delta,
+                                               const kmAABB *aabb)
+{
+    float tmin = 0, tmax = 1;
+    int axis;
+    for (axis=0; axis<3; axis++) {
+        float o = ((const float *)origin)[axis];
+        float d = ((const float *)delta)[axis];
+        float bmin = ((const float *)&aabb->min)[axis];
+        float bmax = ((const float *)&aabb->max)[axis];
+        if (fabsf(d) < kmEpsilon) {
+            // Ray is parallel to the slab
+            if (o < bmin || o > bmax)
+                return -1;
+        } else {
+            float t1 = (bmin - o) / d;
+            float t2 = (bmax - o) / d;
+            if (t1 > t2) {
+                float tmp = t1; t1 = t2; t2 = tmp;
+            }
+            tmin = MAX(tmin, t1);
+            tmax = MIN(tmax, t2);
+            if (tmin > tmax)
+                return -1;
+        }
+    }
+    return tmin;
+}
+
+
+@interface ICBoundingVolumeHierarchy (Private)
+- (void)buildNode:(uint)nodeIndex first:(uint)first count:(uint)count;
+@end
+
+@implementation ICBoundingVolumeHierarchy
+
+@synthesize count = _count;
+
+- (id)initWithBoxes:(const kmAABB *)boxes count:(uint)count
+{
+    if ((self = [super init])) {
+        _count = count;
+        if (_count) {
+            _boxes = malloc(sizeof(kmAABB) * _count);
+            memcpy(_boxes, boxes, sizeof(kmAABB) * _count);
+            _indices = malloc(sizeof(uint) * _count);
+            uint i;
+            for (i=0; i<_count; i++) {
+                _indices[i] = i;
+            }
+            // A binary tree with at least one box per leaf has less than 2n nodes
+            _nodes = malloc(sizeof(icBVHNode) * 2 * _count);
+            _nodeCount = 1;
+            [self buildNode:0 first:0 count:_count];
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_boxes);
+    free(_indices);
+    free(_nodes);
+    [super dealloc];
+}
+
+- (void)buildNode:(uint)nodeIndex first:(uint)first count:(uint)count
+{
+    icBVHNode *node = &((icBVHNode *)_nodes)[nodeIndex];
+    node->aabb = icEnclosingAABB(_boxes, &_indices[first], count);
+    
+    if (count <= IC_BVH_MAX_LEAF_SIZE) {
+        node->first = first;
+        node->count = count;
+        return;
+    }
+    
+    // Split at the median box center along the longest axis of the enclosing box
+    kmVec3 extent;
+    kmVec3Subtract(&extent, &node->aabb.max, &node->aabb.min);
+    int axis = 0;
+    if (extent.y > extent.x)
+        axis = 1;
+    if (extent.z > ((float *)&extent)[axis])
+        axis = 2;
+    
+    uint leftCount = count / 2;
+    icSelectByCenter(_boxes, &_indices[first], count, leftCount, axis);
+    
+    uint leftIndex = _nodeCount;
+    _nodeCount += 2;
+    node->first = leftIndex;
+    node->count = 0;
+    
+    [self buildNode:leftIndex first:first count:leftCount];
+    [self buildNode:leftIndex + 1 first:first + leftCount count:count - leftCount];
+}
+
+- (void)enumerateBoxesIntersectingRay:(icRay3)ray usingBlock:(ICBoundingVolumeHierarchyRayBlock)block
+{
+    if (!_count)
+        return;
+    
+    kmVec3 delta;
+    kmVec3Subtract(&delta, &ray.direction, &ray.origin);
+    
+    const icBVHNode *nodes = (const icBVHNode *)_nodes;
+    uint stack[IC_BVH_MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    
+    while (stackSize > 0) {
+        const icBVHNode *node = &nodes[stack[--stackSize]];
+        if (icRaySegmentIntersectsAABB(&ray.origin, &delta, &node->aabb) < 0)
+            continue;
+        
+        if (node->count) {
+            uint i;
+            for (i=node->first; i<node->first + node->count; i++) {
+                uint index = _indices[i];
+                float distance = icRaySegmentIntersectsAABB(&ray.origin, &delta, &_boxes[index]);
+                if (distance >= 0) {
+                    block(index, distance);
+                }
+            }
+        } else {
+            NSAssert(stackSize + 2 <= IC_BVH_MAX_DEPTH, @"Bounding volume hierarchy too deep");
+            stack[stackSize++] = node->first;
+            stack[stackSize++] = node->first + 1;
+        }
+    }
+}
+
+@end
@@ -63,6 +63,8 @@ typedef uint ICOSVersion;
 	BOOL			_supportsBGRA8888;
 	BOOL			_supportsDiscardFramebuffer;
     BOOL            _supportsPixelBufferObject;
+    BOOL            _supportsVertexArrayObject;
+    BOOL            _supportsTimerQuery;
 	unsigned int	_OSVersion;
 	GLint			_maxSamplesAllowed;
 }
@@ -106,6 +108,14 @@ typedef uint ICOSVersion;
  */
 @property (nonatomic, readonly) BOOL supportsPixelBufferObject;
 
+/** @brief Whether or not OpenGL supports VAOs (Vertex Array Objects)
+ */
+@property (nonatomic, readonly) BOOL supportsVertexArrayObject;
+
+/** @brief Whether or not OpenGL supports timer queries for measuring GPU time
+ */
+@property (nonatomic, readonly) BOOL supportsTimerQuery;
+
 /**
  @brief Whether the system supports CoreVideo texture caches
  */
@@ -43,6 +43,8 @@
 @synthesize supportsBGRA8888 = _supportsBGRA8888;
 @synthesize supportsDiscardFramebuffer = _supportsDiscardFramebuffer;
 @synthesize supportsPixelBufferObject = _supportsPixelBufferObject;
+@synthesize supportsVertexArrayObject = _supportsVertexArrayObject;
+@synthesize supportsTimerQuery = _supportsTimerQuery;
 @synthesize OSVersion = _OSVersion;
 
 //
@@ -139,6 +141,18 @@ static char * glExtensions;
         
         _supportsPixelBufferObject = [self checkForGLExtension:@"GL_ARB_pixel_buffer_object"];
         
+#ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
+        _supportsVertexArrayObject = [self checkForGLExtension:@"GL_OES_vertex_array_object"];
+#elif defined(__MAC_OS_X_VERSION_MAX_ALLOWED)
+        _supportsVertexArrayObject = [self checkForGLExtension:@"GL_APPLE_vertex_array_object"];
+#endif
+        
+#ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
+        _supportsTimerQuery = NO; // OpenGL ES 2 on iOS does not expose timer queries
+#elif defined(__MAC_OS_X_VERSION_MAX_ALLOWED)
+        _supportsTimerQuery = [self checkForGLExtension:@"GL_EXT_timer_query"];
+#endif
+        
 		NSLog(@"icedcoffee: GL_MAX_TEXTURE_SIZE: %d", _maxTextureSize);
 		NSLog(@"icedcoffee: GL_MAX_SAMPLES: %d", _maxSamplesAllowed);
 		NSLog(@"icedcoffee: GL supports PVRTC: %s", (_supportsPVRTC ? "YES" : "NO") );
@@ -146,6 +160,8 @@ static char * glExtensions;
 		NSLog(@"icedcoffee: GL supports NPOT textures: %s", (_supportsNPOT ? "YES" : "NO") );
 		NSLog(@"icedcoffee: GL supports discard_framebuffer: %s", (_supportsDiscardFramebuffer ? "YES" : "NO") );
 		NSLog(@"icedcoffee: GL supports ARB_pixel_buffer_object: %s", (_supportsPixelBufferObject ? "YES" : "NO") );
+		NSLog(@"icedcoffee: GL supports vertex_array_object: %s", (_supportsVertexArrayObject ? "YES" : "NO") );
+		NSLog(@"icedcoffee: GL supports timer_query: %s", (_supportsTimerQuery ? "YES" : "NO") );
 		
 		IC_CHECK_GL_ERROR_DEBUG();
 	}
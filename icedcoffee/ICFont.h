@@ -23,6 +23,7 @@
 
 #import <Foundation/Foundation.h>
 #import <CoreText/CoreText.h>
+#import "icTextBackend.h"
 
 /**
  @brief Defines the default system font size in points used by ICFont::systemFontWithDefaultSize
@@ -38,6 +39,7 @@
 @interface ICFont : NSObject {
 @protected
     CTFontRef _fontRef;
+    icTextFace *_textFace;
     NSString *_name;
     CGFloat _size;
 }
@@ -81,6 +83,16 @@
  */
 @property (nonatomic, readonly) CTFontRef fontRef;
 
+/**
+ @brief The text backend used to rasterize the receiver's glyphs
+ */
+- (const icTextBackend *)textBackend;
+
+/**
+ @brief The face representing the receiver in its ICFont::textBackend
+ */
+- (icTextFace *)textFace;
+
 - (CGFloat)sizeInPixels;
 
 @end
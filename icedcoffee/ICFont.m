@@ -147,6 +147,20 @@
     _fontRef = fontRef;
     if (_fontRef)
         CFRetain(_fontRef);
+    
+    // Create the text face eagerly, as glyphs may be rasterized on worker threads
+    [self textBackend]->releaseFace(_textFace);
+    _textFace = _fontRef ? icTextFaceCreateWithCTFont(_fontRef) : NULL;
+}
+
+- (const icTextBackend *)textBackend
+{
+    return icTextBackendCoreText();
+}
+
+- (icTextFace *)textFace
+{
+    return _textFace;
 }
 
 - (NSString *)description
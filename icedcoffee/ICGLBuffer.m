@@ -22,6 +22,7 @@
 //
 
 #import "ICGLBuffer.h"
+#import "icGLState.h"
 
 @implementation ICGLBuffer
 
@@ -38,10 +39,9 @@
 {
     if ((self = [super init])) {
         glGenBuffers(1, &_bo);
-        glBindBuffer(target, _bo);
+        icGLBindBuffer(target, _bo);
         GLsizeiptr size = count * stride;
         glBufferData(target, size, data, usage);
-        glBindBuffer(target, 0);
         
         _target = target;
         _count = count;
@@ -52,18 +52,18 @@
 
 - (void)dealloc
 {
-    glDeleteBuffers(1, &_bo);
+    icGLDeleteBuffer(_bo);
     [super dealloc];
 }
 
 - (void)bind
 {
-    glBindBuffer(_target, _bo);
+    icGLBindBuffer(_target, _bo);
 }
 
 - (void)unbind
 {
-    glBindBuffer(_target, 0);
+    icGLBindBuffer(_target, 0);
 }
 
 @end
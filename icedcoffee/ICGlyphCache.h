@@ -28,18 +28,21 @@
 @class ICFont;
 @class ICTextureGlyph;
 
-// TODO: asynchronous caching
-
 /**
  @brief Implements a CoreText/OpenGL based font glyph cache
  
  The ICGlyphCache class extracts font glyphs using CoreText, packs them in suitable texture
  atlases and uploads them to OpenGL textures as required by the framework to draw text.
  
- ICGlyphCache employs a Skyline-BL rectangle bin packing algorithm to pack glyphs into texture
- atlases. The size of the textures storing those atlases may be controlled using the
- ICGlyphCache::textureSize property. By default, ICGlyphCache will pack glyphs into 1024x1024
- pixel textures.
+ ICGlyphCache employs a rectangle bin packing algorithm to pack glyphs into texture atlases.
+ The algorithm may be chosen using the ICGlyphCache::packingStrategy property. The size of the
+ textures storing those atlases may be controlled using the ICGlyphCache::textureSize property.
+ By default, ICGlyphCache will pack glyphs into 1024x1024 pixel textures.
+ 
+ Up to ``IC_GLYPH_CACHE_MAX_OPEN_ATLASES`` texture atlases are kept open for adding glyphs.
+ When a glyph does not fit into the most recently allocated atlas, the cache tries to place it
+ in the older open atlases before allocating a new one, so that glyphs of differing sizes fill
+ the gaps left in previous atlases.
  */
 @interface ICGlyphCache : NSObject {
 @protected
@@ -47,6 +50,17 @@
     NSMutableDictionary *_textureGlyphs;
     // Textures used by the glyph cache
     NSMutableArray *_textures;
+    // Textures still accepting glyphs, oldest first
+    NSMutableArray *_openTextures;
+    // Packing strategy to use when allocating new texture atlases
+    ICGlyphPackingStrategy _packingStrategy;
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+    // Sets of glyph keys currently being rasterized, by font name
+    NSMutableDictionary *_pendingGlyphs;
+    // Glyphs rasterized by worker threads, waiting to be committed to texture atlases
+    NSMutableArray *_rasterizedGlyphs;
+    dispatch_queue_t _rasterizedGlyphsQueue;
+#endif
     // Size to use when allocating new texture atlases
     CGSize _textureSize;
 }
@@ -127,6 +141,44 @@
                                                       font:(ICFont *)font;
 
 
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+
+/** @name Rasterizing Glyphs Asynchronously */
+
+/**
+ @brief Requests the given glyphs to be cached asynchronously
+ 
+ @param glyphs A C-array with ICGlyph values defining the glyphs to request
+ @param offsets A C-array with the subpixel offsets of the glyphs to request
+ @param count The number of glyphs stored in the given C-arrays
+ @param font An ICFont representing the font to extract glyphs from
+ 
+ Glyphs which are neither cached nor already requested are rasterized in parallel on
+ background queues. The resulting bitmaps are added to the receiver's texture atlases when
+ ICGlyphCache::commitRasterizedGlyphs is called on the render thread. Once rasterization is
+ complete, the host view controller which was current when the glyphs were requested is
+ asked to redraw its scene.
+ 
+ @return Returns ``YES`` if all given glyphs are already cached, ``NO`` otherwise.
+ */
+- (BOOL)requestGlyphs:(ICGlyph *)glyphs
+              offsets:(float *)offsets
+                count:(NSInteger)count
+                 font:(ICFont *)font;
+
+/**
+ @brief Adds all glyphs rasterized asynchronously since the last call to the receiver's
+ texture atlases
+ 
+ This method must be called on the thread of the OpenGL context the receiver belongs to.
+ Each texture atlas affected by the committed glyphs is uploaded once. ICHostViewController
+ calls this method at the beginning of each frame.
+ */
+- (void)commitRasterizedGlyphs;
+
+#endif
+
+
 /** @name Purging a Glyph Cache */
 
 /**
@@ -152,4 +204,20 @@
  */
 @property (nonatomic, readonly) CGSize textureSize;
 
+/**
+ @brief The packing strategy used by the receiver to place glyphs in new texture atlases
+ 
+ Defaults to ``IC_DEFAULT_GLYPH_PACKING_STRATEGY``. Changing this property does not affect
+ texture atlases which have already been allocated.
+ */
+@property (nonatomic, assign) ICGlyphPackingStrategy packingStrategy;
+
+/**
+ @brief The ratio of the area occupied by glyphs to the total area of all texture atlases used
+ by the receiver
+ 
+ See ICGlyphTextureAtlas::occupancy.
+ */
+- (float)occupancy;
+
 @end
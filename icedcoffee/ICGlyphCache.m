@@ -31,11 +31,25 @@
 #import "icMacros.h"
 #import "icConfig.h"
 #import "ICFontCache.h"
+#import "ICProfiler.h"
+
+
+#if IC_USE_SDF_GLYPHS
+#if IC_GLYPH_CACHE_TEXTURE_DEPTH != 1
+#error Signed distance field glyphs require IC_GLYPH_CACHE_TEXTURE_DEPTH to be set to 1
+#endif
+#define IC_GLYPH_BITMAP_MARGIN IC_SDF_GLYPH_SPREAD
+#else
+#define IC_GLYPH_BITMAP_MARGIN IC_GLYPH_RECTANGLE_MARGIN
+#endif
 
 
 float icValidateSubpixelOffset(float offset)
 {
-#if IC_USE_EXTRA_SUBPIXEL_GLYPHS
+#if IC_USE_SDF_GLYPHS
+    // Distance field glyphs are sampled bilinearly at arbitrary positions
+    return 0;
+#elif IC_USE_EXTRA_SUBPIXEL_GLYPHS
     if (ICContentScaleFactor() == 1.f) {
         // Legal offset values for SD displays are 0.33, 0.66 and 0
         return (offset != 0.33f && offset != 0.66f && offset != 0.f) ? 0.0f : offset;
@@ -48,6 +62,112 @@ float icValidateSubpixelOffset(float offset)
 }
 
 
+#if IC_USE_SDF_GLYPHS
+
+// Squared distance of pixels not yet reached by the distance transform; chosen small enough
+// that sums with squared pixel distances do not overflow
+#define IC_SDF_INFINITY 1.0e+20f
+
+// Returns the font whose glyphs are rendered to serve all sizes of the given font's face
+static ICFont *icReferenceFontForFont(ICFont *font)
+{
+    if ([font sizeInPixels] == IC_SDF_GLYPH_REFERENCE_SIZE) {
+        return font;
+    }
+    CTFontRef ctFont = CTFontCreateCopyWithAttributes(font.fontRef, IC_SDF_GLYPH_REFERENCE_SIZE,
+                                                      NULL, NULL);
+    ICFont *referenceFont = [ICFont fontWithCoreTextFont:ctFont];
+    CFRelease(ctFont);
+    return referenceFont;
+}
+
+// One-dimensional squared Euclidean distance transform of the sampled function f
+// (Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions")
+static void icDistanceTransform1D(const float *f, float *d, int *v, float *z, int n)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -IC_HUGE;
+    z[1] = IC_HUGE;
+    for (int q=1; q<n; q++) {
+        float s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k+1] = IC_HUGE;
+    }
+    k = 0;
+    for (int q=0; q<n; q++) {
+        while (z[k+1] < q) {
+            k++;
+        }
+        d[q] = (q - v[k])*(q - v[k]) + f[v[k]];
+    }
+}
+
+// Two-dimensional squared Euclidean distance transform of grid, performed in place
+static void icDistanceTransform2D(float *grid, int width, int height)
+{
+    int n = MAX(width, height);
+    float *f = (float *)malloc(sizeof(float) * n);
+    float *d = (float *)malloc(sizeof(float) * n);
+    float *z = (float *)malloc(sizeof(float) * (n + 1));
+    int *v = (int *)malloc(sizeof(int) * n);
+    
+    for (int x=0; x<width; x++) {
+        for (int y=0; y<height; y++) {
+            f[y] = grid[y * width + x];
+        }
+        icDistanceTransform1D(f, d, v, z, height);
+        for (int y=0; y<height; y++) {
+            grid[y * width + x] = d[y];
+        }
+    }
+    for (int y=0; y<height; y++) {
+        icDistanceTransform1D(grid + y * width, d, v, z, width);
+        memcpy(grid + y * width, d, sizeof(float) * width);
+    }
+    
+    free(f);
+    free(d);
+    free(z);
+    free(v);
+}
+
+// Converts an 8-bit glyph coverage bitmap to a signed distance field in place. Distances are
+// positive inside the glyph and mapped from [-spread, spread] to [0, 255], so that the glyph's
+// outline lies at the value 127.5.
+static void icConvertGlyphBitmapToDistanceField(uint8_t *bitmap, int width, int height, float spread)
+{
+    size_t count = (size_t)width * height;
+    float *outside = (float *)malloc(sizeof(float) * count);
+    float *inside = (float *)malloc(sizeof(float) * count);
+    for (size_t i=0; i<count; i++) {
+        BOOL covered = bitmap[i] > 127;
+        outside[i] = covered ? 0 : IC_SDF_INFINITY;
+        inside[i] = covered ? IC_SDF_INFINITY : 0;
+    }
+    
+    icDistanceTransform2D(outside, width, height);
+    icDistanceTransform2D(inside, width, height);
+    
+    for (size_t i=0; i<count; i++) {
+        float distance = sqrtf(inside[i]) - sqrtf(outside[i]);
+        float value = 0.5f + distance / (2.f * spread);
+        bitmap[i] = (uint8_t)(MIN(MAX(value, 0.f), 1.f) * 255.f + 0.5f);
+    }
+    
+    free(outside);
+    free(inside);
+}
+
+#endif // IC_USE_SDF_GLYPHS
+
+
 @interface ICGlyphKey : NSObject <NSCopying> {
 @protected
     ICGlyph _glyph;
@@ -100,9 +220,37 @@ float icValidateSubpixelOffset(float offset)
 @end
 
 
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+
+// Glyph bitmap rasterized on a worker thread, waiting to be added to a texture atlas
+@interface ICRasterizedGlyph : NSObject {
+@public
+    ICGlyph _glyph;
+    float _offset;
+    CGRect _boundingRect;
+    CGSize _sizeInPixels;
+    void *_bitmapData;
+    ICFont *_font;
+}
+@end
+
+@implementation ICRasterizedGlyph
+
+- (void)dealloc
+{
+    free(_bitmapData);
+    [_font release];
+    [super dealloc];
+}
+
+@end
+
+#endif // IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+
+
 @interface ICGlyphCache ()
 - (ICGlyphTextureAtlas *)newTextureAtlas;
-- (ICGlyphTextureAtlas *)vacantTextureAtlas;
+- (void)closeTextureAtlas:(ICGlyphTextureAtlas *)textureAtlas;
 - (ICTextureGlyph *)cacheGlyph:(ICGlyph)glyph font:(ICFont *)font;
 - (ICTextureGlyph *)cacheGlyph:(ICGlyph)glyph font:(ICFont *)font offset:(float)offset;
 - (void)cacheGlyphsWithRun:(CTRunRef)run font:(ICFont *)font;
@@ -113,6 +261,7 @@ float icValidateSubpixelOffset(float offset)
 
 @synthesize textures = _textures;
 @synthesize textureSize = _textureSize;
+@synthesize packingStrategy = _packingStrategy;
 
 + (id)currentGlyphCache
 {
@@ -127,7 +276,14 @@ float icValidateSubpixelOffset(float offset)
     if ((self = [super init])) {
         _textureGlyphs = [[NSMutableDictionary alloc] init];
         _textures = [[NSMutableArray alloc] initWithCapacity:1];
+        _openTextures = [[NSMutableArray alloc] initWithCapacity:IC_GLYPH_CACHE_MAX_OPEN_ATLASES];
         _textureSize = IC_DEFAULT_GLYPH_TEXTURE_ATLAS_SIZE;
+        _packingStrategy = IC_DEFAULT_GLYPH_PACKING_STRATEGY;
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+        _pendingGlyphs = [[NSMutableDictionary alloc] init];
+        _rasterizedGlyphs = [[NSMutableArray alloc] init];
+        _rasterizedGlyphsQueue = dispatch_queue_create("org.icedcoffee.glyphcacherasterized", NULL);
+#endif
     }
     return self;
 }
@@ -136,19 +292,22 @@ float icValidateSubpixelOffset(float offset)
 {
     [_textureGlyphs release];
     [_textures release];
+    [_openTextures release];
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+    [_pendingGlyphs release];
+    [_rasterizedGlyphs release];
+    dispatch_release(_rasterizedGlyphsQueue);
+#endif
 
     [super dealloc];
 }
 
 - (ICGlyphTextureAtlas *)newTextureAtlas
 {
-    ICGlyphTextureAtlas *currentTextureAtlas = [_textures lastObject];
-    // Upload current texture atlas data if necessary
-    if ([currentTextureAtlas dataDirty]) {
-        [currentTextureAtlas upload];
+    // Close the oldest open texture atlas if we would exceed the open atlas limit
+    if ([_openTextures count] >= IC_GLYPH_CACHE_MAX_OPEN_ATLASES) {
+        [self closeTextureAtlas:[_openTextures objectAtIndex:0]];
     }
-    // Free RAM copy of texture data for current texture atlas
-    [currentTextureAtlas setData:nil];
     
     // Create new texture atlas
     ICGlyphTextureAtlas *textureAtlas;
@@ -157,8 +316,10 @@ float icValidateSubpixelOffset(float offset)
     ICPixelFormat pixelFormat = IC_GLYPH_CACHE_TEXTURE_DEPTH == 1 ? ICPixelFormatA8 : ICPixelFormatRGBA8888;
     textureAtlas = [[[ICGlyphTextureAtlas alloc] initWithSize:self.textureSize
                                                   pixelFormat:pixelFormat
-                                               resolutionType:bestResolutionType] autorelease];
+                                               resolutionType:bestResolutionType
+                                              packingStrategy:self.packingStrategy] autorelease];
     [_textures addObject:textureAtlas];
+    [_openTextures addObject:textureAtlas];
 
 #if IC_ENABLE_DEBUG_GLYPH_CACHE
     NSLog(@"Glyph cache: new texture atlas allocated");
@@ -172,14 +333,62 @@ float icValidateSubpixelOffset(float offset)
     return textureAtlas;
 }
 
-- (ICGlyphTextureAtlas *)vacantTextureAtlas
+- (void)closeTextureAtlas:(ICGlyphTextureAtlas *)textureAtlas
+{
+    // Upload texture atlas data if necessary
+    if ([textureAtlas dataDirty]) {
+        [textureAtlas upload];
+    }
+    // Free RAM copy of texture data; no more glyphs will be added to this atlas
+    [textureAtlas setData:nil];
+
+#if IC_ENABLE_DEBUG_GLYPH_CACHE
+    NSLog(@"Glyph cache: closing texture atlas with %ld glyphs, occupancy %.2f, fragmentation %.2f",
+          (long)[textureAtlas glyphCount], [textureAtlas occupancy], [textureAtlas fragmentation]);
+#endif
+    
+    [_openTextures removeObject:textureAtlas];
+}
+
+- (ICTextureGlyph *)addGlyphBitmapData:(void *)bitmapData
+                              forGlyph:(ICGlyph)glyph
+                          sizeInPixels:(CGSize)sizeInPixels
+                          boundingRect:(CGRect)boundingRect
+                                offset:(float)offset
+                                  font:(ICFont *)font
 {
-    ICGlyphTextureAtlas *candidate = [_textures lastObject];
-    if (!candidate) {
-        candidate = [self newTextureAtlas];
+    // Try to fill gaps in open texture atlases before allocating a new one, oldest first
+    for (ICGlyphTextureAtlas *textureAtlas in _openTextures) {
+        ICTextureGlyph *textureGlyph = [textureAtlas addGlyphBitmapData:bitmapData
+                                                               forGlyph:glyph
+                                                           sizeInPixels:sizeInPixels
+                                                           boundingRect:boundingRect
+                                                                 offset:offset
+                                                                   font:font
+                                                      uploadImmediately:NO];
+        if (textureGlyph) {
+            return textureGlyph;
+        }
     }
     
-    return candidate;
+    // No more space left in open texture atlases
+    ICGlyphTextureAtlas *textureAtlas = [self newTextureAtlas];
+    return [textureAtlas addGlyphBitmapData:bitmapData
+                                   forGlyph:glyph
+                               sizeInPixels:sizeInPixels
+                               boundingRect:boundingRect
+                                     offset:offset
+                                       font:font
+                          uploadImmediately:NO];
+}
+
+- (float)occupancy
+{
+    float occupancy = 0;
+    for (ICGlyphTextureAtlas *textureAtlas in _textures) {
+        occupancy += [textureAtlas occupancy];
+    }
+    return [_textures count] ? occupancy / [_textures count] : 0;
 }
 
 - (void)cacheTextureGlyph:(ICTextureGlyph *)textureGlyph
@@ -195,32 +404,57 @@ float icValidateSubpixelOffset(float offset)
                                                     offset:textureGlyph.offset]];
 }
 
-- (void)rasterizeGlyph:(ICGlyph)glyph
-                  font:(ICFont *)font
-               xOffset:(float)xOffset
-               yOffset:(float)yOffset
-               context:(CGContextRef)context
+// Rasterizes the given glyph into a newly allocated bitmap conforming to the glyph cache's
+// texture depth. Does not access OpenGL or the current context, so it may be called from any
+// thread. The caller is responsible for freeing the returned bitmap.
+- (void *)newBitmapForGlyph:(ICGlyph)glyph
+               boundingRect:(CGRect)boundingRect
+                     offset:(float)offset
+                       font:(ICFont *)font
+         contentScaleFactor:(float)contentScaleFactor
+               sizeInPixels:(CGSize *)sizeInPixels
 {
-    CGFontRef cgFont = CTFontCopyGraphicsFont(font.fontRef, NULL);
-    //CGContextSetAllowsAntialiasing(context, NO);
-    //CGContextSetShouldAntialias(context, NO);
-    //CGContextSetAllowsFontSmoothing(context, NO);
-    //CGContextSetShouldSmoothFonts(context, NO);
-    CGContextSetShouldSubpixelPositionFonts(context, YES);
-    CGContextSetShouldSubpixelQuantizeFonts(context, YES);
-    CGContextSetTextMatrix(context, CGAffineTransformIdentity);
-    CGContextSetFont(context, cgFont);
-    CGContextSetFontSize(context, CTFontGetSize(font.fontRef));
-    CGContextSetGrayFillColor(context, 1, 1);
-    CGContextShowGlyphsAtPoint(context,
-                               IC_GLYPH_RECTANGLE_MARGIN + xOffset,
-                               IC_GLYPH_RECTANGLE_MARGIN + yOffset,
-                               &glyph, 1);
-    CFRelease(cgFont);
+    size_t deltaW = 0;
+    size_t deltaH = 0;
+    size_t brWidth = (size_t)ceilf(boundingRect.size.width);
+    size_t brHeight = (size_t)ceilf(boundingRect.size.height);
+#if !IC_USE_SDF_GLYPHS
+    if (contentScaleFactor == 2.f) {
+        deltaW = brWidth % 2;
+        deltaH = brHeight % 2;
+    }
+#endif
+    
+    size_t w = brWidth + deltaW + IC_GLYPH_BITMAP_MARGIN * 2;
+    size_t h = brHeight + deltaH + IC_GLYPH_BITMAP_MARGIN * 2;
+    
+    int depth = IC_GLYPH_CACHE_TEXTURE_DEPTH;
+    if (depth != 4 && depth != 1) {
+        NSLog(@"Only RGBA and alpha texture depths are supported, falling back to RGBA");
+        depth = 4;
+    }
     
-    /*CGContextSetLineWidth(context, 1);
-     CGContextSetGrayStrokeColor(context, 1, 1);
-     CGContextStrokeRect(context, CGRectMake(0, 0, w, h));*/
+    void *data = calloc(h, w * depth);
+    
+    float xOffset = -boundingRect.origin.x + offset;
+    float yOffset = -boundingRect.origin.y;
+    
+    if ([font textBackend]->rasterizeGlyph([font textFace], glyph,
+                                           IC_GLYPH_BITMAP_MARGIN + xOffset,
+                                           IC_GLYPH_BITMAP_MARGIN + yOffset,
+                                           (uint8_t *)data, w, h, w * depth, depth)) {
+        free(data);
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"Unable to rasterize glyph %d", glyph];
+        return NULL;
+    }
+    
+#if IC_USE_SDF_GLYPHS
+    icConvertGlyphBitmapToDistanceField((uint8_t *)data, (int)w, (int)h, IC_SDF_GLYPH_SPREAD);
+#endif
+    
+    *sizeInPixels = CGSizeMake(w, h);
+    return data;
 }
 
 - (ICTextureGlyph *)rasterizeAndCacheGlyph:(ICGlyph)glyph
@@ -232,78 +466,25 @@ float icValidateSubpixelOffset(float offset)
     
     // Only extract new glyph texture if glyph has not already been cached
     if (!textureGlyph) {
-        size_t deltaW = 0;
-        size_t deltaH = 0;
-        size_t brWidth = (size_t)ceilf(boundingRect->size.width);
-        size_t brHeight = (size_t)ceilf(boundingRect->size.height);
-        if (ICFontContentScaleFactor() == 2.f) {
-            deltaW = brWidth % 2;
-            deltaH = brHeight % 2;
-        }
-        
-        size_t w = brWidth + deltaW + IC_GLYPH_RECTANGLE_MARGIN * 2;
-        size_t h = brHeight + deltaH + IC_GLYPH_RECTANGLE_MARGIN * 2;
-        
-        CGColorSpaceRef colorSpace;
-        CGImageAlphaInfo alphaInfo;
-        
-        int depth = IC_GLYPH_CACHE_TEXTURE_DEPTH;
-        if (depth != 4 && depth != 1) {
-            NSLog(@"Only RGBA and alpha texture depths are supported, falling back to RGBA");
-            depth = 4;
-        }
-        
-        if (depth == 4) {
-            colorSpace = CGColorSpaceCreateDeviceRGB();
-            alphaInfo = kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big;
-        } else if (depth == 1) {
-            colorSpace = CGColorSpaceCreateDeviceGray();
-            alphaInfo = kCGImageAlphaNone;
-        }
-        
-        void *data = calloc(h, w * depth);
-        CGContextRef context = CGBitmapContextCreate(data, w, h, 8, w * depth, colorSpace, alphaInfo);
-        CGColorSpaceRelease(colorSpace);
-        
-        NSAssert(context != nil, @"Unable to create CoreGraphics bitmap context");
-        
-        if (!context) {
-            free(data);
-            [NSException raise:NSInternalInconsistencyException format:@"Invalid bitmap context"];
-            return nil;
-        }
-        
-        float xOffset = -boundingRect->origin.x + offset;
-        float yOffset = -boundingRect->origin.y;
+        CGSize sizeInPixels;
+        void *data = [self newBitmapForGlyph:glyph
+                                boundingRect:*boundingRect
+                                      offset:offset
+                                        font:font
+                          contentScaleFactor:ICFontContentScaleFactor()
+                                sizeInPixels:&sizeInPixels];
         
-        [self rasterizeGlyph:glyph font:font xOffset:xOffset yOffset:yOffset context:context];
-        
-        ICGlyphTextureAtlas *textureAtlas = [self vacantTextureAtlas];
-        textureGlyph = [textureAtlas addGlyphBitmapData:data
-                                               forGlyph:glyph
-                                           sizeInPixels:CGSizeMake(w,h)
-                                           boundingRect:*boundingRect
-                                                 offset:offset
-                                                   font:font
-                                      uploadImmediately:NO];
-        
-        if (!textureGlyph) {
-            // No more space left in vacant texture atlas
-            textureAtlas = [self newTextureAtlas];
-            textureGlyph = [textureAtlas addGlyphBitmapData:data
-                                                   forGlyph:glyph
-                                               sizeInPixels:CGSizeMake(w,h)
-                                               boundingRect:*boundingRect
-                                                     offset:offset
-                                                       font:font
-                                          uploadImmediately:NO];
-        }
+        textureGlyph = [self addGlyphBitmapData:data
+                                       forGlyph:glyph
+                                   sizeInPixels:sizeInPixels
+                                   boundingRect:*boundingRect
+                                         offset:offset
+                                           font:font];
         
         NSAssert(textureGlyph != nil, @"Something went terribly wrong here");
         
         [self cacheTextureGlyph:textureGlyph];
         
-        CGContextRelease(context);
         free(data);
     }
     
@@ -336,7 +517,7 @@ float icValidateSubpixelOffset(float offset)
                                                  boundingRect:&boundingRects[i]
                                                        offset:0.f
                                                          font:font]];
-#if IC_USE_EXTRA_SUBPIXEL_GLYPHS
+#if IC_USE_EXTRA_SUBPIXEL_GLYPHS && !IC_USE_SDF_GLYPHS
         if (ICContentScaleFactor() == 1.f) {
             [textureGlyphs addObject:[self rasterizeAndCacheGlyph:glyphs[i]
                                                      boundingRect:&boundingRects[i]
@@ -385,6 +566,9 @@ float icValidateSubpixelOffset(float offset)
 
 - (void)cacheGlyphsWithString:(NSString *)string forFont:(ICFont *)font
 {
+#if IC_USE_SDF_GLYPHS
+    font = icReferenceFontForFont(font);
+#endif
     NSDictionary *attributes = [NSDictionary dictionaryWithObjectsAndKeys:
                                 (id)font.fontRef, (NSString *)kCTFontAttributeName, nil];
     NSAttributedString *attributedString = [[NSAttributedString alloc] initWithString:string
@@ -411,6 +595,9 @@ float icValidateSubpixelOffset(float offset)
 // if data is kept by texture atlas (as it is currently)
 - (ICTextureGlyph *)textureGlyphForGlyph:(ICGlyph)glyph offset:(float)offset font:(ICFont *)font
 {
+#if IC_USE_SDF_GLYPHS
+    font = icReferenceFontForFont(font);
+#endif
     offset = icValidateSubpixelOffset(offset);
     ICTextureGlyph *textureGlyph = [self retrieveCachedTextureGlyph:glyph font:font offset:offset];
     
@@ -432,8 +619,12 @@ float icValidateSubpixelOffset(float offset)
                               count:(NSInteger)count
                                font:(ICFont *)font
 {
+    IC_PROFILE_ZONE_BEGIN(glyphZone, ICProfilerCategoryGlyphCache);
     NSMutableArray *resultTextureGlyphs = [NSMutableArray arrayWithCapacity:count];
     
+#if IC_USE_SDF_GLYPHS
+    font = icReferenceFontForFont(font);
+#endif
     NSString *internalFontName = icInternalFontNameForFont(font);
     NSMutableDictionary *glyphsForFont = [_textureGlyphs objectForKey:internalFontName];
     if (!glyphsForFont) {
@@ -473,6 +664,7 @@ float icValidateSubpixelOffset(float offset)
         }
     }
     
+    IC_PROFILE_ZONE_END(glyphZone, ICProfilerCategoryGlyphCache, "Look up texture glyphs");
     return resultTextureGlyphs;
 }
 
@@ -500,12 +692,180 @@ float icValidateSubpixelOffset(float offset)
     return glyphsByTexture;
 }
 
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+
+- (BOOL)requestGlyphs:(ICGlyph *)glyphs
+              offsets:(float *)offsets
+                count:(NSInteger)count
+                 font:(ICFont *)font
+{
+#if IC_USE_SDF_GLYPHS
+    font = icReferenceFontForFont(font);
+#endif
+    
+    NSString *internalFontName = icInternalFontNameForFont(font);
+    NSMutableDictionary *glyphsForFont = [_textureGlyphs objectForKey:internalFontName];
+    NSMutableSet *pendingGlyphsForFont = [_pendingGlyphs objectForKey:internalFontName];
+    
+    // Collect glyphs which are neither cached nor already being rasterized
+    ICGlyph *missingGlyphs = (ICGlyph *)malloc(sizeof(ICGlyph) * count);
+    float *missingOffsets = (float *)malloc(sizeof(float) * count);
+    NSInteger missingCount = 0;
+    BOOL glyphsAvailable = YES;
+    
+    for (NSInteger i=0; i<count; i++) {
+        ICGlyphKey *key = [ICGlyphKey glyphKeyWithGlyph:glyphs[i]
+                                                 offset:icValidateSubpixelOffset(offsets[i])];
+        if ([glyphsForFont objectForKey:key]) {
+            continue;
+        }
+        glyphsAvailable = NO;
+        if ([pendingGlyphsForFont containsObject:key]) {
+            continue;
+        }
+        if (!pendingGlyphsForFont) {
+            pendingGlyphsForFont = [NSMutableSet setWithCapacity:count];
+            [_pendingGlyphs setObject:pendingGlyphsForFont forKey:internalFontName];
+        }
+        [pendingGlyphsForFont addObject:key];
+        missingGlyphs[missingCount] = key.glyph;
+        missingOffsets[missingCount] = key.offset;
+        missingCount++;
+    }
+    
+    if (!missingCount) {
+        free(missingGlyphs);
+        free(missingOffsets);
+        return glyphsAvailable;
+    }
+    
+#if IC_ENABLE_DEBUG_GLYPH_CACHE
+    NSLog(@"Glyph cache: queueing %ld glyphs for asynchronous rasterization", (long)missingCount);
+#endif
+    
+    // Values depending on the current OpenGL context must be captured on this thread
+    float contentScaleFactor = ICFontContentScaleFactor();
+    ICHostViewController *hostViewController = [ICHostViewController currentHostViewController];
+    
+    dispatch_queue_t workerQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_async(workerQueue, ^{
+        CGRect *boundingRects = (CGRect *)malloc(sizeof(CGRect) * missingCount);
+        CTFontGetBoundingRectsForGlyphs(font.fontRef, kCTFontDefaultOrientation,
+                                        missingGlyphs, boundingRects, missingCount);
+        
+        // Rasterize glyphs in parallel into staging bitmaps
+        ICRasterizedGlyph **rasterizedGlyphs = (ICRasterizedGlyph **)malloc(sizeof(id) * missingCount);
+        dispatch_apply(missingCount, workerQueue, ^(size_t i) {
+            ICRasterizedGlyph *rasterizedGlyph = [[ICRasterizedGlyph alloc] init];
+            rasterizedGlyph->_glyph = missingGlyphs[i];
+            rasterizedGlyph->_offset = missingOffsets[i];
+            rasterizedGlyph->_boundingRect = boundingRects[i];
+            rasterizedGlyph->_font = [font retain];
+            rasterizedGlyph->_bitmapData = [self newBitmapForGlyph:missingGlyphs[i]
+                                                      boundingRect:boundingRects[i]
+                                                            offset:missingOffsets[i]
+                                                              font:font
+                                                contentScaleFactor:contentScaleFactor
+                                                      sizeInPixels:&rasterizedGlyph->_sizeInPixels];
+            rasterizedGlyphs[i] = rasterizedGlyph;
+        });
+        
+        // Hand staging bitmaps over to the render thread
+        dispatch_sync(_rasterizedGlyphsQueue, ^{
+            for (NSInteger i=0; i<missingCount; i++) {
+                [_rasterizedGlyphs addObject:rasterizedGlyphs[i]];
+                [rasterizedGlyphs[i] release];
+            }
+        });
+        
+        free(rasterizedGlyphs);
+        free(boundingRects);
+        free(missingGlyphs);
+        free(missingOffsets);
+        
+        // Redraw so that waiting glyph runs pick up their glyphs with the next frame
+        if (hostViewController.thread) {
+            [hostViewController performSelector:@selector(setNeedsDisplay)
+                                       onThread:hostViewController.thread
+                                     withObject:nil
+                                  waitUntilDone:NO];
+        }
+    });
+    
+    return NO;
+}
+
+- (void)commitRasterizedGlyphs
+{
+    __block NSArray *rasterizedGlyphs = nil;
+    dispatch_sync(_rasterizedGlyphsQueue, ^{
+        if ([_rasterizedGlyphs count]) {
+            rasterizedGlyphs = [_rasterizedGlyphs copy];
+            [_rasterizedGlyphs removeAllObjects];
+        }
+    });
+    
+    if (!rasterizedGlyphs) {
+        return;
+    }
+    
+    NSMutableSet *dirtyTextures = [NSMutableSet setWithCapacity:1];
+    for (ICRasterizedGlyph *rasterizedGlyph in rasterizedGlyphs) {
+        ICGlyph glyph = rasterizedGlyph->_glyph;
+        float offset = rasterizedGlyph->_offset;
+        ICFont *font = rasterizedGlyph->_font;
+        
+        NSMutableSet *pendingGlyphsForFont = [_pendingGlyphs objectForKey:icInternalFontNameForFont(font)];
+        [pendingGlyphsForFont removeObject:[ICGlyphKey glyphKeyWithGlyph:glyph offset:offset]];
+        
+        // The glyph may have been cached synchronously in the meantime
+        if ([self retrieveCachedTextureGlyph:glyph font:font offset:offset]) {
+            continue;
+        }
+        
+        ICTextureGlyph *textureGlyph = [self addGlyphBitmapData:rasterizedGlyph->_bitmapData
+                                                       forGlyph:glyph
+                                                   sizeInPixels:rasterizedGlyph->_sizeInPixels
+                                                   boundingRect:rasterizedGlyph->_boundingRect
+                                                         offset:offset
+                                                           font:font];
+        NSAssert(textureGlyph != nil, @"Something went terribly wrong here");
+        
+        [self cacheTextureGlyph:textureGlyph];
+        [dirtyTextures addObject:textureGlyph.textureAtlas];
+    }
+    
+    // Upload each texture atlas touched by the committed glyphs once
+    for (ICGlyphTextureAtlas *textureAtlas in dirtyTextures) {
+        if (textureAtlas.dataDirty) {
+            [textureAtlas upload];
+        }
+    }
+    
+#if IC_ENABLE_DEBUG_GLYPH_CACHE
+    NSLog(@"Glyph cache: committed %ld asynchronously rasterized glyphs",
+          (long)[rasterizedGlyphs count]);
+#endif
+    
+    [rasterizedGlyphs release];
+}
+
+#endif // IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+
 - (void)purge
 {
     [_textureGlyphs release];
     _textureGlyphs = nil;
     [_textures release];
     _textures = nil;
+    [_openTextures release];
+    _openTextures = nil;
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+    [_pendingGlyphs removeAllObjects];
+    dispatch_sync(_rasterizedGlyphsQueue, ^{
+        [_rasterizedGlyphs removeAllObjects];
+    });
+#endif
 }
 
 @end
@@ -68,6 +68,10 @@
     ICGlyphRunMetrics *_metrics;
     CTRunRef _ctRun;
     
+    ICShaderProgram *_uniformHandlesProgram;
+    ICShaderUniformHandle _colorUniformHandle;
+    ICShaderUniformHandle _inverseGammaUniformHandle;
+    
 #if IC_ENABLE_DEBUG_GLYPH_RUN_METRICS
     ICLine2D *_dbgBaseline;
 #endif
@@ -143,6 +147,9 @@
 
 /**
  @brief The color the receiver uses to draw its ICGlyphRun::string
+ 
+ Color and gamma are passed to the glyph shader as uniforms, so changing them does not require
+ the receiver to rebuild its vertex buffers.
  */
 @property (nonatomic, assign, setter=setColor:) icColor4B color;
 
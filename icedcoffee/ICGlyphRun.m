@@ -35,12 +35,14 @@
 #import "ICShaderValue.h"
 #import "ICFontCache.h"
 #import "icFontUtils.h"
+#import "ICTextLayoutCache.h"
 
 
 // FIXME: property changes do not rebuild run
 
 
-#define ICAttributeNameGamma @"a_gamma"
+#define ICUniformNameGlyphColor @"u_color"
+#define ICUniformNameGlyphInverseGamma @"u_inverseGamma"
 
 
 #define SHIFT_STRENGTH 1.0
@@ -49,27 +51,19 @@ NSString *__glyphVSH = IC_SHADER_STRING
 (
     attribute vec4 a_position;
     attribute vec2 a_texCoord;
-    attribute vec4 a_color;
-    attribute float a_gamma;
 
     uniform mat4 u_MVPMatrix;
 
     #ifdef GL_ES
-    varying lowp vec4 v_fragmentColor;
     varying highp vec2 v_texCoord;
-    varying mediump float v_gamma;
     #else
-    varying vec4 v_fragmentColor;
     varying vec2 v_texCoord;
-    varying float v_gamma;
     #endif
 
     void main()
     {
         gl_Position = u_MVPMatrix * a_position;
-        v_fragmentColor = a_color;
         v_texCoord = a_texCoord;
-        v_gamma = a_gamma;
     }
 );
 
@@ -79,16 +73,16 @@ NSString *__glyphRGBAFSH = IC_SHADER_STRING
     precision highp float;
     #endif
 
-    varying vec4 v_fragmentColor;
     varying vec2 v_texCoord;
-    varying float v_gamma;
     uniform sampler2D u_texture;
+    uniform vec4 u_color;
+    uniform float u_inverseGamma;
 
     void main()
     {
         vec4 c = texture2D(u_texture, v_texCoord);
-        vec3 gc = pow(vec3(c.r,c.g,c.b), vec3(1.0/v_gamma));
-        gl_FragColor = vec4(v_fragmentColor.rgb, (gc.r+gc.g+gc.b)/3.0 * v_fragmentColor.a);
+        vec3 gc = pow(vec3(c.r,c.g,c.b), vec3(u_inverseGamma));
+        gl_FragColor = vec4(u_color.rgb, (gc.r+gc.g+gc.b)/3.0 * u_color.a);
     }
 );
 
@@ -98,16 +92,36 @@ NSString *__glyphAFSH = IC_SHADER_STRING
     precision lowp float;
     #endif
 
-    varying vec4 v_fragmentColor;
     varying vec2 v_texCoord;
-    varying float v_gamma;
     uniform sampler2D u_texture;
+    uniform vec4 u_color;
+    uniform float u_inverseGamma;
 
     void main()
     {
-        float glyphAlpha = pow(texture2D(u_texture, v_texCoord).a, 1.0/v_gamma);
-        gl_FragColor = vec4(v_fragmentColor.rgb,
-                            v_fragmentColor.a * glyphAlpha);
+        float glyphAlpha = pow(texture2D(u_texture, v_texCoord).a, u_inverseGamma);
+        gl_FragColor = vec4(u_color.rgb, u_color.a * glyphAlpha);
+    }
+);
+
+NSString *__glyphSDFFSH = IC_SHADER_STRING
+(
+    #ifdef GL_ES
+    precision mediump float;
+    #endif
+
+    varying vec2 v_texCoord;
+    uniform sampler2D u_texture;
+    uniform vec4 u_color;
+    uniform float u_inverseGamma;
+
+    void main()
+    {
+        // The glyph outline lies at distance 0.5; antialias across one pixel on screen
+        float distance = texture2D(u_texture, v_texCoord).a;
+        float width = 0.7 * fwidth(distance);
+        float glyphAlpha = pow(smoothstep(0.5 - width, 0.5 + width, distance), u_inverseGamma);
+        gl_FragColor = vec4(u_color.rgb, u_color.a * glyphAlpha);
     }
 );
 
@@ -179,14 +193,35 @@ NSString *__glyphAFSH = IC_SHADER_STRING
             
             CTFontRef runFont = CFDictionaryGetValue(CTRunGetAttributes(run), kCTFontAttributeName);
             CGRect *boundingRects = malloc(sizeof(CGRect) * _glyphCount);
+#if IC_USE_SDF_GLYPHS
+            // Distance field glyphs are rendered at the reference size and scaled to the run's
+            // font size, so glyph rectangles must be derived from the reference font
+            float sdfScale = CTFontGetSize(runFont) / IC_SDF_GLYPH_REFERENCE_SIZE;
+            CTFontRef referenceFont = CTFontCreateCopyWithAttributes(runFont, IC_SDF_GLYPH_REFERENCE_SIZE,
+                                                                     NULL, NULL);
+            CTFontGetBoundingRectsForGlyphs(referenceFont, kCTFontDefaultOrientation, _glyphs, boundingRects, _glyphCount);
+            CFRelease(referenceFont);
+
+            float marginInPoints = ICFontPixelsToPoints(IC_SDF_GLYPH_SPREAD * sdfScale);
+#else
             CTFontGetBoundingRectsForGlyphs(runFont, kCTFontDefaultOrientation, _glyphs, boundingRects, _glyphCount);
 
             float marginInPoints = ICFontPixelsToPoints(IC_GLYPH_RECTANGLE_MARGIN);
+#endif
             
             kmVec2 min = kmVec2Make(IC_HUGE, IC_HUGE);
             kmVec2 max = kmVec2Make(0, 0);
             CFIndex i=0;
             for (; i<_glyphCount; i++) {
+#if IC_USE_SDF_GLYPHS
+                float textureGlyphHeight = ICFontPixelsToPoints(ceilf(boundingRects[i].size.height) * sdfScale) + marginInPoints;
+                
+                _positions[i].x = ICFontPixelsToPoints(_positions[i].x) + ICFontPixelsToPoints(boundingRects[i].origin.x * sdfScale) - marginInPoints;
+                _positions[i].y = ICFontPixelsToPoints(_positions[i].y) - textureGlyphHeight - ICFontPixelsToPoints(boundingRects[i].origin.y * sdfScale) + roundf(_ascent);
+                _offsets[i] = 0.f;
+                
+                float advance = ICFontPixelsToPoints(boundingRects[i].size.width * sdfScale);
+#else
                 size_t tgHeight = (size_t)ceilf(boundingRects[i].size.height);
                 if (ICFontContentScaleFactor() == 2.)
                     tgHeight += tgHeight % 2;
@@ -228,6 +263,7 @@ NSString *__glyphAFSH = IC_SHADER_STRING
 #endif
                 
                 float advance = ICFontPixelsToPoints(boundingRects[i].size.width);
+#endif // IC_USE_SDF_GLYPHS
                 
                 if (_positions[i].x + marginInPoints < min.x)
                     min.x = _positions[i].x + marginInPoints;
@@ -306,7 +342,6 @@ NSString *__glyphAFSH = IC_SHADER_STRING
 // ICGlyphRun
 //
 
-// TODO: find better solution for solid color (via shader), remove color from vertices?
 // TODO: retain texture glyphs or automatize re-caching in case cache was purged?
 
 @interface ICGlyphRun ()
@@ -399,14 +434,21 @@ NSString *__glyphAFSH = IC_SHADER_STRING
         ICShaderProgram *p = [shaderCache shaderProgramForKey:ICShaderGlyph];
         
         if (!p) {
+#if IC_USE_SDF_GLYPHS
+            NSString *glyphFSH = __glyphSDFFSH;
+#ifdef __IC_PLATFORM_IOS
+            // fwidth() requires the standard derivatives extension on OpenGL ES 2
+            glyphFSH = [@"#extension GL_OES_standard_derivatives : enable\n"
+                        stringByAppendingString:glyphFSH];
+#endif
+#else
             NSString *glyphFSH = IC_GLYPH_CACHE_TEXTURE_DEPTH == 4 ? __glyphRGBAFSH : __glyphAFSH;
+#endif
             p = [ICShaderProgram shaderProgramWithName:ICShaderGlyph
                                     vertexShaderString:__glyphVSH
                                   fragmentShaderString:glyphFSH];
             [p addAttribute:ICAttributeNamePosition index:ICVertexAttribPosition];
-            [p addAttribute:ICAttributeNameColor index:ICVertexAttribColor];
             [p addAttribute:ICAttributeNameTexCoord index:ICVertexAttribTexCoords];
-            [p addAttribute:ICAttributeNameGamma index:ICVertexAttribTexCoords+1];
             
             [p link];
             [p updateUniforms];
@@ -456,6 +498,7 @@ NSString *__glyphAFSH = IC_SHADER_STRING
     self.metrics = nil;
     
     [_buffers release];
+    [_uniformHandlesProgram release];
     
     if (_ctRun)
         CFRelease(_ctRun);
@@ -489,14 +532,15 @@ NSString *__glyphAFSH = IC_SHADER_STRING
 
 - (void)setColor:(icColor4B)color
 {
+    // Color is a shader uniform, so there's no need to rebuild the run's buffers
     _color = color;
-    _dirty = YES;
+    [self setNeedsDisplay];
 }
 
 - (void)setGamma:(float)gamma
 {
     _gamma = gamma;
-    _dirty = YES;
+    [self setNeedsDisplay];
 }
 
 - (void)setTracking:(float)tracking
@@ -530,15 +574,27 @@ NSString *__glyphAFSH = IC_SHADER_STRING
                                         nil];
             NSAttributedString *attributedString = [[[NSAttributedString alloc] initWithString:self.string
                                                                                     attributes:attributes] autorelease];
-            line = CTLineCreateWithAttributedString((CFAttributedStringRef)attributedString);
-            CFArrayRef runs = CTLineGetGlyphRuns(line);
-            CFIndex runCount = CFArrayGetCount(runs);
-            NSAssert(runCount == 1, @"Shouldn't be more than 1 run");
-            run = (CTRunRef)CFArrayGetValueAtIndex(runs, 0);
+            
+            // Metrics are immutable, so runs with identical strings and attributes may share them
+            ICTextLayoutCache *layoutCache = [ICTextLayoutCache sharedTextLayoutCache];
+            ICGlyphRunMetrics *metrics = [layoutCache resultForAttributedString:attributedString
+                                                                           kind:@"ICGlyphRunMetrics"];
+            if (!metrics) {
+                line = CTLineCreateWithAttributedString((CFAttributedStringRef)attributedString);
+                CFArrayRef runs = CTLineGetGlyphRuns(line);
+                CFIndex runCount = CFArrayGetCount(runs);
+                NSAssert(runCount == 1, @"Shouldn't be more than 1 run");
+                run = (CTRunRef)CFArrayGetValueAtIndex(runs, 0);
+                metrics = [[[ICGlyphRunMetrics alloc] initWithCoreTextRun:run] autorelease];
+                [layoutCache setResult:metrics forAttributedString:attributedString
+                                  kind:@"ICGlyphRunMetrics"];
+            }
+            self.metrics = metrics;
+        } else {
+            // Runs of text lines are positioned relative to their line and cannot be shared
+            self.metrics = [[[ICGlyphRunMetrics alloc] initWithCoreTextRun:run] autorelease];
         }
         
-        // Calculate new metrics
-        self.metrics = [[[ICGlyphRunMetrics alloc] initWithCoreTextRun:run] autorelease];
         self.origin = kmVec3Make(self.metrics.boundingBox.x,
                                  self.metrics.boundingBox.y, 0);
         self.size = kmVec3Make(self.metrics.boundingBox.width,
@@ -555,6 +611,18 @@ NSString *__glyphAFSH = IC_SHADER_STRING
 
 - (void)updateBuffers
 {
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+    // Keep the old buffers until the glyph cache has rasterized all glyphs of the run in the
+    // background; the run remains dirty and is rebuilt once they are available
+    if (self.font && self.metrics &&
+        ![[ICGlyphCache currentGlyphCache] requestGlyphs:self.metrics.glyphs
+                                                 offsets:self.metrics.offsets
+                                                   count:self.metrics.glyphCount
+                                                    font:self.font]) {
+        return;
+    }
+#endif
+    
     // Dispose old buffers
     [_buffers release];
     _buffers = nil;
@@ -571,6 +639,13 @@ NSString *__glyphAFSH = IC_SHADER_STRING
         CGPoint *positions = self.metrics.positions;
         float *offsets = self.metrics.offsets;
         
+#if IC_USE_SDF_GLYPHS
+        // Texture glyphs are cached at the reference size and scaled to the run's font size
+        float glyphScale = [self.font sizeInPixels] / IC_SDF_GLYPH_REFERENCE_SIZE;
+#else
+        float glyphScale = 1.f;
+#endif
+        
         // Get texture glyphs separated by texture. The idea here is to create distinct VBOs and
         // index buffers for all relevant glyphs that are cached on the same texture so as to
         // limit the number of texture state changes.
@@ -587,7 +662,7 @@ NSString *__glyphAFSH = IC_SHADER_STRING
             NSInteger textureGlyphCount = [glyphEntries count];
             
             // Allocate memory for upload to VBO
-            icV3F_C4F_T2F_G1F_Quad *quads = (icV3F_C4F_T2F_G1F_Quad *)malloc(sizeof(icV3F_C4F_T2F_G1F_Quad) * textureGlyphCount);
+            icV2F_T2US_Quad *quads = (icV2F_T2US_Quad *)malloc(sizeof(icV2F_T2US_Quad) * textureGlyphCount);
             icUShort_QuadIndices *quadIndices = (icUShort_QuadIndices *)malloc(sizeof(icUShort_QuadIndices) * textureGlyphCount);
             
             // Iterate over all relevant glyph entries for this texture
@@ -599,24 +674,22 @@ NSString *__glyphAFSH = IC_SHADER_STRING
                 ICTextureGlyph *textureGlyph = [glyphEntry objectAtIndex:1];
                 
                 // Calculate and assign vertex positions
-                float x1, x2, y1, y2, z;
+                float x1, x2, y1, y2;
                 
                 x1 = positions[glyphIndex].x;
                 y1 = positions[glyphIndex].y;
-                x2 = x1 + textureGlyph.size.width;
-                y2 = y1 + textureGlyph.size.height;
-                z = 0;
+                x2 = x1 + textureGlyph.size.width * glyphScale;
+                y2 = y1 + textureGlyph.size.height * glyphScale;
                 
-                quads[j].vertices[0].vect = kmVec3Make(x1, y1, z);
-                quads[j].vertices[1].vect = kmVec3Make(x1, y2, z);
-                quads[j].vertices[2].vect = kmVec3Make(x2, y1, z);
-                quads[j].vertices[3].vect = kmVec3Make(x2, y2, z);
+                quads[j].vertices[0].vect = kmVec2Make(x1, y1);
+                quads[j].vertices[1].vect = kmVec2Make(x1, y2);
+                quads[j].vertices[2].vect = kmVec2Make(x2, y1);
+                quads[j].vertices[3].vect = kmVec2Make(x2, y2);
                 
-                // Assign texture coordinates, color, shift and gamma
+                // Assign texture coordinates, normalized to unsigned shorts
                 for (ushort k=0; k<4; k++) {
-                    quads[j].vertices[k].texCoords = textureGlyph.texCoords[k];
-                    quads[j].vertices[k].color = color4FFromColor4B(self.color);
-                    quads[j].vertices[k].gamma = self.gamma;
+                    quads[j].vertices[k].texCoords[0] = (GLushort)(textureGlyph.texCoords[k].x * 65535.f + .5f);
+                    quads[j].vertices[k].texCoords[1] = (GLushort)(textureGlyph.texCoords[k].y * 65535.f + .5f);
                 }
                 
                 // Calculate and assign indices
@@ -632,7 +705,7 @@ NSString *__glyphAFSH = IC_SHADER_STRING
             // Create buffers for all relevant glyphs of this texture
             ICVertexBuffer *vertexBuffer = [ICVertexBuffer vertexBufferWithVertices:quads
                                                                               count:(GLuint)textureGlyphCount * 4
-                                                                             stride:sizeof(icV3F_C4F_T2F_G1F)
+                                                                             stride:sizeof(icV2F_T2US)
                                                                               usage:GL_STATIC_DRAW];
             
             ICIndexBuffer *indexBuffer = [ICIndexBuffer indexBufferWithIndices:quadIndices
@@ -674,62 +747,53 @@ NSString *__glyphAFSH = IC_SHADER_STRING
         [self updateBuffers];
     }
     
+    // Color and gamma are uniform for the whole run
+    if (![visitor isKindOfClass:[ICNodeVisitorPicking class]]) {
+        ICShaderProgram *p = self.shaderProgram;
+        if (p != _uniformHandlesProgram) {
+            // Resolve uniform handles once per program instead of looking them up on each draw
+            [_uniformHandlesProgram release];
+            _uniformHandlesProgram = [p retain];
+            _colorUniformHandle = [p uniformHandleForName:ICUniformNameGlyphColor];
+            _inverseGammaUniformHandle = [p uniformHandleForName:ICUniformNameGlyphInverseGamma];
+        }
+        [p setVec4:kmVec4FromColor4B(_color) forUniformHandle:_colorUniformHandle];
+        [p setFloat:1.f / _gamma forUniformHandle:_inverseGammaUniformHandle];
+    }
+    
     // Draw each texture glyph buffer required to display the run
     for (ICTextureGlyphBuffer *buffer in _buffers) {
         [self applyStandardDrawSetupWithVisitor:visitor];
 
         if (![visitor isKindOfClass:[ICNodeVisitorPicking class]]) {
-            glBindTexture(GL_TEXTURE_2D, buffer.textureAtlas.name);
+            icGLBindTexture2DN(0, buffer.textureAtlas.name);
         }
         
         if ([visitor isKindOfClass:[ICNodeVisitorPicking class]]) {
-            icGLDisable(GL_BLEND);
+            icGLDisable(IC_GL_BLEND);
         } else {
             icGLBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
             icGLEnable(IC_GL_BLEND);
         }
         
-        // FIXME: needs to go into icGLState
-        glEnableVertexAttribArray(ICVertexAttribPosition);
-        glEnableVertexAttribArray(ICVertexAttribColor);
-        glEnableVertexAttribArray(ICVertexAttribTexCoords);
-        glEnableVertexAttribArray(ICVertexAttribTexCoords+1);
+        icGLEnableVertexAttribs(IC_VERTEX_ATTRIB_FLAG_POSITION | IC_VERTEX_ATTRIB_FLAG_TEX_COORDS);
         IC_CHECK_GL_ERROR_DEBUG();
         
         [buffer.vertexBuffer bind];
         [buffer.indexBuffer bind];
         
-#define kVertexSize sizeof(icV3F_C4F_T2F_G1F)
+#define kVertexSize sizeof(icV2F_T2US)
         
         // vertex
-        NSInteger diff = offsetof(icV3F_C4F_T2F_G1F, vect);
-        glVertexAttribPointer(ICVertexAttribPosition, 3, GL_FLOAT, GL_FALSE, kVertexSize, (void*)(diff));
-        
-        // color
-        diff = offsetof(icV3F_C4F_T2F_G1F, color);
-        glVertexAttribPointer(ICVertexAttribColor, 4, GL_FLOAT, GL_FALSE, kVertexSize, (void*)(diff));
+        NSInteger diff = offsetof(icV2F_T2US, vect);
+        glVertexAttribPointer(ICVertexAttribPosition, 2, GL_FLOAT, GL_FALSE, kVertexSize, (void*)(diff));
         
         // texCoords
-        diff = offsetof(icV3F_C4F_T2F_G1F, texCoords);
-        glVertexAttribPointer(ICVertexAttribTexCoords, 2, GL_FLOAT, GL_FALSE, kVertexSize, (void*)(diff));
-
-        // gamma
-        diff = offsetof(icV3F_C4F_T2F_G1F, gamma);
-        glVertexAttribPointer(ICVertexAttribTexCoords+1, 1, GL_FLOAT, GL_FALSE, kVertexSize, (void*)(diff));
+        diff = offsetof(icV2F_T2US, texCoords);
+        glVertexAttribPointer(ICVertexAttribTexCoords, 2, GL_UNSIGNED_SHORT, GL_TRUE, kVertexSize, (void*)(diff));
         
         glDrawElements(GL_TRIANGLES, buffer.indexBuffer.count, GL_UNSIGNED_SHORT, NULL);
         IC_CHECK_GL_ERROR_DEBUG();
-        
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        
-        glBindTexture(GL_TEXTURE_2D, 0);
-        IC_CHECK_GL_ERROR_DEBUG();
-        
-        glDisableVertexAttribArray(ICVertexAttribPosition);
-        glDisableVertexAttribArray(ICVertexAttribColor);
-        glDisableVertexAttribArray(ICVertexAttribTexCoords);
-        glDisableVertexAttribArray(ICVertexAttribTexCoords+1);
     }
     
     //[self debugDrawBoundingBox];
@@ -29,12 +29,22 @@
 
 /**
  @brief Represents a texture atlas for typographic glyphs
+ 
+ Glyphs are placed in the atlas using one of the rectangle bin packing algorithms defined by
+ ICGlyphPackingStrategy. The atlas keeps track of the area occupied by its glyphs, so that the
+ efficiency of different strategies may be measured using the ICGlyphTextureAtlas::occupancy
+ and ICGlyphTextureAtlas::fragmentation properties.
  */
 @interface ICGlyphTextureAtlas : ICMutableTexture2D
 
+#pragma mark - Initializing a Glyph Texture Atlas
+/** @name Initializing a Glyph Texture Atlas */
+
 /**
  @brief Initializes the receiver with a given size, pixel format and resolution type
  
+ The receiver uses the packing strategy defined by ``IC_DEFAULT_GLYPH_PACKING_STRATEGY``.
+ 
  @param sizeInPixels The size of the receiver in pixels
  @param pixelFormat The pixel format of the receiver. Currently only ``ICPixelFormatRGBA8888``
  and ``ICPixelFormatA8`` are supported by this class.
@@ -44,6 +54,25 @@
        pixelFormat:(ICPixelFormat)pixelFormat
     resolutionType:(ICResolutionType)resolutionType;
 
+/**
+ @brief Initializes the receiver with a given size, pixel format, resolution type and
+ packing strategy
+ 
+ @param sizeInPixels The size of the receiver in pixels
+ @param pixelFormat The pixel format of the receiver. Currently only ``ICPixelFormatRGBA8888``
+ and ``ICPixelFormatA8`` are supported by this class.
+ @param resolutionType The resolution type to use for the receiver
+ @param packingStrategy The ICGlyphPackingStrategy used to place glyphs in the receiver
+ */
+- (id)initWithSize:(CGSize)sizeInPixels
+       pixelFormat:(ICPixelFormat)pixelFormat
+    resolutionType:(ICResolutionType)resolutionType
+   packingStrategy:(ICGlyphPackingStrategy)packingStrategy;
+
+
+#pragma mark - Adding Glyphs
+/** @name Adding Glyphs */
+
 /**
  @brief Adds the given glyph bitmap data to the receiver
  
@@ -56,7 +85,7 @@
  @param uploadImmediately A boolean flag indicating whether to upload the given data to the
  receiver's OpenGL texture immediately.
  
- This method first employs a Skyline-BL bin packing algorithm to determine the destination
+ This method first employs the receiver's packing strategy to determine the destination
  rectangle of the given rectangular glyph bitmap data in the receiver. If there's enough space
  left in the receiver to contain the glyph's bitmap data, the method creates an ICTextureGlyph
  object for the given glyph and copies the specified bitmap data to the receiver.
@@ -68,6 +97,9 @@
  the receiver's internal data to OpenGL at a suitable point in time, i.e. when there are no more
  glyphs to add to the receiver or the texture needs to be used by a view component.
  
+ Once a glyph has been rejected, the receiver rejects glyphs at least as large without running
+ the packing algorithm, since free space in the atlas only ever shrinks.
+ 
  @return If the given glyph bitmap data fits into the receiver, this method returns an
  ICTextureGlyph object holding information about the texture glyph. If the glyph bitmap data
  does not fit into the receiver, this method returns ``nil``. In this case, the caller must
@@ -81,5 +113,32 @@
                                   font:(ICFont *)font
                      uploadImmediately:(BOOL)uploadImmediately;
 
-@end
 
+#pragma mark - Measuring Atlas Usage
+/** @name Measuring Atlas Usage */
+
+/**
+ @brief The packing strategy used by the receiver to place glyphs
+ */
+@property (nonatomic, readonly) ICGlyphPackingStrategy packingStrategy;
+
+/**
+ @brief The number of glyphs stored in the receiver
+ */
+@property (nonatomic, readonly) NSUInteger glyphCount;
+
+/**
+ @brief The ratio of the area occupied by glyphs to the total area of the receiver
+ */
+- (float)occupancy;
+
+/**
+ @brief The ratio of unused area within the bounding box of all glyphs to the area of that
+ bounding box
+ 
+ A value close to zero indicates that glyphs are packed tightly; higher values indicate that
+ the packing strategy left gaps between glyphs which are unlikely to be filled later on.
+ */
+- (float)fragmentation;
+
+@end
@@ -24,22 +24,118 @@
 #import "ICGlyphTextureAtlas.h"
 #import "ICHostViewController.h"
 #import "../3rd-party/RectangleBinPack/SkylineBinPack.h"
+#import "../3rd-party/RectangleBinPack/MaxRectsBinPack.h"
+#import "../3rd-party/RectangleBinPack/GuillotineBinPack.h"
 #import "icFontDefs.h"
 #import "icTypes.h"
 
 using RectangleBinPack::SkylineBinPack;
+using RectangleBinPack::MaxRectsBinPack;
+using RectangleBinPack::GuillotineBinPack;
+
+namespace {
+
+// Common interface for the RectangleBinPack algorithms used to place glyphs in atlases
+class ICGlyphPacker {
+public:
+    virtual ~ICGlyphPacker() {}
+    virtual RectangleBinPack::Rect Insert(long width, long height) = 0;
+};
+
+class ICSkylineGlyphPacker : public ICGlyphPacker {
+public:
+    ICSkylineGlyphPacker(long width, long height, bool minWaste)
+    : _binPack(width, height, minWaste)
+    , _heuristic(minWaste ? SkylineBinPack::LevelMinWasteFit : SkylineBinPack::LevelBottomLeft) {}
+    
+    virtual RectangleBinPack::Rect Insert(long width, long height)
+    {
+        return _binPack.Insert(width, height, _heuristic);
+    }
+    
+private:
+    SkylineBinPack _binPack;
+    SkylineBinPack::LevelChoiceHeuristic _heuristic;
+};
+
+class ICMaxRectsGlyphPacker : public ICGlyphPacker {
+public:
+    ICMaxRectsGlyphPacker(long width, long height) : _binPack(width, height) {}
+    
+    virtual RectangleBinPack::Rect Insert(long width, long height)
+    {
+        return _binPack.Insert(width, height, MaxRectsBinPack::RectBestShortSideFit);
+    }
+    
+private:
+    MaxRectsBinPack _binPack;
+};
+
+class ICGuillotineGlyphPacker : public ICGlyphPacker {
+public:
+    ICGuillotineGlyphPacker(long width, long height) : _binPack(width, height) {}
+    
+    virtual RectangleBinPack::Rect Insert(long width, long height)
+    {
+        return _binPack.Insert(width, height, true, GuillotineBinPack::RectBestAreaFit,
+                               GuillotineBinPack::SplitShorterLeftoverAxis);
+    }
+    
+private:
+    GuillotineBinPack _binPack;
+};
+
+ICGlyphPacker *ICGlyphPackerCreate(ICGlyphPackingStrategy strategy, long width, long height)
+{
+    switch (strategy) {
+        case ICGlyphPackingStrategySkylineBottomLeft:
+            return new ICSkylineGlyphPacker(width, height, false);
+        case ICGlyphPackingStrategySkylineMinWaste:
+            return new ICSkylineGlyphPacker(width, height, true);
+        case ICGlyphPackingStrategyMaxRectsBestShortSideFit:
+            return new ICMaxRectsGlyphPacker(width, height);
+        case ICGlyphPackingStrategyGuillotineMerge:
+            return new ICGuillotineGlyphPacker(width, height);
+    }
+    return NULL;
+}
+
+} // namespace
 
 @interface ICGlyphTextureAtlas () {
 @protected
-    SkylineBinPack *_skylineBinPack;
+    ICGlyphPacker *_packer;
+    
+    // Usage metrics
+    long _usedArea;
+    long _usedWidth;
+    long _usedHeight;
+    
+    // Smallest glyph size rejected so far; any glyph at least as large will not fit either
+    long _rejectedWidth;
+    long _rejectedHeight;
 }
 @end
 
 @implementation ICGlyphTextureAtlas
 
+@synthesize packingStrategy = _packingStrategy;
+@synthesize glyphCount = _glyphCount;
+
+- (id)initWithSize:(CGSize)sizeInPixels
+       pixelFormat:(ICPixelFormat)pixelFormat
+    resolutionType:(ICResolutionType)resolutionType
+{
+    return [self initWithSize:sizeInPixels
+                  pixelFormat:pixelFormat
+               resolutionType:resolutionType
+              packingStrategy:IC_DEFAULT_GLYPH_PACKING_STRATEGY];
+}
+
 - (id)initWithSize:(CGSize)sizeInPixels
        pixelFormat:(ICPixelFormat)pixelFormat
     resolutionType:(ICResolutionType)resolutionType
+   packingStrategy:(ICGlyphPackingStrategy)packingStrategy
 {
     NSAssert(pixelFormat == ICPixelFormatRGBA8888 || pixelFormat == ICPixelFormatA8,
              @"Only RGBA8888 or A8 pixel formats are supported by this class");
@@ -52,7 +148,12 @@ using RectangleBinPack::SkylineBinPack;
                            keepData:YES
                   uploadImmediately:NO])) {
         
-        _skylineBinPack = new SkylineBinPack(sizeInPixels.width, sizeInPixels.height, NO);
+        _packingStrategy = packingStrategy;
+        _packer = ICGlyphPackerCreate(packingStrategy, sizeInPixels.width, sizeInPixels.height);
+        NSAssert(_packer != NULL, @"Invalid glyph packing strategy");
+        
+        _rejectedWidth = LONG_MAX;
+        _rejectedHeight = LONG_MAX;
         
     }
     return self;
@@ -60,11 +161,27 @@ using RectangleBinPack::SkylineBinPack;
 
 - (void)dealloc
 {
-    delete _skylineBinPack;
+    delete _packer;
     
     [super dealloc];
 }
 
+- (BOOL)isKnownNotToFitWidth:(long)width height:(long)height
+{
+    // Packers may rotate glyphs, so a glyph is rejected if it is at least as large as a
+    // previously rejected glyph in either orientation
+    return (width >= _rejectedWidth && height >= _rejectedHeight) ||
+           (height >= _rejectedWidth && width >= _rejectedHeight);
+}
+
+- (void)rememberRejectedWidth:(long)width height:(long)height
+{
+    if (_rejectedWidth == LONG_MAX || width * height < _rejectedWidth * _rejectedHeight) {
+        _rejectedWidth = width;
+        _rejectedHeight = height;
+    }
+}
+
 - (ICTextureGlyph *)addGlyphBitmapData:(void *)bitmapData
                               forGlyph:(ICGlyph)glyph
                           sizeInPixels:(CGSize)sizeInPixels
@@ -76,14 +193,22 @@ using RectangleBinPack::SkylineBinPack;
     long bitmapWidth = (long)sizeInPixels.width;
     long bitmapHeight = (long)sizeInPixels.height;
     
-    RectangleBinPack::Rect rect = _skylineBinPack->Insert(sizeInPixels.width,
-                                                          sizeInPixels.height,
-                                                          SkylineBinPack::LevelBottomLeft);
+    if ([self isKnownNotToFitWidth:bitmapWidth height:bitmapHeight]) {
+        return nil;
+    }
+    
+    RectangleBinPack::Rect rect = _packer->Insert(bitmapWidth, bitmapHeight);
     if (rect.x == 0 && rect.y == 0 && rect.width == 0 && rect.height == 0) {
         // Rectangle won't fit into this texture
+        [self rememberRejectedWidth:bitmapWidth height:bitmapHeight];
         return nil;
     }
     
+    _glyphCount++;
+    _usedArea += rect.width * rect.height;
+    _usedWidth = MAX(_usedWidth, rect.x + rect.width);
+    _usedHeight = MAX(_usedHeight, rect.y + rect.height);
+    
     BOOL rotated = NO;
     if (rect.width == bitmapHeight && rect.height == bitmapWidth)
         rotated = YES;
@@ -106,9 +231,9 @@ using RectangleBinPack::SkylineBinPack;
             // Allocate new pixel data
             self.data = calloc((int)self.sizeInPixels.height, (int)self.sizeInPixels.width * stride);
         } else {
-            // Pixel data already available; we will mutate it, so we need to set dataDirty to
-            // YES here manually
-            self.dataDirty = YES;
+            // Pixel data already available; we will mutate it, so we need to mark the glyph's
+            // rect dirty here manually, so that only this region is uploaded later on
+            [self setDataDirtyInRect:CGRectMake(rect.x, rect.y, rect.width, rect.height)];
         }
 
         // Copy bitmap data to texture pixel data
@@ -173,4 +298,15 @@ using RectangleBinPack::SkylineBinPack;
     return textureGlyph;
 }
 
+- (float)occupancy
+{
+    return (float)_usedArea / (self.sizeInPixels.width * self.sizeInPixels.height);
+}
+
+- (float)fragmentation
+{
+    long boundingArea = _usedWidth * _usedHeight;
+    return boundingArea ? 1.f - (float)_usedArea / boundingArea : 0;
+}
+
 @end
@@ -29,6 +29,7 @@
 #import "ICFramebufferProvider.h"
 #import "icMacros.h"
 #import "icTypes.h"
+#import "icGLState.h"
 
 @class ICScene;
 @class ICGLView;
@@ -37,6 +38,7 @@
 @class ICResponder;
 @class ICScheduler;
 @class ICTargetActionDispatcher;
+@class ICProfiler;
 
 
 #if defined(__IC_PLATFORM_MAC)
@@ -99,6 +101,8 @@
     icTime _fpsDelta;
     uint _fpsNumFrames;
     float _fps;
+    icGLStateCounters _glStateCounters;
+    ICProfiler *_profiler;
     
     ICFrameUpdateMode _frameUpdateMode;
     NSDate *_continuousFrameUpdateExpiryDate;
@@ -269,6 +273,21 @@
  */
 @property (nonatomic, readonly) float fps;
 
+/**
+ @brief GL calls issued and eliminated by the GL state cache while drawing the last frame
+ 
+ The counters of the receiver's OpenGL context are read and reset at the beginning of each call
+ to ICHostViewController::drawScene. See #IC_ENABLE_GL_STATE_CACHE.
+ */
+@property (nonatomic, readonly) icGLStateCounters glStateCounters;
+
+/**
+ @brief The profiler recording timings of the frames drawn by the receiver
+ 
+ The profiler is disabled by default. See ICProfiler for details.
+ */
+@property (nonatomic, readonly) ICProfiler *profiler;
+
 /**
  @brief The frame update mode used to present the receiver's scene
  
@@ -293,9 +312,26 @@
 
 /**
  @brief Called by the framework to signal that the receiver's view contents need to be redrawn
+ 
+ Redraws the whole scene, even if the scene tracks damage (see ICScene::tracksDamage).
  */
 - (void)setNeedsDisplay;
 
+/**
+ @brief Called by root scenes tracking damage to signal that the damaged region of the
+ receiver's view contents needs to be redrawn
+ */
+- (void)setNeedsDisplayOfDamage;
+
+/**
+ @brief Whether the receiver's scene may redraw damaged regions only
+ 
+ Returns YES if the receiver's frame update mode is ICFrameUpdateModeOnDemand, frames are not
+ updated continuously at the moment, and the receiver's framebuffer preserves its contents
+ (see ICHostViewController::preservesFramebufferContents).
+ */
+- (BOOL)canRedrawDamageOnly;
+
 /**
  @brief The thread used to draw the receiver's scene and process HID events
  */
@@ -483,5 +519,15 @@
  */
 - (CGSize)framebufferSize;
 
+/**
+ @brief Whether the receiver's framebuffer preserves its contents after presenting a frame
+ 
+ The default implementation returns NO. On Mac OS X, the framebuffer preserves its contents if
+ the view's pixel format defines a backing store, which ICGLView does if #IC_ENABLE_DAMAGE_TRACKING
+ is activated. On iOS, the view must be initialized with a preserved backbuffer and without
+ multisampling.
+ */
+- (BOOL)preservesFramebufferContents;
+
 @end
 
@@ -34,6 +34,7 @@
 #import "icDefaults.h"
 #import "icConfig.h"
 #import "ICConfiguration.h"
+#import "ICProfiler.h"
 #import "sys/time.h"
 
 // FIXME: should be implemented using TLS
@@ -61,6 +62,8 @@ NSLock *g_hvcDictLock = nil; // lazy allocation
 @synthesize frameCount = _frameCount;
 @synthesize elapsedTime = _elapsedTime;
 @synthesize fps = _fps;
+@synthesize glStateCounters = _glStateCounters;
+@synthesize profiler = _profiler;
 @synthesize didAlreadyCallViewDidLoad = _didAlreadyCallViewDidLoad;
 @synthesize openGLContext = _openGLContext;
 
@@ -86,6 +89,7 @@ NSLock *g_hvcDictLock = nil; // lazy allocation
 {
     _scheduler = [[ICScheduler alloc] init];
     _targetActionDispatcher = [[ICTargetActionDispatcher alloc] init];
+    _profiler = [[ICProfiler alloc] init];
     _lastUpdate.tv_sec = 0;
     _lastUpdate.tv_usec = 0;
     _frameUpdateMode = ICFrameUpdateModeSynchronized;
@@ -112,6 +116,7 @@ NSLock *g_hvcDictLock = nil; // lazy allocation
     [_scheduler release];
     [_targetActionDispatcher release];
     [_continuousFrameUpdateExpiryDate release];
+    [_profiler release];
 
     // Make sure no bad access can occur with the current host view controller
     ICHostViewController *currentHVC = [[self class] currentHostViewController];
@@ -187,7 +192,8 @@ NSLock *g_hvcDictLock = nil; // lazy allocation
             _fpsDelta = 0;
             _fpsNumFrames = 0;
 #if IC_DEBUG_OUTPUT_FPS_ON_CONSOLE
-            ICLog(@"FPS: %f", _fps);
+            ICLog(@"FPS: %f, GL calls issued: %u, redundant GL calls eliminated: %u",
+                  _fps, _glStateCounters.issuedCalls, _glStateCounters.eliminatedCalls);
 #endif
         }
     }
@@ -205,6 +211,12 @@ NSLock *g_hvcDictLock = nil; // lazy allocation
 }
 
 - (void)setNeedsDisplay
+{
+    [_scene addDamageRect:CGRectInfinite];
+    [self setNeedsDisplayOfDamage];
+}
+
+- (void)setNeedsDisplayOfDamage
 {
     _needsDisplay = YES;
     
@@ -225,10 +237,25 @@ NSLock *g_hvcDictLock = nil; // lazy allocation
     // Make the receiver the current host view controller before drawing the scene
     [self makeCurrentHostViewController];
     
+    // Keep the GL state counters of the last frame and start counting for this frame
+    _glStateCounters = icGLGetStateCounters();
+    icGLResetStateCounters();
+    
+    // Make the receiver's profiler record zones measured on this thread while drawing
+    icProfilerSetCurrent(_profiler);
+    [_profiler beginFrame];
+    
     if (!_didDrawFirstFrame) {
         _didDrawFirstFrame = YES;
         [self willDrawFirstFrame];
     }
+    
+#if IC_ENABLE_ASYNC_GLYPH_RASTERIZATION
+    // Add glyphs rasterized in the background since the last frame to the glyph cache
+    IC_PROFILE_ZONE_BEGIN(glyphZone, ICProfilerCategoryGlyphCache);
+    [_openGLContext.glyphCache commitRasterizedGlyphs];
+    IC_PROFILE_ZONE_END(glyphZone, ICProfilerCategoryGlyphCache, "Commit rasterized glyphs");
+#endif
 }
 
 // Deprecated as of v0.6.6
@@ -511,6 +538,19 @@ NSLock *g_hvcDictLock = nil; // lazy allocation
     return [[self view] bounds].size;
 }
 
+- (BOOL)preservesFramebufferContents
+{
+    return NO;
+}
+
+- (BOOL)canRedrawDamageOnly
+{
+    BOOL updatesContinuously = _continuousFrameUpdateExpiryDate &&
+        [_continuousFrameUpdateExpiryDate compare:[NSDate date]] == NSOrderedDescending;
+    return _frameUpdateMode == ICFrameUpdateModeOnDemand && !updatesContinuously &&
+           [self preservesFramebufferContents];
+}
+
 
 // Private
 
@@ -0,0 +1,91 @@
+//
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "ICAnimationTimingFunction.h"
+
+/**
+ @brief Implements a piecewise animation timing function defined by keyframes
+ 
+ ICKeyframeTimingFunction maps input time factors to output time factors by interpolating
+ between keyframes. Each keyframe is defined by a key time ``x`` and a value ``y``. Between two
+ keyframes, the value is interpolated linearly or, if ICKeyframeTimingFunction::timingFunctions
+ is set, using the timing function defined for the respective segment.
+ 
+ Key times must be in ascending order and in range [0,1]. Input time factors before the first or
+ after the last key time are mapped to the value of the first or last keyframe respectively.
+ Keyframe timing functions are evaluated directly and never bake lookup tables.
+ */
+@interface ICKeyframeTimingFunction : ICAnimationTimingFunction {
+@protected
+    float *_keyTimes;
+    float *_values;
+    NSUInteger _keyframeCount;
+    NSArray *_timingFunctions;
+}
+
+/**
+ @brief Returns a new autoreleased keyframe timing function with the given key times and values
+ 
+ @sa initWithKeyTimes:values:timingFunctions:
+ */
++ (id)timingFunctionWithKeyTimes:(NSArray *)keyTimes values:(NSArray *)values;
+
+/**
+ @brief Returns a new autoreleased keyframe timing function with the given key times, values
+ and segment timing functions
+ 
+ @sa initWithKeyTimes:values:timingFunctions:
+ */
++ (id)timingFunctionWithKeyTimes:(NSArray *)keyTimes
+                          values:(NSArray *)values
+                 timingFunctions:(NSArray *)timingFunctions;
+
+/**
+ @brief Initializes the receiver with the given key times, values and segment timing functions
+ 
+ @param keyTimes An array of NSNumber objects defining the key times of the receiver's keyframes
+ in ascending order
+ @param values An array of NSNumber objects defining the values of the receiver's keyframes
+ @param timingFunctions An array of ICAnimationTimingFunction objects applied to the segments
+ between keyframes, or nil to interpolate all segments linearly. If not nil, the array must
+ contain one timing function less than there are keyframes.
+ 
+ @exception Raises an NSInvalidArgumentException if less than two keyframes are given, if the
+ number of key times, values or timing functions does not match, or if key times are not
+ in ascending order within range [0,1].
+ */
+- (id)initWithKeyTimes:(NSArray *)keyTimes
+                values:(NSArray *)values
+       timingFunctions:(NSArray *)timingFunctions;
+
+/**
+ @brief The number of keyframes of the receiver
+ */
+@property (nonatomic, readonly) NSUInteger keyframeCount;
+
+/**
+ @brief The timing functions applied to the segments between keyframes, or nil
+ */
+@property (nonatomic, readonly) NSArray *timingFunctions;
+
+@end
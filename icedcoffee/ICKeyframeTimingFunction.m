@@ -0,0 +1,122 @@
+//
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "ICKeyframeTimingFunction.h"
+
+@implementation ICKeyframeTimingFunction
+
+@synthesize keyframeCount = _keyframeCount;
+@synthesize timingFunctions = _timingFunctions;
+
++ (id)timingFunctionWithKeyTimes:(NSArray *)keyTimes values:(NSArray *)values
+{
+    return [[self class] timingFunctionWithKeyTimes:keyTimes values:values timingFunctions:nil];
+}
+
++ (id)timingFunctionWithKeyTimes:(NSArray *)keyTimes
+                          values:(NSArray *)values
+                 timingFunctions:(NSArray *)timingFunctions
+{
+    return [[[[self class] alloc] initWithKeyTimes:keyTimes
+                                            values:values
+                                   timingFunctions:timingFunctions] autorelease];
+}
+
+- (id)initWithKeyTimes:(NSArray *)keyTimes
+                values:(NSArray *)values
+       timingFunctions:(NSArray *)timingFunctions
+{
+    NSUInteger count = [keyTimes count];
+    if (count < 2 || [values count] != count ||
+        (timingFunctions && [timingFunctions count] != count - 1)) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"Keyframe timing functions require at least two keyframes and "
+                            "one timing function per segment"];
+        [self release];
+        return nil;
+    }
+    
+    if ((self = [super initWithControlPointsC0:kmVec2Make(0.f, 0.f)
+                                            c1:kmVec2Make(1.f, 1.f)
+                                 interpolation:ICTimingFunctionInterpolationNone])) {
+        _keyframeCount = count;
+        _keyTimes = malloc(count * sizeof(float));
+        _values = malloc(count * sizeof(float));
+        for (NSUInteger i=0; i<count; i++) {
+            _keyTimes[i] = [[keyTimes objectAtIndex:i] floatValue];
+            _values[i] = [[values objectAtIndex:i] floatValue];
+            if (_keyTimes[i] < 0.f || _keyTimes[i] > 1.f || (i > 0 && _keyTimes[i] < _keyTimes[i-1])) {
+                [NSException raise:NSInvalidArgumentException
+                            format:@"Key times must be in ascending order within range [0,1]"];
+            }
+        }
+        _timingFunctions = [timingFunctions copy];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_keyTimes);
+    free(_values);
+    [_timingFunctions release];
+    
+    [super dealloc];
+}
+
+- (void)setInterpolation:(ICTimingFunctionInterpolation)interpolation
+{
+    // Keyframes are looked up directly
+}
+
+- (icTime)evaluate:(icTime)x
+{
+    if (x <= _keyTimes[0])
+        return _values[0];
+    if (x >= _keyTimes[_keyframeCount-1])
+        return _values[_keyframeCount-1];
+    
+    // Find the segment [lo, lo+1] containing x
+    NSUInteger lo = 0, hi = _keyframeCount - 1;
+    while (hi - lo > 1) {
+        NSUInteger mid = (lo + hi) / 2;
+        if (_keyTimes[mid] <= x)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    
+    float segmentDuration = _keyTimes[lo+1] - _keyTimes[lo];
+    icTime t = segmentDuration > 0.f ? (x - _keyTimes[lo]) / segmentDuration : 1;
+    if (_timingFunctions) {
+        t = [[_timingFunctions objectAtIndex:lo] transform:t];
+    }
+    return _values[lo] + t * (_values[lo+1] - _values[lo]);
+}
+
+- (NSString *)lookupTableKey
+{
+    return nil;
+}
+
+@end
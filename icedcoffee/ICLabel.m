@@ -30,6 +30,13 @@
 #import "ICTextLine.h"
 #import "ICTextFrame.h"
 #import "icUtils.h"
+#import "ICTextLayoutCache.h"
+
+// Measurements of a label's attributed text cached in the shared text layout cache
+typedef struct _icLabelMeasurement {
+    kmVec2 textFrameSize;
+    kmVec3 size;
+} icLabelMeasurement;
 
 @interface ICLabel ()
 
@@ -341,6 +348,18 @@
                                textFrameSize:(kmVec2 *)textFrameSize
                                         size:(kmVec3 *)size
 {
+    // Labels with identical text share their measurements via the layout cache
+    ICTextLayoutCache *layoutCache = [ICTextLayoutCache sharedTextLayoutCache];
+    NSValue *cachedMeasurement = [layoutCache resultForAttributedString:attributedText
+                                                                   kind:@"ICLabelAutoresizing"];
+    if (cachedMeasurement) {
+        icLabelMeasurement measurement;
+        [cachedMeasurement getValue:&measurement];
+        *textFrameSize = measurement.textFrameSize;
+        *size = measurement.size;
+        return;
+    }
+    
     // Measure each text line contained in text
     __block float maxHeight = 0;
     __block float maxLabelHeight = 0;
@@ -396,6 +415,13 @@
     *size = kmVec3Make(maxLineWidth, maxLabelHeight, 0);
     
     [textLines release];
+    
+    icLabelMeasurement measurement;
+    measurement.textFrameSize = *textFrameSize;
+    measurement.size = *size;
+    [layoutCache setResult:[NSValue valueWithBytes:&measurement objCType:@encode(icLabelMeasurement)]
+      forAttributedString:attributedText
+                     kind:@"ICLabelAutoresizing"];
 }
 
 - (void)setSize:(kmVec3)size adjustTextFrameSize:(BOOL)adjustTextFrameSize
@@ -24,6 +24,7 @@
 #import "ICLine2D.h"
 #import "ICShaderProgram.h"
 #import "ICShaderCache.h"
+#import "icGLState.h"
 
 #define ICLINE_DEFAULT_LINE_WIDTH 1
 #define ICLINE_DEFAULT_ANTIALIAS_STRENGTH 1.0f
@@ -95,6 +96,8 @@
         self.lineWidth = lineWidth;
         self.antialiasStrength = antialiasStrength;
         self.color = color;
+        // Lines extend beyond their bounds by half their width
+        self.drawsOutsideBounds = YES;
         self.shaderProgram = [[ICShaderCache currentShaderCache]
                               shaderProgramForKey:kICShader_PositionColor];
     }
@@ -104,7 +107,7 @@
 - (void)dealloc
 {
     if (_vertexBuffer)
-        glDeleteBuffers(1, &_vertexBuffer);
+        icGLDeleteBuffer(_vertexBuffer);
     
     [super dealloc];
 }
@@ -199,9 +202,8 @@
     if (!_vertexBuffer)
         glGenBuffers(1, &_vertexBuffer);
     
-    glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+    icGLBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
     glBufferData(GL_ARRAY_BUFFER, sizeof(icV3F_C4F_T2F) * ICLINE_NUM_VERTICES, vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);    
     IC_CHECK_GL_ERROR_DEBUG();
 }
 
@@ -240,17 +242,14 @@
         _lineTransformDirty = NO;
     }
     
-    kmGLPushMatrix();
-    kmGLMultMatrix(&_lineTransform);
+    kmGLPushMultMatrix(&_lineTransform);
     
     [self applyStandardDrawSetupWithVisitor:visitor];
     
-    glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    icGLBindTexture2DN(0, 0);
     
-    glEnableVertexAttribArray(ICVertexAttribPosition);
-    glEnableVertexAttribArray(ICVertexAttribColor);
-    glEnableVertexAttribArray(ICVertexAttribTexCoords);
+    icGLEnableVertexAttribs(IC_VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
+    icGLBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
     IC_CHECK_GL_ERROR_DEBUG();
     
 #define kVertexSize sizeof(icV3F_C4F_T2F)
@@ -270,12 +269,6 @@
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, ICLINE_NUM_VERTICES);
     IC_CHECK_GL_ERROR_DEBUG();
     
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    
-    glDisableVertexAttribArray(ICVertexAttribPosition);
-    glDisableVertexAttribArray(ICVertexAttribColor);
-    glDisableVertexAttribArray(ICVertexAttribTexCoords);
-    
     kmGLPopMatrix();
 }
 
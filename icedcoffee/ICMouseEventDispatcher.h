@@ -58,6 +58,7 @@ typedef NSUInteger ICAbstractMouseEventType;
     NSUInteger _eventNumber;
     BOOL _acceptsMouseMovedEvents;
     BOOL _updatesEnterExitEventsContinuously;
+    BOOL _mouseOverReadbackLags;
 }
 
 
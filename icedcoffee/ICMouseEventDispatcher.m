@@ -180,7 +180,7 @@ ICMouseButton ICMouseButtonFromEventType(ICOSXEventType eventType)
 - (void)prepareUpdateMouseOverState
 {
     if (!_acceptsMouseMovedEvents ||
-        (!_updatesEnterExitEventsContinuously &&
+        (!_updatesEnterExitEventsContinuously && !_mouseOverReadbackLags &&
          _lastMouseLocation.x == _previousMouseLocation.x &&
          _lastMouseLocation.y == _previousMouseLocation.y))
         return;
@@ -193,13 +193,19 @@ ICMouseButton ICMouseButtonFromEventType(ICOSXEventType eventType)
 - (void)updateMouseOverState:(BOOL)deferredReadback
 {
     if (!_acceptsMouseMovedEvents ||
-        (!_updatesEnterExitEventsContinuously &&
+        (!_updatesEnterExitEventsContinuously && !_mouseOverReadbackLags &&
          _lastMouseLocation.x == _previousMouseLocation.x &&
          _lastMouseLocation.y == _previousMouseLocation.y))
         return;
     
-    if (!_updatesEnterExitEventsContinuously)
+    if (!_updatesEnterExitEventsContinuously) {
+        // Deferred readbacks return the results of the previous hit test, so one more update
+        // is required after the mouse stopped moving to catch up with its final location
+        _mouseOverReadbackLags = deferredReadback &&
+                                 (_lastMouseLocation.x != _previousMouseLocation.x ||
+                                  _lastMouseLocation.y != _previousMouseLocation.y);
         _previousMouseLocation = _lastMouseLocation;
+    }
     
     NSArray *hitNodes = deferredReadback ? [_hostViewController performHitTestReadback] :
                         [_hostViewController hitTest:_lastMouseLocation];
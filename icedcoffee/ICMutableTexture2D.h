@@ -22,6 +22,7 @@
 //
 
 #import "ICTexture2D.h"
+#import "icConfig.h"
 
 /**
  @brief Represents a mutable two-dimensional texture
@@ -32,12 +33,17 @@
  - Keeping a copy of a texture's data in RAM
  - Uploading modified texture data to OpenGL at any time
  - Updating a rectangular area of a texture at any time
+ - Tracking modified regions of the texture's data, so that only those regions are uploaded
  */
 @interface ICMutableTexture2D : ICTexture2D {
 @protected
     void *_data;
     BOOL _ownsData;
     BOOL _dataDirty;
+    // Dirty regions of _data in pixels; if _dataDirty is YES and there are no dirty rects,
+    // the whole texture is dirty
+    CGRect _dirtyRects[IC_MAX_TEXTURE_DIRTY_RECTS];
+    NSUInteger _dirtyRectCount;
 }
 
 /**
@@ -98,11 +104,46 @@
 /**
  @brief Whether the receiver's current ICMutableTexture2D::data is in a dirty state (has not
  yet been uploaded to OpenGL)
+ 
+ Setting this property to ``YES`` marks the whole texture dirty, setting it to ``NO`` discards
+ all dirty regions.
  */
 @property (nonatomic, assign) BOOL dataDirty;
 
+/**
+ @brief Marks the given rectangle of the receiver's ICMutableTexture2D::data dirty
+ 
+ @param rect The modified rectangle in pixels
+ 
+ The receiver keeps a list of up to #IC_MAX_TEXTURE_DIRTY_RECTS dirty rectangles, merging
+ rectangles that overlap or are close to each other. When ICMutableTexture2D::upload is
+ called, only the dirty rectangles are uploaded, unless the whole texture is dirty or no
+ OpenGL texture has been created yet.
+ */
+- (void)setDataDirtyInRect:(CGRect)rect;
+
+/**
+ @brief The number of dirty rectangles waiting to be uploaded
+ 
+ Returns zero if the receiver's data is not dirty or if the whole texture is dirty.
+ */
+@property (nonatomic, readonly) NSUInteger dirtyRectCount;
+
+/**
+ @brief Returns the dirty rectangle at the given index, in pixels
+ */
+- (CGRect)dirtyRectAtIndex:(NSUInteger)index;
+
+/**
+ @brief Returns the number of bytes per pixel of the receiver's pixel format
+ */
+- (uint)bytesPerPixel;
+
 /**
  @brief Uploads the receiver's ICMutableTexture2D::data to OpenGL video memory
+ 
+ If only parts of the receiver's data have been marked dirty using
+ ICMutableTexture2D::setDataDirtyInRect:, only those parts are uploaded.
  */
 - (void)upload;
 
@@ -114,6 +155,9 @@
 /**
  @brief Uploads the given data to the specified rectangle of the receiver's texture in OpenGL
  video memory
+ 
+ The given data must contain tightly packed rows of pixels formatted as defined by the
+ receiver's pixel format.
  */
 - (void)uploadData:(const void *)data inRect:(CGRect)rect;
 
@@ -25,6 +25,48 @@
 
 #import "ICMutableTexture2D.h"
 #import "ICTexture2D_Private.h"
+#import "icGLState.h"
+
+// Dirty rects are merged if the union wastes less than a quarter of the area they cover or
+// fewer pixels than this, as each upload call comes at a fixed cost
+#define IC_DIRTY_RECT_MERGE_SLACK 1024
+
+static BOOL icGLFormatForPixelFormat(ICPixelFormat pixelFormat, GLenum *format, GLenum *type)
+{
+    switch (pixelFormat) {
+        case ICPixelFormatRGBA8888: *format = GL_RGBA; *type = GL_UNSIGNED_BYTE; return YES;
+        case ICPixelFormatRGBA4444: *format = GL_RGBA; *type = GL_UNSIGNED_SHORT_4_4_4_4; return YES;
+        case ICPixelFormatRGB5A1: *format = GL_RGBA; *type = GL_UNSIGNED_SHORT_5_5_5_1; return YES;
+        case ICPixelFormatRGB565: *format = GL_RGB; *type = GL_UNSIGNED_SHORT_5_6_5; return YES;
+        case ICPixelFormatA8: *format = GL_ALPHA; *type = GL_UNSIGNED_BYTE; return YES;
+        default: return NO;
+    }
+}
+
+static float icRectArea(CGRect rect)
+{
+    return rect.size.width * rect.size.height;
+}
+
+// Returns the number of pixels in the union of a and b covered by neither a nor b
+static float icMergeWaste(CGRect a, CGRect b)
+{
+    CGRect intersection = CGRectIntersection(a, b);
+    float covered = icRectArea(a) + icRectArea(b) -
+                    (CGRectIsNull(intersection) ? 0 : icRectArea(intersection));
+    return icRectArea(CGRectUnion(a, b)) - covered;
+}
+
+static BOOL icShouldMergeRects(CGRect a, CGRect b)
+{
+    float waste = icMergeWaste(a, b);
+    return waste <= MAX((icRectArea(a) + icRectArea(b)) / 4, IC_DIRTY_RECT_MERGE_SLACK);
+}
+
+
+@interface ICMutableTexture2D (Private)
+- (void)uploadDataInRect:(CGRect)rect;
+@end
 
 @implementation ICMutableTexture2D
 
@@ -82,6 +124,78 @@
         self.dataDirty = YES;
 }
 
+- (void)setDataDirty:(BOOL)dataDirty
+{
+    _dataDirty = dataDirty;
+    _dirtyRectCount = 0;
+}
+
+- (void)setDataDirtyInRect:(CGRect)rect
+{
+    rect = CGRectIntersection(CGRectIntegral(rect),
+                              CGRectMake(0, 0, _sizeInPixels.width, _sizeInPixels.height));
+    if (CGRectIsNull(rect) || CGRectIsEmpty(rect))
+        return;
+    if (_dataDirty && !_dirtyRectCount)
+        return; // whole texture is dirty already
+    
+    _dataDirty = YES;
+    
+    // Merge with existing rects as long as possible, as merged rects may overlap others
+    BOOL merged;
+    do {
+        merged = NO;
+        for (NSUInteger i=0; i<_dirtyRectCount; i++) {
+            if (icShouldMergeRects(rect, _dirtyRects[i])) {
+                rect = CGRectUnion(rect, _dirtyRects[i]);
+                _dirtyRects[i] = _dirtyRects[--_dirtyRectCount];
+                merged = YES;
+                break;
+            }
+        }
+    } while (merged);
+    
+    if (_dirtyRectCount == IC_MAX_TEXTURE_DIRTY_RECTS) {
+        // Merge with the rect wasting the fewest pixels
+        NSUInteger best = 0;
+        float bestWaste = icMergeWaste(rect, _dirtyRects[0]);
+        for (NSUInteger i=1; i<_dirtyRectCount; i++) {
+            float waste = icMergeWaste(rect, _dirtyRects[i]);
+            if (waste < bestWaste) {
+                best = i;
+                bestWaste = waste;
+            }
+        }
+        rect = CGRectUnion(rect, _dirtyRects[best]);
+        _dirtyRects[best] = _dirtyRects[--_dirtyRectCount];
+    }
+    
+    _dirtyRects[_dirtyRectCount++] = rect;
+}
+
+- (NSUInteger)dirtyRectCount
+{
+    return _dirtyRectCount;
+}
+
+- (CGRect)dirtyRectAtIndex:(NSUInteger)index
+{
+    NSAssert(index < _dirtyRectCount, @"Dirty rect index out of bounds");
+    return _dirtyRects[index];
+}
+
+- (uint)bytesPerPixel
+{
+    switch (_format) {
+        case ICPixelFormatRGBA8888: return 4;
+        case ICPixelFormatRGBA4444:
+        case ICPixelFormatRGB5A1:
+        case ICPixelFormatRGB565: return 2;
+        case ICPixelFormatA8: return 1;
+        default: return 0;
+    }
+}
+
 - (void)internalUploadData:(const void *)data
 {
     [super internalUploadData:data];
@@ -92,9 +206,19 @@
 
 - (void)upload
 {
-    if (self.data) {
+    if (!self.data)
+        return;
+    
+    if (!_name || !_dirtyRectCount) {
+        // Initial upload or whole texture dirty
         [self internalUploadData:self.data];
+        return;
     }
+    
+    for (NSUInteger i=0; i<_dirtyRectCount; i++) {
+        [self uploadDataInRect:_dirtyRects[i]];
+    }
+    self.dataDirty = NO;
 }
 
 - (void)uploadData:(const void *)data
@@ -106,14 +230,67 @@
 {
     NSAssert(data != self.data, @"This method is not thought to upload the texture's internal data");
     
+    GLenum format, type;
+    if (!icGLFormatForPixelFormat(_format, &format, &type)) {
+        [NSException raise:NSInternalInconsistencyException format:@"Unsupported pixel format"];
+    }
+    
     if (_name) {
-        glBindTexture(GL_TEXTURE_2D, _name);
+        icGLBindTexture2D(_name);
         glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)rect.origin.x, (GLint)rect.origin.y,
-                        (GLsizei)rect.size.width, (GLsizei)rect.size.height, GL_RGBA,
-                        GL_UNSIGNED_BYTE, data);
+                        (GLsizei)rect.size.width, (GLsizei)rect.size.height, format,
+                        type, data);
+        IC_CHECK_GL_ERROR_DEBUG();
     } else {
         ICLog(@"ICMutableTextur2D: cannot update uninitialized texture");
     }
 }
 
 @end
+
+
+@implementation ICMutableTexture2D (Private)
+
+// Uploads the given rectangle of the receiver's internal data
+- (void)uploadDataInRect:(CGRect)rect
+{
+    GLenum format, type;
+    if (!icGLFormatForPixelFormat(_format, &format, &type)) {
+        [NSException raise:NSInternalInconsistencyException format:@"Unsupported pixel format"];
+    }
+    
+    uint bytesPerPixel = [self bytesPerPixel];
+    size_t textureRowLength = (size_t)_sizeInPixels.width * bytesPerPixel;
+    GLint x = (GLint)rect.origin.x;
+    GLint y = (GLint)rect.origin.y;
+    GLsizei width = (GLsizei)rect.size.width;
+    GLsizei height = (GLsizei)rect.size.height;
+    const uint8_t *origin = (const uint8_t *)_data + y * textureRowLength + x * bytesPerPixel;
+    
+    icGLBindTexture2D(_name);
+    
+    if (width == (GLsizei)_sizeInPixels.width) {
+        // Full width rows are contiguous in memory
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, origin);
+    } else {
+#ifdef __IC_PLATFORM_MAC
+        // Let OpenGL skip the remainders of the rows
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)_sizeInPixels.width);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, origin);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#else
+        // OpenGL ES 2 does not support GL_UNPACK_ROW_LENGTH, so pack the rows tightly
+        size_t rowLength = width * bytesPerPixel;
+        uint8_t *packed = malloc(rowLength * height);
+        for (GLsizei row=0; row<height; row++) {
+            memcpy(packed + row * rowLength, origin + row * textureRowLength, rowLength);
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, packed);
+        free(packed);
+#endif
+    }
+    
+    IC_CHECK_GL_ERROR_DEBUG();
+}
+
+@end
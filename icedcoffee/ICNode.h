@@ -132,6 +132,10 @@ typedef BOOL(^ICNodeFilterBlockType)(ICNode *node, BOOL *stop);
     kmVec3 _rotationAxis;
     float _rotationAngle;
     BOOL _transformDirty;
+    kmMat4 _worldTransform;
+    kmMat4 _inverseWorldTransform;
+    BOOL _worldTransformDirty;
+    BOOL _inverseWorldTransformDirty;
     BOOL _computesTransform;
     BOOL _autoCenterAnchorPoint;
     
@@ -143,9 +147,17 @@ typedef BOOL(^ICNodeFilterBlockType)(ICNode *node, BOOL *stop);
     // Drawing
     ICShaderProgram *_shaderProgram;
     BOOL _isVisible;
+    BOOL _drawsOutsideBounds;
+    
+    // Bounds
+    kmAABB _subtreeAABB;
+    BOOL _subtreeAABBDirty;
+    BOOL _subtreeDrawsOutsideBounds;
+    CGRect _drawnRect;
     
     // User interaction support
     BOOL _userInteractionEnabled;
+    BOOL _requiresPixelExactHitTest;
     
     // Debugging
     NSString *_dbgParentInfo;
@@ -566,9 +578,13 @@ typedef BOOL(^ICNodeFilterBlockType)(ICNode *node, BOOL *stop);
  @brief A transform matrix used to transform coordinates from the receiver's local node space
  to world space
  
- This method multiplies all ancestor transform matrices, starting with the receiver's direct
- parent, until an ICScene object's parent (or nil) is reached. It invokes nodeToParentTransform
- on all ancestor nodes to retrieve their updated transform matrices.
+ The world transform is the product of all ancestor transform matrices, starting with the
+ receiver's direct parent, until an ICScene object's parent (or nil) is reached.
+ 
+ The receiver caches its world transform. Changing the transform of a node marks the cached
+ world transforms of the node and all its descendants dirty. Dirty world transforms are
+ recomputed lazily from the parent's cached world transform, so retrieving the world transform
+ of a node whose ancestors have not changed does not require walking the ancestor chain.
  
  Note that in icedcoffee the world space of a given node is represented by its nearest ICScene
  ancestor's local coordinate space. This is done to ensure that nested scenes are represented
@@ -576,12 +592,20 @@ typedef BOOL(^ICNodeFilterBlockType)(ICNode *node, BOOL *stop);
  */
 - (kmMat4)nodeToWorldTransform;
 
+/**
+ @brief A const pointer to the receiver's cached world transform matrix
+ 
+ Updates the cached world transform if necessary. The returned pointer is valid until the
+ receiver is deallocated.
+ */
+- (const kmMat4 *)nodeToWorldTransformPtr;
+
 /**
  @brief A transform matrix used to transform coordinates from world space to the receiver's
  local node space
 
- This method invokes nodeToWorldTransform, calculates its inverse and returns the result.
- The resulting matrix may be used to transform coordinates from world space to local node space.
+ Returns the inverse of nodeToWorldTransform. The inverse is cached and recomputed only if the
+ receiver's world transform has changed.
  */
 - (kmMat4)worldToNodeTransform;
 
@@ -971,6 +995,43 @@ typedef BOOL(^ICNodeFilterBlockType)(ICNode *node, BOOL *stop);
  */
 - (kmAABB)aabb;
 
+/**
+ @brief Returns the receiver's axis-aligned bounding box in world coordinate space
+ 
+ This method transforms all eight corners of ICNode::localAABB using the receiver's cached
+ world transform (see ICNode::nodeToWorldTransform) and computes the axis-aligned bounding box
+ enclosing the transformed corners.
+ */
+- (kmAABB)worldAABB;
+
+/**
+ @brief Returns the axis-aligned bounding box of the receiver's branch in local coordinate space
+ 
+ The returned box encloses the receiver's ICNode::localAABB and the subtree bounding boxes of all
+ its visible drawing children. It is cached and recomputed when the receiver or one of its
+ descendants changes its bounds, transform, visibility or children. ICScene returns its
+ ICNode::localAABB, as the contents of a scene are confined to its frame.
+ 
+ The returned box is meaningless if ICNode::subtreeDrawsOutsideBounds returns YES.
+ */
+- (kmAABB)subtreeAABB;
+
+/**
+ @brief Whether the receiver or one of its visible descendants draws outside its bounds
+ 
+ Returns YES if ICNode::drawsOutsideBounds is set for the receiver or one of the visible nodes
+ on its branch.
+ */
+- (BOOL)subtreeDrawsOutsideBounds;
+
+/**
+ @brief Marks the cached subtree bounding boxes of the receiver and its ancestors dirty
+ 
+ Invoked automatically along with ICNode::setNeedsSpatialIndexUpdate and when the receiver's
+ transform changes.
+ */
+- (void)setNeedsSubtreeAABBUpdate;
+
 /**
  @brief The rectangle occupied by the receiver on its parent scene's framebuffer
  
@@ -1075,7 +1136,9 @@ typedef BOOL(^ICNodeFilterBlockType)(ICNode *node, BOOL *stop);
  this method to ensure that the render texture's contents are redrawn to reflect a change
  in the appearance of the receiver. Likewise, if the receiver's ICNode::hostViewController's
  ICHostViewController::frameUpdateMode is set to ICFrameUpdateModeOnDemand, this method needs
- to be called so that the whole scene is redrawn on the host view controller's view.
+ to be called so that the scene is redrawn on the host view controller's view. If the root scene
+ tracks damage (see ICScene::tracksDamage), only the region covered by the receiver's branch
+ before and after the change is redrawn.
  
  Note that this method does not actually redraw the receiver. Instead, it informs the framework
  to redraw the content's of the receiver's parent frame buffer the next time it enters the
@@ -1087,6 +1150,16 @@ typedef BOOL(^ICNodeFilterBlockType)(ICNode *node, BOOL *stop);
  */
 - (void)setNeedsDisplay;
 
+/**
+ @brief The bounds of the receiver's branch when it was last drawn, in normalized device
+ coordinates of the root scene's framebuffer
+ 
+ Set by ICNodeVisitorDrawing if the root scene tracks damage (see ICScene::tracksDamage). The
+ value is ``CGRectNull`` if the receiver's branch has not been drawn and ``CGRectInfinite`` if
+ its bounds are unknown, for example if it draws outside its bounds.
+ */
+@property (nonatomic, assign) CGRect drawnRect;
+
 
 #pragma mark - Performing Ray-based Hit Testing
 /** @name Performing Ray-based Hit Testing */
@@ -1110,6 +1183,48 @@ typedef BOOL(^ICNodeFilterBlockType)(ICNode *node, BOOL *stop);
  */
 - (ICHitTestResult)localRayHitTest:(icRay3)ray;
 
+/**
+ @brief A boolean flag indicating whether the receiver requires a color-based picking test
+
+ ICNodeVisitorRayPicking resolves hit tests using the node's world axis-aligned bounding box
+ (see ICNode::worldAABB) and ICNode::localRayHitTest:. This is exact for rectangular nodes,
+ but not for nodes whose visible shape covers only parts of their bounds, such as glyph runs
+ or sprites with transparent regions. Set this property to YES to let the picking visitor
+ confirm hits on the receiver by drawing it in its pick color, as done by ICNodeVisitorPicking.
+ Color-based picking is considerably more expensive than ray-based picking, as it requires
+ a GPU round trip. The default value for this property is ``NO``.
+ */
+@property (nonatomic, assign) BOOL requiresPixelExactHitTest;
+
+/**
+ @brief Informs the scene indexing the receiver's branch that its spatial index needs to be
+ rebuilt
+
+ ICScene maintains a spatial index of the world bounding boxes of its nodes for ray-based
+ picking (see ICNodeVisitorRayPicking). ICNode invokes this method automatically when the
+ receiver's transform, size, visibility, z-index or parent changes. If you subclass ICNode and
+ override ICNode::localAABB, you must call this method whenever the bounds returned by your
+ implementation change for other reasons.
+ 
+ The default implementation forwards the message to the receiver's parent. ICScene overrides
+ this method to mark its own spatial index dirty.
+ */
+- (void)setNeedsSpatialIndexUpdate;
+
+
+#pragma mark - Culling
+/** @name Culling */
+
+/**
+ @brief Whether the receiver draws outside the bounds returned by ICNode::localAABB
+ 
+ ICNodeVisitorDrawing skips drawing nodes whose branch lies outside of the camera frustum or
+ the clipping region of an ancestor view (see ICNodeVisitorDrawing::cullsNodes). Set this
+ property to YES if the receiver draws outside its bounds to exclude the receiver and its
+ ancestors' branches from culling. The default value is ``NO``.
+ */
+@property (nonatomic, assign) BOOL drawsOutsideBounds;
+
 
 #pragma mark - Managing User Interaction Support
 /** @name Managing User Interaction Support */
@@ -48,6 +48,9 @@
 - (void)setChildren:(NSMutableArray *)children;
 - (void)setNeedsDisplayForNode:(ICNode *)node;
 - (NSArray *)childrenSortedByZIndex;
+- (void)setTransformDirty;
+- (void)invalidateWorldTransform;
+- (void)updateSubtreeAABB;
 @end
 
 
@@ -82,6 +85,8 @@
         kmMat4 identity;
         kmMat4Identity(&identity);
         self.transform = identity;
+        _worldTransformDirty = YES;
+        _inverseWorldTransformDirty = YES;
         
         // Auto center anchor point when content size is set
         self.autoCenterAnchorPoint = YES;
@@ -93,6 +98,8 @@
         self.zIndex = ICZIndexUndefined;
         
         _childrenSortedByZIndexDirty = YES;
+        _subtreeAABBDirty = YES;
+        _drawnRect = CGRectNull;
 #if defined(DEBUG) && IC_DEBUG_ICNODE_PARENTS
         _dbgParentInfo = nil;
 #endif
@@ -145,6 +152,7 @@
         self.zIndex = [_children count];
     [(NSMutableArray *)_children insertObject:child atIndex:index];
     _childrenSortedByZIndexDirty = YES;
+    [self setNeedsSpatialIndexUpdate];
 }
 
 - (void)removeChild:(ICNode *)child
@@ -450,6 +458,15 @@
 
 @synthesize transform = _transform;
 
+- (void)setTransform:(kmMat4)transform
+{
+    _transform = transform;
+    if (!_worldTransformDirty)
+        [self setNeedsSpatialIndexUpdate];
+    [_parent setNeedsSubtreeAABBUpdate];
+    [self invalidateWorldTransform];
+}
+
 - (const kmMat4 *)transformPtr
 {
     return &_transform;
@@ -469,31 +486,56 @@
         [self computeTransform];
     }
     kmMat4 inverseTransform;
-    kmMat4Inverse(&inverseTransform, &_transform);
+    if (!kmMat4AffineInverse(&inverseTransform, &_transform)) {
+        // Singular transforms, e.g. with a scale of zero, cannot be inverted
+        kmMat4Identity(&inverseTransform);
+    }
     return inverseTransform;
 }
 
 // This will stop at ICScene objects to ensure that a scene always represents
 // word coordinates, even if scenes are nested
-- (kmMat4)nodeToWorldTransform
+- (const kmMat4 *)nodeToWorldTransformPtr
 {
-    kmMat4 nodeToParentTransform = [self nodeToParentTransform];
-    for (ICNode *parent = _parent; parent != nil; parent = parent.parent) {
-        kmMat4 parentNodeToParentTransform = [parent nodeToParentTransform];
-        kmMat4Multiply(&nodeToParentTransform, &parentNodeToParentTransform, &nodeToParentTransform);
-        if ([parent isKindOfClass:[ICScene class]]) {
-            break; // scene represents world coordinates
+    if (_worldTransformDirty) {
+        if (_computesTransform && _transformDirty) {
+            [self computeTransform];
         }
+        if (!_parent) {
+            _worldTransform = _transform;
+        } else if ([_parent isKindOfClass:[ICScene class]]) {
+            // Clean the scene's own world transform flag, so that subsequent changes of the
+            // scene's transform are propagated to the receiver (see invalidateWorldTransform)
+            [_parent nodeToWorldTransformPtr];
+            kmMat4 parentTransform = [_parent nodeToParentTransform];
+            kmMat4Multiply(&_worldTransform, &parentTransform, &_transform);
+        } else {
+            kmMat4Multiply(&_worldTransform, [_parent nodeToWorldTransformPtr], &_transform);
+        }
+        _worldTransformDirty = NO;
     }
-    return nodeToParentTransform;
+    return &_worldTransform;
+}
+
+- (kmMat4)nodeToWorldTransform
+{
+    return *[self nodeToWorldTransformPtr];
 }
 
 - (kmMat4)worldToNodeTransform
 {
-    kmMat4 inverseTransform;
-    kmMat4 nodeToWorldTransform = [self nodeToWorldTransform];
-    kmMat4Inverse(&inverseTransform, &nodeToWorldTransform);
-    return inverseTransform;
+    const kmMat4 *nodeToWorldTransform = [self nodeToWorldTransformPtr];
+    if (_inverseWorldTransformDirty) {
+        if (!kmMat4AffineInverse(&_inverseWorldTransform, nodeToWorldTransform)) {
+            // Singular transforms cannot be inverted; keep the inverse dirty, so that it is
+            // recomputed once the transform becomes invertible again
+            kmMat4 identity;
+            kmMat4Identity(&identity);
+            return identity;
+        }
+        _inverseWorldTransformDirty = NO;
+    }
+    return _inverseWorldTransform;
 }
 
 - (kmVec3)convertToNodeSpace:(kmVec3)worldVect
@@ -507,16 +549,43 @@
 - (kmVec3)convertToWorldSpace:(kmVec3)nodeVect
 {
     kmVec3 result;
-    kmMat4 transform = [self nodeToWorldTransform];
-    kmVec3Transform(&result, &nodeVect, &transform);
+    kmVec3Transform(&result, &nodeVect, [self nodeToWorldTransformPtr]);
     return result;
 }
 
+// Marks the receiver's local transform dirty. The scene's spatial index computes the world
+// transforms of all indexed nodes when it is rebuilt, so it only needs to be invalidated when
+// a node's world transform goes from clean to dirty.
+- (void)setTransformDirty
+{
+    _transformDirty = YES;
+    if (!_worldTransformDirty)
+        [self setNeedsSpatialIndexUpdate];
+    // The receiver's transform affects its parent's subtree bounds even if the world transform
+    // is already dirty, since the drawing visitor does not compute world transforms
+    [_parent setNeedsSubtreeAABBUpdate];
+    [self invalidateWorldTransform];
+}
+
+// Marks the cached world transforms of the receiver and its descendants dirty. If a node's
+// world transform is already dirty, so are the world transforms of its descendants, since
+// world transforms are always computed top-down.
+- (void)invalidateWorldTransform
+{
+    if (!_worldTransformDirty) {
+        _worldTransformDirty = YES;
+        _inverseWorldTransformDirty = YES;
+        for (ICNode *child in _children) {
+            [child invalidateWorldTransform];
+        }
+    }
+}
+
 - (void)setPosition:(kmVec3)position
 {
     [self willChangeValueForKey:@"position"];
     _position = position;
-    _transformDirty = YES;
+    [self setTransformDirty];
     [self didChangeValueForKey:@"position"];
 }
 
@@ -713,7 +782,7 @@
 {
     [self willChangeValueForKey:@"anchorPoint"];
     _anchorPoint = anchorPoint;
-    _transformDirty = YES;
+    [self setTransformDirty];
     [self didChangeValueForKey:@"anchorPoint"];
 }
 
@@ -729,11 +798,19 @@
 
 @synthesize origin = _origin;
 
+- (void)setOrigin:(kmVec3)origin
+{
+    _origin = origin;
+    [self setNeedsSpatialIndexUpdate];
+}
+
 - (void)setSize:(kmVec3)size
 {
     [self willChangeValueForKey:@"size"];
     _size = size;
     [self didChangeValueForKey:@"size"];
+    [self setNeedsSubtreeAABBUpdate];
+    [_parent setNeedsSpatialIndexUpdate];
     
     if (_autoCenterAnchorPoint) {
         [self centerAnchorPoint];
@@ -764,32 +841,32 @@
 {
     [self willChangeValueForKey:@"scale"];
     _scale = scale;
-    _transformDirty = YES;
+    [self setTransformDirty];
     [self didChangeValueForKey:@"scale"];
 }
 
 - (void)setScaleX:(float)scaleX
 {
     _scale.x = scaleX;
-    _transformDirty = YES;
+    [self setTransformDirty];
 }
 
 - (void)setScaleY:(float)scaleY
 {
     _scale.y = scaleY;
-    _transformDirty = YES;    
+    [self setTransformDirty];
 }
 
 - (void)setScaleXY:(float)scaleXY
 {
     _scale.x = _scale.y = scaleXY;
-    _transformDirty = YES;
+    [self setTransformDirty];
 }
 
 - (void)setScaleZ:(float)scaleZ
 {
     _scale.z = scaleZ;
-    _transformDirty = YES;    
+    [self setTransformDirty];
 }
 
 - (kmVec3)scale
@@ -803,14 +880,14 @@
 - (void)setRotationAngle:(float)angle
 {
     _rotationAngle = angle;
-    _transformDirty = YES;
+    [self setTransformDirty];
 }
 
 - (void)setRotationAxis:(kmVec3)axis
 {
     [self willChangeValueForKey:@"rotationAxis"];
     _rotationAxis = axis;
-    _transformDirty = YES;
+    [self setTransformDirty];
     [self didChangeValueForKey:@"rotationAxis"];
 }
 
@@ -818,7 +895,7 @@
 {
     self.rotationAxis = axis;
     self.rotationAngle = angle;
-    _transformDirty = YES;
+    [self setTransformDirty];
 }
 
 - (void)getRotationAngle:(float *)angle axis:(kmVec3 *)axis
@@ -833,20 +910,28 @@
 - (void)computeTransform
 {
     if (_transformDirty) {
-        kmMat4 translate, anchorPoint, reAnchorPoint, scale, rotate;
-                
-        kmMat4Translation(&translate, _position.x, _position.y, _position.z);
-        kmMat4Translation(&anchorPoint, -_anchorPoint.x, -_anchorPoint.y, -_anchorPoint.z);
-        kmMat4Translation(&reAnchorPoint, _anchorPoint.x, _anchorPoint.y, _anchorPoint.z);
-        kmMat4Scaling(&scale, _scale.x, _scale.y, _scale.z);
-        kmMat4RotationAxisAngle(&rotate, &_rotationAxis, _rotationAngle);
+        // Compose translate * reAnchorPoint * rotate * scale * anchorPoint directly rather
+        // than multiplying five full matrices: the upper 3x3 part is the rotation matrix with
+        // its columns scaled, the translation part is position + anchorPoint - RS * anchorPoint.
+        kmMat4 *m = &_transform;
+        if (_rotationAngle != 0) {
+            kmMat4RotationAxisAngle(m, &_rotationAxis, _rotationAngle);
+        } else {
+            kmMat4Identity(m);
+        }
+        
+        for (int i=0; i<3; i++) {
+            m->mat[i]   *= _scale.x;
+            m->mat[4+i] *= _scale.y;
+            m->mat[8+i] *= _scale.z;
+        }
         
-        kmMat4Identity(&_transform);
-        kmMat4Multiply(&_transform, &_transform, &anchorPoint);
-        kmMat4Multiply(&_transform, &scale, &_transform);
-        kmMat4Multiply(&_transform, &rotate, &_transform);
-        kmMat4Multiply(&_transform, &reAnchorPoint, &_transform);
-        kmMat4Multiply(&_transform, &translate, &_transform);
+        for (int i=0; i<3; i++) {
+            m->mat[12+i] = ((float *)&_position)[i] + ((float *)&_anchorPoint)[i] -
+                           (m->mat[i]   * _anchorPoint.x +
+                            m->mat[4+i] * _anchorPoint.y +
+                            m->mat[8+i] * _anchorPoint.z);
+        }
         
         _transformDirty = NO;
     }
@@ -868,8 +953,10 @@
 {
     if (zIndex != _zIndex) {
         _zIndex = zIndex;
-        if (self.parent)
+        if (self.parent) {
             self.parent->_childrenSortedByZIndexDirty = YES;
+            [self.parent setNeedsSpatialIndexUpdate];
+        }
     }
 }
 
@@ -954,6 +1041,21 @@
     return icComputeAABBFromVertices((kmVec3*)&aabb, 2);
 }
 
+- (kmAABB)worldAABB
+{
+    kmAABB aabb = [self localAABB];
+    const kmMat4 *transform = [self nodeToWorldTransformPtr];
+    
+    kmVec3 corners[8];
+    for (int i=0; i<8; i++) {
+        kmVec3 corner = kmVec3Make(i & 1 ? aabb.max.x : aabb.min.x,
+                                   i & 2 ? aabb.max.y : aabb.min.y,
+                                   i & 4 ? aabb.max.z : aabb.min.z);
+        kmVec3Transform(&corners[i], &corner, transform);
+    }
+    return icComputeAABBFromVertices(corners, 8);
+}
+
 // FIXME
 - (CGRect)frameRect
 {
@@ -993,6 +1095,15 @@
 
 @synthesize shaderProgram = _shaderProgram;
 @synthesize isVisible = _isVisible;
+@synthesize drawnRect = _drawnRect;
+
+- (void)setIsVisible:(BOOL)isVisible
+{
+    if (isVisible != _isVisible) {
+        _isVisible = isVisible;
+        [_parent setNeedsSpatialIndexUpdate];
+    }
+}
 
 - (void)applyStandardDrawSetupWithVisitor:(ICNodeVisitor *)visitor
 {
@@ -1004,8 +1115,7 @@
     } else {
         ICShaderProgram *p = [[ICShaderCache currentShaderCache] shaderProgramForKey:kICShader_Picking];
         icColor4B pickColor = [(ICNodeVisitorPicking *)visitor pickColor];        
-        [p setShaderValue:[ICShaderValue shaderValueWithVec4:kmVec4FromColor4B(pickColor)]
-               forUniform:@"u_pickColor"];
+        [p setVec4:kmVec4FromColor4B(pickColor) forUniformHandle:p.pickColorUniformHandle];
         icGLUniformModelViewProjectionMatrix(p);
         [p use];
     }    
@@ -1041,6 +1151,84 @@
     return ICHitTestUnsupported;
 }
 
+@synthesize requiresPixelExactHitTest = _requiresPixelExactHitTest;
+@synthesize drawsOutsideBounds = _drawsOutsideBounds;
+
+- (void)setNeedsSpatialIndexUpdate
+{
+    _subtreeAABBDirty = YES;
+    [_parent setNeedsSpatialIndexUpdate];
+}
+
+- (void)setNeedsSubtreeAABBUpdate
+{
+    // If the receiver is dirty already, so are all ancestors depending on its bounds
+    if (!_subtreeAABBDirty) {
+        _subtreeAABBDirty = YES;
+        [_parent setNeedsSubtreeAABBUpdate];
+    }
+}
+
+- (void)updateSubtreeAABB
+{
+    kmAABB bounds = [self localAABB];
+    BOOL drawsOutsideBounds = _drawsOutsideBounds;
+    
+    for (ICNode *child in [self drawingChildren]) {
+        if (!child.isVisible)
+            continue;
+        
+        if ([child subtreeDrawsOutsideBounds]) {
+            drawsOutsideBounds = YES;
+            break;
+        }
+        
+        kmAABB childBounds = [child subtreeAABB];
+        if (child.computesTransform) {
+            [child computeTransform];
+        }
+        kmVec3 corners[10];
+        for (int i=0; i<8; i++) {
+            kmVec3 corner = kmVec3Make(i & 1 ? childBounds.max.x : childBounds.min.x,
+                                       i & 2 ? childBounds.max.y : childBounds.min.y,
+                                       i & 4 ? childBounds.max.z : childBounds.min.z);
+            kmVec3Transform(&corners[i], &corner, &child->_transform);
+        }
+        corners[8] = bounds.min;
+        corners[9] = bounds.max;
+        bounds = icComputeAABBFromVertices(corners, 10);
+    }
+    
+    _subtreeAABB = bounds;
+    _subtreeDrawsOutsideBounds = drawsOutsideBounds;
+    _subtreeAABBDirty = NO;
+}
+
+- (kmAABB)subtreeAABB
+{
+    if (_subtreeAABBDirty) {
+        [self updateSubtreeAABB];
+    }
+    return _subtreeAABB;
+}
+
+- (BOOL)subtreeDrawsOutsideBounds
+{
+    if (_subtreeAABBDirty) {
+        [self updateSubtreeAABB];
+    }
+    return _subtreeDrawsOutsideBounds;
+}
+
+- (void)setDrawsOutsideBounds:(BOOL)drawsOutsideBounds
+{
+    if (drawsOutsideBounds != _drawsOutsideBounds) {
+        _drawsOutsideBounds = drawsOutsideBounds;
+        _subtreeAABBDirty = YES;
+        [_parent setNeedsSubtreeAABBUpdate];
+    }
+}
+
 
 #pragma mark - User Interaction Support
 
@@ -1231,8 +1419,12 @@
 
 - (void)setParent:(ICNode *)parent
 {
+    // Invalidate the spatial indexes of both the old and the new parent's scene
+    [_parent setNeedsSpatialIndexUpdate];
     _parent = parent;
     self.nextResponder = parent;
+    [self invalidateWorldTransform];
+    [_parent setNeedsSpatialIndexUpdate];
     
 #if defined(DEBUG) && IC_DEBUG_ICNODE_PARENTS
     // Debugging
@@ -23,16 +23,101 @@
 
 #import <Foundation/Foundation.h>
 #import "ICNodeVisitor.h"
+#import "icTypes.h"
+#import "Platforms/icGL.h"
+#import "../3rd-party/kazmath/kazmath/kazmath.h"
+
+@class ICShaderProgram;
+@class ICRenderCommandBuffer;
+struct _icCullingRect;
 
 /**
  @brief Node visitor for drawing a scene graph on an OpenGL framebuffer
+ 
+ ### Sprite Batching ###
+ 
+ If ICNodeVisitorDrawing::batchesSprites is set to YES, the visitor does not draw ICSprite
+ nodes immediately. Instead, it transforms each sprite's quad by the current model-view matrix
+ and collects it in a client-side vertex array. Consecutive sprites sharing the same shader
+ program, textures, blend function and projection are accumulated until a node requiring a
+ different state is visited. The visitor then uploads the collected quads to a streaming vertex
+ buffer and draws them using a single call to ``glDrawElements``.
+ 
+ Nodes that do not support batching cause the visitor to flush the current batch before they
+ are drawn, so the painter's order of the scene graph is always preserved. Nodes that do not
+ override ICNode::drawWithVisitor: (e.g. plain container nodes) do not interrupt a batch.
+ 
+ You may retrieve the number of draw calls saved during the last visitation using the
+ ICNodeVisitorDrawing::drawCallsSaved property.
+ 
+ ### Culling ###
+ 
+ If ICNodeVisitorDrawing::cullsNodes is set to YES, the visitor skips branches whose subtree
+ bounding box (see ICNode::subtreeAABB) lies completely outside of the camera frustum or outside
+ the clipping region of an ancestor ICView whose ICView::clipsChildren property is set. Branches
+ containing nodes that draw outside their bounds (see ICNode::drawsOutsideBounds) and nodes
+ without an extent on the XY plane are never culled. The number of culled branches is available
+ via the ICNodeVisitorDrawing::culledNodeCount property.
+ 
+ When drawing a root scene that tracks damage (see ICScene::tracksDamage), the visitor records
+ the bounds of each visited branch in ICNode::drawnRect and culls branches outside of the
+ scene's ICScene::damageRect if the scene redraws damaged regions only.
+ 
+ ### Recording Render Commands ###
+ 
+ If ICNodeVisitorDrawing::recordsCommands is set to YES, sprites supporting batching are not
+ added to the current batch in painter's order. Instead, the visitor records a draw command for
+ each of them in its ICNodeVisitorDrawing::commandBuffer. Recorded commands are submitted sorted
+ by state whenever a node must be drawn immediately and at the end of visitation. See
+ ICRenderCommandBuffer for details on how commands are ordered.
  */
-@interface ICNodeVisitorDrawing : ICNodeVisitor
+@interface ICNodeVisitorDrawing : ICNodeVisitor {
+@protected
+    // Matrix stack context of the current visitation, cached to avoid per-node lookups
+    kmGLContext *_matrixContext;
+    
+    BOOL _batchesSprites;
+    BOOL _cullsNodes;
+    BOOL _recordsDrawnRects;
+    
+    // Clipping regions of ancestor views in normalized device coordinates
+    struct _icCullingRect *_cullingRects;
+    NSUInteger _cullingRectCount;
+    NSUInteger _cullingRectCapacity;
+    BOOL _recordsCommands;
+    ICRenderCommandBuffer *_commandBuffer;
+    
+    // Current batch state
+    ICShaderProgram *_batchShaderProgram;
+    GLuint _batchTexture;
+    GLuint _batchMaskTexture;
+    icBlendFunc _batchBlendFunc;
+    kmMat4 _batchProjection;
+    
+    // Batch storage
+    icV3F_C4F_T2F *_batchVertices;
+    NSUInteger _batchQuadCount;
+    NSUInteger _batchQuadCapacity;
+    GLuint _batchVertexBuffer;
+    GLuint _batchIndexBuffer;
+    
+    // Statistics
+    NSUInteger _batchedSpriteCount;
+    NSUInteger _batchDrawCallCount;
+    NSUInteger _culledNodeCount;
+}
 
 
 #pragma mark - Visiting a Scene for Drawing
 /** @name Visiting a Scene for Drawing */
 
+/**
+ @brief Visits the given node for drawing and flushes any pending sprite batch afterwards
+ 
+ Resets the receiver's batching statistics before visitation starts.
+ */
+- (void)visit:(ICNode *)node;
+
 /**
  @brief Sets up the node's model-view transform matrix and pushes it on the OpenGL matrix stack
  */
@@ -40,6 +125,11 @@
 
 /**
  @brief Draws a single node to the OpenGL framebuffer
+ 
+ If the receiver culls nodes and the given node's branch is not visible, this method returns
+ NO so that the node's children are skipped. If the given node is a sprite supporting batching,
+ its quad is added to the current batch. Otherwise, the current batch is flushed and the node is
+ drawn immediately.
  */
 - (BOOL)visitSingleNode:(ICNode *)node;
 
@@ -53,4 +143,130 @@
  */
 - (void)postVisitNode:(ICNode *)node;
 
+
+#pragma mark - Culling Nodes
+/** @name Culling Nodes */
+
+/**
+ @brief Whether the receiver skips branches outside of the camera frustum or clipping regions
+ 
+ Defaults to the value of #IC_ENABLE_DRAW_CULLING.
+ */
+@property (nonatomic, assign) BOOL cullsNodes;
+
+/**
+ @brief The number of branches culled during the last visitation
+ 
+ Descendants of culled nodes are not counted.
+ */
+@property (nonatomic, readonly) NSUInteger culledNodeCount;
+
+
+#pragma mark - Batching Sprites
+/** @name Batching Sprites */
+
+/**
+ @brief Whether the receiver batches consecutive sprites sharing the same drawing state
+ 
+ Defaults to the value of #IC_ENABLE_SPRITE_BATCHING.
+ */
+@property (nonatomic, assign) BOOL batchesSprites;
+
+/**
+ @brief Adds a quad to the receiver's current sprite batch
+ 
+ The given vertices are transformed by the current model-view matrix before they are stored.
+ If the given state differs from the state of the current batch, the current batch is flushed
+ before the quad is added.
+ 
+ @param vertices A pointer to four vertices defining a quad in triangle strip order
+ @param shaderProgram The shader program used to draw the quad
+ @param texture The name of the texture bound to texture unit 0, or 0 for no texture
+ @param maskTexture The name of the texture bound to texture unit 1, or 0 for no mask
+ @param blendFunc The blend function used to draw the quad
+ */
+- (void)batchQuadVertices:(const icV3F_C4F_T2F *)vertices
+            shaderProgram:(ICShaderProgram *)shaderProgram
+                  texture:(GLuint)texture
+              maskTexture:(GLuint)maskTexture
+                blendFunc:(icBlendFunc)blendFunc;
+
+/**
+ @brief Adds quads already transformed to world space to the receiver's current sprite batch
+ 
+ If the given state differs from the state of the current batch, the current batch is flushed
+ before the quads are added. Used by ICRenderCommandBuffer to submit recorded commands.
+ 
+ @param vertices A pointer to quads defining four vertices each in triangle strip order
+ @param quadCount The number of quads to add
+ @param projection The projection matrix used to draw the quads
+ @param shaderProgram The shader program used to draw the quads
+ @param texture The name of the texture bound to texture unit 0, or 0 for no texture
+ @param maskTexture The name of the texture bound to texture unit 1, or 0 for no mask
+ @param blendFunc The blend function used to draw the quads
+ */
+- (void)batchWorldQuadVertices:(const icV3F_C4F_T2F *)vertices
+                     quadCount:(NSUInteger)quadCount
+                    projection:(const kmMat4 *)projection
+                 shaderProgram:(ICShaderProgram *)shaderProgram
+                       texture:(GLuint)texture
+                   maskTexture:(GLuint)maskTexture
+                     blendFunc:(icBlendFunc)blendFunc;
+
+/**
+ @brief Draws all quads collected in the receiver's current sprite batch
+ 
+ If the receiver records commands, pending commands are submitted first. This method does
+ nothing if there is nothing to draw. You should call this method before issuing custom OpenGL
+ drawing commands while the receiver is visiting a scene.
+ */
+- (void)flushSpriteBatch;
+
+
+#pragma mark - Recording Render Commands
+/** @name Recording Render Commands */
+
+/**
+ @brief Whether the receiver records batchable nodes as render commands for state-sorted
+ submission
+ 
+ Defaults to the value of #IC_ENABLE_RENDER_COMMAND_RECORDING.
+ */
+@property (nonatomic, assign) BOOL recordsCommands;
+
+/**
+ @brief The command buffer holding the commands recorded during the last visitation
+ 
+ The command buffer is reset at the beginning of each visitation. It is nil if the receiver
+ has never recorded commands.
+ */
+@property (nonatomic, readonly) ICRenderCommandBuffer *commandBuffer;
+
+/**
+ @brief Replays the commands recorded during the last visitation
+ 
+ Nodes that have been drawn immediately are not replayed. The receiver must be used in the
+ OpenGL context and with the framebuffer the commands have been recorded for.
+ */
+- (void)replayRecordedCommands;
+
+
+#pragma mark - Retrieving Batching Statistics
+/** @name Retrieving Batching Statistics */
+
+/**
+ @brief The number of sprites drawn as part of a batch during the last visitation
+ */
+@property (nonatomic, readonly) NSUInteger batchedSpriteCount;
+
+/**
+ @brief The number of batched draw calls issued during the last visitation
+ */
+@property (nonatomic, readonly) NSUInteger batchDrawCallCount;
+
+/**
+ @brief The number of draw calls saved by sprite batching during the last visitation
+ */
+- (NSUInteger)drawCallsSaved;
+
 @end
@@ -23,18 +23,126 @@
 
 #import "ICNodeVisitorDrawing.h"
 #import "ICNode.h"
+#import "ICSprite.h"
+#import "ICView.h"
+#import "ICScene.h"
+#import "ICShaderProgram.h"
+#import "ICShaderValue.h"
+#import "ICRenderCommandBuffer.h"
+#import "ICProfiler.h"
+#import "icUtils.h"
+#import <objc/runtime.h>
+#import "icGLState.h"
 #import "icGL.h"
 #import "icConfig.h"
 
+#define IC_SPRITE_BATCH_INITIAL_QUADS 64
+
+
+typedef struct _icCullingRect {
+    ICNode *node;
+    BOOL bounded;
+    kmVec2 min, max;
+} icCullingRect;
+
+
+// Returns YES if the given node's class overrides the implementation of selector in baseClass
+static BOOL icNodeOverridesSelector(ICNode *node, SEL selector, Class baseClass)
+{
+    return [node methodForSelector:selector] != [baseClass instanceMethodForSelector:selector];
+}
+
+
+@interface ICNodeVisitorDrawing (Private)
+- (void)reserveBatchQuads:(NSUInteger)quadCount;
+- (void)getModelViewProjectionMatrix:(kmMat4 *)mvp;
+- (BOOL)testCullingOfNode:(ICNode *)node;
+- (void)pushCullingRectForNode:(ICNode *)node bounded:(BOOL)bounded min:(kmVec2)min max:(kmVec2)max;
+- (icV3F_C4F_T2F *)batchVerticesForQuads:(NSUInteger)quadCount
+                              projection:(const kmMat4 *)projection
+                           shaderProgram:(ICShaderProgram *)shaderProgram
+                                 texture:(GLuint)texture
+                             maskTexture:(GLuint)maskTexture
+                               blendFunc:(icBlendFunc)blendFunc;
+- (void)drawSpriteBatch;
+@end
+
+
 @implementation ICNodeVisitorDrawing
 
+@synthesize batchesSprites = _batchesSprites;
+@synthesize cullsNodes = _cullsNodes;
+@synthesize culledNodeCount = _culledNodeCount;
+@synthesize recordsCommands = _recordsCommands;
+@synthesize commandBuffer = _commandBuffer;
+@synthesize batchedSpriteCount = _batchedSpriteCount;
+@synthesize batchDrawCallCount = _batchDrawCallCount;
+
 - (id)initWithOwner:(ICNode *)owner
 {
     if ((self = [super initWithOwner:owner])) {
+        _batchesSprites = IC_ENABLE_SPRITE_BATCHING;
+        _cullsNodes = IC_ENABLE_DRAW_CULLING;
+        _recordsCommands = IC_ENABLE_RENDER_COMMAND_RECORDING;
     }
     return self;
 }
 
+- (void)dealloc
+{
+    [_batchShaderProgram release];
+    [_commandBuffer release];
+    
+    if (_batchVertices)
+        free(_batchVertices);
+    if (_cullingRects)
+        free(_cullingRects);
+    if (_batchVertexBuffer)
+        icGLDeleteBuffer(_batchVertexBuffer);
+    if (_batchIndexBuffer)
+        icGLDeleteBuffer(_batchIndexBuffer);
+    
+    [super dealloc];
+}
+
+- (void)visit:(ICNode *)node
+{
+    _batchedSpriteCount = 0;
+    _batchDrawCallCount = 0;
+    _culledNodeCount = 0;
+    
+    // Visits may be nested, e.g. when a node draws a sub scene using the same visitor
+    kmGLContext *previousMatrixContext = _matrixContext;
+    _matrixContext = kmGLGetCurrentContextHandle();
+    
+    // Nested visits must not be culled against the clipping regions of the outer visit
+    NSUInteger previousCullingRectCount = _cullingRectCount;
+    [self pushCullingRectForNode:nil bounded:NO min:(kmVec2){0, 0} max:(kmVec2){0, 0}];
+    
+    // Only root scenes tracking damage need to know where their nodes have been drawn
+    BOOL previousRecordsDrawnRects = _recordsDrawnRects;
+    _recordsDrawnRects = [node isKindOfClass:[ICScene class]] && ![node parent] &&
+                         [(ICScene *)node tracksDamage];
+    
+    if (_recordsCommands && !previousMatrixContext) {
+        if (!_commandBuffer)
+            _commandBuffer = [[ICRenderCommandBuffer alloc] init];
+        [_commandBuffer reset];
+    }
+    
+    IC_PROFILE_ZONE_BEGIN(traversalZone, ICProfilerCategoryTraversal);
+    
+    [super visit:node];
+    
+    [self flushSpriteBatch];
+    
+    IC_PROFILE_ZONE_END(traversalZone, ICProfilerCategoryTraversal, "Draw scene");
+    
+    _cullingRectCount = previousCullingRectCount;
+    _recordsDrawnRects = previousRecordsDrawnRects;
+    _matrixContext = previousMatrixContext;
+}
+
 - (void)preVisitNode:(ICNode *)node
 {
     // Compute transform if necessary
@@ -43,13 +151,59 @@
     }
     
     // Push transform
-    kmGLPushMatrix();
-    kmGLMultMatrix([node transformPtr]);
+    kmGLContextPushMultMatrix(_matrixContext, [node transformPtr]);
 }
 
 - (BOOL)visitSingleNode:(ICNode *)node
 {
-    [node drawWithVisitor:self];
+    if ((_cullsNodes || _recordsDrawnRects) && node != _currentRoot && [self testCullingOfNode:node]) {
+        _culledNodeCount++;
+        return NO;
+    }
+    
+#if IC_ENABLE_PROFILER
+    uint64_t nodeTimingStart = icProfilerBeginNodeClassTiming();
+#endif
+    
+    BOOL batched = (_batchesSprites || _recordsCommands) && [node isKindOfClass:[ICSprite class]] &&
+                   [(ICSprite *)node batchWithVisitor:self];
+    
+    // Nodes that do not draw anything must not interrupt the current batch
+    if (!batched && icNodeOverridesSelector(node, @selector(drawWithVisitor:), [ICNode class])) {
+        [self flushSpriteBatch];
+        IC_PROFILE_ZONE_BEGIN(drawZone, ICProfilerCategoryDrawSubmission);
+        [node drawWithVisitor:self];
+        IC_PROFILE_ZONE_END(drawZone, ICProfilerCategoryDrawSubmission, class_getName([node class]));
+    }
+    
+#if IC_ENABLE_PROFILER
+    icProfilerEndNodeClassTiming([node class], nodeTimingStart);
+#endif
+    
+    if (_cullsNodes) {
+        if ([node isKindOfClass:[ICScene class]]) {
+            // Scenes set up their own projection and viewport. Root scenes redrawing damaged
+            // regions only clip their contents to the damage rect.
+            ICScene *scene = (ICScene *)node;
+            if ([scene redrawsDamageOnly]) {
+                CGRect damageRect = [scene damageRect];
+                kmVec2 min = {CGRectGetMinX(damageRect), CGRectGetMinY(damageRect)};
+                kmVec2 max = {CGRectGetMaxX(damageRect), CGRectGetMaxY(damageRect)};
+                [self pushCullingRectForNode:node bounded:YES min:min max:max];
+            } else {
+                [self pushCullingRectForNode:node bounded:NO min:(kmVec2){0, 0} max:(kmVec2){0, 0}];
+            }
+        } else if ([node isKindOfClass:[ICView class]] && [(ICView *)node clipsChildren]) {
+            kmMat4 mvp;
+            [self getModelViewProjectionMatrix:&mvp];
+            kmAABB bounds = [node localAABB];
+            uint outcode;
+            kmVec2 min, max;
+            BOOL bounded = icProjectAABB(&mvp, &bounds, &outcode, &min, &max);
+            [self pushCullingRectForNode:node bounded:bounded min:min max:max];
+        }
+    }
+    
     return YES;
 }
 
@@ -57,14 +211,315 @@
 {
     for (ICNode *child in [node drawingChildren]) {
         [self visitNode:child];
-    }    
+    }
+    
+    // Nodes may reset GL state after their children have been drawn, so batched children
+    // must be drawn before that happens
+    if (icNodeOverridesSelector(node, @selector(childrenDidDrawWithVisitor:), [ICNode class])) {
+        [self flushSpriteBatch];
+    }
     [node childrenDidDrawWithVisitor:self];
 }
 
 - (void)postVisitNode:(ICNode *)node
 {
+    if (_cullingRectCount && _cullingRects[_cullingRectCount - 1].node == node)
+        _cullingRectCount--;
+    
     // Pop transform
-    kmGLPopMatrix();
+    kmGLContextPopMatrix(_matrixContext);
+}
+
+
+#pragma mark - Sprite Batching
+
+- (void)batchQuadVertices:(const icV3F_C4F_T2F *)vertices
+            shaderProgram:(ICShaderProgram *)shaderProgram
+                  texture:(GLuint)texture
+              maskTexture:(GLuint)maskTexture
+                blendFunc:(icBlendFunc)blendFunc
+{
+    kmMat4 projection, modelView;
+    kmGLContextGetMatrix(_matrixContext, KM_GL_PROJECTION, &projection);
+    kmGLContextGetMatrix(_matrixContext, KM_GL_MODELVIEW, &modelView);
+    
+    if (_recordsCommands) {
+        [_commandBuffer addQuadVertices:vertices
+                              quadCount:1
+                              modelView:&modelView
+                             projection:&projection
+                          shaderProgram:shaderProgram
+                                texture:texture
+                            maskTexture:maskTexture
+                              blendFunc:blendFunc
+                            depthTested:icGLIsEnabled(IC_GL_DEPTH_TEST)];
+        return;
+    }
+    
+    icV3F_C4F_T2F *dst = [self batchVerticesForQuads:1
+                                          projection:&projection
+                                       shaderProgram:shaderProgram
+                                             texture:texture
+                                         maskTexture:maskTexture
+                                           blendFunc:blendFunc];
+    
+    // Pre-transform vertices to world space, so that all quads can share the projection matrix
+    for (int i=0; i<4; i++) {
+        dst[i] = vertices[i];
+        kmVec3Transform(&dst[i].vect, &vertices[i].vect, &modelView);
+    }
+}
+
+- (void)batchWorldQuadVertices:(const icV3F_C4F_T2F *)vertices
+                     quadCount:(NSUInteger)quadCount
+                    projection:(const kmMat4 *)projection
+                 shaderProgram:(ICShaderProgram *)shaderProgram
+                       texture:(GLuint)texture
+                   maskTexture:(GLuint)maskTexture
+                     blendFunc:(icBlendFunc)blendFunc
+{
+    while (quadCount) {
+        NSUInteger count = MIN(quadCount, IC_SPRITE_BATCH_MAX_QUADS);
+        icV3F_C4F_T2F *dst = [self batchVerticesForQuads:count
+                                              projection:projection
+                                           shaderProgram:shaderProgram
+                                                 texture:texture
+                                             maskTexture:maskTexture
+                                               blendFunc:blendFunc];
+        memcpy(dst, vertices, sizeof(icV3F_C4F_T2F) * 4 * count);
+        vertices += count * 4;
+        quadCount -= count;
+    }
+}
+
+- (void)flushSpriteBatch
+{
+    if (_recordsCommands)
+        [_commandBuffer submitPendingCommandsWithVisitor:self];
+    [self drawSpriteBatch];
+}
+
+- (void)replayRecordedCommands
+{
+    [_commandBuffer replayWithVisitor:self];
+}
+
+- (NSUInteger)drawCallsSaved
+{
+    return _batchedSpriteCount - _batchDrawCallCount;
+}
+
+- (void)setRecordsCommands:(BOOL)recordsCommands
+{
+    if (_recordsCommands && !recordsCommands)
+        [self flushSpriteBatch];
+    if (recordsCommands && !_commandBuffer)
+        _commandBuffer = [[ICRenderCommandBuffer alloc] init];
+    _recordsCommands = recordsCommands;
+}
+
+@end
+
+
+@implementation ICNodeVisitorDrawing (Private)
+
+- (icV3F_C4F_T2F *)batchVerticesForQuads:(NSUInteger)quadCount
+                              projection:(const kmMat4 *)projection
+                           shaderProgram:(ICShaderProgram *)shaderProgram
+                                 texture:(GLuint)texture
+                             maskTexture:(GLuint)maskTexture
+                               blendFunc:(icBlendFunc)blendFunc
+{
+    if (_batchQuadCount) {
+        if (shaderProgram != _batchShaderProgram ||
+            texture != _batchTexture ||
+            maskTexture != _batchMaskTexture ||
+            blendFunc.src != _batchBlendFunc.src ||
+            blendFunc.dst != _batchBlendFunc.dst ||
+            memcmp(projection->mat, _batchProjection.mat, sizeof(projection->mat)) ||
+            _batchQuadCount + quadCount > IC_SPRITE_BATCH_MAX_QUADS) {
+            [self drawSpriteBatch];
+        }
+    }
+    
+    if (!_batchQuadCount) {
+        [_batchShaderProgram release];
+        _batchShaderProgram = [shaderProgram retain];
+        _batchTexture = texture;
+        _batchMaskTexture = maskTexture;
+        _batchBlendFunc = blendFunc;
+        _batchProjection = *projection;
+    }
+    
+    [self reserveBatchQuads:_batchQuadCount + quadCount];
+    
+    icV3F_C4F_T2F *dst = &_batchVertices[_batchQuadCount * 4];
+    _batchQuadCount += quadCount;
+    _batchedSpriteCount += quadCount;
+    return dst;
+}
+
+- (void)drawSpriteBatch
+{
+    if (!_batchQuadCount)
+        return;
+    
+    IC_PROFILE_ZONE_BEGIN(drawZone, ICProfilerCategoryDrawSubmission);
+    
+    if (!_batchVertexBuffer)
+        glGenBuffers(1, &_batchVertexBuffer);
+    
+    if (!_batchIndexBuffer) {
+        // Indices are static, so we generate them once for the maximum batch size
+        icUShort_QuadIndices *indices = malloc(sizeof(icUShort_QuadIndices) * IC_SPRITE_BATCH_MAX_QUADS);
+        for (GLushort i=0; i<IC_SPRITE_BATCH_MAX_QUADS; i++) {
+            GLushort v = i * 4;
+            indices[i] = (icUShort_QuadIndices){{ v, v+1, v+2, v+2, v+1, v+3 }};
+        }
+        glGenBuffers(1, &_batchIndexBuffer);
+        icGLBindVertexArray(0);
+        icGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _batchIndexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(icUShort_QuadIndices) * IC_SPRITE_BATCH_MAX_QUADS,
+                     indices, GL_STATIC_DRAW);
+        free(indices);
+    }
+    
+    // Vertices are already in world space, so the projection matrix is our MVP matrix
+    [_batchShaderProgram setMat4:&_batchProjection
+                forUniformHandle:_batchShaderProgram.mvpMatrixUniformHandle];
+    [_batchShaderProgram use];
+    
+    if (_batchTexture) {
+        icGLBindTexture2DN(0, _batchTexture);
+        if (_batchMaskTexture) {
+            icGLBindTexture2DN(1, _batchMaskTexture);
+        }
+    }
+    
+    icGLBlendFunc(_batchBlendFunc.src, _batchBlendFunc.dst);
+    icGLEnable(IC_GL_BLEND);
+    
+    icGLEnableVertexAttribs(IC_VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
+    
+    // Orphan the previous buffer store to avoid synchronizing with pending draws
+    icGLBindBuffer(GL_ARRAY_BUFFER, _batchVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(icV3F_C4F_T2F) * 4 * _batchQuadCount, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(icV3F_C4F_T2F) * 4 * _batchQuadCount, _batchVertices);
+    icGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _batchIndexBuffer);
+    
+#define kVertexSize sizeof(icV3F_C4F_T2F)
+    
+	glVertexAttribPointer(ICVertexAttribPosition, 3, GL_FLOAT, GL_FALSE, kVertexSize,
+                          (void*)offsetof(icV3F_C4F_T2F, vect));
+	glVertexAttribPointer(ICVertexAttribColor, 4, GL_FLOAT, GL_FALSE, kVertexSize,
+                          (void*)offsetof(icV3F_C4F_T2F, color));
+	glVertexAttribPointer(ICVertexAttribTexCoords, 2, GL_FLOAT, GL_FALSE, kVertexSize,
+                          (void*)offsetof(icV3F_C4F_T2F, texCoords));
+    
+    glDrawElements(GL_TRIANGLES, (GLsizei)_batchQuadCount * 6, GL_UNSIGNED_SHORT, 0);
+    IC_CHECK_GL_ERROR_DEBUG();
+    
+    _batchDrawCallCount++;
+    _batchQuadCount = 0;
+    
+    IC_PROFILE_ZONE_END(drawZone, ICProfilerCategoryDrawSubmission, "Sprite batch");
+}
+
+- (void)getModelViewProjectionMatrix:(kmMat4 *)mvp
+{
+    kmMat4 projection, modelView;
+    kmGLContextGetMatrix(_matrixContext, KM_GL_PROJECTION, &projection);
+    kmGLContextGetMatrix(_matrixContext, KM_GL_MODELVIEW, &modelView);
+    kmMat4Multiply(mvp, &projection, &modelView);
+}
+
+// Returns YES if the receiver culls nodes and the given node's branch is not visible. If the
+// root scene tracks damage, records the bounds of the branch in the node's drawn rect.
+- (BOOL)testCullingOfNode:(ICNode *)node
+{
+    if ([node subtreeDrawsOutsideBounds]) {
+        if (_recordsDrawnRects)
+            node.drawnRect = CGRectInfinite;
+        return NO;
+    }
+    
+    // Nodes without an extent on the XY plane, such as plain containers, have no usable bounds
+    kmAABB bounds = [node subtreeAABB];
+    if (bounds.min.x == bounds.max.x && bounds.min.y == bounds.max.y) {
+        if (_recordsDrawnRects)
+            node.drawnRect = CGRectNull;
+        return NO;
+    }
+    
+    kmMat4 mvp;
+    [self getModelViewProjectionMatrix:&mvp];
+    
+    uint outcode;
+    kmVec2 min, max;
+    BOOL inFront = icProjectAABB(&mvp, &bounds, &outcode, &min, &max);
+    
+    if (_recordsDrawnRects) {
+        if (outcode)
+            node.drawnRect = CGRectNull;
+        else if (!inFront)
+            node.drawnRect = CGRectInfinite;
+        else
+            node.drawnRect = CGRectMake(min.x, min.y, max.x - min.x, max.y - min.y);
+    }
+    
+    if (!_cullsNodes)
+        return NO;
+    
+    // All corners outside of the same frustum plane
+    if (outcode)
+        return YES;
+    
+    // Completely outside of the clipping region of an ancestor view
+    const icCullingRect *rect = _cullingRectCount ? &_cullingRects[_cullingRectCount - 1] : NULL;
+    if (inFront && rect && rect->bounded) {
+        return max.x <= rect->min.x || min.x >= rect->max.x ||
+               max.y <= rect->min.y || min.y >= rect->max.y;
+    }
+    return NO;
+}
+
+- (void)pushCullingRectForNode:(ICNode *)node bounded:(BOOL)bounded min:(kmVec2)min max:(kmVec2)max
+{
+    if (_cullingRectCount == _cullingRectCapacity) {
+        _cullingRectCapacity = MAX(_cullingRectCapacity * 2, 8);
+        _cullingRects = realloc(_cullingRects, sizeof(icCullingRect) * _cullingRectCapacity);
+    }
+    
+    // Clipping regions of nested views intersect, unless a scene starts a new coordinate space
+    if (node && _cullingRectCount && ![node isKindOfClass:[ICScene class]]) {
+        const icCullingRect *parentRect = &_cullingRects[_cullingRectCount - 1];
+        if (parentRect->bounded && bounded) {
+            min.x = MAX(min.x, parentRect->min.x);
+            min.y = MAX(min.y, parentRect->min.y);
+            max.x = MIN(max.x, parentRect->max.x);
+            max.y = MIN(max.y, parentRect->max.y);
+        } else if (parentRect->bounded) {
+            bounded = YES;
+            min = parentRect->min;
+            max = parentRect->max;
+        }
+    }
+    
+    icCullingRect *rect = &_cullingRects[_cullingRectCount++];
+    rect->node = node;
+    rect->bounded = bounded;
+    rect->min = min;
+    rect->max = max;
+}
+
+- (void)reserveBatchQuads:(NSUInteger)quadCount
+{
+    if (quadCount > _batchQuadCapacity) {
+        NSUInteger capacity = MAX(_batchQuadCapacity * 2, IC_SPRITE_BATCH_INITIAL_QUADS);
+        capacity = MIN(MAX(capacity, quadCount), IC_SPRITE_BATCH_MAX_QUADS);
+        _batchVertices = realloc(_batchVertices, sizeof(icV3F_C4F_T2F) * 4 * capacity);
+        _batchQuadCapacity = capacity;
+    }
 }
 
 @end
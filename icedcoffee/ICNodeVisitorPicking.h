@@ -32,7 +32,8 @@
 #import "icTypes.h"
 
 #define IC_PICK_COLOR_RESOLUTION                255.0f
-#define IC_DEFAULT_PICKING_RT_SIZE_IN_PIXELS    CGSizeMake(256,256)
+#define IC_DEFAULT_PICKING_RT_SIZE_IN_PIXELS    CGSizeMake(256,16)
+#define IC_PICKING_PIXEL_BUFFER_COUNT           2
 
 @class ICRenderTexture;
 @class ICScene;
@@ -66,10 +67,12 @@
  The following characteristics and limitations should be remembered when working with this class:
  
   * A render texture is used as an offscreen framebuffer for collecting pick colors for each node.
-    The size of that render texture determines the capacity of the picking visitor. In other words,
-    you may run into problems if your scene has more nodes than the visitor's render texture has
-    pixels. The default size of the render texture is set to 256x256 pixels, yielding a total
-    capacity of 65535 nodes. (One pixel is reserved for determining the final hit.)
+    The size of that render texture determines the capacity of the picking visitor. The visitor
+    starts with a render texture of 256x16 pixels and grows its height automatically if a picking
+    test visits more nodes than the render texture has pixels. (One pixel is reserved for
+    determining the final hit.) Likewise, it shrinks the render texture if the number of visited
+    nodes drops far below its capacity. Only the rows actually containing pick colors are read
+    back after each picking test.
   * The visitor uses OpenGL scissor tests to limit rendering to one pixel of its render texture.
     This means that, if the picking visitor is used, scissor tests cannot be employed for drawing.
   * The visitor assumes the given node hierarchy to be static for the duration of a call to
@@ -97,8 +100,12 @@
     GLint _viewport[4];
     int _internalMode;
     BOOL _usesAuxiliaryOpenGLContext;
-    GLuint _pbo;
-    BOOL _asyncReadbackIssued;
+    GLuint _pbos[IC_PICKING_PIXEL_BUFFER_COUNT];
+    uint _pboIndex;
+    BOOL _asyncReadbackIssued[IC_PICKING_PIXEL_BUFFER_COUNT];
+    NSMutableArray *_asyncPickNodes[IC_PICKING_PIXEL_BUFFER_COUNT];
+    uint32_t _asyncNodeCount[IC_PICKING_PIXEL_BUFFER_COUNT];
+    NSArray *_lastAsyncHitNodes;
     
     ICOpenGLContext *_auxGLContext;
 }
@@ -146,6 +153,9 @@
 
 /**
  @brief The receiver's render texture size in pixels
+ 
+ The receiver adjusts the height of its render texture automatically to the number of nodes
+ visited during a picking test. The width set using this property is retained.
  */
 @property (nonatomic, assign, setter=setRenderTextureSizeInPixels:) CGSize renderTextureSizeInPixels;
 
@@ -225,8 +235,10 @@
  @param deferredReadback (Mac OS X only.) If pixel buffer objects are supported by the OpenGL
  hardware, issues an asynchronous glReadPixels command and defers the actual readback of pixels
  to a later point in time. You should use ICNodeVisitorPicking::readHitNodesAsync to perform
- the deferred readback and retrieve the corresponding hit nodes. If this parameter is set to YES,
- the method always returns nil.
+ the deferred readback and retrieve the corresponding hit nodes. Deferred readbacks alternate
+ between two pixel buffer objects, so that a readback issued while the next one is pending
+ may be mapped without stalling the OpenGL pipeline. If this parameter is set to YES, the method
+ always returns nil.
   
  @return If deferredReadback is set to NO, returns an NSArray containing ICNode objects
  representing the nodes that passed the picking test. If no nodes passed the test, an empty array
@@ -248,6 +260,12 @@
  ICNodeVisitorPicking::performPickingTestWithNode:point:viewport:deferredReadback: to perform
  the actual readback on the visitor's render texture and return the corresponding hit nodes.
  
+ In order to avoid stalling the OpenGL pipeline, this method returns the results of the picking
+ test issued before the most recent one, which has usually completed on the GPU by the time the
+ next picking test is issued, typically one frame later. The most recent picking test remains
+ pending until the next call. If no earlier picking test is pending, the method returns the hit
+ nodes it returned last, or an empty array.
+ 
  @return Returns an NSArray containing ICNode objects representing the nodes that passed the
  picking test. If no nodes passed the test, an empty array is returned. If one or more nodes
  passed the test, the last object in the array always represents the final hit. The final hit is
@@ -30,6 +30,7 @@
 #import "ICConfiguration.h"
 #import "icUtils.h"
 #import "ICScene.h"
+#import "icGLState.h"
 #import "ICCamera.h"
 
 enum {
@@ -43,7 +44,14 @@ enum {
 - (BOOL)isInPickingContext;
 - (void)end;
 - (NSArray *)hitNodes;
-- (ICNode *)nodeForPickColor:(icColor4B)color;
+- (ICNode *)nodeForPickColor:(icColor4B)color pickNodes:(NSArray *)pickNodes;
+- (void)collectHitNodesIntoArray:(NSMutableArray *)resultNodes
+                       pixelData:(void *)data
+                       pickNodes:(NSArray *)pickNodes
+                       nodeCount:(uint32_t)nodeCount;
+- (CGSize)renderTextureSizeForNodeCount:(uint32_t)nodeCount;
+- (uint)usedRowCount;
+- (void)deletePixelBuffers;
 - (CGPoint)pixelLocationForNodeIndex:(uint32_t)nodeIndex;
 - (void)setUpScissorTestForPixelAtLocation:(CGPoint)location;
 - (void)tearDownScissorTest;
@@ -72,6 +80,11 @@ enum {
         _rayStack = [[NSMutableArray alloc] init];
         _usesAuxiliaryOpenGLContext = useAuxContext;
         
+        // Each node is drawn with its own pick color, so sprites must not be batched
+        _batchesSprites = NO;
+        _recordsCommands = NO;
+        _cullsNodes = NO;
+        
         ICHostViewController *hostViewController = owner.hostViewController;
         NSAssert(hostViewController != nil,
                  @"No host view controller could be determined. " \
@@ -89,12 +102,29 @@ enum {
 
 - (void)dealloc
 {
+    if (_pbos[0]) {
+        ICOpenGLContext *oldContext = nil;
+        if (_usesAuxiliaryOpenGLContext) {
+            oldContext = [ICOpenGLContext currentContext];
+            [_auxGLContext makeCurrentContext];
+        }
+        [self deletePixelBuffers];
+        if (_usesAuxiliaryOpenGLContext) {
+            if (oldContext)
+                [oldContext makeCurrentContext];
+            else
+                [ICOpenGLContext clearCurrentContext];
+        }
+    }
+    
     [[_auxGLContext unregisterContext] release];
     _auxGLContext = nil;
     
     [_renderTexture release];
+    [_pickNodes release];
     [_pickContextStack release];
     [_rayStack release];
+    [_lastAsyncHitNodes release];
     
     if (_clientData) {
         free(_clientData);
@@ -149,7 +179,51 @@ enum {
         
         [_pickNodes release];
         _pickNodes = [[NSMutableArray alloc] init];
+        
+        // Pixel buffers are sized for the previous render texture
+        [self deletePixelBuffers];
+    }
+}
+
+// Returns a render texture size with the receiver's current width and a height fitting the
+// given number of nodes, rounded up to the next power of two to avoid frequent reallocation
+- (CGSize)renderTextureSizeForNodeCount:(uint32_t)nodeCount
+{
+    uint width = _renderTextureSizeInPixels.width;
+    if (!width) {
+        width = IC_DEFAULT_PICKING_RT_SIZE_IN_PIXELS.width;
+    }
+    uint rows = (nodeCount + width - 1) / width;
+    uint height = IC_DEFAULT_PICKING_RT_SIZE_IN_PIXELS.height;
+    while (height < rows) {
+        height *= 2;
+    }
+    return CGSizeMake(width, height);
+}
+
+// Returns the number of render texture rows containing pick colors of the last picking test,
+// including the pixel reserved for the final hit
+- (uint)usedRowCount
+{
+    uint width = _renderTextureSizeInPixels.width;
+    uint rows = (_nodeCount + 1 + width - 1) / width;
+    return MIN(rows, (uint)_renderTextureSizeInPixels.height);
+}
+
+- (void)deletePixelBuffers
+{
+    if (_pbos[0]) {
+        glDeleteBuffers(IC_PICKING_PIXEL_BUFFER_COUNT, _pbos);
+        IC_CHECK_GL_ERROR_DEBUG();
+    }
+    uint i;
+    for (i=0; i<IC_PICKING_PIXEL_BUFFER_COUNT; i++) {
+        _pbos[i] = 0;
+        _asyncReadbackIssued[i] = NO;
+        [_asyncPickNodes[i] release];
+        _asyncPickNodes[i] = nil;
     }
+    _pboIndex = 0;
 }
 
 - (uint)renderTextureCapacity
@@ -236,32 +310,56 @@ enum {
     
     // Push a pick context consisting of the given point and viewport
     [self pushPickContext:[ICPickContext pickContextWithPoint:point viewport:viewport]];
+    
+    // Shrink the render texture if the previous picking test used only a fraction of it
+    if (_renderTexture && (_nodeCount + 1) * 4 < [self renderTextureCapacity]) {
+        CGSize size = [self renderTextureSizeForNodeCount:_nodeCount + 1];
+        if (size.height < _renderTextureSizeInPixels.height) {
+            [self setRenderTextureSizeInPixels:size];
+        }
+    }
+    
     // Bind the render texture's framebuffer
     [self begin];
     // Perform visitation
     [self visit:node];
+    if (_nodeCount + 1 > [self renderTextureCapacity]) {
+        // Pick colors of some nodes were drawn outside the render texture, so grow the
+        // render texture to fit all nodes and repeat visitation
+        [self end];
+        [self setRenderTextureSizeInPixels:[self renderTextureSizeForNodeCount:_nodeCount + 1]];
+        [self begin];
+        [self visit:node];
+    }
     if (!deferredReadback) {
         // Retrieve hit nodes synchronously
         hitNodes = [self hitNodes];
     } else {
 #ifdef __IC_PLATFORM_MAC
-        uint pboMemorySize = ICPointsToPixels(_renderTexture.size.width) *
-                             ICPointsToPixels(_renderTexture.size.height) * 4;
-        if (!_pbo) {
-            glGenBuffers(1, &_pbo);
-            glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbo);
-            glBufferData(GL_PIXEL_PACK_BUFFER, pboMemorySize, 0, GL_STREAM_READ);
+        uint pboMemorySize = [self renderTextureMemorySize];
+        if (!_pbos[0]) {
+            glGenBuffers(IC_PICKING_PIXEL_BUFFER_COUNT, _pbos);
+            uint i;
+            for (i=0; i<IC_PICKING_PIXEL_BUFFER_COUNT; i++) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[i]);
+                glBufferData(GL_PIXEL_PACK_BUFFER, pboMemorySize, 0, GL_STREAM_READ);
+            }
             glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-            IC_CHECK_GL_ERROR_DEBUG();    
+            IC_CHECK_GL_ERROR_DEBUG();
         }
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbo);
-        glReadPixels(0, 0,
-                     ICPointsToPixels(_renderTexture.size.width),
-                     ICPointsToPixels(_renderTexture.size.height),
+        // Read back only the rows containing pick colors into the next pixel buffer
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[_pboIndex]);
+        glReadPixels(0, 0, _renderTextureSizeInPixels.width, [self usedRowCount],
                      GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
         glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
         IC_CHECK_GL_ERROR_DEBUG();
-        _asyncReadbackIssued = YES;
+        
+        // Keep the pick nodes of this test until its readback has been consumed
+        [_asyncPickNodes[_pboIndex] release];
+        _asyncPickNodes[_pboIndex] = [_pickNodes mutableCopy];
+        _asyncNodeCount[_pboIndex] = _nodeCount;
+        _asyncReadbackIssued[_pboIndex] = YES;
+        _pboIndex = (_pboIndex + 1) % IC_PICKING_PIXEL_BUFFER_COUNT;
 #elif defined(__IC_PLATFORM_IOS)
         NSAssert(nil, @"Asynchronous readback is not available on iOS");
 #endif
@@ -428,22 +526,25 @@ enum {
     return result;
 }
 
-- (ICNode *)nodeForPickColor:(icColor4B)color
+- (ICNode *)nodeForPickColor:(icColor4B)color pickNodes:(NSArray *)pickNodes
 {
     uint index = *((uint *)&color);
-    if (index < [_pickNodes count]) {
-        return [_pickNodes objectAtIndex:index];
+    if (index < [pickNodes count]) {
+        return [pickNodes objectAtIndex:index];
     }
     return nil;
 }
 
-- (void)collectHitNodesIntoArray:(NSMutableArray *)resultNodes pixelData:(void *)data
+- (void)collectHitNodesIntoArray:(NSMutableArray *)resultNodes
+                       pixelData:(void *)data
+                       pickNodes:(NSArray *)pickNodes
+                       nodeCount:(uint32_t)nodeCount
 {
     // Iterate over all pixels stored in the receiver's render texture. Each pixel represents
     // a node that was processed during picking visitation. The color of the respective pixel
     // identifies the corresponding ICNode object.
     uint32_t i = 0;
-    for (; i<_nodeCount+1; i++) {
+    for (; i<nodeCount+1; i++) {
         icColor4B *color = (icColor4B *)&data[i*4];
         if ([[ICConfiguration sharedConfiguration] supportsCVOpenGLESTextureCache]) {
             // Convert BGRA to RGBA when using CoreVideo
@@ -451,9 +552,9 @@ enum {
             color->r = color->b;
             color->b = r;
         }
-        ICNode *node = [self nodeForPickColor:*color];
+        ICNode *node = [self nodeForPickColor:*color pickNodes:pickNodes];
         if (node) {
-            if (i == _nodeCount) {
+            if (i == nodeCount) {
                 // Make sure the final hit is the last object in our result array
                 if ([resultNodes containsObject:node]) {
                     [resultNodes removeObject:node];
@@ -498,7 +599,10 @@ enum {
         CVReturn err = CVPixelBufferLockBaseAddress(_renderTexture.texture.cvRenderTarget, kCVPixelBufferLock_ReadOnly);
         if (err == kCVReturnSuccess) {
             uint8_t *pixels = (uint8_t *)CVPixelBufferGetBaseAddress(_renderTexture.texture.cvRenderTarget);
-            [self collectHitNodesIntoArray:resultNodes pixelData:pixels];
+            [self collectHitNodesIntoArray:resultNodes
+                                 pixelData:pixels
+                                 pickNodes:_pickNodes
+                                 nodeCount:_nodeCount];
         }
         CVPixelBufferUnlockBaseAddress(_renderTexture.texture.cvRenderTarget, kCVPixelBufferLock_ReadOnly);
 #endif
@@ -506,10 +610,14 @@ enum {
         // Standard readback on Mac or iOS simulator
         NSAssert(_clientData != NULL, @"No client buffer");
         
-        CGRect rect = CGRectMake(0, 0, _renderTextureSizeInPixels.width, _renderTextureSizeInPixels.height);
+        // Read back only the rows containing pick colors
+        CGRect rect = CGRectMake(0, 0, _renderTextureSizeInPixels.width, [self usedRowCount]);
         [_renderTexture readPixels:_clientData inRect:rect];
         
-        [self collectHitNodesIntoArray:resultNodes pixelData:_clientData];
+        [self collectHitNodesIntoArray:resultNodes
+                             pixelData:_clientData
+                             pickNodes:_pickNodes
+                             nodeCount:_nodeCount];
     }
     
     return resultNodes;
@@ -518,9 +626,21 @@ enum {
 - (NSArray *)readHitNodesAsync
 {
 #ifdef __IC_PLATFORM_MAC
-    NSMutableArray *resultNodes = [NSMutableArray array];
+    // Consume the oldest pending readback other than the most recent one, which is likely
+    // still in flight on the GPU
+    int index = -1;
+    uint i;
+    for (i=0; i<IC_PICKING_PIXEL_BUFFER_COUNT-1; i++) {
+        uint bufferIndex = (_pboIndex + i) % IC_PICKING_PIXEL_BUFFER_COUNT;
+        if (_asyncReadbackIssued[bufferIndex]) {
+            index = bufferIndex;
+            break;
+        }
+    }
     
-    if (_asyncReadbackIssued) {
+    if (index >= 0) {
+        NSMutableArray *resultNodes = [NSMutableArray array];
+        
         NSOpenGLContext *oldContext = nil;
         if (_usesAuxiliaryOpenGLContext) {
             oldContext = [NSOpenGLContext currentContext];
@@ -532,10 +652,13 @@ enum {
 #endif
         
         [_renderTexture begin];
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[index]);
         void *data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
         if (data) {
-            [self collectHitNodesIntoArray:resultNodes pixelData:data];
+            [self collectHitNodesIntoArray:resultNodes
+                                 pixelData:data
+                                 pickNodes:_asyncPickNodes[index]
+                                 nodeCount:_asyncNodeCount[index]];
             glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
         }
         
@@ -543,8 +666,13 @@ enum {
         IC_CHECK_GL_ERROR_DEBUG();    
         [_renderTexture end];
         
-        // Reset async readback flag
-        _asyncReadbackIssued = NO;
+        // Reset async readback state of the consumed buffer
+        _asyncReadbackIssued[index] = NO;
+        [_asyncPickNodes[index] release];
+        _asyncPickNodes[index] = nil;
+        
+        [_lastAsyncHitNodes release];
+        _lastAsyncHitNodes = [resultNodes retain];
         
         if (_usesAuxiliaryOpenGLContext) {
             if (oldContext)
@@ -554,11 +682,12 @@ enum {
         }    
     } else {
 #if IC_ENABLE_DEBUG_PICKING
-        ICLog(@"Picking visitor: async readback not issued");
+        ICLog(@"Picking visitor: no completed async readback pending");
 #endif        
     }
     
-    return resultNodes;
+    // If no earlier readback was pending, repeat the results returned last
+    return _lastAsyncHitNodes ? [[_lastAsyncHitNodes retain] autorelease] : [NSArray array];
     
 #elif defined(__IC_PLATFORM_IOS)
     NSAssert(nil, @"Asynchronous readback is not available on iOS");
@@ -576,13 +705,13 @@ enum {
 
 - (void)setUpScissorTestForPixelAtLocation:(CGPoint)location
 {
-    glScissor(location.x, location.y, 1, 1);
-    glEnable(GL_SCISSOR_TEST);
+    icGLScissor(location.x, location.y, 1, 1);
+    icGLEnable(IC_GL_SCISSOR_TEST);
 }
 
 - (void)tearDownScissorTest
 {
-    glDisable(GL_SCISSOR_TEST);
+    icGLDisable(IC_GL_SCISSOR_TEST);
 }
 
 @end
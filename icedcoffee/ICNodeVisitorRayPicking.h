@@ -0,0 +1,70 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import "ICNodeVisitorPicking.h"
+
+/**
+ @brief Node visitor for ray-based picking using a scene's spatial index
+ 
+ The ICNodeVisitorRayPicking class implements a picking visitor that performs hit tests on the
+ CPU, without drawing. For a given pick point, it computes a world ray using the scene's camera
+ (see ICScene::worldRayFromFramebufferLocation:) and queries the scene's spatial index (see
+ ICScene::enumerateNodesIntersectingWorldRay:usingBlock:) for nodes whose world axis-aligned
+ bounding boxes are intersected by the ray. Each candidate is then checked as follows:
+ 
+  * Nodes with ICNode::userInteractionEnabled set to NO are not reported.
+  * If ICNode::localRayHitTest: fails for the node or any of its ancestors, the node is not
+    reported. This mirrors ICNodeVisitorPicking, which skips the branch of a node whose ray-based
+    hit test failed. Nodes returning ICHitTestUnsupported or ICHitTestDismissed pass the test,
+    as their bounding box is known to be intersected by the ray.
+  * Nodes which do not draw anything, such as plain ICNode containers, scenes and render
+    textures, are not reported, since these never appear in color-based picking results either.
+  * Render texture sub scenes are hit tested recursively if the render texture passes the test,
+    using the pick point transformed to the sub scene's framebuffer. Their hits are reported
+    immediately after the render texture.
+ 
+ Hit nodes are reported in drawing order, so the final hit is the last node drawn at the pick
+ point. If the scene performs depth testing (see ICScene::performsDepthTesting), hit nodes are
+ instead ordered by decreasing distance from the camera, so that the final hit is the closest
+ node.
+ 
+ Bounding boxes and ray hit tests are exact for rectangular nodes, but not for nodes whose
+ visible shape covers only parts of their bounds. Such nodes may set
+ ICNode::requiresPixelExactHitTest to YES. If any of these nodes is hit by the ray, the visitor
+ falls back to the color-based picking implemented by its super class to confirm them. As this
+ is only required for opted-in nodes, hit tests on typical user interfaces such as mouse move
+ tracking never require a GPU round trip.
+ 
+ Deferred readbacks (see ICNodeVisitorPicking::readHitNodesAsync) are supported for
+ compatibility only: the results are computed synchronously and returned by the subsequent call
+ to ICNodeVisitorRayPicking::readHitNodesAsync.
+ 
+ ICNodeVisitorRayPicking is the default picking visitor of ICScene (see
+ #IC_DEFAULT_PICKING_VISITOR).
+ */
+@interface ICNodeVisitorRayPicking : ICNodeVisitorPicking {
+@protected
+    NSArray *_deferredHitNodes;
+}
+
+@end
@@ -0,0 +1,226 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import "ICNodeVisitorRayPicking.h"
+#import "ICScene.h"
+#import "ICRenderTexture.h"
+#import "icMacros.h"
+#import "icConfig.h"
+
+typedef struct _icRayPickingCandidate {
+    ICNode *node;
+    uint drawingOrder;
+    float distance;
+} icRayPickingCandidate;
+
+static int icCompareCandidatesByDrawingOrder(const void *a, const void *b)
+{
+    uint orderA = ((const icRayPickingCandidate *)a)->drawingOrder;
+    uint orderB = ((const icRayPickingCandidate *)b)->drawingOrder;
+    return orderA < orderB ? -1 : (orderA > orderB ? 1 : 0);
+}
+
+// Orders candidates from far to near, so that the closest candidate comes last. Candidates
+// at equal distances are ordered by drawing order, as GL_LEQUAL depth tests let the last
+// drawn fragment win.
+static int icCompareCandidatesByDistance(const void *a, const void *b)
+{
+    float distanceA = ((const icRayPickingCandidate *)a)->distance;
+    float distanceB = ((const icRayPickingCandidate *)b)->distance;
+    if (distanceA != distanceB)
+        return distanceA > distanceB ? -1 : 1;
+    return icCompareCandidatesByDrawingOrder(a, b);
+}
+
+static ICHitTestResult icWorldRayHitTest(ICNode *node, icRay3 worldRay)
+{
+    icRay3 localRay;
+    localRay.origin = [node convertToNodeSpace:worldRay.origin];
+    localRay.direction = [node convertToNodeSpace:worldRay.direction];
+    return [node localRayHitTest:localRay];
+}
+
+// Nodes which do not draw anything never appear in color-based picking results
+static BOOL icNodeDrawsForPicking(ICNode *node)
+{
+    static IMP defaultDrawImp = NULL;
+    if (!defaultDrawImp) {
+        defaultDrawImp = [ICNode instanceMethodForSelector:@selector(drawWithVisitor:)];
+    }
+    if ([node isKindOfClass:[ICScene class]] || [node isKindOfClass:[ICRenderTexture class]]) {
+        return NO;
+    }
+    return [node methodForSelector:@selector(drawWithVisitor:)] != defaultDrawImp;
+}
+
+
+@interface ICNodeVisitorRayPicking (Private)
+- (void)collectHitNodesIntoArray:(NSMutableArray *)hitNodes
+                           scene:(ICScene *)scene
+                           point:(CGPoint)point;
+- (BOOL)ancestorsOfNode:(ICNode *)node passRayHitTest:(icRay3)worldRay scene:(ICScene *)scene;
+@end
+
+@implementation ICNodeVisitorRayPicking
+
+- (void)dealloc
+{
+    [_deferredHitNodes release];
+    [super dealloc];
+}
+
+- (NSArray *)performPickingTestWithNode:(ICNode *)node
+                                  point:(CGPoint)point
+                               viewport:(GLint *)viewport
+                       deferredReadback:(BOOL)deferredReadback
+{
+    if (![node isKindOfClass:[ICScene class]]) {
+        // Ray-based picking requires the spatial index of a scene
+        return [super performPickingTestWithNode:node
+                                           point:point
+                                        viewport:viewport
+                                deferredReadback:deferredReadback];
+    }
+    
+    NSMutableArray *hitNodes = [NSMutableArray array];
+    [self collectHitNodesIntoArray:hitNodes scene:(ICScene *)node point:point];
+    
+    // Confirm hits on nodes requiring pixel exact hit tests using color-based picking
+    BOOL requiresColorPicking = NO;
+    for (ICNode *hitNode in hitNodes) {
+        if (hitNode.requiresPixelExactHitTest) {
+            requiresColorPicking = YES;
+            break;
+        }
+    }
+    if (requiresColorPicking) {
+        NSArray *colorHitNodes = [super performPickingTestWithNode:node
+                                                             point:point
+                                                          viewport:viewport
+                                                  deferredReadback:NO];
+        NSIndexSet *rejectedNodes = [hitNodes indexesOfObjectsPassingTest:
+                                     ^BOOL(id obj, NSUInteger idx, BOOL *stop) {
+                                         return [obj requiresPixelExactHitTest] &&
+                                                ![colorHitNodes containsObject:obj];
+                                     }];
+#if IC_ENABLE_DEBUG_PICKING
+        ICLog(@"Ray picking visitor: %lu node(s) rejected by color-based picking",
+              (unsigned long)[rejectedNodes count]);
+#endif
+        [hitNodes removeObjectsAtIndexes:rejectedNodes];
+    }
+    
+    if (deferredReadback) {
+        [_deferredHitNodes release];
+        _deferredHitNodes = [hitNodes retain];
+        return nil;
+    }
+    
+    return hitNodes;
+}
+
+- (NSArray *)readHitNodesAsync
+{
+    if (_deferredHitNodes) {
+        NSArray *hitNodes = [_deferredHitNodes autorelease];
+        _deferredHitNodes = nil;
+        return hitNodes;
+    }
+    return [super readHitNodesAsync];
+}
+
+- (void)collectHitNodesIntoArray:(NSMutableArray *)hitNodes
+                           scene:(ICScene *)scene
+                           point:(CGPoint)point
+{
+    icRay3 worldRay = [scene worldRayFromFramebufferLocation:point];
+    
+    NSMutableData *candidateData = [NSMutableData data];
+    [scene enumerateNodesIntersectingWorldRay:worldRay
+                                   usingBlock:^(ICNode *node, uint drawingOrder, float distance) {
+        icRayPickingCandidate candidate = { node, drawingOrder, distance };
+        [candidateData appendBytes:&candidate length:sizeof(icRayPickingCandidate)];
+    }];
+    
+    icRayPickingCandidate *candidates = (icRayPickingCandidate *)[candidateData mutableBytes];
+    uint candidateCount = (uint)([candidateData length] / sizeof(icRayPickingCandidate));
+    qsort(candidates, candidateCount, sizeof(icRayPickingCandidate),
+          scene.performsDepthTesting ? icCompareCandidatesByDistance :
+                                       icCompareCandidatesByDrawingOrder);
+    
+    uint i;
+    for (i=0; i<candidateCount; i++) {
+        ICNode *node = candidates[i].node;
+        
+        if (!node.userInteractionEnabled ||
+            ![self ancestorsOfNode:node passRayHitTest:worldRay scene:scene]) {
+            continue;
+        }
+        
+        if ([node isKindOfClass:[ICScene class]]) {
+            // Descendant scene drawn to the same framebuffer using its own camera
+            [self collectHitNodesIntoArray:hitNodes scene:(ICScene *)node point:point];
+            continue;
+        }
+        
+        if (icWorldRayHitTest(node, worldRay) == ICHitTestFailed) {
+#if IC_ENABLE_DEBUG_PICKING
+            ICLog(@"Ray picking visitor: ray hit test failed for node: %@", [node description]);
+#endif
+            continue;
+        }
+        
+        if (icNodeDrawsForPicking(node)) {
+            [hitNodes addObject:node];
+        }
+        
+        if ([node isKindOfClass:[ICRenderTexture class]]) {
+            ICRenderTexture *renderTexture = (ICRenderTexture *)node;
+            ICScene *subScene = renderTexture.subScene;
+            if (subScene && subScene.isVisible && subScene.userInteractionEnabled) {
+                // Transform the pick point to the render texture's framebuffer
+                kmVec3 location = [renderTexture parentFramebufferToNodeLocation:point];
+                CGPoint subPoint = kmVec3ToCGPoint(location);
+                if (subPoint.x >= 0 && subPoint.y >= 0 &&
+                    subPoint.x <= renderTexture.size.width &&
+                    subPoint.y <= renderTexture.size.height) {
+                    [self collectHitNodesIntoArray:hitNodes scene:subScene point:subPoint];
+                }
+            }
+        }
+    }
+}
+
+- (BOOL)ancestorsOfNode:(ICNode *)node passRayHitTest:(icRay3)worldRay scene:(ICScene *)scene
+{
+    ICNode *ancestor = node.parent;
+    for (; ancestor && ancestor != scene; ancestor = ancestor.parent) {
+        if (ancestor.userInteractionEnabled &&
+            icWorldRayHitTest(ancestor, worldRay) == ICHitTestFailed) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@end
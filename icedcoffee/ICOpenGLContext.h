@@ -53,6 +53,7 @@
     ICGlyphCache *_glyphCache;
     NSMutableDictionary *_customObjects;
     float _contentScaleFactor;
+    struct _icGLStateCache *_glStateCache;
 }
 
 /** @name Initialization */
@@ -148,6 +149,15 @@
 @property (nonatomic, assign) float contentScaleFactor;
 
 
+/**
+ @brief The GL state cache mirroring the state of the receiver's native context
+ 
+ State caches are never shared between contexts. The cache is made current for the calling
+ thread together with the receiver, see icGLState.h.
+ */
+@property (nonatomic, readonly) struct _icGLStateCache *glStateCache;
+
+
 /** @name Managing Custom Objects Associated with an OpenGL context */
 
 /**
@@ -24,6 +24,7 @@
 #import "ICOpenGLContext.h"
 #import "ICOpenGLContextManager.h"
 #import "icDefaults.h"
+#import "icGLState.h"
 
 // FIXME: ICOpenGLContext should observe property changes on share contexts to track changes
 
@@ -35,6 +36,7 @@
 @synthesize glyphCache = _glyphCache;
 @synthesize customObjects = _customObjects;
 @synthesize contentScaleFactor = _contentScaleFactor;
+@synthesize glStateCache = _glStateCache;
 
 + (id)openGLContextWithNativeOpenGLContext:(IC_NATIVE_OPENGL_CONTEXT *)nativeContext
 {
@@ -58,6 +60,8 @@
 {
     if ((self = [super init])) {
         _nativeContext = [nativeContext retain];
+        // GL state is per context, even if objects are shared
+        _glStateCache = icGLStateCacheCreate();
         if (shareContext) {
             self.textureCache = shareContext.textureCache;
             self.shaderCache = shareContext.shaderCache;
@@ -77,6 +81,7 @@
 {
     [_customObjects release];
     [_nativeContext release];
+    icGLStateCacheFree(_glStateCache);
     
     [super dealloc];
 }
@@ -23,6 +23,7 @@
 
 #import "ICOpenGLContextManager.h"
 #import "Platforms/icGL.h"
+#import "icGLState.h"
 
 ICOpenGLContextManager *g_defaultOpenGLContextManager = nil;
 
@@ -91,9 +92,11 @@ ICOpenGLContextManager *g_defaultOpenGLContextManager = nil;
     // FIXME: better solution might be to use [NSThread threadDictionary]
     if (context) {
         kmGLSetCurrentContext(context);
+        icGLSetCurrentStateCache(context.glStateCache);
         [[[NSThread currentThread] threadDictionary] setObject:context forKey:@"currentICOpenGLContext"];
     } else {
         kmGLSetCurrentContext(NULL);
+        icGLSetCurrentStateCache(NULL);
         [[[NSThread currentThread] threadDictionary] removeObjectForKey:@"currentICOpenGLContext"];
     }
 }
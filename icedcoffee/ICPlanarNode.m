@@ -63,8 +63,8 @@
     kmVec3 planeNormal = [self planeNormal];;
     kmVec3 planePoint = [self planePoint];
     kmMat4 nodeToWorldTransform = [self nodeToWorldTransform];
-    kmMat4 inverseTransform, normalTransform;
-    kmMat4Inverse(&inverseTransform, &nodeToWorldTransform);    
+    kmMat4 inverseTransform = [self worldToNodeTransform];
+    kmMat4 normalTransform;
     kmMat4Transpose(&normalTransform, &inverseTransform);
     kmVec3Transform(&planeNormal, &planeNormal, &normalTransform);
     kmVec3Transform(&planePoint, &planePoint, &nodeToWorldTransform);
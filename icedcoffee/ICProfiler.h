@@ -0,0 +1,271 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import <Foundation/Foundation.h>
+#import "icConfig.h"
+
+@class ICProfiler;
+
+/**
+ @brief Categories of work measured by ICProfiler
+ */
+typedef enum _ICProfilerCategory {
+    /** @brief CPU time spent between ICProfiler::beginFrame and ICProfiler::endFrame */
+    ICProfilerCategoryFrame = 0,
+    /** @brief Dispatching ICUpdatable::update: messages to scheduled targets */
+    ICProfilerCategorySchedulerUpdate,
+    /** @brief Processing animations in ICScheduler */
+    ICProfilerCategoryAnimations,
+    /** @brief Traversing the scene graph with ICNodeVisitorDrawing or one of its subclasses,
+        which includes the traversals performed for picking */
+    ICProfilerCategoryTraversal,
+    /** @brief Issuing draw calls, including sprite batches and immediately drawn nodes */
+    ICProfilerCategoryDrawSubmission,
+    /** @brief Performing hit tests and reading back picking results */
+    ICProfilerCategoryPicking,
+    /** @brief Looking up, rasterizing and uploading glyphs in ICGlyphCache */
+    ICProfilerCategoryGlyphCache,
+    /** @brief The number of profiler categories */
+    ICProfilerCategoryCount
+} ICProfilerCategory;
+
+/**
+ @brief Timings of a single frame recorded by ICProfiler
+ */
+typedef struct _icProfilerFrame {
+    //! The index of the frame, starting at zero when the profiler is enabled
+    uint64_t frameIndex;
+    //! Start of the frame in seconds since the profiler has been created
+    double startTime;
+    //! CPU time in seconds spent in each category. Nested zones of the same category are
+    //! counted once, zones of different categories overlap (e.g. draw submission is part of
+    //! traversal).
+    double cpuTimes[ICProfilerCategoryCount];
+    //! GPU time in seconds spent on the frame's GL commands, or a negative value if unavailable
+    double gpuTime;
+} icProfilerFrame;
+
+/**
+ @brief Aggregated timing of all nodes of a class drawn by ICNodeVisitorDrawing
+ */
+typedef struct _icProfilerNodeClassTiming {
+    //! The node class
+    Class nodeClass;
+    //! The number of nodes of the class visited for drawing
+    uint64_t count;
+    //! The total CPU time in seconds spent on drawing nodes of the class, excluding children
+    double time;
+} icProfilerNodeClassTiming;
+
+/**
+ @brief Records per-frame timings of the framework's main stages
+ 
+ Each ICHostViewController owns a profiler available via ICHostViewController::profiler.
+ Profilers are disabled by default, so they can stay compiled into production builds at the
+ cost of a thread-local lookup per instrumented zone. Set ICProfiler::enabled to YES to start
+ recording.
+ 
+ While enabled, the profiler records zones measured using the #IC_PROFILE_ZONE_BEGIN and
+ #IC_PROFILE_ZONE_END macros on the thread its host view controller draws on. It keeps the
+ timings of the most recent #IC_PROFILER_FRAME_HISTORY frames and the most recent
+ #IC_PROFILER_MAX_EVENTS zones, which may be exported in Chrome's trace event format using
+ ICProfiler::writeChromeTraceToFile: and inspected in ``chrome://tracing``.
+ 
+ If ICProfiler::measuresGPUTime is set to YES and the GL implementation supports timer queries
+ (see ICConfiguration::supportsTimerQuery), the profiler additionally measures the GPU time of
+ each frame. Results are read back asynchronously a few frames later, so they never stall the
+ pipeline.
+ 
+ If ICProfiler::recordsNodeClassTimings is set to YES, ICNodeVisitorDrawing additionally
+ aggregates the time spent on drawing each node by the node's class.
+ 
+ Zones recorded on threads other than the drawing thread of the profiler's host view
+ controller (e.g. glyph rasterization on background queues) are not recorded.
+ */
+@interface ICProfiler : NSObject {
+@protected
+    void *_state;
+    BOOL _measuresGPUTime;
+}
+
+
+#pragma mark - Enabling the Profiler
+/** @name Enabling the Profiler */
+
+/**
+ @brief Whether the receiver records timings
+ 
+ Enabling the profiler clears all previously recorded timings.
+ */
+@property (nonatomic, assign, getter=isEnabled) BOOL enabled;
+
+/**
+ @brief Whether the receiver measures the GPU time of each frame using timer queries
+ 
+ Defaults to NO. Has no effect if timer queries are not supported.
+ */
+@property (nonatomic, assign) BOOL measuresGPUTime;
+
+/**
+ @brief Whether the receiver aggregates drawing times by node class
+ 
+ Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL recordsNodeClassTimings;
+
+
+#pragma mark - Recording Frames
+/** @name Recording Frames */
+
+/**
+ @brief Starts recording a new frame
+ 
+ Called by ICHostViewController::drawScene. Ends the previous frame if it has not been ended
+ yet. Must be called with the OpenGL context of the frame being current.
+ */
+- (void)beginFrame;
+
+/**
+ @brief Ends recording the current frame
+ 
+ Called by platform specific host view controllers after the scene has been drawn.
+ */
+- (void)endFrame;
+
+
+#pragma mark - Retrieving Timings
+/** @name Retrieving Timings */
+
+/**
+ @brief The number of frames whose timings are available, at most #IC_PROFILER_FRAME_HISTORY
+ */
+@property (nonatomic, readonly) NSUInteger frameCount;
+
+/**
+ @brief Returns the timings of a recorded frame
+ 
+ @param index The index of the frame, where 0 is the oldest and ICProfiler::frameCount - 1 the
+ most recently ended frame
+ */
+- (icProfilerFrame)frameAtIndex:(NSUInteger)index;
+
+/**
+ @brief Returns the average timings of all available frames
+ */
+- (icProfilerFrame)averageFrame;
+
+/**
+ @brief The number of node classes for which timings have been aggregated
+ */
+@property (nonatomic, readonly) NSUInteger nodeClassTimingCount;
+
+/**
+ @brief Returns the aggregated timing at the given index, sorted by descending time
+ */
+- (icProfilerNodeClassTiming)nodeClassTimingAtIndex:(NSUInteger)index;
+
+/**
+ @brief Clears all recorded frames, zones and node class timings
+ */
+- (void)reset;
+
+
+#pragma mark - Exporting Traces
+/** @name Exporting Traces */
+
+/**
+ @brief Returns the recorded zones and frames in Chrome's trace event JSON format
+ */
+- (NSData *)chromeTraceData;
+
+/**
+ @brief Writes the recorded zones and frames in Chrome's trace event JSON format to a file
+ 
+ @return Returns YES on success or NO if the file could not be written
+ */
+- (BOOL)writeChromeTraceToFile:(NSString *)path;
+
+@end
+
+
+/**
+ @defgroup profiling Profiling
+ @{
+ */
+
+/**
+ @brief Makes the given profiler the current profiler of the calling thread
+ 
+ Called by ICHostViewController before it draws a frame. Pass nil to disable profiling on the
+ calling thread. The profiler is not retained.
+ */
+void icProfilerSetCurrent(ICProfiler *profiler);
+
+/**
+ @brief Returns the current profiler of the calling thread, or nil if there is none
+ */
+ICProfiler *icProfilerGetCurrent(void);
+
+/**
+ @brief Begins a zone of the given category in the calling thread's current profiler
+ 
+ @return Returns a timestamp to be passed to icProfilerEndZone(), or 0 if the calling thread has
+ no current profiler or the profiler is disabled
+ */
+uint64_t icProfilerBeginZone(ICProfilerCategory category);
+
+/**
+ @brief Ends a zone started using icProfilerBeginZone()
+ 
+ @param category The category passed to icProfilerBeginZone()
+ @param name The name of the zone. Must point to a string that remains valid for the lifetime
+ of the profiler, e.g. a string literal or the result of ``class_getName()``.
+ @param start The timestamp returned by icProfilerBeginZone(). The call has no effect if 0.
+ */
+void icProfilerEndZone(ICProfilerCategory category, const char *name, uint64_t start);
+
+/**
+ @brief Returns a timestamp for a node class timing, or 0 if node class timings are not recorded
+ */
+uint64_t icProfilerBeginNodeClassTiming(void);
+
+/**
+ @brief Adds the time elapsed since start to the aggregated timing of the given node class
+ 
+ The call has no effect if start is 0.
+ */
+void icProfilerEndNodeClassTiming(Class nodeClass, uint64_t start);
+
+#if IC_ENABLE_PROFILER
+/** @brief Begins a profiler zone, storing its start timestamp in a local variable named var */
+#define IC_PROFILE_ZONE_BEGIN(var, category) \
+    uint64_t var = icProfilerBeginZone(category)
+/** @brief Ends a profiler zone started using #IC_PROFILE_ZONE_BEGIN */
+#define IC_PROFILE_ZONE_END(var, category, name) \
+    do { if (var) icProfilerEndZone(category, name, var); } while(0)
+#else
+#define IC_PROFILE_ZONE_BEGIN(var, category)
+#define IC_PROFILE_ZONE_END(var, category, name) do {} while(0)
+#endif
+
+/** @} */
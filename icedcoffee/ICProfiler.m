@@ -0,0 +1,533 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import "ICProfiler.h"
+#import "ICConfiguration.h"
+#import "icGL.h"
+#import <mach/mach_time.h>
+#import <pthread.h>
+
+#if defined(__IC_PLATFORM_MAC)
+#import <OpenGL/glext.h>
+#endif
+
+#if defined(__IC_PLATFORM_MAC) && defined(GL_TIME_ELAPSED_EXT)
+#define IC_PROFILER_SUPPORTS_GPU_TIMER 1
+#else
+#define IC_PROFILER_SUPPORTS_GPU_TIMER 0
+#endif
+
+// Number of timer queries in flight; results are read back this many frames late at worst
+#define IC_PROFILER_GPU_QUERY_COUNT 4
+
+
+typedef struct _icProfilerEvent {
+    uint64_t start;
+    uint64_t duration;
+    uint64_t frameIndex;
+    const char *name;
+    ICProfilerCategory category;
+} icProfilerEvent;
+
+typedef struct _icProfilerState {
+    ICProfiler *profiler;
+    BOOL enabled;
+    BOOL recordsNodeClassTimings;
+    uint64_t creationTime;
+    
+    // Frame currently being recorded
+    BOOL inFrame;
+    uint64_t frameStart;
+    uint64_t nextFrameIndex;
+    icProfilerFrame currentFrame;
+    uint categoryDepth[ICProfilerCategoryCount];
+    
+    // Ring buffer of recently ended frames
+    icProfilerFrame *frames;
+    uint frameHead;
+    uint frameCount;
+    
+    // Ring buffer of recently ended zones
+    icProfilerEvent *events;
+    uint eventHead;
+    uint eventCount;
+    
+    icProfilerNodeClassTiming *nodeClassTimings;
+    uint nodeClassTimingCount;
+    uint nodeClassTimingCapacity;
+    uint lastNodeClassTiming;
+    
+#if IC_PROFILER_SUPPORTS_GPU_TIMER
+    GLuint gpuQueries[IC_PROFILER_GPU_QUERY_COUNT];
+    uint64_t gpuQueryFrames[IC_PROFILER_GPU_QUERY_COUNT];
+    BOOL gpuQueryPending[IC_PROFILER_GPU_QUERY_COUNT];
+    uint gpuQueryIndex;
+    BOOL gpuQueryActive;
+#endif
+} icProfilerState;
+
+
+static pthread_key_t g_currentProfilerKey;
+static pthread_once_t g_currentProfilerKeyOnce = PTHREAD_ONCE_INIT;
+static double g_secondsPerTick = 0;
+
+static void icProfilerInitialize(void)
+{
+    pthread_key_create(&g_currentProfilerKey, NULL);
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    g_secondsPerTick = (double)timebase.numer / (double)timebase.denom * 1e-9;
+}
+
+// The thread-local key stores the profiler's state directly to avoid a message send per zone
+static inline icProfilerState *icProfilerCurrentState(void)
+{
+    return (icProfilerState *)pthread_getspecific(g_currentProfilerKey);
+}
+
+static inline double icProfilerSeconds(uint64_t ticks)
+{
+    return ticks * g_secondsPerTick;
+}
+
+static int icCompareNodeClassTimings(const void *a, const void *b)
+{
+    double ta = ((const icProfilerNodeClassTiming *)a)->time;
+    double tb = ((const icProfilerNodeClassTiming *)b)->time;
+    return ta > tb ? -1 : (ta < tb ? 1 : 0);
+}
+
+static const char *icProfilerCategoryNames[ICProfilerCategoryCount] = {
+    "frame",
+    "scheduler",
+    "animations",
+    "traversal",
+    "draw",
+    "picking",
+    "glyphs"
+};
+
+static void icProfilerAddEvent(icProfilerState *state, ICProfilerCategory category,
+                               const char *name, uint64_t start, uint64_t duration)
+{
+    icProfilerEvent *event = &state->events[state->eventHead];
+    event->start = start;
+    event->duration = duration;
+    event->frameIndex = state->currentFrame.frameIndex;
+    event->name = name;
+    event->category = category;
+    state->eventHead = (state->eventHead + 1) % IC_PROFILER_MAX_EVENTS;
+    state->eventCount = MIN(state->eventCount + 1, IC_PROFILER_MAX_EVENTS);
+}
+
+static void icAppendFormat(NSMutableData *data, const char *format, ...)
+{
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0)
+        [data appendBytes:buffer length:MIN((size_t)length, sizeof(buffer) - 1)];
+}
+
+
+@interface ICProfiler (Private)
+- (void *)state;
+- (void)readGPUQueries;
+- (icProfilerFrame *)historyFrameWithIndex:(uint64_t)frameIndex;
+@end
+
+
+@implementation ICProfiler
+
+@synthesize measuresGPUTime = _measuresGPUTime;
+
+- (id)init
+{
+    if ((self = [super init])) {
+        pthread_once(&g_currentProfilerKeyOnce, icProfilerInitialize);
+        icProfilerState *state = calloc(1, sizeof(icProfilerState));
+        state->profiler = self;
+        state->creationTime = mach_absolute_time();
+        _state = state;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    icProfilerState *state = _state;
+    if (icProfilerCurrentState() == state)
+        icProfilerSetCurrent(nil);
+#if IC_PROFILER_SUPPORTS_GPU_TIMER
+    if (state->gpuQueries[0])
+        glDeleteQueries(IC_PROFILER_GPU_QUERY_COUNT, state->gpuQueries);
+#endif
+    free(state->frames);
+    free(state->events);
+    free(state->nodeClassTimings);
+    free(state);
+    
+    [super dealloc];
+}
+
+- (BOOL)isEnabled
+{
+    return ((icProfilerState *)_state)->enabled;
+}
+
+- (void)setEnabled:(BOOL)enabled
+{
+    icProfilerState *state = _state;
+    if (enabled && !state->enabled) {
+        // Storage is allocated lazily, so disabled profilers in production builds cost nothing
+        if (!state->frames)
+            state->frames = malloc(sizeof(icProfilerFrame) * IC_PROFILER_FRAME_HISTORY);
+        if (!state->events)
+            state->events = malloc(sizeof(icProfilerEvent) * IC_PROFILER_MAX_EVENTS);
+        [self reset];
+    }
+    state->enabled = enabled;
+}
+
+- (BOOL)recordsNodeClassTimings
+{
+    return ((icProfilerState *)_state)->recordsNodeClassTimings;
+}
+
+- (void)setRecordsNodeClassTimings:(BOOL)recordsNodeClassTimings
+{
+    ((icProfilerState *)_state)->recordsNodeClassTimings = recordsNodeClassTimings;
+}
+
+- (void)reset
+{
+    icProfilerState *state = _state;
+    state->inFrame = NO;
+    state->nextFrameIndex = 0;
+    state->frameHead = state->frameCount = 0;
+    state->eventHead = state->eventCount = 0;
+    state->nodeClassTimingCount = 0;
+    state->lastNodeClassTiming = 0;
+    memset(state->categoryDepth, 0, sizeof(state->categoryDepth));
+#if IC_PROFILER_SUPPORTS_GPU_TIMER
+    memset(state->gpuQueryPending, 0, sizeof(state->gpuQueryPending));
+    state->gpuQueryActive = NO;
+#endif
+}
+
+- (void)beginFrame
+{
+    icProfilerState *state = _state;
+    if (!state->enabled)
+        return;
+    
+    if (state->inFrame)
+        [self endFrame];
+    
+    state->inFrame = YES;
+    state->frameStart = mach_absolute_time();
+    memset(&state->currentFrame, 0, sizeof(icProfilerFrame));
+    state->currentFrame.frameIndex = state->nextFrameIndex++;
+    state->currentFrame.startTime = icProfilerSeconds(state->frameStart - state->creationTime);
+    state->currentFrame.gpuTime = -1;
+    
+#if IC_PROFILER_SUPPORTS_GPU_TIMER
+    [self readGPUQueries];
+    if (_measuresGPUTime && [[ICConfiguration sharedConfiguration] supportsTimerQuery]) {
+        if (!state->gpuQueries[0])
+            glGenQueries(IC_PROFILER_GPU_QUERY_COUNT, state->gpuQueries);
+        // Skip measuring this frame if the query's previous result is still outstanding
+        if (!state->gpuQueryPending[state->gpuQueryIndex]) {
+            glBeginQuery(GL_TIME_ELAPSED_EXT, state->gpuQueries[state->gpuQueryIndex]);
+            state->gpuQueryActive = YES;
+        }
+    }
+#endif
+}
+
+- (void)endFrame
+{
+    icProfilerState *state = _state;
+    if (!state->enabled || !state->inFrame)
+        return;
+    
+    uint64_t now = mach_absolute_time();
+    
+#if IC_PROFILER_SUPPORTS_GPU_TIMER
+    if (state->gpuQueryActive) {
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+        state->gpuQueryPending[state->gpuQueryIndex] = YES;
+        state->gpuQueryFrames[state->gpuQueryIndex] = state->currentFrame.frameIndex;
+        state->gpuQueryIndex = (state->gpuQueryIndex + 1) % IC_PROFILER_GPU_QUERY_COUNT;
+        state->gpuQueryActive = NO;
+    }
+#endif
+    
+    state->currentFrame.cpuTimes[ICProfilerCategoryFrame] = icProfilerSeconds(now - state->frameStart);
+    icProfilerAddEvent(state, ICProfilerCategoryFrame, "Frame", state->frameStart, now - state->frameStart);
+    
+    state->frames[state->frameHead] = state->currentFrame;
+    state->frameHead = (state->frameHead + 1) % IC_PROFILER_FRAME_HISTORY;
+    state->frameCount = MIN(state->frameCount + 1, IC_PROFILER_FRAME_HISTORY);
+    state->inFrame = NO;
+}
+
+- (NSUInteger)frameCount
+{
+    return ((icProfilerState *)_state)->frameCount;
+}
+
+- (icProfilerFrame)frameAtIndex:(NSUInteger)index
+{
+    icProfilerState *state = _state;
+    NSAssert(index < state->frameCount, @"Frame index out of bounds");
+    uint oldest = (state->frameHead + IC_PROFILER_FRAME_HISTORY - state->frameCount) % IC_PROFILER_FRAME_HISTORY;
+    return state->frames[(oldest + index) % IC_PROFILER_FRAME_HISTORY];
+}
+
+- (icProfilerFrame)averageFrame
+{
+    icProfilerState *state = _state;
+    icProfilerFrame average;
+    memset(&average, 0, sizeof(icProfilerFrame));
+    average.gpuTime = -1;
+    
+    uint gpuFrameCount = 0;
+    double gpuTime = 0;
+    for (uint i=0; i<state->frameCount; i++) {
+        const icProfilerFrame *frame = &state->frames[i];
+        for (uint c=0; c<ICProfilerCategoryCount; c++)
+            average.cpuTimes[c] += frame->cpuTimes[c];
+        if (frame->gpuTime >= 0) {
+            gpuTime += frame->gpuTime;
+            gpuFrameCount++;
+        }
+    }
+    if (state->frameCount) {
+        for (uint c=0; c<ICProfilerCategoryCount; c++)
+            average.cpuTimes[c] /= state->frameCount;
+    }
+    if (gpuFrameCount)
+        average.gpuTime = gpuTime / gpuFrameCount;
+    return average;
+}
+
+- (NSUInteger)nodeClassTimingCount
+{
+    return ((icProfilerState *)_state)->nodeClassTimingCount;
+}
+
+- (icProfilerNodeClassTiming)nodeClassTimingAtIndex:(NSUInteger)index
+{
+    icProfilerState *state = _state;
+    NSAssert(index < state->nodeClassTimingCount, @"Node class timing index out of bounds");
+    if (index == 0) {
+        qsort(state->nodeClassTimings, state->nodeClassTimingCount,
+              sizeof(icProfilerNodeClassTiming), icCompareNodeClassTimings);
+    }
+    return state->nodeClassTimings[index];
+}
+
+- (NSData *)chromeTraceData
+{
+    icProfilerState *state = _state;
+    NSMutableData *data = [NSMutableData dataWithCapacity:state->eventCount * 128 + 1024];
+    
+    icAppendFormat(data, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    icAppendFormat(data, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"icedcoffee\"}},\n");
+    icAppendFormat(data, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Drawing\"}}");
+    
+    uint oldest = (state->eventHead + IC_PROFILER_MAX_EVENTS - state->eventCount) % IC_PROFILER_MAX_EVENTS;
+    for (uint i=0; i<state->eventCount; i++) {
+        const icProfilerEvent *event = &state->events[(oldest + i) % IC_PROFILER_MAX_EVENTS];
+        icAppendFormat(data, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                       "\"pid\":1,\"tid\":1,\"args\":{\"frame\":%llu}}",
+                       event->name, icProfilerCategoryNames[event->category],
+                       icProfilerSeconds(event->start - state->creationTime) * 1e6,
+                       icProfilerSeconds(event->duration) * 1e6,
+                       (unsigned long long)event->frameIndex);
+    }
+    
+    // Per-frame totals and GPU times as counter tracks
+    for (NSUInteger i=0; i<[self frameCount]; i++) {
+        icProfilerFrame frame = [self frameAtIndex:i];
+        icAppendFormat(data, ",\n{\"name\":\"CPU ms\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{",
+                       frame.startTime * 1e6);
+        for (uint c=0; c<ICProfilerCategoryCount; c++) {
+            icAppendFormat(data, "%s\"%s\":%.4f", c ? "," : "", icProfilerCategoryNames[c],
+                           frame.cpuTimes[c] * 1e3);
+        }
+        icAppendFormat(data, "}}");
+        if (frame.gpuTime >= 0) {
+            icAppendFormat(data, ",\n{\"name\":\"GPU ms\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,"
+                           "\"args\":{\"frame\":%.4f}}", frame.startTime * 1e6, frame.gpuTime * 1e3);
+        }
+    }
+    
+    icAppendFormat(data, "\n]}\n");
+    return data;
+}
+
+- (BOOL)writeChromeTraceToFile:(NSString *)path
+{
+    return [[self chromeTraceData] writeToFile:path atomically:YES];
+}
+
+@end
+
+
+@implementation ICProfiler (Private)
+
+- (void *)state
+{
+    return _state;
+}
+
+- (void)readGPUQueries
+{
+#if IC_PROFILER_SUPPORTS_GPU_TIMER
+    icProfilerState *state = _state;
+    for (uint i=0; i<IC_PROFILER_GPU_QUERY_COUNT; i++) {
+        if (!state->gpuQueryPending[i])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(state->gpuQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        GLuint64EXT nanoseconds = 0;
+        glGetQueryObjectui64vEXT(state->gpuQueries[i], GL_QUERY_RESULT, &nanoseconds);
+        state->gpuQueryPending[i] = NO;
+        icProfilerFrame *frame = [self historyFrameWithIndex:state->gpuQueryFrames[i]];
+        if (frame)
+            frame->gpuTime = nanoseconds * 1e-9;
+    }
+#endif
+}
+
+- (icProfilerFrame *)historyFrameWithIndex:(uint64_t)frameIndex
+{
+    icProfilerState *state = _state;
+    // Results arrive a few frames late, so search backwards from the most recent frame
+    for (uint i=1; i<=state->frameCount; i++) {
+        icProfilerFrame *frame = &state->frames[(state->frameHead + IC_PROFILER_FRAME_HISTORY - i) %
+                                                IC_PROFILER_FRAME_HISTORY];
+        if (frame->frameIndex == frameIndex)
+            return frame;
+        if (frame->frameIndex < frameIndex)
+            break;
+    }
+    return NULL;
+}
+
+@end
+
+
+void icProfilerSetCurrent(ICProfiler *profiler)
+{
+    pthread_once(&g_currentProfilerKeyOnce, icProfilerInitialize);
+    pthread_setspecific(g_currentProfilerKey, profiler ? [profiler state] : NULL);
+}
+
+ICProfiler *icProfilerGetCurrent(void)
+{
+    pthread_once(&g_currentProfilerKeyOnce, icProfilerInitialize);
+    icProfilerState *state = icProfilerCurrentState();
+    return state ? state->profiler : nil;
+}
+
+uint64_t icProfilerBeginZone(ICProfilerCategory category)
+{
+    icProfilerState *state = icProfilerCurrentState();
+    if (!state || !state->enabled)
+        return 0;
+    state->categoryDepth[category]++;
+    return mach_absolute_time();
+}
+
+void icProfilerEndZone(ICProfilerCategory category, const char *name, uint64_t start)
+{
+    icProfilerState *state = icProfilerCurrentState();
+    if (!start || !state)
+        return;
+    
+    uint64_t duration = mach_absolute_time() - start;
+    if (state->categoryDepth[category])
+        state->categoryDepth[category]--;
+    if (!state->enabled)
+        return;
+    
+    // Only the outermost zone of a category contributes to the frame's totals
+    if (state->inFrame && !state->categoryDepth[category])
+        state->currentFrame.cpuTimes[category] += icProfilerSeconds(duration);
+    icProfilerAddEvent(state, category, name, start, duration);
+}
+
+uint64_t icProfilerBeginNodeClassTiming(void)
+{
+    icProfilerState *state = icProfilerCurrentState();
+    if (!state || !state->enabled || !state->recordsNodeClassTimings)
+        return 0;
+    return mach_absolute_time();
+}
+
+void icProfilerEndNodeClassTiming(Class nodeClass, uint64_t start)
+{
+    icProfilerState *state = icProfilerCurrentState();
+    if (!start || !state || !state->enabled)
+        return;
+    
+    double time = icProfilerSeconds(mach_absolute_time() - start);
+    
+    // Consecutive nodes tend to be of the same class, so try the last hit first
+    icProfilerNodeClassTiming *timing = NULL;
+    if (state->lastNodeClassTiming < state->nodeClassTimingCount &&
+        state->nodeClassTimings[state->lastNodeClassTiming].nodeClass == nodeClass) {
+        timing = &state->nodeClassTimings[state->lastNodeClassTiming];
+    } else {
+        for (uint i=0; i<state->nodeClassTimingCount; i++) {
+            if (state->nodeClassTimings[i].nodeClass == nodeClass) {
+                timing = &state->nodeClassTimings[i];
+                state->lastNodeClassTiming = i;
+                break;
+            }
+        }
+    }
+    
+    if (!timing) {
+        if (state->nodeClassTimingCount == state->nodeClassTimingCapacity) {
+            state->nodeClassTimingCapacity = MAX(state->nodeClassTimingCapacity * 2, 32);
+            state->nodeClassTimings = realloc(state->nodeClassTimings, sizeof(icProfilerNodeClassTiming) *
+                                              state->nodeClassTimingCapacity);
+        }
+        state->lastNodeClassTiming = state->nodeClassTimingCount++;
+        timing = &state->nodeClassTimings[state->lastNodeClassTiming];
+        timing->nodeClass = nodeClass;
+        timing->count = 0;
+        timing->time = 0;
+    }
+    
+    timing->count++;
+    timing->time += time;
+}
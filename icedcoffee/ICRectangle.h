@@ -24,6 +24,7 @@
 #import "ICView.h"
 
 @class ICSprite;
+@class ICShaderProgram;
 
 #define ICShaderRectangle @"ShaderRectangle"
 
@@ -38,6 +39,14 @@
     icColor4B _borderColor;
     icColor4B _gradientStartColor;
     icColor4B _gradientEndColor;
+    
+    ICShaderProgram *_uniformHandlesProgram;
+    ICShaderUniformHandle _borderWidthUniformHandle;
+    ICShaderUniformHandle _roundnessUniformHandle;
+    ICShaderUniformHandle _sizeUniformHandle;
+    ICShaderUniformHandle _innerColorUniformHandle;
+    ICShaderUniformHandle _innerColor2UniformHandle;
+    ICShaderUniformHandle _borderColorUniformHandle;
 }
 
 #pragma mark - Controlling the Rectangle's Appearance
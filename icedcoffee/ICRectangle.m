@@ -200,6 +200,13 @@ NSString *__rectangleFSH = IC_SHADER_STRING
     return self;
 }
 
+- (void)dealloc
+{
+    [_uniformHandlesProgram release];
+    
+    [super dealloc];
+}
+
 - (void)setBorderWidth:(float)borderWidth
 {
     _borderWidth = ICPointsToPixels(borderWidth);
@@ -219,13 +226,26 @@ NSString *__rectangleFSH = IC_SHADER_STRING
     
     float distOnePixel = 1.0/(self.size.height);
     
-    [_sprite.shaderProgram setShaderValue:[ICShaderValue shaderValueWithFloat:_borderWidth*distOnePixel] forUniform:@"u_borderWidth"];
-    [_sprite.shaderProgram setShaderValue:[ICShaderValue shaderValueWithFloat:0.4] forUniform:@"u_roundness"];
-    [_sprite.shaderProgram setShaderValue:[ICShaderValue shaderValueWithVec2:kmVec2Make(_sprite.size.width, _sprite.size.height)] forUniform:@"u_size"];
+    ICShaderProgram *p = _sprite.shaderProgram;
+    if (p != _uniformHandlesProgram) {
+        // Resolve uniform handles once per program instead of looking them up on each draw
+        [_uniformHandlesProgram release];
+        _uniformHandlesProgram = [p retain];
+        _borderWidthUniformHandle = [p uniformHandleForName:@"u_borderWidth"];
+        _roundnessUniformHandle = [p uniformHandleForName:@"u_roundness"];
+        _sizeUniformHandle = [p uniformHandleForName:@"u_size"];
+        _innerColorUniformHandle = [p uniformHandleForName:@"u_innerColor"];
+        _innerColor2UniformHandle = [p uniformHandleForName:@"u_innerColor2"];
+        _borderColorUniformHandle = [p uniformHandleForName:@"u_borderColor"];
+    }
+    
+    [p setFloat:_borderWidth*distOnePixel forUniformHandle:_borderWidthUniformHandle];
+    [p setFloat:0.4 forUniformHandle:_roundnessUniformHandle];
+    [p setVec2:kmVec2Make(_sprite.size.width, _sprite.size.height) forUniformHandle:_sizeUniformHandle];
 
-    [_sprite.shaderProgram setShaderValue:[ICShaderValue shaderValueWithVec4:kmVec4FromColor4B(_gradientStartColor)] forUniform:@"u_innerColor"];
-    [_sprite.shaderProgram setShaderValue:[ICShaderValue shaderValueWithVec4:kmVec4FromColor4B(_gradientEndColor)] forUniform:@"u_innerColor2"];
-    [_sprite.shaderProgram setShaderValue:[ICShaderValue shaderValueWithVec4:kmVec4FromColor4B(_borderColor)] forUniform:@"u_borderColor"];    
+    [p setVec4:kmVec4FromColor4B(_gradientStartColor) forUniformHandle:_innerColorUniformHandle];
+    [p setVec4:kmVec4FromColor4B(_gradientEndColor) forUniformHandle:_innerColor2UniformHandle];
+    [p setVec4:kmVec4FromColor4B(_borderColor) forUniformHandle:_borderColorUniformHandle];
 }
 
 @end
@@ -0,0 +1,185 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import <Foundation/Foundation.h>
+#import "icTypes.h"
+#import "Platforms/icGL.h"
+#import "../3rd-party/kazmath/kazmath/kazmath.h"
+
+@class ICShaderProgram;
+@class ICNodeVisitorDrawing;
+
+/**
+ @brief A lightweight draw command recorded by ICNodeVisitorDrawing
+ 
+ Each command references a range of world space quads stored in its ICRenderCommandBuffer along
+ with the state required to draw them.
+ */
+typedef struct _icRenderCommand {
+    //! Key used to sort opaque commands by state
+    uint64_t sortKey;
+    //! Shader program used to draw the command, retained by the command buffer
+    ICShaderProgram *shaderProgram;
+    //! Name of the texture bound to texture unit 0, or 0 for no texture
+    GLuint texture;
+    //! Name of the texture bound to texture unit 1, or 0 for no mask
+    GLuint maskTexture;
+    //! Blend function used to draw the command
+    icBlendFunc blendFunc;
+    //! Index of the command's projection matrix in the command buffer
+    uint projectionIndex;
+    //! Index of the command's first quad in the command buffer
+    uint firstQuad;
+    //! Number of quads drawn by the command
+    uint quadCount;
+    //! Bounds of the command's projected quads in normalized device coordinates
+    kmVec2 boundsMin, boundsMax;
+    //! Whether depth testing was enabled when the command was recorded
+    BOOL depthTested;
+} icRenderCommand;
+
+/**
+ @brief Records draw commands of a frame for state-sorted submission
+ 
+ ICRenderCommandBuffer is used by ICNodeVisitorDrawing if ICNodeVisitorDrawing::recordsCommands
+ is set to YES. Instead of drawing batchable nodes immediately, the visitor records a draw command
+ for each of them. Recorded commands are organized in segments. A segment ends whenever the visitor
+ encounters a node that must be drawn immediately, at which point the segment's commands are
+ submitted in the following order:
+ 
+ - Opaque commands (blend function ``GL_ONE, GL_ZERO``) recorded with depth testing enabled are
+   drawn first, sorted by their sort key, i.e. by shader program, projection and textures.
+   The depth buffer resolves their visibility, so their painter's order is irrelevant.
+ - All other commands are drawn in painter's order, except that a command is merged into an
+   earlier batch sharing its state if it does not overlap any batch drawn in between.
+ 
+ The commands of a frame are kept until the buffer is reset at the beginning of the next frame,
+ so the frame's recorded content may be replayed using ICRenderCommandBuffer::replayWithVisitor:,
+ e.g. for profiling submission in isolation. Content drawn immediately is not part of a replay.
+ Textures are referenced by name and are not retained by the buffer.
+ */
+@interface ICRenderCommandBuffer : NSObject {
+@protected
+    icRenderCommand *_commands;
+    uint _commandCount;
+    uint _commandCapacity;
+    
+    icV3F_C4F_T2F *_vertices;
+    uint _quadCount;
+    uint _quadCapacity;
+    
+    kmMat4 *_projections;
+    uint _projectionCount;
+    uint _projectionCapacity;
+    
+    NSMutableArray *_shaderPrograms;
+    
+    uint *_segmentEnds;
+    uint _segmentCount;
+    uint _segmentCapacity;
+    uint _submittedCommandCount;
+}
+
+
+#pragma mark - Recording Commands
+/** @name Recording Commands */
+
+/**
+ @brief Removes all commands from the receiver
+ */
+- (void)reset;
+
+/**
+ @brief Records a command drawing the given quads
+ 
+ The given vertices are transformed by the given model-view matrix before they are stored.
+ If the command's state equals that of the previously recorded command in the current segment,
+ the quads are appended to the previous command.
+ 
+ @param vertices A pointer to quads defining four vertices each in triangle strip order
+ @param quadCount The number of quads to record
+ @param modelView The model-view matrix used to transform the given vertices to world space
+ @param projection The projection matrix used to draw the quads
+ @param shaderProgram The shader program used to draw the quads
+ @param texture The name of the texture bound to texture unit 0, or 0 for no texture
+ @param maskTexture The name of the texture bound to texture unit 1, or 0 for no mask
+ @param blendFunc The blend function used to draw the quads
+ @param depthTested Whether depth testing is enabled for the quads
+ */
+- (void)addQuadVertices:(const icV3F_C4F_T2F *)vertices
+              quadCount:(uint)quadCount
+              modelView:(const kmMat4 *)modelView
+             projection:(const kmMat4 *)projection
+          shaderProgram:(ICShaderProgram *)shaderProgram
+                texture:(GLuint)texture
+            maskTexture:(GLuint)maskTexture
+              blendFunc:(icBlendFunc)blendFunc
+            depthTested:(BOOL)depthTested;
+
+
+#pragma mark - Submitting Commands
+/** @name Submitting Commands */
+
+/**
+ @brief Ends the current segment and submits its commands to the given visitor's sprite batch
+ 
+ Does nothing if no commands have been recorded since the last submission. The caller is
+ responsible for flushing the visitor's sprite batch afterwards.
+ */
+- (void)submitPendingCommandsWithVisitor:(ICNodeVisitorDrawing *)visitor;
+
+/**
+ @brief Submits all segments recorded since the last reset again and flushes the visitor's batch
+ */
+- (void)replayWithVisitor:(ICNodeVisitorDrawing *)visitor;
+
+
+#pragma mark - Inspecting Recorded Commands
+/** @name Inspecting Recorded Commands */
+
+/**
+ @brief The number of commands recorded since the last reset
+ */
+@property (nonatomic, readonly) uint commandCount;
+
+/**
+ @brief The number of quads recorded since the last reset
+ */
+@property (nonatomic, readonly) uint quadCount;
+
+/**
+ @brief The number of segments submitted since the last reset
+ */
+@property (nonatomic, readonly) uint segmentCount;
+
+/**
+ @brief Returns a pointer to the command at the given index
+ */
+- (const icRenderCommand *)commandAtIndex:(uint)index;
+
+/**
+ @brief Returns a pointer to the world space vertices of the given command
+ */
+- (const icV3F_C4F_T2F *)verticesForCommand:(const icRenderCommand *)command;
+
+@end
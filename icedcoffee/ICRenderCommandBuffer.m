@@ -0,0 +1,347 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import "ICRenderCommandBuffer.h"
+#import "ICNodeVisitorDrawing.h"
+#import "ICShaderProgram.h"
+
+// Number of batches a command may skip when it is merged into an earlier batch of the same state
+#define IC_RENDER_COMMAND_MERGE_LOOKBACK 16
+
+#define IC_RENDER_COMMAND_TRANSLUCENT_BIT (1ULL << 63)
+
+
+typedef struct _icRenderCommandOrder {
+    uint64_t key;
+    uint index;
+} icRenderCommandOrder;
+
+typedef struct _icRenderCommandBatch {
+    uint command;
+    kmVec2 boundsMin, boundsMax;
+} icRenderCommandBatch;
+
+static int icCompareRenderCommandOrder(const void *a, const void *b)
+{
+    const icRenderCommandOrder *oa = a, *ob = b;
+    if (oa->key != ob->key)
+        return oa->key < ob->key ? -1 : 1;
+    // Keep painter's order for commands of equal key
+    return oa->index < ob->index ? -1 : (oa->index > ob->index ? 1 : 0);
+}
+
+static BOOL icRenderCommandIsOpaque(const icRenderCommand *command)
+{
+    return command->blendFunc.src == GL_ONE && command->blendFunc.dst == GL_ZERO;
+}
+
+static BOOL icRenderCommandsShareState(const icRenderCommand *a, const icRenderCommand *b)
+{
+    return a->shaderProgram == b->shaderProgram &&
+           a->texture == b->texture &&
+           a->maskTexture == b->maskTexture &&
+           a->blendFunc.src == b->blendFunc.src &&
+           a->blendFunc.dst == b->blendFunc.dst &&
+           a->projectionIndex == b->projectionIndex &&
+           a->depthTested == b->depthTested;
+}
+
+static BOOL icRenderBoundsIntersect(const kmVec2 *minA, const kmVec2 *maxA,
+                                    const kmVec2 *minB, const kmVec2 *maxB)
+{
+    return minA->x < maxB->x && minB->x < maxA->x && minA->y < maxB->y && minB->y < maxA->y;
+}
+
+static void icRenderBoundsUnion(kmVec2 *min, kmVec2 *max, const kmVec2 *otherMin, const kmVec2 *otherMax)
+{
+    min->x = MIN(min->x, otherMin->x);
+    min->y = MIN(min->y, otherMin->y);
+    max->x = MAX(max->x, otherMax->x);
+    max->y = MAX(max->y, otherMax->y);
+}
+
+
+@interface ICRenderCommandBuffer (Private)
+- (uint)indexForShaderProgram:(ICShaderProgram *)shaderProgram;
+- (uint)indexForProjection:(const kmMat4 *)projection;
+- (void)submitCommandsFrom:(uint)first to:(uint)end withVisitor:(ICNodeVisitorDrawing *)visitor;
+- (void)submitCommand:(const icRenderCommand *)command withVisitor:(ICNodeVisitorDrawing *)visitor;
+@end
+
+
+@implementation ICRenderCommandBuffer
+
+@synthesize commandCount = _commandCount;
+@synthesize quadCount = _quadCount;
+@synthesize segmentCount = _segmentCount;
+
+- (id)init
+{
+    if ((self = [super init])) {
+        _shaderPrograms = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_commands);
+    free(_vertices);
+    free(_projections);
+    free(_segmentEnds);
+    [_shaderPrograms release];
+    
+    [super dealloc];
+}
+
+- (void)reset
+{
+    _commandCount = 0;
+    _quadCount = 0;
+    _projectionCount = 0;
+    _segmentCount = 0;
+    _submittedCommandCount = 0;
+    [_shaderPrograms removeAllObjects];
+}
+
+- (void)addQuadVertices:(const icV3F_C4F_T2F *)vertices
+              quadCount:(uint)quadCount
+              modelView:(const kmMat4 *)modelView
+             projection:(const kmMat4 *)projection
+          shaderProgram:(ICShaderProgram *)shaderProgram
+                texture:(GLuint)texture
+            maskTexture:(GLuint)maskTexture
+              blendFunc:(icBlendFunc)blendFunc
+            depthTested:(BOOL)depthTested
+{
+    if (!quadCount)
+        return;
+    
+    if (_quadCount + quadCount > _quadCapacity) {
+        _quadCapacity = MAX(MAX(_quadCapacity * 2, 256), _quadCount + quadCount);
+        _vertices = realloc(_vertices, sizeof(icV3F_C4F_T2F) * 4 * _quadCapacity);
+    }
+    
+    icRenderCommand command;
+    command.shaderProgram = shaderProgram;
+    command.texture = texture;
+    command.maskTexture = maskTexture;
+    command.blendFunc = blendFunc;
+    command.projectionIndex = [self indexForProjection:projection];
+    command.firstQuad = _quadCount;
+    command.quadCount = quadCount;
+    command.depthTested = depthTested;
+    
+    // Transform vertices to eye space and compute their projected bounds in normalized device
+    // coordinates, which determine whether translucent commands overlap on screen
+    icV3F_C4F_T2F *dst = &_vertices[_quadCount * 4];
+    BOOL inFront = YES;
+    kmVec2Fill(&command.boundsMin, FLT_MAX, FLT_MAX);
+    kmVec2Fill(&command.boundsMax, -FLT_MAX, -FLT_MAX);
+    for (uint i=0; i<quadCount * 4; i++) {
+        dst[i] = vertices[i];
+        kmVec3Transform(&dst[i].vect, &vertices[i].vect, modelView);
+        kmVec4 v, c;
+        kmVec4Fill(&v, dst[i].vect.x, dst[i].vect.y, dst[i].vect.z, 1);
+        kmVec4Transform(&c, &v, projection);
+        if (c.w <= kmEpsilon) {
+            inFront = NO;
+            continue;
+        }
+        command.boundsMin.x = MIN(command.boundsMin.x, c.x / c.w);
+        command.boundsMin.y = MIN(command.boundsMin.y, c.y / c.w);
+        command.boundsMax.x = MAX(command.boundsMax.x, c.x / c.w);
+        command.boundsMax.y = MAX(command.boundsMax.y, c.y / c.w);
+    }
+    if (!inFront) {
+        // Quads crossing the camera plane may cover any part of the screen
+        kmVec2Fill(&command.boundsMin, -FLT_MAX, -FLT_MAX);
+        kmVec2Fill(&command.boundsMax, FLT_MAX, FLT_MAX);
+    }
+    _quadCount += quadCount;
+    
+    // Extend the previous command of the current segment if it shares the new command's state
+    if (_commandCount > _submittedCommandCount) {
+        icRenderCommand *previous = &_commands[_commandCount - 1];
+        if (icRenderCommandsShareState(previous, &command)) {
+            previous->quadCount += quadCount;
+            icRenderBoundsUnion(&previous->boundsMin, &previous->boundsMax,
+                                &command.boundsMin, &command.boundsMax);
+            return;
+        }
+    }
+    
+    // Sort key: translucency, shader program, projection, texture and mask texture
+    command.sortKey = ((uint64_t)([self indexForShaderProgram:shaderProgram] & 0x7FFF) << 48) |
+                      ((uint64_t)(command.projectionIndex & 0xFFFF) << 32) |
+                      ((uint64_t)(texture & 0xFFFF) << 16) |
+                      (uint64_t)(maskTexture & 0xFFFF);
+    if (!icRenderCommandIsOpaque(&command) || !depthTested)
+        command.sortKey |= IC_RENDER_COMMAND_TRANSLUCENT_BIT;
+    
+    if (_commandCount == _commandCapacity) {
+        _commandCapacity = MAX(_commandCapacity * 2, 64);
+        _commands = realloc(_commands, sizeof(icRenderCommand) * _commandCapacity);
+    }
+    _commands[_commandCount++] = command;
+}
+
+- (void)submitPendingCommandsWithVisitor:(ICNodeVisitorDrawing *)visitor
+{
+    if (_submittedCommandCount == _commandCount)
+        return;
+    
+    if (_segmentCount == _segmentCapacity) {
+        _segmentCapacity = MAX(_segmentCapacity * 2, 8);
+        _segmentEnds = realloc(_segmentEnds, sizeof(uint) * _segmentCapacity);
+    }
+    _segmentEnds[_segmentCount++] = _commandCount;
+    
+    [self submitCommandsFrom:_submittedCommandCount to:_commandCount withVisitor:visitor];
+    _submittedCommandCount = _commandCount;
+}
+
+- (void)replayWithVisitor:(ICNodeVisitorDrawing *)visitor
+{
+    uint first = 0;
+    for (uint i=0; i<_segmentCount; i++) {
+        [self submitCommandsFrom:first to:_segmentEnds[i] withVisitor:visitor];
+        [visitor flushSpriteBatch];
+        first = _segmentEnds[i];
+    }
+}
+
+- (const icRenderCommand *)commandAtIndex:(uint)index
+{
+    NSAssert(index < _commandCount, @"Command index out of bounds");
+    return &_commands[index];
+}
+
+- (const icV3F_C4F_T2F *)verticesForCommand:(const icRenderCommand *)command
+{
+    return &_vertices[command->firstQuad * 4];
+}
+
+@end
+
+
+@implementation ICRenderCommandBuffer (Private)
+
+- (uint)indexForShaderProgram:(ICShaderProgram *)shaderProgram
+{
+    // Frames typically use a handful of shader programs, so a linear search is sufficient
+    NSUInteger index = [_shaderPrograms indexOfObjectIdenticalTo:shaderProgram];
+    if (index == NSNotFound) {
+        index = [_shaderPrograms count];
+        [_shaderPrograms addObject:shaderProgram];
+    }
+    return (uint)index;
+}
+
+- (uint)indexForProjection:(const kmMat4 *)projection
+{
+    // Projections rarely change within a frame, so we only compare against the last one
+    if (_projectionCount &&
+        !memcmp(_projections[_projectionCount - 1].mat, projection->mat, sizeof(projection->mat))) {
+        return _projectionCount - 1;
+    }
+    if (_projectionCount == _projectionCapacity) {
+        _projectionCapacity = MAX(_projectionCapacity * 2, 4);
+        _projections = realloc(_projections, sizeof(kmMat4) * _projectionCapacity);
+    }
+    _projections[_projectionCount] = *projection;
+    return _projectionCount++;
+}
+
+- (void)submitCommandsFrom:(uint)first to:(uint)end withVisitor:(ICNodeVisitorDrawing *)visitor
+{
+    uint count = end - first;
+    icRenderCommandOrder *order = malloc(sizeof(icRenderCommandOrder) * count);
+    icRenderCommandBatch *batches = malloc(sizeof(icRenderCommandBatch) * count);
+    uint batchCount = 0;
+    
+    for (uint i=first; i<end; i++) {
+        const icRenderCommand *command = &_commands[i];
+        icRenderCommandOrder *entry = &order[i - first];
+        entry->index = i;
+        
+        if (!(command->sortKey & IC_RENDER_COMMAND_TRANSLUCENT_BIT)) {
+            // Opaque depth tested commands are sorted by state and drawn first
+            entry->key = command->sortKey;
+            continue;
+        }
+        
+        // Merge the command into the latest batch sharing its state, unless it overlaps with a
+        // batch drawn in between
+        uint target = UINT_MAX;
+        uint lookbackEnd = batchCount > IC_RENDER_COMMAND_MERGE_LOOKBACK ?
+                           batchCount - IC_RENDER_COMMAND_MERGE_LOOKBACK : 0;
+        for (uint b=batchCount; b>lookbackEnd; b--) {
+            icRenderCommandBatch *batch = &batches[b - 1];
+            const icRenderCommand *batchCommand = &_commands[batch->command];
+            if (icRenderCommandsShareState(batchCommand, command)) {
+                target = b - 1;
+                break;
+            }
+            // Commands of different projections belong to different scenes, so never merge across them
+            if (batchCommand->projectionIndex != command->projectionIndex ||
+                icRenderBoundsIntersect(&batch->boundsMin, &batch->boundsMax,
+                                        &command->boundsMin, &command->boundsMax)) {
+                break;
+            }
+        }
+        
+        if (target == UINT_MAX) {
+            target = batchCount++;
+            batches[target].command = i;
+            batches[target].boundsMin = command->boundsMin;
+            batches[target].boundsMax = command->boundsMax;
+        } else {
+            icRenderBoundsUnion(&batches[target].boundsMin, &batches[target].boundsMax,
+                                &command->boundsMin, &command->boundsMax);
+        }
+        entry->key = IC_RENDER_COMMAND_TRANSLUCENT_BIT | target;
+    }
+    
+    qsort(order, count, sizeof(icRenderCommandOrder), icCompareRenderCommandOrder);
+    
+    for (uint i=0; i<count; i++) {
+        [self submitCommand:&_commands[order[i].index] withVisitor:visitor];
+    }
+    
+    free(batches);
+    free(order);
+}
+
+- (void)submitCommand:(const icRenderCommand *)command withVisitor:(ICNodeVisitorDrawing *)visitor
+{
+    [visitor batchWorldQuadVertices:&_vertices[command->firstQuad * 4]
+                          quadCount:command->quadCount
+                         projection:&_projections[command->projectionIndex]
+                      shaderProgram:command->shaderProgram
+                            texture:command->texture
+                        maskTexture:command->maskTexture
+                          blendFunc:command->blendFunc];
+}
+
+@end
@@ -165,6 +165,7 @@
 	GLuint      _fbo;
 	GLint		_oldFBO;
     GLint       _oldFBOViewport[4];
+    BOOL        _oldScissorTestEnabled;
     GLuint      _depthRBO;
     GLuint      _stencilRBO;
     GLint       _oldRBO;
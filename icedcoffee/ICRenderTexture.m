@@ -381,6 +381,11 @@ stencilBufferFormat:(ICStencilBufferFormat)stencilBufferFormat
 	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &_oldFBO);
 	glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
     
+    // The parent framebuffer may be scissored to its damaged region
+    _oldScissorTestEnabled = icGLIsEnabled(IC_GL_SCISSOR_TEST);
+    if (_oldScissorTestEnabled)
+        icGLDisable(IC_GL_SCISSOR_TEST);
+    
     IC_CHECK_GL_ERROR_DEBUG();
     
     _isInRenderTextureDrawContext = YES;
@@ -391,6 +396,9 @@ stencilBufferFormat:(ICStencilBufferFormat)stencilBufferFormat
     // Restore the old framebuffer
 	glBindFramebuffer(GL_FRAMEBUFFER, _oldFBO);
     IC_CHECK_GL_ERROR_DEBUG();
+    
+    if (_oldScissorTestEnabled)
+        icGLEnable(IC_GL_SCISSOR_TEST);
 
     [self popRenderTextureMatrices];
     
@@ -517,7 +525,10 @@ stencilBufferFormat:(ICStencilBufferFormat)stencilBufferFormat
 {
     // Note that this render texture needs to redraw its contents
     _needsDisplay = YES;
-    [super setNeedsDisplayForNode:node];
+    
+    // Nodes of the sub scene are drawn to a different framebuffer, so report the render
+    // texture itself as changed to the parent framebuffer
+    [super setNeedsDisplayForNode:self];
 }
 
 - (void)setParent:(ICNode *)parent
@@ -60,9 +60,9 @@
 - (void)dealloc
 {
     if (_scale9VertexBuffer)
-        glDeleteBuffers(1, &_scale9VertexBuffer);
+        icGLDeleteBuffer(_scale9VertexBuffer);
     if (_indexBuffer)
-        glDeleteBuffers(1, &_indexBuffer);
+        icGLDeleteBuffer(_indexBuffer);
     
     [super dealloc];
 }
@@ -201,20 +201,20 @@
     };
     
     if (_scale9VertexBuffer)
-        glDeleteBuffers(1, &_scale9VertexBuffer);
+        icGLDeleteBuffer(_scale9VertexBuffer);
     if (_indexBuffer)
-        glDeleteBuffers(1, &_indexBuffer);
+        icGLDeleteBuffer(_indexBuffer);
     
     glGenBuffers(1, &_scale9VertexBuffer);
     glGenBuffers(1, &_indexBuffer);
     
-    glBindBuffer(GL_ARRAY_BUFFER, _scale9VertexBuffer);
+    icGLBindBuffer(GL_ARRAY_BUFFER, _scale9VertexBuffer);
     glBufferData(GL_ARRAY_BUFFER, sizeof(icV3F_C4F_T2F) * NUM_VERTICES, vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
     
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+    // Element array bindings are vertex array object state
+    icGLBindVertexArray(0);
+    icGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * NUM_INDICES, indices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 - (void)setScale9Rect:(CGRect)scale9Rect
@@ -252,24 +252,21 @@
     [self applyStandardDrawSetupWithVisitor:visitor];
     
     if (![visitor isKindOfClass:[ICNodeVisitorPicking class]] && _texture)
-        glBindTexture(GL_TEXTURE_2D, [_texture name]);
+        icGLBindTexture2DN(0, [_texture name]);
     
     // FIXME: support for textured picking?
     if ([visitor isKindOfClass:[ICNodeVisitorPicking class]]) {
-        icGLDisable(GL_BLEND);
+        icGLDisable(IC_GL_BLEND);
     } else {
         icGLBlendFunc(_blendFunc.src, _blendFunc.dst);
         icGLEnable(IC_GL_BLEND);
     }    
     
-    // FIXME: needs to go into icGLState
-    glEnableVertexAttribArray(ICVertexAttribPosition);
-    glEnableVertexAttribArray(ICVertexAttribColor);
-    glEnableVertexAttribArray(ICVertexAttribTexCoords);
+    icGLEnableVertexAttribs(IC_VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
     IC_CHECK_GL_ERROR_DEBUG();
 
-    glBindBuffer(GL_ARRAY_BUFFER, _scale9VertexBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+    icGLBindBuffer(GL_ARRAY_BUFFER, _scale9VertexBuffer);
+    icGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
 
 #define kVertexSize sizeof(icV3F_C4F_T2F)    
 
@@ -287,16 +284,6 @@
     
 	glDrawElements(GL_TRIANGLES, NUM_INDICES, GL_UNSIGNED_SHORT, NULL);
     IC_CHECK_GL_ERROR_DEBUG();
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    
-    glBindTexture(GL_TEXTURE_2D, 0);
-    IC_CHECK_GL_ERROR_DEBUG();
-    
-    glDisableVertexAttribArray(ICVertexAttribPosition);
-    glDisableVertexAttribArray(ICVertexAttribColor);
-    glDisableVertexAttribArray(ICVertexAttribTexCoords);    
 }
 
 @end
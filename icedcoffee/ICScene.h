@@ -33,6 +33,17 @@
 @class ICCamera;
 @class ICHostViewController;
 @class ICRenderTexture;
+@class ICBoundingVolumeHierarchy;
+
+/**
+ @brief Block type used to enumerate nodes intersected by a ray in a scene's spatial index
+
+ @param node The intersected node
+ @param drawingOrder The position of the node in the scene's drawing order. Nodes with a higher
+ drawing order are drawn after nodes with a lower drawing order.
+ @param distance The ray parameter at which the ray enters the node's world bounding box
+ */
+typedef void (^ICSceneSpatialIndexBlock)(ICNode *node, uint drawingOrder, float distance);
 
 /**
  @brief Defines the root of a scene graph, manages a camera and visitors for drawing nodes
@@ -182,6 +193,17 @@
     
     kmMat4 _matOldProjection;
     GLint _oldViewport[4];
+    
+    ICBoundingVolumeHierarchy *_spatialIndex;
+    NSMutableArray *_spatialIndexNodes;
+    uint *_spatialIndexBoxNodes;
+    BOOL _spatialIndexDirty;
+    
+    BOOL _tracksDamage;
+    BOOL _redrawsDamageOnly;
+    CGRect _damageRect;
+    CGRect _pendingDamageRect;
+    NSMutableSet *_damagedNodes;
 }
 
 
@@ -341,6 +363,46 @@
 - (void)visit;
 
 
+#pragma mark - Tracking Damage
+/** @name Tracking Damage */
+
+/**
+ @brief Whether the receiver redraws only regions of its framebuffer that have changed
+ 
+ If set to YES and the receiver is a root scene, the receiver accumulates the regions covered
+ by nodes calling ICNode::setNeedsDisplay before and after their changes. The next frame then
+ clears and redraws only the accumulated region, preserving the rest of the framebuffer.
+ Branches outside of the region are not drawn.
+ 
+ Damaged regions are only redrawn partially if the host view controller can do so, see
+ ICHostViewController::canRedrawDamageOnly. Otherwise, and for nodes whose bounds are unknown
+ (see ICNode::drawsOutsideBounds), the whole scene is redrawn.
+ 
+ Defaults to the value of #IC_ENABLE_DAMAGE_TRACKING.
+ */
+@property (nonatomic, assign) BOOL tracksDamage;
+
+/**
+ @brief Whether the frame currently being drawn redraws ICScene::damageRect only
+ */
+@property (nonatomic, readonly) BOOL redrawsDamageOnly;
+
+/**
+ @brief The region redrawn by the frame currently being drawn, in normalized device coordinates
+ 
+ Only valid while ICScene::redrawsDamageOnly returns YES.
+ */
+@property (nonatomic, readonly) CGRect damageRect;
+
+/**
+ @brief Adds the given rect in normalized device coordinates to the region redrawn by the next
+ frame
+ 
+ Pass ``CGRectInfinite`` to redraw the whole scene.
+ */
+- (void)addDamageRect:(CGRect)rect;
+
+
 #pragma mark - Performing Hit Tests
 /** @name Performing Hit Tests */
 
@@ -408,6 +470,45 @@
 - (icRay3)worldRayFromFramebufferLocation:(CGPoint)location;
 
 
+#pragma mark - Managing the Scene's Spatial Index
+/** @name Managing the Scene's Spatial Index */
+
+/**
+ @brief Marks the receiver's spatial index dirty
+ 
+ The receiver maintains a bounding volume hierarchy of the world axis-aligned bounding boxes
+ (see ICNode::worldAABB) of its visible descendants, which is used by ICNodeVisitorRayPicking to
+ perform hit tests without drawing. This method is called by descendant nodes when their bounds
+ change (see ICNode::setNeedsSpatialIndexUpdate). The index is rebuilt lazily on the next query.
+ 
+ In contrast to ICNode, ICScene does not forward this message to its parent, as world
+ coordinates end at the scene level.
+ */
+- (void)setNeedsSpatialIndexUpdate;
+
+/**
+ @brief Rebuilds the receiver's spatial index if it has been marked dirty
+ */
+- (void)updateSpatialIndex;
+
+/**
+ @brief Enumerates all nodes in the receiver's spatial index whose world bounding box is
+ intersected by the given ray
+ 
+ Updates the spatial index if necessary, then calls the given block for each node whose world
+ bounding box intersects the given ray. The index contains all visible descendants reachable via
+ ICNode::pickingChildren, except for render texture sub scenes and their contents. Descendant
+ scenes drawn directly to the receiver's framebuffer are not indexed themselves, as their
+ contents are unprojected using their own cameras. These scenes are enumerated for every ray
+ with a distance of ``FLT_MAX``. Nodes are not enumerated in any particular order.
+ 
+ @param ray An icRay3 in world coordinates as returned by
+ ICScene::worldRayFromFramebufferLocation:.
+ @param block The block to call for each intersected node.
+ */
+- (void)enumerateNodesIntersectingWorldRay:(icRay3)ray usingBlock:(ICSceneSpatialIndexBlock)block;
+
+
 #pragma mark - Managing the Scene's Size
 /** @name Managing the Scene's Size */
 
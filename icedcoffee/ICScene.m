@@ -25,12 +25,15 @@
 #import "icDefaults.h"
 #import "ICHostViewController.h"
 #import "ICRenderTexture.h"
+#import "ICCamera.h"
 #import "kazmath/vec4.h"
 #import "icUtils.h"
 #import "icGL.h"
 #import "icMacros.h"
 #import "icConfig.h"
 #import "icGLState.h"
+#import "ICBoundingVolumeHierarchy.h"
+#import "ICProfiler.h"
 
 #ifdef __IC_PLATFORM_IOS
 #import "Platforms/iOS/ICGLView.h"
@@ -47,6 +50,9 @@
 
 @interface ICScene (Private)
 - (void)adjustToFramebufferSize;
+- (void)collectSpatialIndexNodesOfNode:(ICNode *)node boxes:(NSMutableData *)boxes;
+- (CGRect)normalizedDeviceRectOfNode:(ICNode *)node;
+- (void)updateDamageRect;
 @end
 
 
@@ -63,6 +69,9 @@
 @synthesize clearsStencilBuffer = _clearsStencilBuffer;
 @synthesize performsDepthTesting = _performsDepthTesting;
 @synthesize performsFaceCulling = _performsFaceCulling;
+@synthesize tracksDamage = _tracksDamage;
+@synthesize redrawsDamageOnly = _redrawsDamageOnly;
+@synthesize damageRect = _damageRect;
 
 + (id)scene
 {
@@ -99,6 +108,11 @@
         _clearsStencilBuffer = YES;
         _performsDepthTesting = NO;
         _performsFaceCulling = YES;
+        _spatialIndexDirty = YES;
+        _tracksDamage = IC_ENABLE_DAMAGE_TRACKING;
+        _damageRect = CGRectNull;
+        _pendingDamageRect = CGRectInfinite;
+        _damagedNodes = [[NSMutableSet alloc] init];
     }
     return self;
 }
@@ -109,6 +123,16 @@
     self.drawingVisitor = nil;
     self.pickingVisitor = nil;
     
+    [_damagedNodes release];
+    _damagedNodes = nil;
+    
+    [_spatialIndex release];
+    _spatialIndex = nil;
+    [_spatialIndexNodes release];
+    _spatialIndexNodes = nil;
+    free(_spatialIndexBoxNodes);
+    _spatialIndexBoxNodes = NULL;
+    
     [super dealloc];
 }
 
@@ -129,9 +153,31 @@
 
 - (void)setUpSceneForDrawingWithVisitor:(ICNodeVisitorDrawing *)visitor
 {
-    icGLPurgeStateCache();
+    // GL state may have been changed outside of icedcoffee between frames. Nested scenes are
+    // drawn by icedcoffee, so their state is known.
+    if (!_parent)
+        icGLPurgeStateCache();
     IC_CHECK_GL_ERROR_DEBUG();
     
+    // Restrict clearing and drawing to the damaged region if possible
+    if (!_parent && _tracksDamage) {
+        [self updateDamageRect];
+        if (_redrawsDamageOnly) {
+            GLint x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+            if (!CGRectIsNull(_damageRect)) {
+                CGSize size = [self framebufferSize];
+                float width = ICPointsToPixels(size.width), height = ICPointsToPixels(size.height);
+                // Include an extra pixel to account for antialiased edges
+                x0 = MAX(0, floorf((CGRectGetMinX(_damageRect) * 0.5f + 0.5f) * width) - 1);
+                y0 = MAX(0, floorf((CGRectGetMinY(_damageRect) * 0.5f + 0.5f) * height) - 1);
+                x1 = MIN(width, ceilf((CGRectGetMaxX(_damageRect) * 0.5f + 0.5f) * width) + 1);
+                y1 = MIN(height, ceilf((CGRectGetMaxY(_damageRect) * 0.5f + 0.5f) * height) + 1);
+            }
+            icGLEnable(IC_GL_SCISSOR_TEST);
+            icGLScissor(x0, y0, x1 - x0, y1 - y0);
+        }
+    }
+    
     // Clear buffers as configured
     if (_clearsColorBuffer)
         glClearColor((float)_clearColor.r/255.0f,
@@ -153,7 +199,7 @@
     
     // Enable face culling by default
     if (_performsFaceCulling)
-        glEnable(GL_CULL_FACE);
+        icGLEnable(IC_GL_CULL_FACE);
     
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -161,13 +207,13 @@
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
     // Set up alpha blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    icGLEnable(IC_GL_BLEND);
+    icGLBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     
     if (_performsDepthTesting) {
         // Enable depth testing
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        icGLEnable(IC_GL_DEPTH_TEST);
+        icGLDepthFunc(GL_LEQUAL);
     }
 
     IC_CHECK_GL_ERROR_DEBUG();
@@ -188,7 +234,22 @@
     kmGLLoadMatrix(&_matOldProjection);
     kmGLMatrixMode(KM_GL_MODELVIEW);
     
-    glDisable(GL_DEPTH_TEST);
+    icGLDisable(IC_GL_DEPTH_TEST);
+    
+    if (_redrawsDamageOnly) {
+        // Reset the scissor box to the whole framebuffer, so that GL code relying on the default
+        // scissor box is not restricted to the damaged region
+        CGSize size = [self framebufferSize];
+        icGLDisable(IC_GL_SCISSOR_TEST);
+        icGLScissor(0, 0, ICPointsToPixels(size.width), ICPointsToPixels(size.height));
+        _redrawsDamageOnly = NO;
+    }
+    
+#if IC_ENABLE_VERTEX_ARRAY_OBJECTS
+    // Do not leave vertex array objects bound for GL code running outside of icedcoffee
+    if (!_parent)
+        icGLBindVertexArray(0);
+#endif
 }
 
 - (void)setUpSceneForPickingWithVisitor:(ICNodeVisitorPicking *)visitor
@@ -196,6 +257,9 @@
     CGPoint point;
     GLint *viewport;
     
+    if (!_parent)
+        icGLPurgeStateCache();
+    
     if (_renderTexture) {
         
         // This is a render texture scene, so we need to transform the current pick point
@@ -247,7 +311,7 @@
     point.y = [self framebufferSize].height - point.y;
     
     // Disable alpha blending
-    glDisable(GL_BLEND);
+    icGLDisable(IC_GL_BLEND);
     
     kmGLGetMatrix(KM_GL_PROJECTION, &_matOldProjection);
     
@@ -259,8 +323,8 @@
 
     // FIXME: code duplication
     if (_performsDepthTesting) {
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        icGLEnable(IC_GL_DEPTH_TEST);
+        icGLDepthFunc(GL_LEQUAL);
     }
     
     if (_renderTexture) {
@@ -344,10 +408,12 @@
         return [NSArray array];
     }
     
+    IC_PROFILE_ZONE_BEGIN(pickingZone, ICProfilerCategoryPicking);
     NSArray *hitNodes = [self.pickingVisitor performPickingTestWithNode:self
                                                                   point:point
                                                                viewport:viewport
                                                        deferredReadback:deferredReadback];
+    IC_PROFILE_ZONE_END(pickingZone, ICProfilerCategoryPicking, "Hit test");
     
 #if IC_ENABLE_DEBUG_HITTEST && defined(DEBUG) && defined(ICEDCOFFEE_DEBUG)
     if (!deferredReadback) {
@@ -368,7 +434,10 @@
 
 - (NSArray *)performHitTestReadback
 {
-    return [self.pickingVisitor readHitNodesAsync];
+    IC_PROFILE_ZONE_BEGIN(pickingZone, ICProfilerCategoryPicking);
+    NSArray *hitNodes = [self.pickingVisitor readHitNodesAsync];
+    IC_PROFILE_ZONE_END(pickingZone, ICProfilerCategoryPicking, "Hit test readback");
+    return hitNodes;
 }
 
 - (icRay3)worldRayFromFramebufferLocation:(CGPoint)location
@@ -395,6 +464,105 @@
     return worldRay;
 }
 
+- (void)setNeedsSpatialIndexUpdate
+{
+    _spatialIndexDirty = YES;
+    // The receiver's own bounds may have changed
+    [_parent setNeedsSubtreeAABBUpdate];
+}
+
+- (kmAABB)subtreeAABB
+{
+    // Contents of a scene are confined to its frame
+    return [self localAABB];
+}
+
+- (BOOL)subtreeDrawsOutsideBounds
+{
+    return _drawsOutsideBounds;
+}
+
+- (void)collectSpatialIndexNodesOfNode:(ICNode *)node boxes:(NSMutableData *)boxes
+{
+    for (ICNode *child in [node pickingChildren]) {
+        if (!child.isVisible)
+            continue;
+        
+        if ([child isKindOfClass:[ICScene class]]) {
+            // Render texture sub scenes are hit tested via their render texture, other
+            // descendant scenes are enumerated for every ray
+            if (!((ICScene *)child).renderTexture) {
+                [_spatialIndexNodes addObject:child];
+            }
+            continue;
+        }
+        
+        // Note that computing the world AABB also recomputes the node's world transform if it
+        // is dirty, which is required for ICNode::setTransformDirty to notify us again
+        kmAABB worldAABB = [child worldAABB];
+        [boxes appendBytes:&worldAABB length:sizeof(kmAABB)];
+        [_spatialIndexNodes addObject:child];
+        
+        [self collectSpatialIndexNodesOfNode:child boxes:boxes];
+    }
+}
+
+- (void)updateSpatialIndex
+{
+    if (!_spatialIndexDirty)
+        return;
+    
+    if (!_spatialIndexNodes)
+        _spatialIndexNodes = [[NSMutableArray alloc] init];
+    [_spatialIndexNodes removeAllObjects];
+    
+    // Clean the receiver's own world transform flag, so that subsequent transform changes
+    // are propagated to descendants (see ICNode::invalidateWorldTransform)
+    [self nodeToWorldTransformPtr];
+    
+    NSMutableData *boxes = [NSMutableData data];
+    [self collectSpatialIndexNodesOfNode:self boxes:boxes];
+    
+    // Map box indices to drawing order, skipping descendant scenes
+    uint boxCount = (uint)([boxes length] / sizeof(kmAABB));
+    free(_spatialIndexBoxNodes);
+    _spatialIndexBoxNodes = boxCount ? malloc(sizeof(uint) * boxCount) : NULL;
+    uint i = 0, boxIndex = 0;
+    for (ICNode *node in _spatialIndexNodes) {
+        if (![node isKindOfClass:[ICScene class]]) {
+            _spatialIndexBoxNodes[boxIndex++] = i;
+        }
+        i++;
+    }
+    
+    [_spatialIndex release];
+    _spatialIndex = [[ICBoundingVolumeHierarchy alloc] initWithBoxes:(const kmAABB *)[boxes bytes]
+                                                               count:boxCount];
+    _spatialIndexDirty = NO;
+}
+
+- (void)enumerateNodesIntersectingWorldRay:(icRay3)ray usingBlock:(ICSceneSpatialIndexBlock)block
+{
+    [self updateSpatialIndex];
+    
+    NSArray *nodes = _spatialIndexNodes;
+    const uint *boxNodes = _spatialIndexBoxNodes;
+    [_spatialIndex enumerateBoxesIntersectingRay:ray usingBlock:^(uint index, float distance) {
+        uint drawingOrder = boxNodes[index];
+        block([nodes objectAtIndex:drawingOrder], drawingOrder, distance);
+    }];
+    
+    if ([_spatialIndex count] < [_spatialIndexNodes count]) {
+        uint drawingOrder = 0;
+        for (ICNode *node in _spatialIndexNodes) {
+            if ([node isKindOfClass:[ICScene class]]) {
+                block(node, drawingOrder, FLT_MAX);
+            }
+            drawingOrder++;
+        }
+    }
+}
+
 - (ICHostViewController *)hostViewController
 {
     if (!_hostViewController)
@@ -487,10 +655,80 @@
     }
 }
 
+- (void)addDamageRect:(CGRect)rect
+{
+    if (CGRectIsInfinite(rect) || CGRectIsInfinite(_pendingDamageRect))
+        _pendingDamageRect = CGRectInfinite;
+    else
+        _pendingDamageRect = CGRectUnion(_pendingDamageRect, rect);
+}
+
+// Projects the node's branch with the receiver's camera, as done by ICNodeVisitorDrawing
+- (CGRect)normalizedDeviceRectOfNode:(ICNode *)node
+{
+    if ([node subtreeDrawsOutsideBounds])
+        return CGRectInfinite;
+    
+    kmAABB bounds = [node subtreeAABB];
+    if (bounds.min.x == bounds.max.x && bounds.min.y == bounds.max.y)
+        return CGRectNull;
+    
+    if (_camera.dirty) {
+        [_camera setUpScreen];
+        _camera.dirty = NO;
+    }
+    
+    // The camera replaces the receiver's own transform when drawing its children
+    kmMat4 mvp, matProjection = _camera.matProjection, matLookAt = _camera.matLookAt;
+    kmMat4 worldToScene = [self worldToNodeTransform];
+    kmMat4Multiply(&mvp, &matProjection, &matLookAt);
+    kmMat4Multiply(&mvp, &mvp, &worldToScene);
+    kmMat4Multiply(&mvp, &mvp, [node nodeToWorldTransformPtr]);
+    
+    uint outcode;
+    kmVec2 min, max;
+    BOOL inFront = icProjectAABB(&mvp, &bounds, &outcode, &min, &max);
+    if (outcode)
+        return CGRectNull;
+    if (!inFront)
+        return CGRectInfinite;
+    return CGRectMake(min.x, min.y, max.x - min.x, max.y - min.y);
+}
+
+- (void)updateDamageRect
+{
+    // Add the regions covered by damaged nodes after their changes. Nodes removed from the
+    // receiver only damage the region they covered before.
+    for (ICNode *node in _damagedNodes) {
+        ICScene *scene = [node parentScene];
+        if (scene == self) {
+            [self addDamageRect:[self normalizedDeviceRectOfNode:node]];
+        } else if (scene) {
+            // Nodes of nested scenes are drawn with different cameras
+            [self addDamageRect:CGRectInfinite];
+        }
+    }
+    [_damagedNodes removeAllObjects];
+    
+    _redrawsDamageOnly = !CGRectIsInfinite(_pendingDamageRect) &&
+                         [self.hostViewController canRedrawDamageOnly];
+    if (_redrawsDamageOnly)
+        _damageRect = CGRectIntersection(_pendingDamageRect, CGRectMake(-1, -1, 2, 2));
+    _pendingDamageRect = CGRectNull;
+}
+
 - (void)setNeedsDisplayForNode:(ICNode *)node
 {
     if (!_parent) {
-        [self.hostViewController setNeedsDisplay];
+        if (!_tracksDamage || node == self) {
+            [self.hostViewController setNeedsDisplay];
+        } else {
+            // Damage the region the node covered when it was last drawn. The region covered
+            // after its changes is added when the next frame is drawn.
+            [self addDamageRect:node.drawnRect];
+            [_damagedNodes addObject:node];
+            [self.hostViewController setNeedsDisplayOfDamage];
+        }
     } else {
         [super setNeedsDisplayForNode:node];
     }
@@ -27,12 +27,17 @@
 @class ICNode;
 @class ICAnimation;
 
+struct _icScheduledTarget;
+struct _icScheduledAnimation;
+
 typedef enum _ICSchedulerPriority {
     kICSchedulerPriority_Default,
     kICSchedulerPriority_High,
     kICSchedulerPriority_Low,
 } ICSchedulerPriority;
 
+#define IC_NUM_SCHEDULER_PRIORITIES 3
+
 /**
  @brief A scheduler used for continuously updating animated objects in a scene
  
@@ -47,10 +52,26 @@ typedef enum _ICSchedulerPriority {
  */
 @interface ICScheduler : NSObject {
 @protected
-    NSMutableArray *_targets;
-    NSMutableArray *_targetsWithLowPriority;
-    NSMutableArray *_targetsWithHighPriority;
-    NSMutableDictionary *_animations;
+    // Targets are stored in a slab of entries linked into one list per priority. Entry indices
+    // are stable handles, so unscheduling a target is a constant time operation.
+    struct _icScheduledTarget *_targets;
+    NSUInteger _targetCapacity;
+    NSUInteger _targetSlabSize;
+    NSUInteger _freeTarget;
+    NSUInteger _targetListHeads[IC_NUM_SCHEDULER_PRIORITIES];
+    NSUInteger _targetListTails[IC_NUM_SCHEDULER_PRIORITIES];
+    CFMutableDictionaryRef _targetIndices;
+    NSUInteger _numberOfRemovedTargets;
+    BOOL _isUpdatingTargets;
+    
+    // Animations are stored densely in a contiguous array, each node's animations being
+    // linked in a circular list whose head is looked up in _animationLists.
+    struct _icScheduledAnimation *_animations;
+    NSUInteger _animationCapacity;
+    NSUInteger _animationCount;
+    CFMutableDictionaryRef _animationLists;
+    NSUInteger _numberOfRemovedAnimations;
+    BOOL _isProcessingAnimations;
 }
 
 
@@ -102,6 +123,8 @@ typedef enum _ICSchedulerPriority {
  ICHostViewController object that draws the scene is set to synchronized frame update mode. See
  ICHostViewController::frameUpdateMode.
  
+ If the target has already been scheduled, its priority is changed to the given priority.
+ 
  @exception Raises an NSInvalidArgumentException if target is nil or if priority is not a valid
  ICSchedulerPriority enumerated value.
  
@@ -114,6 +137,10 @@ typedef enum _ICSchedulerPriority {
  
  @param target An object that was previously scheduled for updates. The object will be released
  by this method.
+ 
+ Unscheduling a target takes constant time. If called while the receiver is updating its
+ targets, the target will not receive any further update messages, but will be released after
+ all other targets have been updated.
  */
 - (void)unscheduleUpdateForTarget:(id<ICUpdatable>)target;
 
@@ -132,6 +159,9 @@ typedef enum _ICSchedulerPriority {
 
 /**
  @brief Returns all animations for the given node
+ 
+ Returns an autoreleased array containing the node's animations in the order they have been
+ added, or an empty array if the node has no animations.
  */
 - (NSArray *)animationsForNode:(ICNode *)node;
 
@@ -142,6 +172,10 @@ typedef enum _ICSchedulerPriority {
 
 /**
  @brief Removes the given animation for the specified node from the receiver
+ 
+ The animation's delegate receives an ICAnimationDelegate::animationDidStop:finished: message.
+ If called while the receiver is processing animations, the animation is released after
+ all other animations have been processed.
  */
 - (void)removeAnimation:(ICAnimation *)animation forNode:(ICNode *)node;
 
@@ -25,9 +25,50 @@
 #import "ICHostViewController.h"
 #import "ICAnimation.h"
 #import "ICNode.h"
+#import "ICProfiler.h"
+
+typedef void (*icUpdateIMP)(id, SEL, icTime);
+typedef void (*icProcessAnimationIMP)(id, SEL, ICNode *, icTime);
+
+typedef struct _icScheduledTarget {
+    id<ICUpdatable> target;     // retained, nil for free entries
+    icUpdateIMP update;
+    ICSchedulerPriority priority;
+    NSUInteger prev;            // NSNotFound terminated
+    NSUInteger next;            // NSNotFound terminated, links free entries if target is nil
+    BOOL removed;
+} icScheduledTarget;
+
+typedef struct _icScheduledAnimation {
+    ICNode *node;               // not retained
+    ICAnimation *animation;     // retained
+    icProcessAnimationIMP process;
+    NSUInteger prevForNode;     // circular
+    NSUInteger nextForNode;     // circular
+    BOOL removed;
+} icScheduledAnimation;
+
+#define IC_SCHEDULER_MIN_CAPACITY 64
+
+// Order in which targets are updated
+static const ICSchedulerPriority icSchedulerUpdateOrder[IC_NUM_SCHEDULER_PRIORITIES] = {
+    kICSchedulerPriority_High,
+    kICSchedulerPriority_Default,
+    kICSchedulerPriority_Low
+};
+
 
 @interface ICScheduler (Private)
 - (void)processAnimations:(icTime)dt;
+- (NSUInteger)allocateTarget;
+- (void)linkTargetAtIndex:(NSUInteger)index;
+- (void)unlinkTargetAtIndex:(NSUInteger)index;
+- (void)freeTargetAtIndex:(NSUInteger)index;
+- (void)purgeRemovedTargets;
+- (NSUInteger)indexOfAnimation:(ICAnimation *)animation forNode:(ICNode *)node;
+- (void)unlinkAnimationAtIndex:(NSUInteger)index;
+- (void)moveAnimationFromIndex:(NSUInteger)fromIndex toIndex:(NSUInteger)toIndex;
+- (void)purgeRemovedAnimations;
 @end
 
 @implementation ICScheduler
@@ -40,20 +81,30 @@
 - (id)init
 {
     if ((self = [super init])) {
-        _targets = [[NSMutableArray alloc] init];
-        _targetsWithHighPriority = [[NSMutableArray alloc] init];
-        _targetsWithLowPriority = [[NSMutableArray alloc] init];
-        _animations = [[NSMutableDictionary alloc] init];
+        _freeTarget = NSNotFound;
+        for (NSUInteger i=0; i<IC_NUM_SCHEDULER_PRIORITIES; i++) {
+            _targetListHeads[i] = NSNotFound;
+            _targetListTails[i] = NSNotFound;
+        }
+        // Keys are compared by pointer and neither keys nor values are retained
+        _targetIndices = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+        _animationLists = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
     }
     return self;
 }
 
 - (void)dealloc
 {
-    [_targets release];
-    [_targetsWithLowPriority release];
-    [_targetsWithHighPriority release];
-    [_animations release];
+    for (NSUInteger i=0; i<_targetSlabSize; i++) {
+        [_targets[i].target release];
+    }
+    for (NSUInteger i=0; i<_animationCount; i++) {
+        [_animations[i].animation release];
+    }
+    free(_targets);
+    free(_animations);
+    CFRelease(_targetIndices);
+    CFRelease(_animationLists);
     
     [super dealloc];
 }
@@ -69,60 +120,99 @@
         [NSException raise:NSInvalidArgumentException format:@"Target must not be nil"];
         return;
     }
+    if ((NSUInteger)priority >= IC_NUM_SCHEDULER_PRIORITIES) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"Invalid priority value"];
+        return;
+    }
     
-    switch (priority) {
-        case kICSchedulerPriority_Default:
-            [_targets addObject:target];
-            break;
-        case kICSchedulerPriority_Low:
-            [_targetsWithLowPriority addObject:target];
-            break;
-        case kICSchedulerPriority_High:
-            [_targetsWithHighPriority addObject:target];
-            break;
-            
-        default:
-            [NSException raise:NSInvalidArgumentException
-                        format:@"Invalid priority value"];
-            break;
+    const void *value;
+    if (CFDictionaryGetValueIfPresent(_targetIndices, target, &value)) {
+        NSUInteger index = (NSUInteger)value;
+        if (_targets[index].priority == priority)
+            return;
+        if (!_isUpdatingTargets) {
+            [self unlinkTargetAtIndex:index];
+            _targets[index].priority = priority;
+            [self linkTargetAtIndex:index];
+            return;
+        }
+        // Lists must not be relinked while being updated, so retire the existing entry instead
+        _targets[index].removed = YES;
+        _numberOfRemovedTargets++;
+        [target retain];
+        CFDictionaryRemoveValue(_targetIndices, target);
+    } else {
+        [target retain];
     }
+    
+    NSUInteger index = [self allocateTarget];
+    icScheduledTarget *entry = &_targets[index];
+    entry->target = target;
+    entry->update = (icUpdateIMP)[target methodForSelector:@selector(update:)];
+    entry->priority = priority;
+    entry->removed = NO;
+    [self linkTargetAtIndex:index];
+    CFDictionarySetValue(_targetIndices, target, (const void *)index);
 }
 
 - (void)unscheduleUpdateForTarget:(id<ICUpdatable>)target
 {
-    if ([_targets containsObject:target])
-        [_targets removeObject:target];
-    if ([_targetsWithLowPriority containsObject:target])
-        [_targetsWithLowPriority removeObject:target];
-    if ([_targetsWithHighPriority containsObject:target])
-        [_targetsWithHighPriority removeObject:target];
+    const void *value;
+    if (!target || !CFDictionaryGetValueIfPresent(_targetIndices, target, &value))
+        return;
+    
+    NSUInteger index = (NSUInteger)value;
+    CFDictionaryRemoveValue(_targetIndices, target);
+    if (_isUpdatingTargets) {
+        // Unlinked and released once all targets have been updated
+        _targets[index].removed = YES;
+        _numberOfRemovedTargets++;
+    } else {
+        [self unlinkTargetAtIndex:index];
+        [self freeTargetAtIndex:index];
+    }
 }
 
 - (void)update:(icTime)dt
 {
+    IC_PROFILE_ZONE_BEGIN(animationZone, ICProfilerCategoryAnimations);
     [self processAnimations:dt];
+    IC_PROFILE_ZONE_END(animationZone, ICProfilerCategoryAnimations, "Process animations");
     
-    for (id<ICUpdatable> target in _targetsWithHighPriority) {
-        [target update:dt];
-    }
-    
-    for (id<ICUpdatable> target in _targets) {
-        [target update:dt];
-    }
-
-    for (id<ICUpdatable> target in _targetsWithLowPriority) {
-        [target update:dt];
+    IC_PROFILE_ZONE_BEGIN(updateZone, ICProfilerCategorySchedulerUpdate);
+    _isUpdatingTargets = YES;
+    for (NSUInteger p=0; p<IC_NUM_SCHEDULER_PRIORITIES; p++) {
+        // Targets scheduled while updating are appended to the lists and may reallocate the
+        // slab, so entries are accessed by index after each update message
+        NSUInteger index = _targetListHeads[icSchedulerUpdateOrder[p]];
+        while (index != NSNotFound) {
+            if (!_targets[index].removed) {
+                icScheduledTarget entry = _targets[index];
+                entry.update(entry.target, @selector(update:), dt);
+            }
+            index = _targets[index].next;
+        }
     }
+    _isUpdatingTargets = NO;
+    if (_numberOfRemovedTargets)
+        [self purgeRemovedTargets];
+    IC_PROFILE_ZONE_END(updateZone, ICProfilerCategorySchedulerUpdate, "Update targets");
 }
 
-// FIXME: this creates a new dictionary even if not required
 - (NSArray *)animationsForNode:(ICNode *)node
 {
-    NSMutableArray *animations = [_animations objectForKey:[NSValue valueWithPointer:node]];
-    if (!animations) {
-        animations = [NSMutableArray arrayWithCapacity:1];
-        [_animations setObject:animations forKey:[NSValue valueWithPointer:node]];
-    }
+    const void *value;
+    if (!CFDictionaryGetValueIfPresent(_animationLists, node, &value))
+        return [NSArray array];
+    
+    NSUInteger head = (NSUInteger)value;
+    NSMutableArray *animations = [NSMutableArray arrayWithCapacity:1];
+    NSUInteger index = head;
+    do {
+        [animations addObject:_animations[index].animation];
+        index = _animations[index].nextForNode;
+    } while (index != head);
     return animations;
 }
 
@@ -131,8 +221,33 @@
     NSAssert(node != nil, @"target must not be nil");
     NSAssert(animation != nil, @"animation must not be nil");
     
-    NSMutableArray *animations = (NSMutableArray *)[self animationsForNode:node];
-    [animations addObject:animation];
+    if (_animationCount == _animationCapacity) {
+        _animationCapacity = MAX(_animationCapacity * 2, IC_SCHEDULER_MIN_CAPACITY);
+        _animations = realloc(_animations, _animationCapacity * sizeof(icScheduledAnimation));
+    }
+    
+    NSUInteger index = _animationCount++;
+    icScheduledAnimation *record = &_animations[index];
+    record->node = node;
+    record->animation = [animation retain];
+    record->process = (icProcessAnimationIMP)
+        [animation methodForSelector:@selector(processAnimationWithTarget:deltaTime:)];
+    record->removed = NO;
+    
+    // Append to the node's circular list
+    const void *value;
+    if (CFDictionaryGetValueIfPresent(_animationLists, node, &value)) {
+        NSUInteger head = (NSUInteger)value;
+        NSUInteger tail = _animations[head].prevForNode;
+        record->prevForNode = tail;
+        record->nextForNode = head;
+        _animations[tail].nextForNode = index;
+        _animations[head].prevForNode = index;
+    } else {
+        record->prevForNode = index;
+        record->nextForNode = index;
+        CFDictionarySetValue(_animationLists, node, (const void *)index);
+    }
 }
 
 - (void)removeAnimation:(ICAnimation *)animation forNode:(ICNode *)node
@@ -140,30 +255,181 @@
     NSAssert(node != nil, @"target must not be nil");
     NSAssert(animation != nil, @"animation must not be nil");
     
-    NSMutableArray *animations = (NSMutableArray *)[self animationsForNode:node];
-    [animations removeObject:animation];
+    NSUInteger index = [self indexOfAnimation:animation forNode:node];
+    if (index != NSNotFound) {
+        // Keep the animation alive while its delegate is notified
+        [animation retain];
+        [self unlinkAnimationAtIndex:index];
+        _animations[index].removed = YES;
+        if (_isProcessingAnimations) {
+            _numberOfRemovedAnimations++;
+        } else {
+            [_animations[index].animation release];
+            [self moveAnimationFromIndex:--_animationCount toIndex:index];
+        }
+        [animation autorelease];
+    }
+    
     if ([animation.delegate respondsToSelector:@selector(animationDidStop:finished:)]) {
         [animation.delegate animationDidStop:animation finished:NO];
     }
 }
 
+@end
+
+
+@implementation ICScheduler (Private)
+
 - (void)processAnimations:(icTime)dt
 {
-    NSDictionary *animations = [_animations copy];
+    // Animations added while processing are appended to the array and processed
+    // in the next frame
+    NSUInteger count = _animationCount;
+    _isProcessingAnimations = YES;
+    for (NSUInteger i=0; i<count; i++) {
+        if (_animations[i].removed)
+            continue;
+        icScheduledAnimation record = _animations[i];
+        record.process(record.animation, @selector(processAnimationWithTarget:deltaTime:),
+                       record.node, dt);
+        if (record.animation.isFinished && !_animations[i].removed)
+            [record.node removeAnimation:record.animation];
+    }
+    _isProcessingAnimations = NO;
     
-    for (NSValue *nodeValue in animations) {
-        NSArray *nodeAnimations = [[animations objectForKey:nodeValue] copy];
-        for (NSInteger i=[nodeAnimations count] - 1; i>=0; i--) {
-            ICNode *node = (ICNode *)[nodeValue pointerValue];
-            ICAnimation *animation = [nodeAnimations objectAtIndex:i];
-            [animation processAnimationWithTarget:node deltaTime:dt];
-            if (animation.isFinished)
-                [node removeAnimation:animation];
+    if (_numberOfRemovedAnimations)
+        [self purgeRemovedAnimations];
+}
+
+- (NSUInteger)allocateTarget
+{
+    NSUInteger index = _freeTarget;
+    if (index != NSNotFound) {
+        _freeTarget = _targets[index].next;
+        return index;
+    }
+    if (_targetSlabSize == _targetCapacity) {
+        _targetCapacity = MAX(_targetCapacity * 2, IC_SCHEDULER_MIN_CAPACITY);
+        _targets = realloc(_targets, _targetCapacity * sizeof(icScheduledTarget));
+    }
+    return _targetSlabSize++;
+}
+
+- (void)linkTargetAtIndex:(NSUInteger)index
+{
+    ICSchedulerPriority priority = _targets[index].priority;
+    NSUInteger tail = _targetListTails[priority];
+    _targets[index].prev = tail;
+    _targets[index].next = NSNotFound;
+    if (tail != NSNotFound)
+        _targets[tail].next = index;
+    else
+        _targetListHeads[priority] = index;
+    _targetListTails[priority] = index;
+}
+
+- (void)unlinkTargetAtIndex:(NSUInteger)index
+{
+    icScheduledTarget *entry = &_targets[index];
+    if (entry->prev != NSNotFound)
+        _targets[entry->prev].next = entry->next;
+    else
+        _targetListHeads[entry->priority] = entry->next;
+    if (entry->next != NSNotFound)
+        _targets[entry->next].prev = entry->prev;
+    else
+        _targetListTails[entry->priority] = entry->prev;
+}
+
+- (void)freeTargetAtIndex:(NSUInteger)index
+{
+    id<ICUpdatable> target = _targets[index].target;
+    _targets[index].target = nil;
+    _targets[index].next = _freeTarget;
+    _freeTarget = index;
+    [target release];
+}
+
+- (void)purgeRemovedTargets
+{
+    for (NSUInteger p=0; p<IC_NUM_SCHEDULER_PRIORITIES; p++) {
+        NSUInteger index = _targetListHeads[p];
+        while (index != NSNotFound) {
+            NSUInteger next = _targets[index].next;
+            if (_targets[index].removed) {
+                [self unlinkTargetAtIndex:index];
+                [self freeTargetAtIndex:index];
+            }
+            index = next;
         }
-        [nodeAnimations release];
     }
+    _numberOfRemovedTargets = 0;
+}
+
+- (NSUInteger)indexOfAnimation:(ICAnimation *)animation forNode:(ICNode *)node
+{
+    const void *value;
+    if (!CFDictionaryGetValueIfPresent(_animationLists, node, &value))
+        return NSNotFound;
+    
+    NSUInteger head = (NSUInteger)value;
+    NSUInteger index = head;
+    do {
+        if (_animations[index].animation == animation)
+            return index;
+        index = _animations[index].nextForNode;
+    } while (index != head);
+    return NSNotFound;
+}
+
+- (void)unlinkAnimationAtIndex:(NSUInteger)index
+{
+    icScheduledAnimation *record = &_animations[index];
+    if (record->nextForNode == index) {
+        CFDictionaryRemoveValue(_animationLists, record->node);
+        return;
+    }
+    _animations[record->prevForNode].nextForNode = record->nextForNode;
+    _animations[record->nextForNode].prevForNode = record->prevForNode;
+    if ((NSUInteger)CFDictionaryGetValue(_animationLists, record->node) == index)
+        CFDictionarySetValue(_animationLists, record->node, (const void *)record->nextForNode);
+}
+
+// Moves the record at fromIndex to toIndex, overwriting the record at toIndex
+- (void)moveAnimationFromIndex:(NSUInteger)fromIndex toIndex:(NSUInteger)toIndex
+{
+    if (fromIndex == toIndex)
+        return;
+    
+    icScheduledAnimation *record = &_animations[toIndex];
+    *record = _animations[fromIndex];
+    if (record->removed)
+        return;
     
-    [animations release];
+    if (record->nextForNode == fromIndex) {
+        record->prevForNode = toIndex;
+        record->nextForNode = toIndex;
+    } else {
+        _animations[record->prevForNode].nextForNode = toIndex;
+        _animations[record->nextForNode].prevForNode = toIndex;
+    }
+    if ((NSUInteger)CFDictionaryGetValue(_animationLists, record->node) == fromIndex)
+        CFDictionarySetValue(_animationLists, record->node, (const void *)toIndex);
+}
+
+- (void)purgeRemovedAnimations
+{
+    NSUInteger i = 0;
+    while (i < _animationCount) {
+        if (_animations[i].removed) {
+            [_animations[i].animation release];
+            // Fill the gap with the last record, which is checked again in the next iteration
+            [self moveAnimationFromIndex:--_animationCount toIndex:i];
+        } else {
+            i++;
+        }
+    }
+    _numberOfRemovedAnimations = 0;
 }
 
 @end
@@ -57,6 +57,7 @@
 #define ICUniformSampler                "u_texture"
 #define ICUniformSampler2               "u_texture2"
 #define ICUniformAlphaTestValue         "u_alpha_value"
+#define ICUniformPickColor              "u_pickColor"
 
 // Uniform names (deprecated)
 #define kICUniformMVPMatrix_s			ICUniformMVPMatrix
@@ -76,6 +77,7 @@
 
 
 @class ICShaderValue;
+@class ICShaderUniform;
 
 /**
  @brief Defines a GLSL shader program
@@ -133,11 +135,21 @@
  full list of all ICShaderUniform objects fetched from the shader program's source using the
  ICShaderProgram::uniforms property.
  
+ Uniforms that are set frequently, e.g. once per draw, should be set using uniform handles.
+ A uniform handle is an integer resolved by ICShaderProgram::uniformHandleForName: after the
+ program has been linked. The typed setters, such as ICShaderProgram::setMat4:forUniformHandle:,
+ store the given value directly in the uniform without looking up its name or allocating
+ ICShaderValue objects. The handles of the model-view-projection matrix and pick color uniforms
+ are cached by the program and available via ICShaderProgram::mvpMatrixUniformHandle and
+ ICShaderProgram::pickColorUniformHandle.
+ 
  ### Updating Uniforms ###
  
  After linking a program or setting values on the program's uniforms, you have to call
  ICShaderProgram::updateUniforms to update the uniforms in the shaders. This will upload the
- values to the program and make them available for processing on the GPU.
+ values to the program and make them available for processing on the GPU. As OpenGL retains
+ uniform values per program, only uniforms whose values have changed since the last update
+ are uploaded.
  
  ### Retrieving Program Logs ###
  
@@ -170,6 +182,11 @@
     
     NSString *_programName;
     NSMutableDictionary *_uniforms;
+    
+    ICShaderUniform **_uniformsByHandle;
+    GLint _uniformCount;
+    ICShaderUniformHandle _mvpMatrixUniformHandle;
+    ICShaderUniformHandle _pickColorUniformHandle;
 }
 
 #pragma mark - Creating a Shader Program
@@ -273,6 +290,74 @@ fragmentShaderString:(NSString *)fShaderString;
 - (ICShaderValue *)shaderValueForUniform:(NSString *)uniformName;
 
 
+#pragma mark - Setting Uniforms Using Handles
+/** @name Setting Uniforms Using Handles */
+
+/**
+ @brief Returns the handle of the uniform with the given name
+ 
+ @param uniformName The uniform's name as defined in the GLSL program's source code
+ 
+ @return Returns an ICShaderUniformHandle identifying the uniform or
+ #ICShaderUniformHandleInvalid if the program defines no uniform of the given name.
+ 
+ Handles are resolved when the program is linked. Applications should obtain handles once after
+ linking and reuse them for setting uniform values using the typed setters below.
+ */
+- (ICShaderUniformHandle)uniformHandleForName:(NSString *)uniformName;
+
+/**
+ @brief Returns the uniform for the given handle or ``nil`` if the handle is invalid
+ */
+- (ICShaderUniform *)uniformForHandle:(ICShaderUniformHandle)handle;
+
+/**
+ @brief The handle of the program's #ICUniformMVPMatrix uniform
+ 
+ #ICShaderUniformHandleInvalid if the program does not define such a uniform.
+ */
+@property (nonatomic, readonly) ICShaderUniformHandle mvpMatrixUniformHandle;
+
+/**
+ @brief The handle of the program's #ICUniformPickColor uniform
+ 
+ #ICShaderUniformHandleInvalid if the program does not define such a uniform.
+ */
+@property (nonatomic, readonly) ICShaderUniformHandle pickColorUniformHandle;
+
+/**
+ @brief Sets the int or sampler uniform identified by the given handle to the given value
+ 
+ @return Returns ``YES`` if the handle is valid and the uniform's type matches, otherwise ``NO``.
+ */
+- (BOOL)setInt:(int)value forUniformHandle:(ICShaderUniformHandle)handle;
+
+/**
+ @brief Sets the float uniform identified by the given handle to the given value
+ */
+- (BOOL)setFloat:(float)value forUniformHandle:(ICShaderUniformHandle)handle;
+
+/**
+ @brief Sets the vec2 uniform identified by the given handle to the given value
+ */
+- (BOOL)setVec2:(kmVec2)value forUniformHandle:(ICShaderUniformHandle)handle;
+
+/**
+ @brief Sets the vec3 uniform identified by the given handle to the given value
+ */
+- (BOOL)setVec3:(kmVec3)value forUniformHandle:(ICShaderUniformHandle)handle;
+
+/**
+ @brief Sets the vec4 uniform identified by the given handle to the given value
+ */
+- (BOOL)setVec4:(kmVec4)value forUniformHandle:(ICShaderUniformHandle)handle;
+
+/**
+ @brief Sets the mat4 uniform identified by the given handle to the given matrix
+ */
+- (BOOL)setMat4:(const kmMat4 *)value forUniformHandle:(ICShaderUniformHandle)handle;
+
+
 #pragma mark - Linking and Using a Shader Program
 /** @name Linking and Using a Shader Program */
 
@@ -287,7 +372,7 @@ fragmentShaderString:(NSString *)fShaderString;
 - (void)use;
 
 /**
- @brief Updates the shader's uniform values
+ @brief Uploads the values of all uniforms that have changed since the last update
  */
 - (void)updateUniforms;
 
@@ -104,6 +104,8 @@ typedef void (*GLLogFunction) (GLuint program,
 @synthesize program = _program;
 @synthesize programName = _programName;
 @synthesize uniforms = _uniforms;
+@synthesize mvpMatrixUniformHandle = _mvpMatrixUniformHandle;
+@synthesize pickColorUniformHandle = _pickColorUniformHandle;
 
 + (id)shaderProgramWithName:(NSString *)programName
          vertexShaderString:(NSString *)vShaderString
@@ -163,6 +165,8 @@ fragmentShaderString:(NSString *)fShaderString
         _programName = [programName copy];
         
         _uniforms = [[NSMutableDictionary alloc] init];
+        _mvpMatrixUniformHandle = ICShaderUniformHandleInvalid;
+        _pickColorUniformHandle = ICShaderUniformHandleInvalid;
         
         _program = glCreateProgram();
         
@@ -198,13 +202,14 @@ fragmentShaderString:(NSString *)fShaderString
 	ICLogDealloc(@"icedcoffee: deallocing %@", self);
     
     [_uniforms release];
+    free(_uniformsByHandle);
     
 	// There is no need to delete the shaders. They should have been already deleted.
 	NSAssert(_vertShader == 0, @"Vertex Shaders should have been already deleted");
 	NSAssert(_fragShader == 0, @"Fragment Shaders should have been already deleted");
     
     if (_program) {
-        glDeleteProgram(_program);
+        icGLDeleteProgram(_program);
     }
     
     [_programName release];
@@ -259,15 +264,66 @@ fragmentShaderString:(NSString *)fShaderString
     return [_uniforms objectForKey:uniformName];
 }
 
+- (ICShaderUniformHandle)uniformHandleForName:(NSString *)uniformName
+{
+    ICShaderUniform *uniform = [_uniforms objectForKey:uniformName];
+    if (uniform) {
+        for (GLint i=0; i<_uniformCount; i++) {
+            if (_uniformsByHandle[i] == uniform)
+                return i;
+        }
+    }
+    return ICShaderUniformHandleInvalid;
+}
+
+- (ICShaderUniform *)uniformForHandle:(ICShaderUniformHandle)handle
+{
+    if (handle < 0 || handle >= _uniformCount)
+        return nil;
+    return _uniformsByHandle[handle];
+}
+
+- (BOOL)setInt:(int)value forUniformHandle:(ICShaderUniformHandle)handle
+{
+    return [[self uniformForHandle:handle] setIntValue:value];
+}
+
+- (BOOL)setFloat:(float)value forUniformHandle:(ICShaderUniformHandle)handle
+{
+    return [[self uniformForHandle:handle] setFloatValue:value];
+}
+
+- (BOOL)setVec2:(kmVec2)value forUniformHandle:(ICShaderUniformHandle)handle
+{
+    return [[self uniformForHandle:handle] setVec2Value:value];
+}
+
+- (BOOL)setVec3:(kmVec3)value forUniformHandle:(ICShaderUniformHandle)handle
+{
+    return [[self uniformForHandle:handle] setVec3Value:value];
+}
+
+- (BOOL)setVec4:(kmVec4)value forUniformHandle:(ICShaderUniformHandle)handle
+{
+    return [[self uniformForHandle:handle] setVec4Value:value];
+}
+
+- (BOOL)setMat4:(const kmMat4 *)value forUniformHandle:(ICShaderUniformHandle)handle
+{
+    return [[self uniformForHandle:handle] setMat4Value:value];
+}
+
 - (void)updateUniforms
 {
-    glUseProgram(_program);
-    NSEnumerator* e = [_uniforms objectEnumerator];
-    
-    ICShaderUniform* u;
+    icGLUseProgram(_program);
     
-    while(u = (ICShaderUniform*)[e nextObject])
+    for (GLint i=0; i<_uniformCount; i++)
     {
+        ICShaderUniform *u = _uniformsByHandle[i];
+        if (!u.dirty)
+            continue;
+        u.dirty = NO;
+        
         switch(u.type)
         {
             case ICShaderValueTypeInt:
@@ -323,8 +379,18 @@ fragmentShaderString:(NSString *)fShaderString
 // Adapted from http://stackoverflow.com/questions/4783912/how-can-i-find-a-list-of-all-the-uniforms-in-opengl-es-2-0-vertex-shader-pro
 - (void)fetchUniforms
 {
+    // Handles index into _uniformsByHandle, so they are invalidated when relinking
+    [_uniforms removeAllObjects];
+    free(_uniformsByHandle);
+    _uniformsByHandle = NULL;
+    _uniformCount = 0;
+    _mvpMatrixUniformHandle = ICShaderUniformHandleInvalid;
+    _pickColorUniformHandle = ICShaderUniformHandleInvalid;
+    
     GLint numUniforms;
     glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &numUniforms);
+    if (numUniforms > 0)
+        _uniformsByHandle = calloc(numUniforms, sizeof(ICShaderUniform *));
     for(int i=0; i<numUniforms; ++i)  {
         int name_len=-1, num=-1;
         GLenum type = GL_ZERO;
@@ -337,16 +403,19 @@ fragmentShaderString:(NSString *)fShaderString
         if (shaderValueType == ICShaderValueTypeInvalid) {
             NSLog(@"Invalid shader value type for uniform %s", name);
         }
-        [_uniforms setObject:[ICShaderUniform shaderUniformWithType:shaderValueType location:location]
-                                                             forKey:[NSString stringWithCString:name encoding:NSUTF8StringEncoding]];
+        ICShaderUniform *uniform = [ICShaderUniform shaderUniformWithType:shaderValueType location:location];
+        [_uniforms setObject:uniform forKey:[NSString stringWithCString:name encoding:NSUTF8StringEncoding]];
+        // Uniforms are retained by _uniforms
+        _uniformsByHandle[_uniformCount] = uniform;
+        if (strcmp(name, ICUniformMVPMatrix) == 0)
+            _mvpMatrixUniformHandle = _uniformCount;
+        else if (strcmp(name, ICUniformPickColor) == 0)
+            _pickColorUniformHandle = _uniformCount;
+        _uniformCount++;
     }
     
-    if ([_uniforms objectForKey:@"u_texture"]) {
-        [self setShaderValue:[ICShaderValue shaderValueWithInt:0] forUniform:@"u_texture"];
-    }
-    if ([_uniforms objectForKey:@"u_texture2"]) {
-        [self setShaderValue:[ICShaderValue shaderValueWithInt:1] forUniform:@"u_texture2"];
-    }
+    [self setInt:0 forUniformHandle:[self uniformHandleForName:@ICUniformSampler]];
+    [self setInt:1 forUniformHandle:[self uniformHandleForName:@ICUniformSampler2]];
 }
 
 - (BOOL)link
@@ -364,7 +433,7 @@ fragmentShaderString:(NSString *)fShaderString
 			glDeleteShader(_vertShader);
 		if (_fragShader)
 			glDeleteShader(_fragShader);
-		glDeleteProgram(_program);
+		icGLDeleteProgram(_program);
 		_vertShader = _fragShader = _program = 0;
         return NO;
 	}
@@ -386,7 +455,7 @@ fragmentShaderString:(NSString *)fShaderString
 
 - (void)use
 {
-    glUseProgram(_program);
+    icGLUseProgram(_program);
     [self updateUniforms];
     IC_CHECK_GL_ERROR_DEBUG();    
 }
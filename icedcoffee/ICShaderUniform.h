@@ -33,10 +33,16 @@
  ICShaderProgram enumerates all uniforms implemented by a given shader program and automatically
  creates ICShaderUniform objects for them. The ICShaderUniform class is then used to set uniforms
  to a certain value represented by the ICShaderValue class.
+ 
+ Besides ICShaderUniform::setToShaderValue:, uniforms provide typed setters which store the given
+ value in place without allocating intermediate ICShaderValue objects. A uniform is marked dirty
+ whenever its value changes. ICShaderProgram::updateUniforms uploads dirty uniforms only and
+ clears their dirty flag afterwards.
  */
 @interface ICShaderUniform : ICShaderValue {
 @protected
     GLint _location;
+    BOOL _dirty;
 }
 
 #pragma mark - Creating a Shader Uniform Representation
@@ -49,8 +55,52 @@
 #pragma mark - Setting the Uniform's Value
 /** @name Setting the Uniform's Value */
 
+/**
+ @brief Sets the uniform to the value of the given shader value
+ 
+ @return Returns ``YES`` if the type of ``value`` matches the uniform's type, otherwise ``NO``.
+ */
 - (BOOL)setToShaderValue:(ICShaderValue *)value;
 
+/**
+ @brief Sets the uniform to the given int value
+ 
+ Applicable to uniforms of type ICShaderValueTypeInt and ICShaderValueTypeSampler2D.
+ 
+ @return Returns ``YES`` if the uniform's type matches, otherwise ``NO``.
+ */
+- (BOOL)setIntValue:(int)value;
+
+/**
+ @brief Sets the uniform to the given float value
+ */
+- (BOOL)setFloatValue:(float)value;
+
+/**
+ @brief Sets the uniform to the given two-dimensional vector
+ */
+- (BOOL)setVec2Value:(kmVec2)value;
+
+/**
+ @brief Sets the uniform to the given three-dimensional vector
+ */
+- (BOOL)setVec3Value:(kmVec3)value;
+
+/**
+ @brief Sets the uniform to the given four-dimensional vector
+ */
+- (BOOL)setVec4Value:(kmVec4)value;
+
+/**
+ @brief Sets the uniform to the given 4x4 matrix
+ */
+- (BOOL)setMat4Value:(const kmMat4 *)value;
+
+/**
+ @brief Whether the uniform's value has changed since it was last uploaded to its program
+ */
+@property (nonatomic, assign, getter=isDirty) BOOL dirty;
+
 #pragma mark - Obtaining the Uniform's Location
 /** @name Obtaining the Uniform's Location */
 
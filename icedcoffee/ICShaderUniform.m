@@ -23,9 +23,17 @@
 
 #import "ICShaderUniform.h"
 
+// Stores size bytes of value in the uniform's value storage if they differ from what is stored
+#define IC_SET_UNIFORM_VALUE(member, value, size) \
+    if (memcmp(&_value.member, value, size) != 0) { \
+        memcpy(&_value.member, value, size); \
+        _dirty = YES; \
+    }
+
 @implementation ICShaderUniform
 
 @synthesize location = _location;
+@synthesize dirty = _dirty;
 
 + (id)shaderUniformWithType:(ICShaderValueType)type location:(GLint)location
 {
@@ -37,6 +45,7 @@
     if ((self = [super init])) {
         _type = type;
         self.location = location;
+        _dirty = YES;
     }
     return self;
 }
@@ -47,7 +56,64 @@
         return NO;
     }
     
-    _value = value->_value;
+    if (memcmp(&_value, &value->_value, sizeof(_value)) != 0) {
+        _value = value->_value;
+        _dirty = YES;
+    }
+    return YES;
+}
+
+- (BOOL)setIntValue:(int)value
+{
+    if (_type != ICShaderValueTypeInt && _type != ICShaderValueTypeSampler2D) {
+        return NO;
+    }
+    IC_SET_UNIFORM_VALUE(intValue, &value, sizeof(int));
+    return YES;
+}
+
+- (BOOL)setFloatValue:(float)value
+{
+    if (_type != ICShaderValueTypeFloat) {
+        return NO;
+    }
+    IC_SET_UNIFORM_VALUE(floatValue, &value, sizeof(float));
+    return YES;
+}
+
+- (BOOL)setVec2Value:(kmVec2)value
+{
+    if (_type != ICShaderValueTypeVec2) {
+        return NO;
+    }
+    IC_SET_UNIFORM_VALUE(vec2Value, &value, sizeof(kmVec2));
+    return YES;
+}
+
+- (BOOL)setVec3Value:(kmVec3)value
+{
+    if (_type != ICShaderValueTypeVec3) {
+        return NO;
+    }
+    IC_SET_UNIFORM_VALUE(vec3Value, &value, sizeof(kmVec3));
+    return YES;
+}
+
+- (BOOL)setVec4Value:(kmVec4)value
+{
+    if (_type != ICShaderValueTypeVec4) {
+        return NO;
+    }
+    IC_SET_UNIFORM_VALUE(vec4Value, &value, sizeof(kmVec4));
+    return YES;
+}
+
+- (BOOL)setMat4Value:(const kmMat4 *)value
+{
+    if (_type != ICShaderValueTypeMat4) {
+        return NO;
+    }
+    IC_SET_UNIFORM_VALUE(mat4Value, value, sizeof(kmMat4));
     return YES;
 }
 
@@ -0,0 +1,104 @@
+//
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "ICAnimationTimingFunction.h"
+
+/**
+ @brief Implements an animation timing function simulating a damped spring
+ 
+ ICSpringTimingFunction models the animation's progression as a mass attached to a damped
+ spring, moving from 0 to its rest position 1. Depending on the spring's parameters, the
+ progression may overshoot and oscillate around 1 before coming to rest.
+ 
+ Input time factors in range [0,1] are mapped to the time the spring takes to settle, which is
+ available via ICSpringTimingFunction::settlingDuration. Animations using spring timing
+ functions should usually set their duration to the settling duration, so that the spring
+ moves with its natural speed.
+ 
+ By default, spring timing functions bake lookup tables, see
+ ICAnimationTimingFunction::interpolation. Lightly damped springs oscillating too often to be
+ represented by #IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE samples are evaluated directly instead.
+ Lookup tables are shared only by springs without initial velocity.
+ */
+@interface ICSpringTimingFunction : ICAnimationTimingFunction {
+@protected
+    float _mass;
+    float _stiffness;
+    float _damping;
+    float _initialVelocity;
+    icTime _settlingDuration;
+}
+
+/**
+ @brief Returns a new autoreleased spring timing function with the given parameters
+ 
+ @sa initWithMass:stiffness:damping:initialVelocity:
+ */
++ (id)timingFunctionWithMass:(float)mass
+                   stiffness:(float)stiffness
+                     damping:(float)damping
+             initialVelocity:(float)initialVelocity;
+
+/**
+ @brief Initializes the receiver with the given spring parameters
+ 
+ @param mass The mass attached to the spring, must be greater than zero
+ @param stiffness The spring's stiffness, must be greater than zero
+ @param damping The spring's damping coefficient. Values below ``2 * sqrt(stiffness * mass)``
+ let the spring oscillate before coming to rest.
+ @param initialVelocity The initial velocity of the mass in units of the distance between
+ start and rest position per second
+ */
+- (id)initWithMass:(float)mass
+         stiffness:(float)stiffness
+           damping:(float)damping
+   initialVelocity:(float)initialVelocity;
+
+/**
+ @brief The mass attached to the spring
+ */
+@property (nonatomic, readonly) float mass;
+
+/**
+ @brief The spring's stiffness
+ */
+@property (nonatomic, readonly) float stiffness;
+
+/**
+ @brief The spring's damping coefficient
+ */
+@property (nonatomic, readonly) float damping;
+
+/**
+ @brief The initial velocity of the mass
+ */
+@property (nonatomic, readonly) float initialVelocity;
+
+/**
+ @brief The time in seconds it takes the spring to come to rest
+ 
+ The spring is considered at rest once its distance from the rest position stays below 0.1%.
+ */
+@property (nonatomic, readonly) icTime settlingDuration;
+
+@end
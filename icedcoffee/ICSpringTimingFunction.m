@@ -0,0 +1,175 @@
+//
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "ICSpringTimingFunction.h"
+
+#define IC_SPRING_REST_THRESHOLD 0.001
+#define IC_SPRING_MAX_SETTLING_DURATION 60.0
+#define IC_SPRING_SETTLING_STEP (1.0 / 240.0)
+// The minimum number of lookup table samples per oscillation period required to bake a table
+#define IC_SPRING_SAMPLES_PER_OSCILLATION 16
+
+
+@interface ICSpringTimingFunction (Private)
+- (double)displacementAtTime:(double)t;
+- (icTime)computeSettlingDuration;
+- (double)oscillationCount;
+@end
+
+@implementation ICSpringTimingFunction
+
+@synthesize mass = _mass;
+@synthesize stiffness = _stiffness;
+@synthesize damping = _damping;
+@synthesize initialVelocity = _initialVelocity;
+@synthesize settlingDuration = _settlingDuration;
+
++ (id)timingFunctionWithMass:(float)mass
+                   stiffness:(float)stiffness
+                     damping:(float)damping
+             initialVelocity:(float)initialVelocity
+{
+    return [[[[self class] alloc] initWithMass:mass
+                                     stiffness:stiffness
+                                       damping:damping
+                               initialVelocity:initialVelocity] autorelease];
+}
+
+- (id)initWithMass:(float)mass
+         stiffness:(float)stiffness
+           damping:(float)damping
+   initialVelocity:(float)initialVelocity
+{
+    if (mass <= 0 || stiffness <= 0 || damping < 0) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"Mass and stiffness must be positive, damping must not be negative"];
+        [self release];
+        return nil;
+    }
+    
+    if ((self = [super initWithControlPointsC0:kmVec2Make(0.f, 0.f)
+                                            c1:kmVec2Make(1.f, 1.f)
+                                 interpolation:ICTimingFunctionInterpolationNone])) {
+        _mass = mass;
+        _stiffness = stiffness;
+        _damping = damping;
+        _initialVelocity = initialVelocity;
+        _settlingDuration = [self computeSettlingDuration];
+        // Lookup tables cannot represent oscillations spanning only a few samples
+        if ([self oscillationCount] * IC_SPRING_SAMPLES_PER_OSCILLATION <=
+            IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE)
+            self.interpolation = IC_DEFAULT_TIMING_FUNCTION_INTERPOLATION;
+    }
+    return self;
+}
+
+- (icTime)evaluate:(icTime)x
+{
+    if (x >= 1)
+        return 1;
+    if (x <= 0)
+        return 0;
+    return 1 - [self displacementAtTime:x * _settlingDuration];
+}
+
+- (NSString *)lookupTableKey
+{
+    // Initial velocities of gesture driven springs rarely repeat, so their tables are not shared
+    if (_initialVelocity != 0)
+        return nil;
+    return [NSString stringWithFormat:@"%@ %a %a %a", NSStringFromClass([self class]),
+            _mass, _stiffness, _damping];
+}
+
+@end
+
+
+@implementation ICSpringTimingFunction (Private)
+
+// Returns the signed distance of the mass from its rest position at time t, starting at 1
+- (double)displacementAtTime:(double)t
+{
+    double omega0 = sqrt(_stiffness / _mass);
+    double zeta = _damping / (2 * sqrt(_stiffness * _mass));
+    double v0 = _initialVelocity;
+    
+    if (zeta < 1) {
+        // Underdamped, oscillates around the rest position
+        double omegaD = omega0 * sqrt(1 - zeta * zeta);
+        double decay = zeta * omega0;
+        return exp(-decay * t) * (cos(omegaD * t) + ((decay - v0) / omegaD) * sin(omegaD * t));
+    } else if (zeta == 1) {
+        // Critically damped
+        return exp(-omega0 * t) * (1 + (omega0 - v0) * t);
+    }
+    
+    // Overdamped
+    double root = sqrt(zeta * zeta - 1);
+    double r1 = -omega0 * (zeta - root);
+    double r2 = -omega0 * (zeta + root);
+    double a = (-v0 - r2) / (r1 - r2);
+    return a * exp(r1 * t) + (1 - a) * exp(r2 * t);
+}
+
+- (icTime)computeSettlingDuration
+{
+    double omega0 = sqrt(_stiffness / _mass);
+    double zeta = _damping / (2 * sqrt(_stiffness * _mass));
+    
+    if (zeta < 1) {
+        // The oscillation's amplitude is bounded by an exponentially decaying envelope
+        double omegaD = omega0 * sqrt(1 - zeta * zeta);
+        double decay = zeta * omega0;
+        double ratio = (decay - _initialVelocity) / omegaD;
+        double amplitude = sqrt(1 + ratio * ratio);
+        if (decay > 0 && amplitude > IC_SPRING_REST_THRESHOLD)
+            return MIN(log(amplitude / IC_SPRING_REST_THRESHOLD) / decay,
+                       IC_SPRING_MAX_SETTLING_DURATION);
+        return IC_SPRING_MAX_SETTLING_DURATION;
+    }
+    
+    // Critically damped and overdamped springs cross the rest position at most once, so they
+    // are settled once they are close to it and still approaching it
+    double previous = 1;
+    for (double t = IC_SPRING_SETTLING_STEP; t < IC_SPRING_MAX_SETTLING_DURATION;
+         t += IC_SPRING_SETTLING_STEP) {
+        double current = fabs([self displacementAtTime:t]);
+        if (current < IC_SPRING_REST_THRESHOLD && current <= previous)
+            return t;
+        previous = current;
+    }
+    return IC_SPRING_MAX_SETTLING_DURATION;
+}
+
+// Returns the number of oscillation periods within the settling duration
+- (double)oscillationCount
+{
+    double omega0 = sqrt(_stiffness / _mass);
+    double zeta = _damping / (2 * sqrt(_stiffness * _mass));
+    if (zeta >= 1)
+        return 0;
+    double omegaD = omega0 * sqrt(1 - zeta * zeta);
+    return _settlingDuration * omegaD / (2 * M_PI);
+}
+
+@end
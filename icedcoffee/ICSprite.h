@@ -27,6 +27,8 @@
 #import "ICTexture2D.h"
 #import "icTypes.h"
 
+@class ICNodeVisitorDrawing;
+
 /**
  @brief A colored and textured 2D sprite
  
@@ -44,7 +46,10 @@
     icColor4B    _color;
     icBlendFunc  _blendFunc;
     GLuint       _vertexBuffer;
+    GLuint       _vertexArray;
+    struct _icGLStateCache *_vertexArrayStateCache;
     kmVec2       _texCoords[4];
+    icV3F_C4F_T2F _vertices[4];
 }
 
 #pragma mark - Creating a Sprite
@@ -127,4 +132,16 @@
  */
 - (void)drawWithVisitor:(ICNodeVisitor *)visitor;
 
+/**
+ @brief Adds the sprite's quad to the given visitor's current sprite batch
+ 
+ This method is called by ICNodeVisitorDrawing instead of ICSprite::drawWithVisitor: if the
+ visitor batches sprites (see ICNodeVisitorDrawing::batchesSprites).
+ 
+ @return Returns YES if the sprite has been added to the batch or NO if the sprite must be drawn
+ using ICSprite::drawWithVisitor:. The default implementation returns NO if the sprite has no
+ shader program or if the receiver's class overrides ICSprite::drawWithVisitor:.
+ */
+- (BOOL)batchWithVisitor:(ICNodeVisitorDrawing *)visitor;
+
 @end
@@ -26,8 +26,10 @@
 #import "ICShaderCache.h"
 #import "icMacros.h"
 #import "ICNodeVisitorPicking.h"
+#import "ICNodeVisitorDrawing.h"
 #import "icGLState.h"
 #import "icUtils.h"
+#import "ICConfiguration.h"
 
 
 #define NUM_VERTICES 4
@@ -35,6 +37,8 @@
 
 @interface ICSprite (Private)
 - (void)setDefaultTexCoords;
+- (void)setVertexAttribPointers;
+- (BOOL)bindVertexArray;
 @end
 
 @implementation ICSprite
@@ -75,7 +79,10 @@
     ICLogDealloc(@"Deallocing ICSprite");
     
     if (_vertexBuffer)
-        glDeleteBuffers(1, &_vertexBuffer);    
+        icGLDeleteBuffer(_vertexBuffer);    
+    // Vertex array objects are not shared, so they can only be deleted in their own context
+    if (_vertexArray && _vertexArrayStateCache == icGLGetCurrentStateCache())
+        icGLDeleteVertexArray(_vertexArray);
     
     self.texture = nil;
     
@@ -123,18 +130,16 @@
 
 - (void)updateQuad
 {
-    icV3F_C4F_T2F vertices[NUM_VERTICES];    
-
-    [self updateQuadPositionsWithVertices:vertices];
-    [self updateQuadTexCoordsWithVertices:vertices];
-    [self updateQuadColorsWithVertices:vertices];
+    // Vertices are kept on the client side for sprite batching
+    [self updateQuadPositionsWithVertices:_vertices];
+    [self updateQuadTexCoordsWithVertices:_vertices];
+    [self updateQuadColorsWithVertices:_vertices];
     
     if (!_vertexBuffer)
         glGenBuffers(1, &_vertexBuffer);
     
-    glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(icV3F_C4F_T2F) * NUM_VERTICES, vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);    
+    icGLBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(icV3F_C4F_T2F) * NUM_VERTICES, _vertices, GL_STATIC_DRAW);
 }
 
 - (icColor4B)color
@@ -154,30 +159,34 @@
     
     // Set texture (unless we're in picking mode)
     if (_texture && ![visitor isKindOfClass:[ICNodeVisitorPicking class]]) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, [_texture name]);
+        icGLBindTexture2DN(0, [_texture name]);
         if (_maskTexture) {
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, [_maskTexture name]);
+            icGLBindTexture2DN(1, [_maskTexture name]);
         }
         IC_CHECK_GL_ERROR_DEBUG();
     }
     
     // FIXME: support for textured picking?
     if ([visitor isKindOfClass:[ICNodeVisitorPicking class]]) {
-        icGLDisable(GL_BLEND);
+        icGLDisable(IC_GL_BLEND);
     } else {
         icGLBlendFunc(_blendFunc.src, _blendFunc.dst);
         icGLEnable(IC_GL_BLEND);
     }
     
-    glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
-
-    // FIXME: needs to go into icGLState
-    glEnableVertexAttribArray(ICVertexAttribPosition);
-    glEnableVertexAttribArray(ICVertexAttribColor);
-    glEnableVertexAttribArray(ICVertexAttribTexCoords);
+    if (![self bindVertexArray]) {
+        icGLEnableVertexAttribs(IC_VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
+        [self setVertexAttribPointers];
+    }
+    IC_CHECK_GL_ERROR_DEBUG();
+    
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     IC_CHECK_GL_ERROR_DEBUG();
+}
+
+- (void)setVertexAttribPointers
+{
+    icGLBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
     
 #define kVertexSize sizeof(icV3F_C4F_T2F)    
     
@@ -192,23 +201,55 @@
 	// texCoords
 	diff = offsetof(icV3F_C4F_T2F, texCoords);
 	glVertexAttribPointer(ICVertexAttribTexCoords, 2, GL_FLOAT, GL_FALSE, kVertexSize, (void*)(diff));
-    
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    IC_CHECK_GL_ERROR_DEBUG();
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+// Binds a vertex array object recording the sprite's attribute setup, returns NO if vertex array
+// objects cannot be used in the current context
+- (BOOL)bindVertexArray
+{
+#if IC_ENABLE_VERTEX_ARRAY_OBJECTS
+    icGLStateCache *stateCache = icGLGetCurrentStateCache();
+    if (!stateCache || ![[ICConfiguration sharedConfiguration] supportsVertexArrayObject])
+        return NO;
     
-    if (_maskTexture) {
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, 0);
+    if (!_vertexArray) {
+        glGenVertexArrays(1, &_vertexArray);
+        _vertexArrayStateCache = stateCache;
+        icGLBindVertexArray(_vertexArray);
+        glEnableVertexAttribArray(ICVertexAttribPosition);
+        glEnableVertexAttribArray(ICVertexAttribColor);
+        glEnableVertexAttribArray(ICVertexAttribTexCoords);
+        [self setVertexAttribPointers];
+        return YES;
     }
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    IC_CHECK_GL_ERROR_DEBUG();
     
-    glDisableVertexAttribArray(ICVertexAttribPosition);
-    glDisableVertexAttribArray(ICVertexAttribColor);
-    glDisableVertexAttribArray(ICVertexAttribTexCoords);
+    // Vertex array objects are not shared between contexts
+    if (_vertexArrayStateCache != stateCache)
+        return NO;
+    
+    icGLBindVertexArray(_vertexArray);
+    return YES;
+#else
+    return NO;
+#endif
+}
+
+- (BOOL)batchWithVisitor:(ICNodeVisitorDrawing *)visitor
+{
+    static IMP spriteDrawIMP = NULL;
+    if (!spriteDrawIMP)
+        spriteDrawIMP = [ICSprite instanceMethodForSelector:@selector(drawWithVisitor:)];
+    
+    // Subclasses implementing custom drawing code cannot be batched
+    if (!self.shaderProgram || [self methodForSelector:@selector(drawWithVisitor:)] != spriteDrawIMP)
+        return NO;
+    
+    [visitor batchQuadVertices:_vertices
+                 shaderProgram:self.shaderProgram
+                       texture:_texture ? [_texture name] : 0
+                   maskTexture:_maskTexture ? [_maskTexture name] : 0
+                     blendFunc:_blendFunc];
+    return YES;
 }
 
 - (void)setTexture:(ICTexture2D *)texture
@@ -23,21 +23,115 @@
 
 #import "ICScrollView.h"
 #import "ICTableViewDataSource.h"
-
-// Work in progress
+#import "ICTableViewDelegate.h"
 
 @class ICTableViewCell;
 
+/**
+ @brief A scroll view displaying a list of rows
+ 
+ <h3>Overview</h3>
+ 
+ The ICTableView class displays a vertical list of rows provided by an object conforming to the
+ ICTableViewDataSource protocol. Table views only instantiate cells for rows intersecting their
+ visible region. When the ICScrollView::contentOffset changes, cells of rows scrolled out of
+ view are removed from the table and enqueued in a reuse pool for their
+ ICTableViewCell::identifier. Cells for rows scrolled into view are requested from the data
+ source, which should obtain recycled cells using ICTableView::dequeueReusableCellWithIdentifier:.
+ 
+ Rows are ICTableView::rowHeight points high by default. Variable row heights may be provided
+ by a delegate implementing ICTableViewDelegate::tableView:heightForRowAtIndex:. Row heights
+ are queried once per ICTableView::reloadData and stored as running offsets, so finding the
+ rows of the visible region takes logarithmic time in the number of rows.
+ */
 @interface ICTableView : ICScrollView {
 @protected
     id<ICTableViewDataSource> _dataSource;
+    id<ICTableViewDelegate> _delegate;
+    float _rowHeight;
+    NSInteger _numberOfRows;
+    float *_rowOffsets;
+    NSMutableArray *_visibleCells;
+    NSRange _visibleRows;
     NSMutableDictionary *_reusableCells;
 }
 
+#pragma mark - Providing the Table's Data
+/** @name Providing the Table's Data */
+
+/**
+ @brief The table view's data source
+ 
+ Setting a data source reloads the table's data.
+ */
 @property (nonatomic, assign) id<ICTableViewDataSource> dataSource;
 
-- (ICTableViewCell *)dequeueReusableCellWithIdentifier:(NSString *)identifier;
+/**
+ @brief The table view's delegate
+ 
+ Setting a delegate reloads the table's data.
+ */
+@property (nonatomic, assign) id<ICTableViewDelegate> delegate;
 
+/**
+ @brief Discards all visible cells and reloads the number of rows, row heights and visible rows
+ */
 - (void)reloadData;
 
+
+#pragma mark - Configuring Rows
+/** @name Configuring Rows */
+
+/**
+ @brief The height of rows if the delegate does not provide row heights, defaults to 30 points
+ */
+@property (nonatomic, assign, setter=setRowHeight:) float rowHeight;
+
+/**
+ @brief The number of rows as of the last call to ICTableView::reloadData
+ */
+@property (nonatomic, readonly) NSInteger numberOfRows;
+
+/**
+ @brief Returns the vertical offset of the row at the given index in content coordinates
+ */
+- (float)offsetForRowAtIndex:(NSInteger)rowIndex;
+
+/**
+ @brief Returns the height of the row at the given index
+ */
+- (float)heightForRowAtIndex:(NSInteger)rowIndex;
+
+/**
+ @brief Returns the index of the row at the given vertical offset in content coordinates
+ 
+ Returns NSNotFound if the table has no rows. Offsets outside of the table's content are
+ clamped to the first or last row, respectively.
+ */
+- (NSInteger)indexOfRowAtOffset:(float)offset;
+
+
+#pragma mark - Accessing Cells
+/** @name Accessing Cells */
+
+/**
+ @brief The range of rows whose cells are currently instantiated
+ */
+@property (nonatomic, readonly) NSRange visibleRows;
+
+/**
+ @brief The cells of the currently visible rows in row order
+ */
+- (NSArray *)visibleCells;
+
+/**
+ @brief Returns the cell of the row at the given index or nil if the row is not visible
+ */
+- (ICTableViewCell *)cellForRowAtIndex:(NSInteger)rowIndex;
+
+/**
+ @brief Returns a recycled cell with the given identifier or nil if no such cell is available
+ */
+- (ICTableViewCell *)dequeueReusableCellWithIdentifier:(NSString *)identifier;
+
 @end
@@ -24,13 +24,27 @@
 #import "ICTableView.h"
 #import "ICTableViewCell.h"
 
+@interface ICTableView (Private)
+- (void)updateVisibleRows;
+- (void)layoutCell:(ICTableViewCell *)cell forRowAtIndex:(NSInteger)rowIndex;
+- (void)enqueueReusableCell:(ICTableViewCell *)cell;
+@end
+
 @implementation ICTableView
 
 @synthesize dataSource = _dataSource;
+@synthesize delegate = _delegate;
+@synthesize rowHeight = _rowHeight;
+@synthesize numberOfRows = _numberOfRows;
+@synthesize visibleRows = _visibleRows;
 
 - (id)initWithSize:(kmVec3)size
 {
     if ((self = [super initWithSize:size])) {
+        // Content size is derived from row heights, see reloadData
+        self.automaticallyCalculatesContentSize = NO;
+        _rowHeight = 30;
+        _visibleCells = [[NSMutableArray alloc] init];
         _reusableCells = [[NSMutableDictionary alloc] initWithCapacity:1];
     }
     return self;
@@ -38,9 +52,14 @@
 
 - (void)dealloc
 {
+    [_visibleCells release];
+    _visibleCells = nil;
     [_reusableCells release];
     _reusableCells = nil;
     
+    if (_rowOffsets)
+        free(_rowOffsets);
+    
     [super dealloc];
 }
 
@@ -50,23 +69,184 @@
     [self reloadData]; 
 }
 
+- (void)setDelegate:(id<ICTableViewDelegate>)delegate
+{
+    _delegate = delegate;
+    [self reloadData];
+}
+
+- (void)setRowHeight:(float)rowHeight
+{
+    _rowHeight = rowHeight;
+    [self reloadData];
+}
+
+- (void)setSize:(kmVec3)size
+{
+    [super setSize:size];
+    
+    // Called by super class initializers before the row offsets have been set up
+    if (_rowOffsets) {
+        [self setContentSize:kmVec3Make(_size.width, _rowOffsets[_numberOfRows], 0)];
+        [self setContentOffset:_contentOffset];
+        for (NSUInteger i=0; i<[_visibleCells count]; i++) {
+            [self layoutCell:[_visibleCells objectAtIndex:i]
+               forRowAtIndex:_visibleRows.location + i];
+        }
+    }
+}
+
+- (void)setContentOffset:(kmVec3)contentOffset
+{
+    [super setContentOffset:contentOffset];
+    [self updateVisibleRows];
+}
+
 - (ICTableViewCell *)dequeueReusableCellWithIdentifier:(NSString *)identifier
 {
-    return nil;
+    NSMutableArray *pool = [_reusableCells objectForKey:identifier];
+    ICTableViewCell *cell = [[[pool lastObject] retain] autorelease];
+    if (cell) {
+        [pool removeLastObject];
+        [cell prepareForReuse];
+    }
+    return cell;
 }
 
 - (void)reloadData
 {
-    if (_dataSource) {
-        NSInteger numRows = [_dataSource numberOfRowsInTableView:self];
-        for (NSInteger i=0; i<numRows; i++) {
-            ICTableViewCell *cell = [_dataSource tableView:self cellForRowAtIndex:i];
+    for (ICTableViewCell *cell in _visibleCells) {
+        [self enqueueReusableCell:cell];
+    }
+    [_visibleCells removeAllObjects];
+    _visibleRows = NSMakeRange(0, 0);
+    
+    _numberOfRows = _dataSource ? [_dataSource numberOfRowsInTableView:self] : 0;
+    
+    // Row offsets are stored as running sums of row heights, the last element being the
+    // total height of all rows
+    _rowOffsets = realloc(_rowOffsets, sizeof(float) * (_numberOfRows + 1));
+    BOOL variableRowHeights = [_delegate respondsToSelector:@selector(tableView:heightForRowAtIndex:)];
+    _rowOffsets[0] = 0;
+    for (NSInteger i=0; i<_numberOfRows; i++) {
+        float height = variableRowHeights ? [_delegate tableView:self heightForRowAtIndex:i] : _rowHeight;
+        _rowOffsets[i+1] = _rowOffsets[i] + height;
+    }
+    
+    [self setContentSize:kmVec3Make(_size.width, _rowOffsets[_numberOfRows], 0)];
+    
+    // Clamps the current offset to the new content size and loads visible rows
+    [self setContentOffset:_contentOffset];
+    [self setNeedsDisplay];
+}
+
+- (float)offsetForRowAtIndex:(NSInteger)rowIndex
+{
+    NSAssert(rowIndex >= 0 && rowIndex < _numberOfRows, @"Row index out of bounds");
+    return _rowOffsets[rowIndex];
+}
+
+- (float)heightForRowAtIndex:(NSInteger)rowIndex
+{
+    NSAssert(rowIndex >= 0 && rowIndex < _numberOfRows, @"Row index out of bounds");
+    return _rowOffsets[rowIndex+1] - _rowOffsets[rowIndex];
+}
+
+- (NSInteger)indexOfRowAtOffset:(float)offset
+{
+    if (!_numberOfRows)
+        return NSNotFound;
+    
+    // Find the last row starting at or before the given offset
+    NSInteger low = 0, high = _numberOfRows - 1;
+    while (low < high) {
+        NSInteger mid = low + (high - low + 1) / 2;
+        if (_rowOffsets[mid] <= offset)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    return low;
+}
+
+- (NSArray *)visibleCells
+{
+    return [[_visibleCells copy] autorelease];
+}
+
+- (ICTableViewCell *)cellForRowAtIndex:(NSInteger)rowIndex
+{
+    if (rowIndex < 0 || !NSLocationInRange(rowIndex, _visibleRows))
+        return nil;
+    return [_visibleCells objectAtIndex:rowIndex - _visibleRows.location];
+}
+
+@end
+
+
+@implementation ICTableView (Private)
+
+- (void)updateVisibleRows
+{
+    NSRange rows = NSMakeRange(0, 0);
+    if (_dataSource && _numberOfRows) {
+        float top = -_contentOffset.y;
+        float bottom = top + _size.height;
+        NSInteger first = [self indexOfRowAtOffset:top];
+        NSInteger last = [self indexOfRowAtOffset:bottom];
+        // A row starting exactly at the bottom edge is not visible
+        if (last > first && _rowOffsets[last] >= bottom)
+            last--;
+        rows = NSMakeRange(first, last - first + 1);
+    }
+    
+    if (NSEqualRanges(rows, _visibleRows))
+        return;
+    
+    // Recycle cells scrolled out of view first, so that the data source may reuse them
+    // for rows scrolled into view
+    NSMutableArray *cells = [NSMutableArray arrayWithCapacity:rows.length];
+    for (NSUInteger i=0; i<[_visibleCells count]; i++) {
+        if (!NSLocationInRange(_visibleRows.location + i, rows))
+            [self enqueueReusableCell:[_visibleCells objectAtIndex:i]];
+    }
+    
+    for (NSUInteger row=rows.location; row<NSMaxRange(rows); row++) {
+        ICTableViewCell *cell;
+        if (NSLocationInRange(row, _visibleRows)) {
+            cell = [_visibleCells objectAtIndex:row - _visibleRows.location];
+        } else {
+            cell = [_dataSource tableView:self cellForRowAtIndex:row];
+            NSAssert(cell != nil, @"Data source must return a cell for each row");
             [self addChild:cell];
-            [cell setPositionY:i * cell.size.height];
-            [cell setSize:kmVec3Make(self.size.width, cell.size.height, 0)];
+            [self layoutCell:cell forRowAtIndex:row];
+        }
+        [cells addObject:cell];
+    }
+    
+    [_visibleCells setArray:cells];
+    _visibleRows = rows;
+    [self setNeedsDisplay];
+}
+
+- (void)layoutCell:(ICTableViewCell *)cell forRowAtIndex:(NSInteger)rowIndex
+{
+    [cell setPositionY:_rowOffsets[rowIndex]];
+    [cell setSize:kmVec3Make(_size.width, _rowOffsets[rowIndex+1] - _rowOffsets[rowIndex], 0)];
+}
+
+- (void)enqueueReusableCell:(ICTableViewCell *)cell
+{
+    NSString *identifier = cell.identifier;
+    if (identifier) {
+        NSMutableArray *pool = [_reusableCells objectForKey:identifier];
+        if (!pool) {
+            pool = [NSMutableArray array];
+            [_reusableCells setObject:pool forKey:identifier];
         }
-        [self setNeedsDisplay];
+        [pool addObject:cell];
     }
+    [self removeChild:cell];
 }
 
 @end
@@ -45,4 +45,13 @@
 
 - (id)initWithIdentifier:(NSString *)identifier;
 
+/**
+ @brief Called by ICTableView before the receiver is returned from
+ ICTableView::dequeueReusableCellWithIdentifier:
+ 
+ The default implementation deselects the cell. Subclasses overriding this method must call
+ the super class implementation.
+ */
+- (void)prepareForReuse;
+
 @end
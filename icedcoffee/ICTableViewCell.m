@@ -70,6 +70,11 @@
     [self.label centerNodeVertically];    
 }
 
+- (void)prepareForReuse
+{
+    self.selected = NO;
+}
+
 - (void)setSelected:(BOOL)selected
 {
     if (_selected != selected) {
@@ -26,12 +26,27 @@
 @class ICTableView;
 @class ICTableViewCell;
 
+/**
+ @brief Defines a protocol for table view data sources
+ 
+ The ICTableViewDataSource protocol declares methods that must be implemented by data sources
+ of ICTableView objects.
+ */
 @protocol ICTableViewDataSource <NSObject>
 
 @required
 
+/**
+ @brief Returns the number of rows of the given table view
+ */
 - (NSInteger)numberOfRowsInTableView:(ICTableView *)tableView;
 
+/**
+ @brief Returns a cell for the row at the given index
+ 
+ This method is called whenever a row becomes visible. Implementations should obtain recycled
+ cells using ICTableView::dequeueReusableCellWithIdentifier: before creating new ones.
+ */
 - (ICTableViewCell *)tableView:(ICTableView *)tableView cellForRowAtIndex:(NSInteger)rowIndex;
 
 @end
@@ -28,7 +28,7 @@
 #import "icUtils.h"
 
 @interface ICTextFrame ()
-- (void)updateFrame;
+- (void)updateFrameWithPreviousAttributedString:(NSAttributedString *)previousAttributedString;
 @end
 
 @implementation ICTextFrame
@@ -82,13 +82,36 @@
 
 - (void)setAttributedString:(NSAttributedString *)attributedString
 {
-    [_attributedString release];
+    NSAttributedString *previousAttributedString = _attributedString;
     _attributedString = [attributedString copy];
-    [self updateFrame];
+    [self updateFrameWithPreviousAttributedString:previousAttributedString];
+    [previousAttributedString release];
 }
 
-- (void)updateFrame
+// Typesets the receiver's attributed string, reusing the lines of the previous layout whose text
+// and glyph layout have not changed, so that their glyph runs and buffers need not be rebuilt
+- (void)updateFrameWithPreviousAttributedString:(NSAttributedString *)previousAttributedString
 {
+    // Determine the range of the string that has changed since the previous layout: lines
+    // contained in the common prefix keep their string range, lines contained in the common
+    // suffix are shifted by the difference in length
+    NSUInteger previousLength = [previousAttributedString length];
+    NSUInteger length = [self.attributedString length];
+    NSUInteger prefixLength = 0, suffixLength = 0;
+    NSMutableDictionary *previousLines = nil;
+    if (previousAttributedString && self.attributedString && [self.lines count]) {
+        prefixLength = icAttributedStringsCommonPrefixLength(previousAttributedString,
+                                                             self.attributedString);
+        suffixLength = icAttributedStringsCommonSuffixLength(previousAttributedString,
+                                                             self.attributedString,
+                                                             MIN(previousLength, length) - prefixLength);
+        previousLines = [NSMutableDictionary dictionaryWithCapacity:[self.lines count]];
+        for (ICTextLine *line in self.lines) {
+            [previousLines setObject:line
+                              forKey:[NSNumber numberWithUnsignedInteger:line.stringRange.location]];
+        }
+    }
+    
     [self removeAllChildren];
     
     CGRect frameRect = CGRectMake(ICFontPointsToPixels(self.origin.x),
@@ -112,13 +135,35 @@
         CTLineRef line = (CTLineRef)CFArrayGetValueAtIndex(lines, i);
         CFRange cfStringRange = CTLineGetStringRange(line);
         NSRange stringRange = NSMakeRange(cfStringRange.location, cfStringRange.length);
-        NSAttributedString *attSubString = [self.attributedString attributedSubstringFromRange:stringRange];
-        ICTextLine *textLine = [[ICTextLine alloc] initWithCoreTextLine:line
-                                                     icAttributedString:attSubString
-                                                            stringRange:stringRange];
-        textLine.userInteractionEnabled = self.userInteractionEnabled;
         CGPoint origin = origins[i];
         origin.x = ICFontPixelsToPoints(origin.x);
+        
+        // Reuse the previous line covering the same text if CoreText laid it out identically
+        ICTextLine *textLine = nil;
+        NSNumber *previousLocation = nil;
+        if (NSMaxRange(stringRange) <= prefixLength) {
+            previousLocation = [NSNumber numberWithUnsignedInteger:stringRange.location];
+        } else if (stringRange.location >= length - suffixLength) {
+            previousLocation = [NSNumber numberWithUnsignedInteger:
+                                stringRange.location + previousLength - length];
+        }
+        if (previousLocation) {
+            ICTextLine *previousLine = [previousLines objectForKey:previousLocation];
+            if (previousLine && previousLine.stringRange.length == stringRange.length &&
+                previousLine.position.x == origin.x &&
+                [previousLine adoptCoreTextLine:line stringRange:stringRange]) {
+                textLine = [previousLine retain];
+            }
+        }
+        
+        if (!textLine) {
+            NSAttributedString *attSubString = [self.attributedString attributedSubstringFromRange:stringRange];
+            textLine = [[ICTextLine alloc] initWithCoreTextLine:line
+                                             icAttributedString:attSubString
+                                                    stringRange:stringRange];
+            textLine.userInteractionEnabled = self.userInteractionEnabled;
+        }
+        
         origin.y = roundf(ICFontPixelsToPoints(origin.y)+[textLine ascent]);
         //NSLog(@"origin: %f", origin.y);
         [textLine setPositionX:origin.x];
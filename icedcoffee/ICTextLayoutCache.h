@@ -0,0 +1,140 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import <Foundation/Foundation.h>
+
+@class ICTextLayoutCacheEntry;
+
+/**
+ @brief Implements a bounded least recently used cache for text layout results
+ 
+ Measuring and typesetting text using CoreText is expensive, and user interfaces tend to lay
+ out identical strings repeatedly, e.g. the titles of reused table view cells. ICTextLayoutCache
+ stores layout results such as glyph run metrics (glyphs, positions and bounding boxes) and
+ label measurements keyed by their attributed string, which includes font, paragraph style and
+ all other attributes, a layout kind string identifying the type of result, and the current font
+ content scale factor.
+ 
+ The shared layout cache is used by ICGlyphRun and ICLabel. It holds up to
+ ICTextLayoutCache::capacity results, evicting the least recently used result when full.
+ Cached results must be immutable, as they are shared by all clients retrieving them. The cache
+ counts hits and misses, which may be used to tune its capacity.
+ 
+ ICTextLayoutCache is thread-safe.
+ */
+@interface ICTextLayoutCache : NSObject {
+@protected
+    NSMutableDictionary *_entries;
+    ICTextLayoutCacheEntry *_mostRecentlyUsed;
+    ICTextLayoutCacheEntry *_leastRecentlyUsed;
+    NSUInteger _capacity;
+    NSUInteger _hits;
+    NSUInteger _misses;
+    NSUInteger _evictions;
+}
+
+#pragma mark - Retrieving the Shared Layout Cache
+/** @name Retrieving the Shared Layout Cache */
+
+/**
+ @brief Returns the globally shared text layout cache
+ 
+ The shared cache is created with a capacity of #IC_DEFAULT_TEXT_LAYOUT_CACHE_CAPACITY results.
+ */
++ (id)sharedTextLayoutCache;
+
+/**
+ @brief Initializes the receiver with the given capacity
+ */
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+
+#pragma mark - Caching Layout Results
+/** @name Caching Layout Results */
+
+/**
+ @brief Returns the cached layout result of the given kind for the given attributed string
+ 
+ @param attributedString The attributed string the result was computed for
+ @param kind A string identifying the type of layout result, e.g. ``@"ICGlyphRunMetrics"``
+ 
+ @return Returns the cached result or ``nil`` if no result is cached. Successful lookups mark
+ the result as most recently used.
+ */
+- (id)resultForAttributedString:(NSAttributedString *)attributedString kind:(NSString *)kind;
+
+/**
+ @brief Caches the given immutable layout result of the given kind for the given attributed string
+ 
+ If the receiver is full, the least recently used result is evicted.
+ */
+- (void)setResult:(id)result forAttributedString:(NSAttributedString *)attributedString kind:(NSString *)kind;
+
+/**
+ @brief Removes all cached results from the receiver
+ */
+- (void)removeAllResults;
+
+/**
+ @brief The maximum number of results cached by the receiver
+ 
+ Reducing the capacity evicts least recently used results as required. Setting the capacity to
+ zero disables caching.
+ */
+@property (nonatomic, assign, setter=setCapacity:) NSUInteger capacity;
+
+/**
+ @brief The number of results currently cached by the receiver
+ */
+- (NSUInteger)count;
+
+
+#pragma mark - Tuning the Cache
+/** @name Tuning the Cache */
+
+/**
+ @brief The number of successful lookups since the receiver's statistics were reset
+ */
+@property (nonatomic, readonly) NSUInteger hits;
+
+/**
+ @brief The number of failed lookups since the receiver's statistics were reset
+ */
+@property (nonatomic, readonly) NSUInteger misses;
+
+/**
+ @brief The number of results evicted since the receiver's statistics were reset
+ */
+@property (nonatomic, readonly) NSUInteger evictions;
+
+/**
+ @brief The ratio of successful lookups to all lookups, or zero if there were no lookups
+ */
+- (float)hitRate;
+
+/**
+ @brief Resets the receiver's hit, miss and eviction counters
+ */
+- (void)resetStatistics;
+
+@end
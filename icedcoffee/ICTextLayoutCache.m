@@ -0,0 +1,304 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import "ICTextLayoutCache.h"
+#import "icFontConfig.h"
+#import "icFontDefs.h"
+#import "icMacros.h"
+#import "ICOpenGLContext.h"
+
+
+//
+// ICTextLayoutKey
+//
+
+@interface ICTextLayoutKey : NSObject <NSCopying> {
+@protected
+    NSAttributedString *_attributedString;
+    NSString *_kind;
+    float _contentScaleFactor;
+    NSUInteger _hash;
+}
+
+- (id)initWithAttributedString:(NSAttributedString *)attributedString kind:(NSString *)kind;
+
+@end
+
+@implementation ICTextLayoutKey
+
+- (id)initWithAttributedString:(NSAttributedString *)attributedString kind:(NSString *)kind
+{
+    if ((self = [super init])) {
+        _attributedString = [attributedString copy];
+        _kind = [kind copy];
+        // Layout results are measured in points, but computed in pixels
+        _contentScaleFactor = ICFontContentScaleFactor();
+        _hash = [[_attributedString string] hash] ^ [_kind hash] ^ (NSUInteger)_contentScaleFactor;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_attributedString release];
+    [_kind release];
+    [super dealloc];
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // Keys are immutable
+    return [self retain];
+}
+
+- (NSUInteger)hash
+{
+    return _hash;
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (![object isKindOfClass:[ICTextLayoutKey class]])
+        return NO;
+    ICTextLayoutKey *key = (ICTextLayoutKey *)object;
+    return _hash == key->_hash &&
+           _contentScaleFactor == key->_contentScaleFactor &&
+           [_kind isEqualToString:key->_kind] &&
+           [_attributedString isEqualToAttributedString:key->_attributedString];
+}
+
+@end
+
+
+//
+// ICTextLayoutCacheEntry
+//
+
+// Entries form a doubly linked list ordered from most to least recently used
+@interface ICTextLayoutCacheEntry : NSObject {
+@public
+    ICTextLayoutKey *_key;
+    id _result;
+    ICTextLayoutCacheEntry *_previous; // weak
+    ICTextLayoutCacheEntry *_next; // weak
+}
+@end
+
+@implementation ICTextLayoutCacheEntry
+
+- (void)dealloc
+{
+    [_key release];
+    [_result release];
+    [super dealloc];
+}
+
+@end
+
+
+//
+// ICTextLayoutCache
+//
+
+ICTextLayoutCache *g_sharedTextLayoutCache = nil;
+
+@interface ICTextLayoutCache (Private)
+- (void)unlinkEntry:(ICTextLayoutCacheEntry *)entry;
+- (void)linkEntryAsMostRecentlyUsed:(ICTextLayoutCacheEntry *)entry;
+- (void)evictEntriesToCount:(NSUInteger)count;
+@end
+
+@implementation ICTextLayoutCache
+
+@synthesize capacity = _capacity;
+@synthesize hits = _hits;
+@synthesize misses = _misses;
+@synthesize evictions = _evictions;
+
++ (id)sharedTextLayoutCache
+{
+    @synchronized (self) {
+        if (!g_sharedTextLayoutCache) {
+            g_sharedTextLayoutCache = [[[self class] alloc]
+                                       initWithCapacity:IC_DEFAULT_TEXT_LAYOUT_CACHE_CAPACITY];
+        }
+    }
+    return g_sharedTextLayoutCache;
+}
+
+- (id)init
+{
+    return [self initWithCapacity:IC_DEFAULT_TEXT_LAYOUT_CACHE_CAPACITY];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity
+{
+    if ((self = [super init])) {
+        _entries = [[NSMutableDictionary alloc] initWithCapacity:capacity];
+        _capacity = capacity;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_entries release];
+    [super dealloc];
+}
+
+- (id)resultForAttributedString:(NSAttributedString *)attributedString kind:(NSString *)kind
+{
+    if (!attributedString)
+        return nil;
+    
+    ICTextLayoutKey *key = [[ICTextLayoutKey alloc] initWithAttributedString:attributedString
+                                                                        kind:kind];
+    id result = nil;
+    @synchronized (self) {
+        ICTextLayoutCacheEntry *entry = [_entries objectForKey:key];
+        if (entry) {
+            [self unlinkEntry:entry];
+            [self linkEntryAsMostRecentlyUsed:entry];
+            result = [[entry->_result retain] autorelease];
+            _hits++;
+        } else {
+            _misses++;
+        }
+    }
+    [key release];
+    return result;
+}
+
+- (void)setResult:(id)result forAttributedString:(NSAttributedString *)attributedString kind:(NSString *)kind
+{
+    if (!result || !attributedString)
+        return;
+    
+    ICTextLayoutKey *key = [[ICTextLayoutKey alloc] initWithAttributedString:attributedString
+                                                                        kind:kind];
+    @synchronized (self) {
+        if (_capacity) {
+            ICTextLayoutCacheEntry *entry = [_entries objectForKey:key];
+            if (entry) {
+                [self unlinkEntry:entry];
+                [entry->_result release];
+                entry->_result = [result retain];
+            } else {
+                [self evictEntriesToCount:_capacity - 1];
+                entry = [[[ICTextLayoutCacheEntry alloc] init] autorelease];
+                entry->_key = [key retain];
+                entry->_result = [result retain];
+                [_entries setObject:entry forKey:key];
+            }
+            [self linkEntryAsMostRecentlyUsed:entry];
+        }
+    }
+    [key release];
+}
+
+- (void)removeAllResults
+{
+    @synchronized (self) {
+        [_entries removeAllObjects];
+        _mostRecentlyUsed = _leastRecentlyUsed = nil;
+    }
+}
+
+- (void)setCapacity:(NSUInteger)capacity
+{
+    @synchronized (self) {
+        _capacity = capacity;
+        [self evictEntriesToCount:capacity];
+    }
+}
+
+- (NSUInteger)count
+{
+    @synchronized (self) {
+        return [_entries count];
+    }
+}
+
+- (float)hitRate
+{
+    @synchronized (self) {
+        NSUInteger lookups = _hits + _misses;
+        return lookups ? (float)_hits / lookups : 0;
+    }
+}
+
+- (void)resetStatistics
+{
+    @synchronized (self) {
+        _hits = _misses = _evictions = 0;
+    }
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ = %08X | count = %lu | capacity = %lu | hits = %lu | misses = %lu | evictions = %lu | hitRate = %0.02f>",
+            [self class], (uint)self, (unsigned long)[self count], (unsigned long)self.capacity,
+            (unsigned long)self.hits, (unsigned long)self.misses, (unsigned long)self.evictions,
+            [self hitRate]];
+}
+
+@end
+
+
+@implementation ICTextLayoutCache (Private)
+
+- (void)unlinkEntry:(ICTextLayoutCacheEntry *)entry
+{
+    if (entry->_previous)
+        entry->_previous->_next = entry->_next;
+    else
+        _mostRecentlyUsed = entry->_next;
+    if (entry->_next)
+        entry->_next->_previous = entry->_previous;
+    else
+        _leastRecentlyUsed = entry->_previous;
+    entry->_previous = entry->_next = nil;
+}
+
+- (void)linkEntryAsMostRecentlyUsed:(ICTextLayoutCacheEntry *)entry
+{
+    entry->_next = _mostRecentlyUsed;
+    if (_mostRecentlyUsed)
+        _mostRecentlyUsed->_previous = entry;
+    _mostRecentlyUsed = entry;
+    if (!_leastRecentlyUsed)
+        _leastRecentlyUsed = entry;
+}
+
+- (void)evictEntriesToCount:(NSUInteger)count
+{
+    while ([_entries count] > count && _leastRecentlyUsed) {
+        ICTextLayoutCacheEntry *entry = _leastRecentlyUsed;
+        [self unlinkEntry:entry];
+        // Entries are owned by the dictionary
+        [_entries removeObjectForKey:entry->_key];
+        _evictions++;
+    }
+}
+
+@end
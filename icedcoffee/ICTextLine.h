@@ -91,6 +91,18 @@
                stringRange:(NSRange)stringRange;
 
 
+/**
+ @brief Replaces the receiver's CoreText line and string range without rebuilding its glyph runs
+ 
+ ICTextFrame uses this method to reuse lines whose text has not changed when its attributed string
+ is modified. The given line is adopted only if it has the same glyph layout as the receiver's
+ current CoreText line, so that the receiver's glyph runs and their buffers remain valid.
+ 
+ @return Returns ``YES`` if the receiver has adopted the given line, otherwise ``NO``.
+ */
+- (BOOL)adoptCoreTextLine:(CTLineRef)ctLine stringRange:(NSRange)stringRange;
+
+
 /** @name Managing the Line's String */
 
 /**
@@ -93,6 +93,17 @@
     return [self initWithAttributedString:icAttString];
 }
 
+- (BOOL)adoptCoreTextLine:(CTLineRef)ctLine stringRange:(NSRange)stringRange
+{
+    if (!self.ctLine || !ctLine || !icCTLinesHaveEqualGlyphLayout(self.ctLine, ctLine))
+        return NO;
+    
+    // Glyph runs retain the CoreText runs of the previous line, so they remain valid
+    self.ctLine = ctLine;
+    _stringRange = stringRange;
+    return YES;
+}
+
 - (void)dealloc
 {
     self.ctLine = nil;
@@ -69,6 +69,7 @@ Copyright (C) 2008 Apple Inc. All Rights Reserved.
 #import <Availability.h>
 
 #import "Platforms/icGL.h"
+#import "icGLState.h"
 #import "Platforms/icNS.h"
 
 
@@ -159,7 +160,7 @@ static ICPixelFormat defaultAlphaPixel_format = ICPixelFormatDefault;
     
     if (!_name)
         glGenTextures(1, &_name);    
-    glBindTexture(GL_TEXTURE_2D, _name);
+    icGLBindTexture2D(_name);
     
     [self setAntiAliasTexParameters];
     
@@ -258,8 +259,8 @@ static ICPixelFormat defaultAlphaPixel_format = ICPixelFormatDefault;
             CFRelease(attrs);
             CFRelease(empty);
             
-            glBindTexture(CVOpenGLESTextureGetTarget(_cvTexture),
-                          CVOpenGLESTextureGetName(_cvTexture));
+            // Texture was created for GL_TEXTURE_2D above
+            icGLBindTexture2D(CVOpenGLESTextureGetName(_cvTexture));
             
             _name = CVOpenGLESTextureGetName(_cvTexture);
             _format = ICPixelFormatRGBA8888;
@@ -466,6 +467,8 @@ static ICPixelFormat defaultAlphaPixel_format = ICPixelFormatDefault;
         if (_cvTexture) {
             CFRelease(_cvTexture);
             _cvTexture = NULL;
+            // The texture cache deletes the texture's name without notifying icGLState
+            icGLPurgeStateCache();
         }
         
         CVOpenGLESTextureCacheFlush(_cvTextureCache, 0);
@@ -474,7 +477,7 @@ static ICPixelFormat defaultAlphaPixel_format = ICPixelFormatDefault;
     } else {
 #endif
         // Normal texture
-        glDeleteTextures(1, &_name);
+        icGLDeleteTexture(_name);
         _name = 0;
 #ifdef __IC_PLATFORM_IOS
     }
@@ -783,7 +786,7 @@ static ICPixelFormat defaultAlphaPixel_format = ICPixelFormatDefault;
     NSUInteger width = [self pixelsWide];
     NSUInteger height = [self pixelsHigh];
 	NSAssert( width == icNextPOT((unsigned int)width) && height == icNextPOT((unsigned int)height), @"Mipmap texture only works in POT textures");
-	glBindTexture( GL_TEXTURE_2D, _name );
+	icGLBindTexture2D(_name);
 	glGenerateMipmap(GL_TEXTURE_2D);
 }
 
@@ -794,7 +797,7 @@ static ICPixelFormat defaultAlphaPixel_format = ICPixelFormatDefault;
 	NSAssert( (width == icNextPOT((unsigned int)width) && height == icNextPOT((unsigned int)height)) ||
 			 (texParams->wrapS == GL_CLAMP_TO_EDGE && texParams->wrapT == GL_CLAMP_TO_EDGE),
 			 @"GL_CLAMP_TO_EDGE should be used in NPOT textures");
-	glBindTexture(GL_TEXTURE_2D, self.name);
+	icGLBindTexture2D(self.name);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texParams->minFilter);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texParams->magFilter);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texParams->wrapS);
@@ -25,6 +25,7 @@
 #import "ICScene.h"
 #import "ICUIScene.h"
 #import "ICSprite.h"
+#import "icGLState.h"
 #import "ICNodeVisitorPicking.h"
 
 @implementation ICView
@@ -303,32 +304,32 @@
             glClearStencil(0);
             glClear(GL_STENCIL_BUFFER_BIT);
             
-            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-            glDepthMask(GL_FALSE);
-            glEnable(GL_STENCIL_TEST);
+            icGLColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            icGLDepthMask(GL_FALSE);
+            icGLEnable(IC_GL_STENCIL_TEST);
             
-            glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-            glStencilFunc(GL_ALWAYS, 1, 1);
+            icGLStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+            icGLStencilFunc(GL_ALWAYS, 1, 1);
             
             // Draw solid sprite in rectangular region of the view to stencil buffer
             [_clippingMask drawWithVisitor:visitor];
             
-            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-            glDepthMask(GL_TRUE);
-            glStencilFunc(GL_EQUAL, 1, 1);
+            icGLColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            icGLDepthMask(GL_TRUE);
+            icGLStencilFunc(GL_EQUAL, 1, 1);
         }
         
         // FIXME: this can be a problem when doing depth testing
         if ([visitor isKindOfClass:[ICNodeVisitorPicking class]]) {
-            BOOL depthTestingEnabled = glIsEnabled(GL_DEPTH_TEST);
+            BOOL depthTestingEnabled = icGLIsEnabled(IC_GL_DEPTH_TEST);
             if (depthTestingEnabled) {
-                glDisable(GL_DEPTH_TEST);
+                icGLDisable(IC_GL_DEPTH_TEST);
             }
             // Draw view as solid sprite for picking, so the view itself reacts to
             // user interaction events
             [_clippingMask drawWithVisitor:visitor];
             if (depthTestingEnabled) {
-                glEnable(GL_DEPTH_TEST);
+                icGLEnable(IC_GL_DEPTH_TEST);
             }
         }
     }
@@ -337,7 +338,7 @@
 - (void)childrenDidDrawWithVisitor:(ICNodeVisitor *)visitor
 {
     if (_clipsChildren && !_backing) {
-        glDisable(GL_STENCIL_TEST);
+        icGLDisable(IC_GL_STENCIL_TEST);
     }    
 }
 
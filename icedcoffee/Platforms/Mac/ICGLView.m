@@ -38,6 +38,7 @@
 #import "ICGLView.h"
 #import "ICHostViewController.h"
 #import "ICNode.h"
+#import "icConfig.h"
 
 
 #define DISPATCH_EVENT(eventMethod) \
@@ -77,6 +78,9 @@
         // https://developer.apple.com/library/mac/qa/qa1734/_index.html
         // https://developer.apple.com/library/mac/technotes/tn2229/_index.html
         NSOpenGLPFAAllowOfflineRenderers, // needed for running on integrated GPU on Macs with multiple GPUs
+#if IC_ENABLE_DAMAGE_TRACKING
+        NSOpenGLPFABackingStore, // preserve contents so that damaged regions can be redrawn only
+#endif
 		0
     };
     
@@ -50,6 +50,7 @@
 #import "ICRenderTexture.h"
 #import "icGL.h"
 #import "ICScheduler.h"
+#import "ICProfiler.h"
 #import "icConfig.h"
 
 
@@ -313,6 +314,8 @@ static CVReturn MyDisplayLinkCallback(CVDisplayLinkRef displayLink,
         }        
     }
     
+    [_profiler endFrame];
+    
     CGLUnlockContext([self.nativeOpenGLContext CGLContextObj]);
 }
 
@@ -360,6 +363,15 @@ static CVReturn MyDisplayLinkCallback(CVDisplayLinkRef displayLink,
     return [_mouseEventDispatcher updatesEnterExitEventsContinuously];
 }
 
+- (BOOL)preservesFramebufferContents
+{
+    GLint backingStore = 0;
+    [[(ICGLView *)self.view pixelFormat] getValues:&backingStore
+                                      forAttribute:NSOpenGLPFABackingStore
+                                  forVirtualScreen:0];
+    return backingStore != 0;
+}
+
 // Issue #3: Interface Builder integration
 - (BOOL)isViewLoaded
 {
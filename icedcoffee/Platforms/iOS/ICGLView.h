@@ -138,6 +138,9 @@ Copyright (C) 2008 Apple Inc. All Rights Reserved.
 
 @property(nonatomic,readwrite) BOOL multiSampling;
 
+/** whether the contents of the render buffer are retained after presenting */
+@property(nonatomic,readonly) BOOL preserveBackbuffer;
+
 
 #pragma mark - Accessing the ES 2 Renderer
 /** @name Accessing the ES 2 Renderer */
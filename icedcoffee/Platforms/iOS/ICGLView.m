@@ -91,6 +91,7 @@ Copyright (C) 2008 Apple Inc. All Rights Reserved.
 //@synthesize touchDelegate=touchDelegate_;
 @synthesize context=context_;
 @synthesize multiSampling=multiSampling_;
+@synthesize preserveBackbuffer=preserveBackbuffer_;
 
 @synthesize hostViewController = _hostViewController;
 @synthesize renderer = renderer_;
@@ -57,6 +57,7 @@
 #import "icGL.h"
 #import "ICESRenderer.h"
 #import "ICScheduler.h"
+#import "ICProfiler.h"
 #import "icConfig.h"
 
 #ifdef IC_ENABLE_DEBUG_HOSTVIEWCONTROLLER
@@ -216,6 +217,8 @@
         [openGLview swapBuffers];
     }
     
+    [_profiler endFrame];
+    
     [_glContextLock unlock];
     
     if (_frameUpdateMode == ICFrameUpdateModeOnDemand) {
@@ -223,6 +226,13 @@
     }
 }
 
+- (BOOL)preservesFramebufferContents
+{
+    // Multisampled framebuffers are resolved into the render buffer, discarding their contents
+    ICGLView *openGLview = (ICGLView *)self.view;
+    return openGLview.preserveBackbuffer && !openGLview.multiSampling;
+}
+
 // point is in UIView's coordinate system
 - (NSArray *)hitTest:(CGPoint)point deferredReadback:(BOOL)deferredReadback
 {
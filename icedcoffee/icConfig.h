@@ -35,11 +35,25 @@
 
 // General Configuration
 
-// GL state cache (incomplete)
 #ifndef IC_ENABLE_GL_STATE_CACHE
+/**
+ @brief Activate to let the icGL* functions in icGLState.h skip redundant GL state changes
+ 
+ Each ICOpenGLContext tracks its bound program, buffers, textures, enabled vertex attributes
+ and server side states. If disabled, all icGL* functions forward directly to OpenGL.
+ */
 #define IC_ENABLE_GL_STATE_CACHE 1
 #endif
 
+#ifndef IC_ENABLE_VERTEX_ARRAY_OBJECTS
+/**
+ @brief Activate to let nodes record their vertex attribute setup in vertex array objects
+ 
+ Vertex array objects are only used if ICConfiguration::supportsVertexArrayObject returns ``YES``.
+ */
+#define IC_ENABLE_VERTEX_ARRAY_OBJECTS 1
+#endif
+
 
 // Extensions
 
@@ -56,6 +70,93 @@
 
 // Optimizations
 
+#ifndef IC_ENABLE_SPRITE_BATCHING
+/**
+ @brief Activate to let ICNodeVisitorDrawing merge consecutive sprite draws into batches
+
+ If enabled, the drawing visitor collects consecutive ICSprite nodes sharing the same shader
+ program, textures and blend function in a streaming vertex buffer and draws them using a single
+ draw call. See ICNodeVisitorDrawing::batchesSprites.
+ */
+#define IC_ENABLE_SPRITE_BATCHING 1
+#endif
+
+#ifndef IC_SPRITE_BATCH_MAX_QUADS
+/**
+ @brief The maximum number of sprite quads drawn with a single batched draw call
+
+ Must not exceed 16384, as batched quads are indexed using unsigned short indices.
+ */
+#define IC_SPRITE_BATCH_MAX_QUADS 4096
+#endif
+
+#ifndef IC_MAX_TEXTURE_DIRTY_RECTS
+/**
+ @brief The maximum number of dirty rectangles tracked by ICMutableTexture2D
+ 
+ Further rectangles are merged with the closest dirty rectangle. See
+ ICMutableTexture2D::setDataDirtyInRect:.
+ */
+#define IC_MAX_TEXTURE_DIRTY_RECTS 16
+#endif
+
+#ifndef IC_ENABLE_DRAW_CULLING
+/**
+ @brief Activate to let ICNodeVisitorDrawing skip branches that are not visible
+ 
+ See ICNodeVisitorDrawing::cullsNodes and ICNode::drawsOutsideBounds.
+ */
+#define IC_ENABLE_DRAW_CULLING 1
+#endif
+
+#ifndef IC_ENABLE_DAMAGE_TRACKING
+/**
+ @brief Activate to let root scenes redraw only the regions of their nodes that have changed
+ 
+ Damaged regions are redrawn partially in ICFrameUpdateModeOnDemand only. If activated, ICGLView
+ requests a pixel format with a backing store on Mac OS X, so that the framebuffer's contents
+ are preserved between frames. See ICScene::tracksDamage.
+ */
+#define IC_ENABLE_DAMAGE_TRACKING 0
+#endif
+
+#ifndef IC_ENABLE_RENDER_COMMAND_RECORDING
+/**
+ @brief Activate to let ICNodeVisitorDrawing record sprites as render commands
+ 
+ If enabled, the drawing visitor records sprites in an ICRenderCommandBuffer and submits them
+ sorted by state instead of drawing them in the order of the scene graph. See
+ ICNodeVisitorDrawing::recordsCommands.
+ */
+#define IC_ENABLE_RENDER_COMMAND_RECORDING 0
+#endif
+
+#ifndef IC_ENABLE_TIMING_FUNCTION_LOOKUP_TABLES
+/**
+ @brief Activate to let animation timing functions bake lookup tables by default
+ 
+ See ICAnimationTimingFunction::interpolation.
+ */
+#define IC_ENABLE_TIMING_FUNCTION_LOOKUP_TABLES 1
+#endif
+
+#ifndef IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE
+/**
+ @brief The number of samples in lookup tables baked by animation timing functions
+ */
+#define IC_TIMING_FUNCTION_LOOKUP_TABLE_SIZE 256
+#endif
+
+#ifndef IC_MAX_SHARED_TIMING_FUNCTION_LOOKUP_TABLES
+/**
+ @brief The maximum number of lookup tables shared by animation timing functions
+ 
+ If exceeded, the least recently shared table is evicted. Timing functions keep their tables
+ after eviction.
+ */
+#define IC_MAX_SHARED_TIMING_FUNCTION_LOOKUP_TABLES 64
+#endif
+
 #ifdef __IC_PLATFORM_IOS
 
 #ifndef IC_ENABLE_CV_TEXTURE_CACHE
@@ -71,6 +172,30 @@
 
 // Logging and Debugging
 
+#ifndef IC_ENABLE_PROFILER
+/**
+ @brief Activate to compile profiler zones into the framework
+ 
+ Profilers are disabled at runtime by default, see ICProfiler::enabled. Deactivate to remove
+ all profiler zones from the framework at compile time.
+ */
+#define IC_ENABLE_PROFILER 1
+#endif
+
+#ifndef IC_PROFILER_FRAME_HISTORY
+/**
+ @brief The number of most recent frames whose timings are kept by ICProfiler
+ */
+#define IC_PROFILER_FRAME_HISTORY 300
+#endif
+
+#ifndef IC_PROFILER_MAX_EVENTS
+/**
+ @brief The number of most recent zones kept by ICProfiler for exporting traces
+ */
+#define IC_PROFILER_MAX_EVENTS 32768
+#endif
+
 #ifndef IC_DEBUG_ICNODE_PARENTS
 #define IC_DEBUG_ICNODE_PARENTS 0
 #endif
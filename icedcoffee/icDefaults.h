@@ -70,12 +70,15 @@
  */
 #define IC_DEFAULT_DRAWING_VISITOR ICNodeVisitorDrawing
 
-#import "ICNodeVisitorPicking.h"
+#import "ICNodeVisitorRayPicking.h"
 /**
  @def IC_DEFAULT_PICKING_VISITOR
  @brief The default picking visitor class
+ 
+ Defaults to ICNodeVisitorRayPicking, which performs hit tests on the CPU. Define this as
+ ICNodeVisitorPicking to use color-based picking for all nodes.
  */
-#define IC_DEFAULT_PICKING_VISITOR ICNodeVisitorPicking
+#define IC_DEFAULT_PICKING_VISITOR ICNodeVisitorRayPicking
 
 /** @} */
 
@@ -0,0 +1,181 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#include <math.h>
+#include "icEasing.h"
+
+
+// Inspired by
+// http://blog.greweb.fr/2012/02/bezier-curve-based-easing-functions-from-concept-to-implementation/
+
+static float icTermA(float u, float v)
+{
+    return 1.f - 3.f * v + 3.f * u;
+}
+
+static float icTermB(float u, float v)
+{
+    return 3.f * v - 6.f * u;
+}
+
+static float icTermC(float u)
+{
+    return 3.f * u;
+}
+
+static float icBezier(float t, float u, float v)
+{
+    return ((icTermA(u, v)*t + icTermB(u, v))*t + icTermC(u))*t;
+}
+
+static float icSlope(float t, float u, float v)
+{
+    return 3.f * icTermA(u, v)*t*t + 2.f * icTermB(u, v) * t + icTermC(u);
+}
+
+static float icTForX(float x, kmVec2 c0, kmVec2 c1)
+{
+    float t = x;
+    for (int i=0; i<8; i++) {
+        float slope = icSlope(t, c0.x, c1.x);
+        if (slope == 0.f)
+            return t;
+        float currentX = icBezier(t, c0.x, c1.x) - x;
+        t -= currentX / slope;
+    }
+    return t;
+}
+
+static float icTForXPrecise(float x, kmVec2 c0, kmVec2 c1)
+{
+    float t = x;
+    for (int i=0; i<8; i++) {
+        float currentX = icBezier(t, c0.x, c1.x) - x;
+        if (fabsf(currentX) < 1e-7f)
+            return t;
+        float slope = icSlope(t, c0.x, c1.x);
+        if (fabsf(slope) < 1e-6f)
+            break;
+        t -= currentX / slope;
+    }
+    
+    // x(t) is monotonic for control point x coordinates in [0,1]
+    float lo = 0.f, hi = 1.f;
+    t = x;
+    for (int i=0; i<32 && lo < hi; i++) {
+        float currentX = icBezier(t, c0.x, c1.x);
+        if (fabsf(currentX - x) < 1e-7f)
+            break;
+        if (currentX < x)
+            lo = t;
+        else
+            hi = t;
+        t = 0.5f * (lo + hi);
+    }
+    return t;
+}
+
+float icCubicBezierEvaluateIterative(float x, kmVec2 c0, kmVec2 c1)
+{
+    return icBezier(icTForX(x, c0, c1), c0.y, c1.y);
+}
+
+float icCubicBezierEvaluate(float x, kmVec2 c0, kmVec2 c1)
+{
+    if (x <= 0.f)
+        return 0.f;
+    if (x >= 1.f)
+        return 1.f;
+    return icBezier(icTForXPrecise(x, c0, c1), c0.y, c1.y);
+}
+
+void icEasingTableBakeCubicBezier(float *values, unsigned int count, kmVec2 c0, kmVec2 c1)
+{
+    for (unsigned int i=0; i<count; i++) {
+        values[i] = icCubicBezierEvaluate((float)i / (float)(count - 1), c0, c1);
+    }
+}
+
+// Fritsch-Carlson monotone tangents, in units of value change per sample
+void icEasingTableComputeTangents(float *tangents, const float *values, unsigned int count)
+{
+    if (count < 2) {
+        if (count)
+            tangents[0] = 0.f;
+        return;
+    }
+    
+    tangents[0] = values[1] - values[0];
+    tangents[count-1] = values[count-1] - values[count-2];
+    for (unsigned int i=1; i<count-1; i++) {
+        float d0 = values[i] - values[i-1];
+        float d1 = values[i+1] - values[i];
+        tangents[i] = d0 * d1 <= 0.f ? 0.f : 0.5f * (d0 + d1);
+    }
+    
+    for (unsigned int i=0; i<count-1; i++) {
+        float d = values[i+1] - values[i];
+        if (d == 0.f) {
+            tangents[i] = tangents[i+1] = 0.f;
+            continue;
+        }
+        float a = tangents[i] / d;
+        float b = tangents[i+1] / d;
+        float s = a * a + b * b;
+        if (s > 9.f) {
+            float tau = 3.f / sqrtf(s);
+            tangents[i] = tau * a * d;
+            tangents[i+1] = tau * b * d;
+        }
+    }
+}
+
+float icEasingTableLookupLinear(const float *values, unsigned int count, float x)
+{
+    float position = x * (float)(count - 1);
+    if (position <= 0.f)
+        return values[0];
+    unsigned int i = (unsigned int)position;
+    if (i >= count - 1)
+        return values[count-1];
+    float f = position - (float)i;
+    return values[i] + f * (values[i+1] - values[i]);
+}
+
+float icEasingTableLookupCubic(const float *values, const float *tangents,
+                               unsigned int count, float x)
+{
+    float position = x * (float)(count - 1);
+    if (position <= 0.f)
+        return values[0];
+    unsigned int i = (unsigned int)position;
+    if (i >= count - 1)
+        return values[count-1];
+    float f = position - (float)i;
+    float f2 = f * f;
+    float f3 = f2 * f;
+    return (2.f*f3 - 3.f*f2 + 1.f) * values[i] +
+           (f3 - 2.f*f2 + f) * tangents[i] +
+           (-2.f*f3 + 3.f*f2) * values[i+1] +
+           (f3 - f2) * tangents[i+1];
+}
@@ -0,0 +1,85 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#pragma once
+
+#include "kazmath/vec2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     @defgroup easing-functions Easing Functions
+     @{
+     */
+    
+    /**
+     @brief Evaluates the cubic bezier easing curve defined by (0,0), c0, c1 and (1,1) at x
+     using eight Newton iterations
+     
+     This is the fast but approximate solver used by ICAnimationTimingFunction when no lookup
+     table is used. It may converge slowly for control points producing steep curves.
+     */
+    float icCubicBezierEvaluateIterative(float x, kmVec2 c0, kmVec2 c1);
+    
+    /**
+     @brief Evaluates the cubic bezier easing curve defined by (0,0), c0, c1 and (1,1) at x
+     
+     Falls back to bisection if Newton's method does not converge, so the result is accurate
+     to single precision for all control points whose x coordinates are in range [0,1].
+     Used for baking lookup tables.
+     */
+    float icCubicBezierEvaluate(float x, kmVec2 c0, kmVec2 c1);
+    
+    /**
+     @brief Samples the cubic bezier easing curve at count uniformly spaced x coordinates
+     in range [0,1]
+     */
+    void icEasingTableBakeCubicBezier(float *values, unsigned int count, kmVec2 c0, kmVec2 c1);
+    
+    /**
+     @brief Computes tangents for cubic interpolation of the given samples
+     
+     Tangents are limited such that interpolation preserves monotonicity between samples,
+     so the interpolated curve never overshoots where the sampled curve does not.
+     */
+    void icEasingTableComputeTangents(float *tangents, const float *values, unsigned int count);
+    
+    /**
+     @brief Looks up x in range [0,1] in an easing table using linear interpolation
+     */
+    float icEasingTableLookupLinear(const float *values, unsigned int count, float x);
+    
+    /**
+     @brief Looks up x in range [0,1] in an easing table using cubic Hermite interpolation
+     with the given tangents
+     */
+    float icEasingTableLookupCubic(const float *values, const float *tangents,
+                                   unsigned int count, float x);
+    
+    /** @} */
+
+#ifdef __cplusplus
+}
+#endif
@@ -57,6 +57,67 @@
  */
 #define IC_DEFAULT_GLYPH_TEXTURE_ATLAS_SIZE CGSizeMake(1024, 1024)
 
+/**
+ @brief The default packing strategy used by ICGlyphCache to place glyphs in texture atlases
+ 
+ See ICGlyphPackingStrategy for possible values.
+ */
+#define IC_DEFAULT_GLYPH_PACKING_STRATEGY ICGlyphPackingStrategySkylineMinWaste
+
+/**
+ @brief The maximum number of texture atlases ICGlyphCache keeps open for adding glyphs
+ 
+ Open atlases keep a copy of their pixel data in RAM, so that glyphs may be added to them
+ later on. When a glyph does not fit into any open atlas, a new atlas is allocated and the
+ oldest open atlas is closed, releasing its RAM copy if the limit is exceeded.
+ */
+#define IC_GLYPH_CACHE_MAX_OPEN_ATLASES 3
+
+/**
+ @brief Rasterize glyphs missing from the glyph cache asynchronously on worker threads
+ 
+ If enabled, ICGlyphRun requests missing glyphs from ICGlyphCache instead of rasterizing them
+ while drawing. Glyphs are rasterized in parallel on background queues and added to the
+ cache's texture atlases at the beginning of the next frame. Glyph runs keep drawing their
+ previous contents until all of their glyphs are available.
+ */
+#define IC_ENABLE_ASYNC_GLYPH_RASTERIZATION 1
+
+/**
+ @brief The maximum number of layout results kept by the shared ICTextLayoutCache
+ 
+ Set to 0 to disable caching of glyph run metrics and label measurements.
+ */
+#define IC_DEFAULT_TEXT_LAYOUT_CACHE_CAPACITY 512
+
+/**
+ @brief Cache glyphs as signed distance fields rendered once per font face
+ 
+ If enabled, ICGlyphCache renders each glyph of a font face only once, at
+ ``IC_SDF_GLYPH_REFERENCE_SIZE``, and stores its signed distance field in the texture atlas.
+ ICGlyphRun scales these glyphs to the size of its font and reconstructs their outlines in the
+ fragment shader, so that all sizes of a font face share the same texture glyphs and zooming
+ text does not rasterize new glyphs. Extra subpixel glyphs are not used in this mode.
+ 
+ Requires ``IC_GLYPH_CACHE_TEXTURE_DEPTH`` to be set to 1.
+ */
+#define IC_USE_SDF_GLYPHS               0
+
+/**
+ @brief The size in pixels at which glyphs are rendered when using signed distance field glyphs
+ 
+ Larger values preserve finer glyph details such as sharp corners at the cost of atlas space.
+ */
+#define IC_SDF_GLYPH_REFERENCE_SIZE     64
+
+/**
+ @brief The maximum distance in pixels encoded in signed distance field glyphs
+ 
+ This value is also used as the margin around each glyph's bounding box, so that distances
+ fade out before reaching the glyph's texture rectangle edges.
+ */
+#define IC_SDF_GLYPH_SPREAD             8
+
 /**
  @brief The size in pixels of the margin to add to each glyph's bounding box when
  extracting glyph textures
@@ -30,6 +30,21 @@
 typedef CGGlyph ICGlyph;
 
 
+/**
+ @brief Rectangle bin packing strategies used to place glyphs in ICGlyphTextureAtlas objects
+ */
+typedef enum _ICGlyphPackingStrategy {
+    //! Skyline with bottom-left placement; fast, but leaves gaps below uneven glyph rows
+    ICGlyphPackingStrategySkylineBottomLeft = 0,
+    //! Skyline with minimum waste placement and a waste map reclaiming space below the skyline
+    ICGlyphPackingStrategySkylineMinWaste,
+    //! Maximal rectangles with best short side fit; densest packing, slowest insertion
+    ICGlyphPackingStrategyMaxRectsBestShortSideFit,
+    //! Guillotine with best area fit and merging of free rectangles
+    ICGlyphPackingStrategyGuillotineMerge
+} ICGlyphPackingStrategy;
+
+
 // FIXME: missing documentation
 // FIXME: move to separate header?
 
@@ -50,6 +50,31 @@ extern "C" {
      @brief Creates a CoreText attributed string from an icedcoffee attributed string
      */
     NSAttributedString *icCreateCTAttributedStringWithAttributedString(NSAttributedString *icAttString);
+    
+    /**
+     @brief Returns the number of leading characters for which both given attributed strings have
+     equal characters and attributes
+     */
+    NSUInteger icAttributedStringsCommonPrefixLength(NSAttributedString *a, NSAttributedString *b);
+    
+    /**
+     @brief Returns the number of trailing characters for which both given attributed strings have
+     equal characters and attributes
+     
+     @param a The first attributed string
+     @param b The second attributed string
+     @param maxLength The maximum length to return, used to prevent the suffix from overlapping
+     a common prefix computed using icAttributedStringsCommonPrefixLength()
+     */
+    NSUInteger icAttributedStringsCommonSuffixLength(NSAttributedString *a,
+                                                     NSAttributedString *b,
+                                                     NSUInteger maxLength);
+    
+    /**
+     @brief Returns whether the given CoreText lines consist of runs with equal attributes, glyphs
+     and glyph positions
+     */
+    BOOL icCTLinesHaveEqualGlyphLayout(CTLineRef a, CTLineRef b);
 
 #ifdef __cplusplus
 }
@@ -207,3 +207,116 @@ NSAttributedString *icCreateCTAttributedStringWithAttributedString(NSAttributedS
     return ctAttString;
 }
 
+NSUInteger icAttributedStringsCommonPrefixLength(NSAttributedString *a, NSAttributedString *b)
+{
+    NSString *stringA = [a string], *stringB = [b string];
+    NSUInteger length = MIN([stringA length], [stringB length]);
+    
+    // Find the first differing character
+    unichar charsA[256], charsB[256];
+    NSUInteger prefixLength = 0;
+    while (prefixLength < length) {
+        NSUInteger count = MIN(length - prefixLength, 256);
+        [stringA getCharacters:charsA range:NSMakeRange(prefixLength, count)];
+        [stringB getCharacters:charsB range:NSMakeRange(prefixLength, count)];
+        NSUInteger i = 0;
+        while (i < count && charsA[i] == charsB[i])
+            i++;
+        prefixLength += i;
+        if (i < count)
+            break;
+    }
+    
+    // Shorten the prefix to the first differing attributes
+    NSUInteger index = 0;
+    while (index < prefixLength) {
+        NSRange rangeA, rangeB;
+        NSDictionary *attrsA = [a attributesAtIndex:index effectiveRange:&rangeA];
+        NSDictionary *attrsB = [b attributesAtIndex:index effectiveRange:&rangeB];
+        if (![attrsA isEqualToDictionary:attrsB])
+            return index;
+        index = MIN(NSMaxRange(rangeA), NSMaxRange(rangeB));
+    }
+    
+    return prefixLength;
+}
+
+NSUInteger icAttributedStringsCommonSuffixLength(NSAttributedString *a,
+                                                 NSAttributedString *b,
+                                                 NSUInteger maxLength)
+{
+    NSString *stringA = [a string], *stringB = [b string];
+    NSUInteger lengthA = [stringA length], lengthB = [stringB length];
+    NSUInteger length = MIN(MIN(lengthA, lengthB), maxLength);
+    
+    // Find the last differing character
+    unichar charsA[256], charsB[256];
+    NSUInteger suffixLength = 0;
+    while (suffixLength < length) {
+        NSUInteger count = MIN(length - suffixLength, 256);
+        [stringA getCharacters:charsA range:NSMakeRange(lengthA - suffixLength - count, count)];
+        [stringB getCharacters:charsB range:NSMakeRange(lengthB - suffixLength - count, count)];
+        NSUInteger i = 0;
+        while (i < count && charsA[count - 1 - i] == charsB[count - 1 - i])
+            i++;
+        suffixLength += i;
+        if (i < count)
+            break;
+    }
+    
+    // Shorten the suffix to the last differing attributes
+    NSUInteger offset = 0;
+    while (offset < suffixLength) {
+        NSUInteger indexA = lengthA - 1 - offset, indexB = lengthB - 1 - offset;
+        NSRange rangeA, rangeB;
+        NSDictionary *attrsA = [a attributesAtIndex:indexA effectiveRange:&rangeA];
+        NSDictionary *attrsB = [b attributesAtIndex:indexB effectiveRange:&rangeB];
+        if (![attrsA isEqualToDictionary:attrsB])
+            return offset;
+        offset += MIN(indexA - rangeA.location, indexB - rangeB.location) + 1;
+    }
+    
+    return suffixLength;
+}
+
+BOOL icCTLinesHaveEqualGlyphLayout(CTLineRef a, CTLineRef b)
+{
+    CFArrayRef runsA = CTLineGetGlyphRuns(a);
+    CFArrayRef runsB = CTLineGetGlyphRuns(b);
+    CFIndex runCount = CFArrayGetCount(runsA);
+    if (runCount != CFArrayGetCount(runsB))
+        return NO;
+    
+    BOOL equal = YES;
+    CGGlyph *glyphs = NULL;
+    CGPoint *positions = NULL;
+    CFIndex capacity = 0;
+    
+    for (CFIndex i=0; i<runCount && equal; i++) {
+        CTRunRef runA = (CTRunRef)CFArrayGetValueAtIndex(runsA, i);
+        CTRunRef runB = (CTRunRef)CFArrayGetValueAtIndex(runsB, i);
+        CFIndex glyphCount = CTRunGetGlyphCount(runA);
+        if (glyphCount != CTRunGetGlyphCount(runB) ||
+            !CFEqual(CTRunGetAttributes(runA), CTRunGetAttributes(runB))) {
+            equal = NO;
+            break;
+        }
+        
+        // Copy glyphs and positions of both runs to temporary buffers and compare them
+        if (glyphCount > capacity) {
+            capacity = glyphCount;
+            glyphs = (CGGlyph *)realloc(glyphs, sizeof(CGGlyph) * capacity * 2);
+            positions = (CGPoint *)realloc(positions, sizeof(CGPoint) * capacity * 2);
+        }
+        CTRunGetGlyphs(runA, CFRangeMake(0, 0), glyphs);
+        CTRunGetGlyphs(runB, CFRangeMake(0, 0), glyphs + glyphCount);
+        CTRunGetPositions(runA, CFRangeMake(0, 0), positions);
+        CTRunGetPositions(runB, CFRangeMake(0, 0), positions + glyphCount);
+        equal = memcmp(glyphs, glyphs + glyphCount, sizeof(CGGlyph) * glyphCount) == 0 &&
+                memcmp(positions, positions + glyphCount, sizeof(CGPoint) * glyphCount) == 0;
+    }
+    
+    free(glyphs);
+    free(positions);
+    return equal;
+}
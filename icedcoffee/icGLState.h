@@ -36,31 +36,133 @@ enum {
 	ICVertexAttribMAX,
 };
 
+/** Vertex attribute flags used with icGLEnableVertexAttribs() */
+#define IC_VERTEX_ATTRIB_FLAG(index)            (1 << (index))
+#define IC_VERTEX_ATTRIB_FLAG_NONE              0
+#define IC_VERTEX_ATTRIB_FLAG_POSITION          IC_VERTEX_ATTRIB_FLAG(ICVertexAttribPosition)
+#define IC_VERTEX_ATTRIB_FLAG_COLOR             IC_VERTEX_ATTRIB_FLAG(ICVertexAttribColor)
+#define IC_VERTEX_ATTRIB_FLAG_TEX_COORDS        IC_VERTEX_ATTRIB_FLAG(ICVertexAttribTexCoords)
+#define IC_VERTEX_ATTRIB_FLAG_POS_COLOR_TEX     (IC_VERTEX_ATTRIB_FLAG_POSITION | \
+                                                 IC_VERTEX_ATTRIB_FLAG_COLOR | \
+                                                 IC_VERTEX_ATTRIB_FLAG_TEX_COORDS)
+
+/** The number of vertex attributes tracked by the state cache */
+#define IC_GL_MAX_TRACKED_VERTEX_ATTRIBS        8
+
+/** The number of texture units tracked by the state cache */
+#define IC_GL_MAX_TRACKED_TEXTURE_UNITS         8
+
 @class ICShaderProgram;
 
 /** GL server side states */
 typedef enum {
 	IC_GL_BLEND = 0x01,
+    IC_GL_DEPTH_TEST = 0x02,
+    IC_GL_STENCIL_TEST = 0x04,
+    IC_GL_SCISSOR_TEST = 0x08,
+    IC_GL_CULL_FACE = 0x10,
     
-    IC_GL_ALL = ( IC_GL_BLEND ),
+    IC_GL_ALL = ( IC_GL_BLEND | IC_GL_DEPTH_TEST | IC_GL_STENCIL_TEST | IC_GL_SCISSOR_TEST |
+                  IC_GL_CULL_FACE ),
 } icGLServerState;
 
+/**
+ @brief Counts GL calls issued and eliminated by the state cache
+ 
+ ``issuedCalls`` counts state changes that were forwarded to OpenGL, ``eliminatedCalls`` counts
+ redundant state changes the cache did not forward since the counters were last reset.
+ ICHostViewController resets the counters of its OpenGL context once per frame, see
+ ICHostViewController::glStateCounters.
+ */
+typedef struct _icGLStateCounters {
+    unsigned int issuedCalls;
+    unsigned int eliminatedCalls;
+} icGLStateCounters;
+
+/**
+ @brief Opaque GL state cache
+ 
+ Each ICOpenGLContext owns a state cache mirroring the GL state of its native context. The
+ icGL* functions below operate on the cache set for the current thread, which is switched
+ automatically when an ICOpenGLContext is made current. If no cache is set, or if
+ #IC_ENABLE_GL_STATE_CACHE is disabled, all functions forward directly to OpenGL.
+ */
+typedef struct _icGLStateCache icGLStateCache;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
     
+    icGLStateCache *icGLStateCacheCreate();
+    
+    void icGLStateCacheFree(icGLStateCache *cache);
+    
+    void icGLSetCurrentStateCache(icGLStateCache *cache);
+    
+    icGLStateCache *icGLGetCurrentStateCache();
+    
+    /** Forgets all cached state, call after changing GL state without using the icGL* functions */
     void icGLPurgeStateCache();
+    
+    icGLStateCounters icGLGetStateCounters();
+    
+    void icGLResetStateCounters();
 
     void icGLUniformModelViewProjectionMatrix(ICShaderProgram *shaderProgram);
+    
+    void icGLUseProgram(GLuint program);
+    
+    void icGLDeleteProgram(GLuint program);
+    
+    /** Caches GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER bindings, other targets are forwarded */
+    void icGLBindBuffer(GLenum target, GLuint buffer);
+    
+    void icGLDeleteBuffer(GLuint buffer);
+    
+    void icGLBindVertexArray(GLuint vertexArray);
+    
+    void icGLDeleteVertexArray(GLuint vertexArray);
+    
+    void icGLActiveTexture(GLenum textureUnit);
+    
+    /** Binds the given texture to GL_TEXTURE_2D of the active texture unit */
+    void icGLBindTexture2D(GLuint texture);
+    
+    /** Binds the given texture to GL_TEXTURE_2D of the texture unit with the given index */
+    void icGLBindTexture2DN(GLuint textureUnit, GLuint texture);
+    
+    void icGLDeleteTexture(GLuint texture);
+    
+    /**
+     Enables the vertex attributes whose IC_VERTEX_ATTRIB_FLAG bits are set in ``flags`` and
+     disables all others. Attribute arrays are vertex array object state, so this function
+     binds the default vertex array object first.
+     */
+    void icGLEnableVertexAttribs(unsigned int flags);
 
     void icGLBlendFunc(GLenum sfactor, GLenum dfactor);
 
+    /** Enables the given server side states, leaving all other states unchanged */
     void icGLEnable(icGLServerState flags);
     
+    /** Disables the given server side states, leaving all other states unchanged */
     void icGLDisable(icGLServerState flags);
+    
+    /** Returns whether the given server side state is enabled, queries OpenGL only if unknown */
+    BOOL icGLIsEnabled(icGLServerState state);
+    
+    void icGLDepthFunc(GLenum func);
+    
+    void icGLDepthMask(GLboolean flag);
+    
+    void icGLColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+    
+    void icGLStencilFunc(GLenum func, GLint ref, GLuint mask);
+    
+    void icGLStencilOp(GLenum sfail, GLenum dpfail, GLenum dppass);
+    
+    void icGLScissor(GLint x, GLint y, GLsizei width, GLsizei height);
 
 #ifdef __cplusplus
 }
 #endif
-
-
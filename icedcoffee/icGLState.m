@@ -26,25 +26,172 @@
  *
  */
 
-// FIXME: bad codebase: code duplication, inconsistent, bad concept
-
 #import "icGLState.h"
 #import "icGL.h"
 #import "ICShaderProgram.h"
 #import "icConfig.h"
-#import "ICShaderValue.h"
+#import <pthread.h>
+
+// Marks cached names and enums whose value is not known, e.g. after purging the cache
+#define IC_GL_UNKNOWN ((GLuint)-1)
+
+struct _icGLStateCache {
+    GLuint program;
+    GLuint arrayBuffer;
+    GLuint elementArrayBuffer; // element array binding of the bound vertex array object
+    GLuint vertexArray;
+    GLenum activeTexture;
+    GLuint textures[IC_GL_MAX_TRACKED_TEXTURE_UNITS];
+    unsigned int attribMask; // attribute arrays enabled on the default vertex array object
+    BOOL attribMaskValid;
+    icGLServerState serverState;
+    icGLServerState serverStateValid;
+    GLenum blendSource;
+    GLenum blendDest;
+    GLenum depthFunc;
+    GLint depthMask;
+    GLint colorMask;
+    GLenum stencilFunc;
+    GLint stencilRef;
+    GLuint stencilMask;
+    GLenum stencilFail;
+    GLenum stencilDepthFail;
+    GLenum stencilDepthPass;
+    GLint scissorBox[4];
+    BOOL scissorBoxValid;
+    icGLStateCounters counters;
+    struct _icGLStateCache *next;
+};
+
+static const GLenum _icGLServerStateCaps[] = {
+    GL_BLEND, GL_DEPTH_TEST, GL_STENCIL_TEST, GL_SCISSOR_TEST, GL_CULL_FACE
+};
 
+// All caches, used to forget deleted names of objects shared between contexts
+static icGLStateCache *_icGLStateCaches = NULL;
+static pthread_mutex_t _icGLStateCachesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_key_t _icGLCurrentStateCacheKey;
+static pthread_once_t _icGLCurrentStateCacheKeyOnce = PTHREAD_ONCE_INIT;
+static BOOL _icGLCurrentStateCacheKeyCreated = NO;
+
+static void icGLCreateCurrentStateCacheKey(void)
+{
+    pthread_key_create(&_icGLCurrentStateCacheKey, NULL);
+    _icGLCurrentStateCacheKeyCreated = YES;
+}
+
+static inline icGLStateCache *icGLCurrentStateCache()
+{
 #if IC_ENABLE_GL_STATE_CACHE
-static GLenum _icBlendingSource = -1;
-static GLenum _icBlendingDest = -1;
-static icGLServerState _icGLServerState = 0;
-#endif // IC_ENABLE_GL_STATE_CACHE
+    if (!_icGLCurrentStateCacheKeyCreated)
+        return NULL;
+    return pthread_getspecific(_icGLCurrentStateCacheKey);
+#else
+    return NULL;
+#endif
+}
+
+// Returns from the calling function if cache->member already equals value, otherwise
+// records value in the cache so that the caller can forward the call to OpenGL
+#define IC_GL_RETURN_IF_CACHED(cache, member, value) \
+    if (cache) { \
+        if ((cache)->member == (value)) { \
+            (cache)->counters.eliminatedCalls++; \
+            return; \
+        } \
+        (cache)->member = (value); \
+        (cache)->counters.issuedCalls++; \
+    }
+
+static void icGLStateCacheInvalidate(icGLStateCache *cache)
+{
+    cache->program = IC_GL_UNKNOWN;
+    cache->arrayBuffer = IC_GL_UNKNOWN;
+    cache->elementArrayBuffer = IC_GL_UNKNOWN;
+    cache->vertexArray = IC_GL_UNKNOWN;
+    cache->activeTexture = IC_GL_UNKNOWN;
+    for (int i=0; i<IC_GL_MAX_TRACKED_TEXTURE_UNITS; i++)
+        cache->textures[i] = IC_GL_UNKNOWN;
+    cache->attribMaskValid = NO;
+    cache->serverStateValid = 0;
+    cache->blendSource = cache->blendDest = IC_GL_UNKNOWN;
+    cache->depthFunc = IC_GL_UNKNOWN;
+    cache->depthMask = -1;
+    cache->colorMask = -1;
+    cache->stencilFunc = IC_GL_UNKNOWN;
+    cache->stencilFail = IC_GL_UNKNOWN;
+    cache->scissorBoxValid = NO;
+}
+
+icGLStateCache *icGLStateCacheCreate()
+{
+    pthread_once(&_icGLCurrentStateCacheKeyOnce, icGLCreateCurrentStateCacheKey);
+    
+    icGLStateCache *cache = calloc(1, sizeof(icGLStateCache));
+    icGLStateCacheInvalidate(cache);
+    
+    pthread_mutex_lock(&_icGLStateCachesMutex);
+    cache->next = _icGLStateCaches;
+    _icGLStateCaches = cache;
+    pthread_mutex_unlock(&_icGLStateCachesMutex);
+    
+    return cache;
+}
+
+void icGLStateCacheFree(icGLStateCache *cache)
+{
+    if (!cache)
+        return;
+    
+    pthread_mutex_lock(&_icGLStateCachesMutex);
+    icGLStateCache **link = &_icGLStateCaches;
+    while (*link && *link != cache)
+        link = &(*link)->next;
+    if (*link)
+        *link = cache->next;
+    pthread_mutex_unlock(&_icGLStateCachesMutex);
+    
+    if (icGLCurrentStateCache() == cache)
+        icGLSetCurrentStateCache(NULL);
+    
+    free(cache);
+}
+
+void icGLSetCurrentStateCache(icGLStateCache *cache)
+{
+    pthread_once(&_icGLCurrentStateCacheKeyOnce, icGLCreateCurrentStateCacheKey);
+    pthread_setspecific(_icGLCurrentStateCacheKey, cache);
+}
+
+icGLStateCache *icGLGetCurrentStateCache()
+{
+    return icGLCurrentStateCache();
+}
 
 void icGLPurgeStateCache()
 {
-    _icBlendingSource = -1;
-    _icBlendingDest = -1;
-    _icGLServerState = 0;
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache)
+        icGLStateCacheInvalidate(cache);
+}
+
+icGLStateCounters icGLGetStateCounters()
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache)
+        return cache->counters;
+    icGLStateCounters counters = {0, 0};
+    return counters;
+}
+
+void icGLResetStateCounters()
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache) {
+        cache->counters.issuedCalls = 0;
+        cache->counters.eliminatedCalls = 0;
+    }
 }
 
 void icGLUniformModelViewProjectionMatrix(ICShaderProgram *shaderProgram)
@@ -58,68 +205,291 @@ void icGLUniformModelViewProjectionMatrix(ICShaderProgram *shaderProgram)
     
 	kmMat4Multiply(&matrixMVP, &matrixP, &matrixMV);
     
-    [shaderProgram setShaderValue:[ICShaderValue shaderValueWithMat4: matrixMVP] forUniform:@"u_MVPMatrix"];
+    [shaderProgram setMat4:&matrixMVP forUniformHandle:shaderProgram.mvpMatrixUniformHandle];
 }
 
-void icGLBlendFunc(GLenum sfactor, GLenum dfactor)
+void icGLUseProgram(GLuint program)
 {
-#if IC_ENABLE_GL_STATE_CACHE
-	if( sfactor != _icBlendingSource || dfactor != _icBlendingDest ) {
-		_icBlendingSource = sfactor;
-		_icBlendingDest = dfactor;
-		glBlendFunc( sfactor, dfactor );
-	}
-#else
-	glBlendFunc( sfactor, dfactor );
-#endif // IC_ENABLE_GL_STATE_CACHE
+    icGLStateCache *cache = icGLCurrentStateCache();
+    IC_GL_RETURN_IF_CACHED(cache, program, program);
+    glUseProgram(program);
 }
 
-void icGLEnable(icGLServerState flags)
+void icGLDeleteProgram(GLuint program)
 {
-#if IC_ENABLE_GL_STATE_CACHE
+    glDeleteProgram(program);
     
-	BOOL enabled = NO;
+    // Programs are shared between contexts, a program in use is deleted once it is unused
+    pthread_mutex_lock(&_icGLStateCachesMutex);
+    for (icGLStateCache *cache = _icGLStateCaches; cache; cache = cache->next) {
+        if (cache->program == program)
+            cache->program = IC_GL_UNKNOWN;
+    }
+    pthread_mutex_unlock(&_icGLStateCachesMutex);
+}
+
+void icGLBindBuffer(GLenum target, GLuint buffer)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (target == GL_ARRAY_BUFFER) {
+        IC_GL_RETURN_IF_CACHED(cache, arrayBuffer, buffer);
+    } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        IC_GL_RETURN_IF_CACHED(cache, elementArrayBuffer, buffer);
+    }
+    glBindBuffer(target, buffer);
+}
+
+void icGLDeleteBuffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
     
-	/* GL_BLEND */
-	if( (enabled=(flags & IC_GL_BLEND)) != (_icGLServerState & IC_GL_BLEND) ) {
-		if( enabled ) {
-			glEnable( GL_BLEND );
-			_icGLServerState |= IC_GL_BLEND;
-		} else {
-			glDisable( GL_BLEND );
-			_icGLServerState &= ~IC_GL_BLEND;
-		}
-	}
+    // Buffer names may be reused by subsequent glGenBuffers calls in any shared context
+    pthread_mutex_lock(&_icGLStateCachesMutex);
+    for (icGLStateCache *cache = _icGLStateCaches; cache; cache = cache->next) {
+        if (cache->arrayBuffer == buffer)
+            cache->arrayBuffer = IC_GL_UNKNOWN;
+        if (cache->elementArrayBuffer == buffer)
+            cache->elementArrayBuffer = IC_GL_UNKNOWN;
+    }
+    pthread_mutex_unlock(&_icGLStateCachesMutex);
+}
+
+void icGLBindVertexArray(GLuint vertexArray)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    IC_GL_RETURN_IF_CACHED(cache, vertexArray, vertexArray);
+    glBindVertexArray(vertexArray);
+    if (cache) {
+        // The element array binding is part of the vertex array object's state
+        cache->elementArrayBuffer = IC_GL_UNKNOWN;
+    }
+}
+
+void icGLDeleteVertexArray(GLuint vertexArray)
+{
+    glDeleteVertexArrays(1, &vertexArray);
     
-#else
-	if (flags & IC_GL_BLEND)
-		glEnable( GL_BLEND );
-	else
-		glDisable( GL_BLEND );
-#endif
+    // Vertex array objects are not shared between contexts
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache && cache->vertexArray == vertexArray) {
+        cache->vertexArray = IC_GL_UNKNOWN;
+        cache->elementArrayBuffer = IC_GL_UNKNOWN;
+    }
 }
 
-void icGLDisable(icGLServerState flags)
+void icGLActiveTexture(GLenum textureUnit)
 {
-#if IC_ENABLE_GL_STATE_CACHE
+    icGLStateCache *cache = icGLCurrentStateCache();
+    IC_GL_RETURN_IF_CACHED(cache, activeTexture, textureUnit);
+    glActiveTexture(textureUnit);
+}
+
+void icGLBindTexture2D(GLuint texture)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache && cache->activeTexture != IC_GL_UNKNOWN) {
+        GLuint unit = cache->activeTexture - GL_TEXTURE0;
+        if (unit < IC_GL_MAX_TRACKED_TEXTURE_UNITS) {
+            IC_GL_RETURN_IF_CACHED(cache, textures[unit], texture);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void icGLBindTexture2DN(GLuint textureUnit, GLuint texture)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache && textureUnit < IC_GL_MAX_TRACKED_TEXTURE_UNITS &&
+        cache->textures[textureUnit] == texture) {
+        // Already bound, so there is no need to switch texture units either
+        cache->counters.eliminatedCalls++;
+        return;
+    }
+    icGLActiveTexture(GL_TEXTURE0 + textureUnit);
+    icGLBindTexture2D(texture);
+}
+
+void icGLDeleteTexture(GLuint texture)
+{
+    glDeleteTextures(1, &texture);
     
-	BOOL enabled = NO;
+    // Texture names may be reused by subsequent glGenTextures calls in any shared context
+    pthread_mutex_lock(&_icGLStateCachesMutex);
+    for (icGLStateCache *cache = _icGLStateCaches; cache; cache = cache->next) {
+        for (int i=0; i<IC_GL_MAX_TRACKED_TEXTURE_UNITS; i++) {
+            if (cache->textures[i] == texture)
+                cache->textures[i] = IC_GL_UNKNOWN;
+        }
+    }
+    pthread_mutex_unlock(&_icGLStateCachesMutex);
+}
+
+void icGLEnableVertexAttribs(unsigned int flags)
+{
+#if IC_ENABLE_VERTEX_ARRAY_OBJECTS
+    icGLBindVertexArray(0);
+#endif
     
-	/* GL_BLEND */
-	if( (enabled=(flags & IC_GL_BLEND)) == (_icGLServerState & IC_GL_BLEND) ) {
-		if( enabled ) {
-			glDisable( GL_BLEND );
-			_icGLServerState &= ~IC_GL_BLEND;
-		} else {
-			glEnable( GL_BLEND );
-			_icGLServerState |= IC_GL_BLEND;
-		}
-	}
+    icGLStateCache *cache = icGLCurrentStateCache();
+    for (GLuint i=0; i<IC_GL_MAX_TRACKED_VERTEX_ATTRIBS; i++) {
+        unsigned int bit = IC_VERTEX_ATTRIB_FLAG(i);
+        BOOL enable = (flags & bit) != 0;
+        if (cache) {
+            if (cache->attribMaskValid && enable == ((cache->attribMask & bit) != 0)) {
+                // Only count requested attributes, unused ones were never toggled per draw
+                if (enable)
+                    cache->counters.eliminatedCalls++;
+                continue;
+            }
+            cache->counters.issuedCalls++;
+        }
+        if (enable)
+            glEnableVertexAttribArray(i);
+        else
+            glDisableVertexAttribArray(i);
+    }
     
-#else
-	if (flags & IC_GL_BLEND)
-		glDisable( GL_BLEND );
-	else
-		glEnable( GL_BLEND );
-#endif    
-}
\ No newline at end of file
+    if (cache) {
+        cache->attribMask = flags;
+        cache->attribMaskValid = YES;
+    }
+}
+
+void icGLBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache) {
+        if (sfactor == cache->blendSource && dfactor == cache->blendDest) {
+            cache->counters.eliminatedCalls++;
+            return;
+        }
+        cache->blendSource = sfactor;
+        cache->blendDest = dfactor;
+        cache->counters.issuedCalls++;
+    }
+    glBlendFunc(sfactor, dfactor);
+}
+
+static void icGLSetServerState(icGLServerState flags, BOOL enable)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    for (unsigned int i=0; i<sizeof(_icGLServerStateCaps)/sizeof(GLenum); i++) {
+        icGLServerState bit = 1 << i;
+        if (!(flags & bit))
+            continue;
+        if (cache) {
+            if ((cache->serverStateValid & bit) && enable == ((cache->serverState & bit) != 0)) {
+                cache->counters.eliminatedCalls++;
+                continue;
+            }
+            cache->serverStateValid |= bit;
+            if (enable)
+                cache->serverState |= bit;
+            else
+                cache->serverState &= ~bit;
+            cache->counters.issuedCalls++;
+        }
+        if (enable)
+            glEnable(_icGLServerStateCaps[i]);
+        else
+            glDisable(_icGLServerStateCaps[i]);
+    }
+}
+
+void icGLEnable(icGLServerState flags)
+{
+    icGLSetServerState(flags, YES);
+}
+
+void icGLDisable(icGLServerState flags)
+{
+    icGLSetServerState(flags, NO);
+}
+
+BOOL icGLIsEnabled(icGLServerState state)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    for (unsigned int i=0; i<sizeof(_icGLServerStateCaps)/sizeof(GLenum); i++) {
+        if (state != 1 << i)
+            continue;
+        if (cache && (cache->serverStateValid & state))
+            return (cache->serverState & state) != 0;
+        return glIsEnabled(_icGLServerStateCaps[i]) == GL_TRUE;
+    }
+    return NO;
+}
+
+void icGLDepthFunc(GLenum func)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    IC_GL_RETURN_IF_CACHED(cache, depthFunc, func);
+    glDepthFunc(func);
+}
+
+void icGLDepthMask(GLboolean flag)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    IC_GL_RETURN_IF_CACHED(cache, depthMask, (GLint)(flag != GL_FALSE));
+    glDepthMask(flag);
+}
+
+void icGLColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    GLint mask = (red != GL_FALSE) | (green != GL_FALSE) << 1 |
+                 (blue != GL_FALSE) << 2 | (alpha != GL_FALSE) << 3;
+    IC_GL_RETURN_IF_CACHED(cache, colorMask, mask);
+    glColorMask(red, green, blue, alpha);
+}
+
+void icGLStencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache) {
+        if (func == cache->stencilFunc && ref == cache->stencilRef && mask == cache->stencilMask) {
+            cache->counters.eliminatedCalls++;
+            return;
+        }
+        cache->stencilFunc = func;
+        cache->stencilRef = ref;
+        cache->stencilMask = mask;
+        cache->counters.issuedCalls++;
+    }
+    glStencilFunc(func, ref, mask);
+}
+
+void icGLStencilOp(GLenum sfail, GLenum dpfail, GLenum dppass)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache) {
+        if (sfail == cache->stencilFail && dpfail == cache->stencilDepthFail &&
+            dppass == cache->stencilDepthPass) {
+            cache->counters.eliminatedCalls++;
+            return;
+        }
+        cache->stencilFail = sfail;
+        cache->stencilDepthFail = dpfail;
+        cache->stencilDepthPass = dppass;
+        cache->counters.issuedCalls++;
+    }
+    glStencilOp(sfail, dpfail, dppass);
+}
+
+void icGLScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    icGLStateCache *cache = icGLCurrentStateCache();
+    if (cache) {
+        if (cache->scissorBoxValid && x == cache->scissorBox[0] && y == cache->scissorBox[1] &&
+            width == cache->scissorBox[2] && height == cache->scissorBox[3]) {
+            cache->counters.eliminatedCalls++;
+            return;
+        }
+        cache->scissorBox[0] = x;
+        cache->scissorBox[1] = y;
+        cache->scissorBox[2] = width;
+        cache->scissorBox[3] = height;
+        cache->scissorBoxValid = YES;
+        cache->counters.issuedCalls++;
+    }
+    glScissor(x, y, width, height);
+}
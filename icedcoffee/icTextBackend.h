@@ -0,0 +1,165 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __APPLE__
+#include <CoreText/CoreText.h>
+#endif
+
+#ifndef IC_ENABLE_FREETYPE_TEXT_BACKEND
+/**
+ @brief Activate to compile the FreeType text backend
+ 
+ The FreeType backend allows for shaping and rasterizing text on platforms without CoreText,
+ e.g. for running text layout and glyph caching benchmarks on Linux.
+ */
+#define IC_ENABLE_FREETYPE_TEXT_BACKEND 0
+#endif
+
+#ifndef IC_ENABLE_HARFBUZZ_SHAPING
+/**
+ @brief Activate to let the FreeType text backend shape text using HarfBuzz
+ 
+ If deactivated, the FreeType backend maps characters to glyphs one by one and positions them
+ using their advances and kerning, which is sufficient for simple scripts only.
+ */
+#define IC_ENABLE_HARFBUZZ_SHAPING 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     @defgroup text-backends Text Backends
+     @{
+     */
+    
+    /**
+     @brief Opaque font face at a fixed size, created and interpreted by a text backend
+     */
+    typedef struct _icTextFace icTextFace;
+    
+    /**
+     @brief Typographic metrics of a text face in pixels
+     */
+    typedef struct _icTextFaceMetrics {
+        float ascent;
+        float descent;
+        float leading;
+    } icTextFaceMetrics;
+    
+    /**
+     @brief A glyph produced by shaping text
+     */
+    typedef struct _icShapedGlyph {
+        uint16_t glyph;             //!< Glyph index in the face
+        uint32_t cluster;           //!< Index of the first UTF-16 code unit the glyph represents
+        float x;                    //!< Horizontal pen position in pixels relative to the run origin
+        float y;                    //!< Vertical pen position in pixels relative to the baseline
+        float advance;              //!< Horizontal advance in pixels
+    } icShapedGlyph;
+    
+    /**
+     @brief Bounding rectangle of a glyph in pixels, relative to its pen position, y pointing up
+     */
+    typedef struct _icGlyphBounds {
+        float x;
+        float y;
+        float width;
+        float height;
+    } icGlyphBounds;
+    
+    /**
+     @brief Function table implementing text shaping and glyph rasterization
+     
+     The glyph pipeline accesses fonts exclusively through this interface when rasterizing glyphs,
+     so that glyph caching does not depend on CoreGraphics. All functions must be safe to call
+     concurrently for distinct faces. Functions only reading a face must be safe to call
+     concurrently for the same face.
+     */
+    typedef struct _icTextBackend {
+        //! Name of the backend
+        const char *name;
+        
+        //! Creates a face from the font file at the given path, returns NULL on failure
+        icTextFace *(*createFaceWithFile)(const char *path, float sizeInPixels);
+        
+        //! Releases a face created by the backend
+        void (*releaseFace)(icTextFace *face);
+        
+        //! Retrieves the typographic metrics of a face
+        void (*getFaceMetrics)(icTextFace *face, icTextFaceMetrics *metrics);
+        
+        /**
+         Shapes the given UTF-16 characters as a single run, writing up to capacity glyphs.
+         Returns the total number of glyphs of the run, which may exceed capacity.
+         */
+        size_t (*shape)(icTextFace *face, const uint16_t *characters, size_t length,
+                        icShapedGlyph *glyphs, size_t capacity);
+        
+        //! Retrieves the bounding rectangles of the given glyphs
+        void (*getGlyphBounds)(icTextFace *face, const uint16_t *glyphs, size_t count,
+                               icGlyphBounds *bounds);
+        
+        /**
+         Rasterizes a glyph in white into the given bitmap with depth bytes per pixel (1 for
+         alpha, 4 for premultiplied RGBA). The glyph's pen position x, y is measured in pixels
+         from the bitmap's bottom left corner, whereas the bitmap's rows are stored top to bottom.
+         Returns 0 on success.
+         */
+        int (*rasterizeGlyph)(icTextFace *face, uint16_t glyph, float x, float y,
+                              uint8_t *bitmap, size_t width, size_t height, size_t rowBytes,
+                              unsigned int depth);
+    } icTextBackend;
+    
+#ifdef __APPLE__
+    /**
+     @brief Returns the CoreText text backend
+     */
+    const icTextBackend *icTextBackendCoreText(void);
+    
+    /**
+     @brief Creates a CoreText backend face wrapping the given CoreText font
+     */
+    icTextFace *icTextFaceCreateWithCTFont(CTFontRef font);
+#endif
+    
+#if IC_ENABLE_FREETYPE_TEXT_BACKEND
+    /**
+     @brief Returns the FreeType text backend
+     
+     Glyphs are shaped using HarfBuzz if #IC_ENABLE_HARFBUZZ_SHAPING is activated.
+     */
+    const icTextBackend *icTextBackendFreeType(void);
+#endif
+    
+    /** @} */
+    
+#ifdef __cplusplus
+}
+#endif
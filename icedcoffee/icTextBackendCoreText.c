@@ -0,0 +1,199 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#include "icTextBackend.h"
+
+#ifdef __APPLE__
+
+#include <stdlib.h>
+#include <string.h>
+
+
+struct _icTextFace {
+    CTFontRef font;
+};
+
+
+icTextFace *icTextFaceCreateWithCTFont(CTFontRef font)
+{
+    icTextFace *face = (icTextFace *)malloc(sizeof(icTextFace));
+    face->font = (CTFontRef)CFRetain(font);
+    return face;
+}
+
+static icTextFace *icCTCreateFaceWithFile(const char *path, float sizeInPixels)
+{
+    CGDataProviderRef dataProvider = CGDataProviderCreateWithFilename(path);
+    if (!dataProvider)
+        return NULL;
+    CGFontRef cgFont = CGFontCreateWithDataProvider(dataProvider);
+    CGDataProviderRelease(dataProvider);
+    if (!cgFont)
+        return NULL;
+    
+    CTFontRef font = CTFontCreateWithGraphicsFont(cgFont, sizeInPixels, NULL, NULL);
+    CGFontRelease(cgFont);
+    
+    icTextFace *face = icTextFaceCreateWithCTFont(font);
+    CFRelease(font);
+    return face;
+}
+
+static void icCTReleaseFace(icTextFace *face)
+{
+    if (!face)
+        return;
+    CFRelease(face->font);
+    free(face);
+}
+
+static void icCTGetFaceMetrics(icTextFace *face, icTextFaceMetrics *metrics)
+{
+    metrics->ascent = CTFontGetAscent(face->font);
+    metrics->descent = CTFontGetDescent(face->font);
+    metrics->leading = CTFontGetLeading(face->font);
+}
+
+// Shapes the characters using a CoreText line. Glyphs substituted from fallback fonts are
+// reported as well, so the face should cover all characters for the glyph indices to be
+// meaningful.
+static size_t icCTShape(icTextFace *face, const uint16_t *characters, size_t length,
+                        icShapedGlyph *glyphs, size_t capacity)
+{
+    CFStringRef string = CFStringCreateWithCharacters(NULL, characters, (CFIndex)length);
+    CFStringRef keys[] = { kCTFontAttributeName };
+    CFTypeRef values[] = { face->font };
+    CFDictionaryRef attributes = CFDictionaryCreate(NULL, (const void **)keys, values, 1,
+                                                    &kCFTypeDictionaryKeyCallBacks,
+                                                    &kCFTypeDictionaryValueCallBacks);
+    CFAttributedStringRef attributedString = CFAttributedStringCreate(NULL, string, attributes);
+    CTLineRef line = CTLineCreateWithAttributedString(attributedString);
+    
+    size_t glyphCount = 0;
+    CFArrayRef runs = CTLineGetGlyphRuns(line);
+    for (CFIndex i=0; i<CFArrayGetCount(runs); i++) {
+        CTRunRef run = (CTRunRef)CFArrayGetValueAtIndex(runs, i);
+        CFIndex runGlyphCount = CTRunGetGlyphCount(run);
+        CFIndex count = glyphCount < capacity ? (CFIndex)(capacity - glyphCount) : 0;
+        if (count > runGlyphCount)
+            count = runGlyphCount;
+        if (count > 0) {
+            CGGlyph *runGlyphs = (CGGlyph *)malloc(sizeof(CGGlyph) * count);
+            CGPoint *positions = (CGPoint *)malloc(sizeof(CGPoint) * count);
+            CGSize *advances = (CGSize *)malloc(sizeof(CGSize) * count);
+            CFIndex *indices = (CFIndex *)malloc(sizeof(CFIndex) * count);
+            CTRunGetGlyphs(run, CFRangeMake(0, count), runGlyphs);
+            CTRunGetPositions(run, CFRangeMake(0, count), positions);
+            CTRunGetAdvances(run, CFRangeMake(0, count), advances);
+            CTRunGetStringIndices(run, CFRangeMake(0, count), indices);
+            for (CFIndex j=0; j<count; j++) {
+                icShapedGlyph *glyph = &glyphs[glyphCount + j];
+                glyph->glyph = runGlyphs[j];
+                glyph->cluster = (uint32_t)indices[j];
+                glyph->x = positions[j].x;
+                glyph->y = positions[j].y;
+                glyph->advance = advances[j].width;
+            }
+            free(runGlyphs);
+            free(positions);
+            free(advances);
+            free(indices);
+        }
+        glyphCount += runGlyphCount;
+    }
+    
+    CFRelease(line);
+    CFRelease(attributedString);
+    CFRelease(attributes);
+    CFRelease(string);
+    return glyphCount;
+}
+
+static void icCTGetGlyphBounds(icTextFace *face, const uint16_t *glyphs, size_t count,
+                               icGlyphBounds *bounds)
+{
+    CGRect *rects = (CGRect *)malloc(sizeof(CGRect) * count);
+    CTFontGetBoundingRectsForGlyphs(face->font, kCTFontDefaultOrientation, glyphs, rects,
+                                    (CFIndex)count);
+    for (size_t i=0; i<count; i++) {
+        bounds[i].x = rects[i].origin.x;
+        bounds[i].y = rects[i].origin.y;
+        bounds[i].width = rects[i].size.width;
+        bounds[i].height = rects[i].size.height;
+    }
+    free(rects);
+}
+
+static int icCTRasterizeGlyph(icTextFace *face, uint16_t glyph, float x, float y,
+                              uint8_t *bitmap, size_t width, size_t height, size_t rowBytes,
+                              unsigned int depth)
+{
+    CGColorSpaceRef colorSpace;
+    CGBitmapInfo bitmapInfo;
+    if (depth == 4) {
+        colorSpace = CGColorSpaceCreateDeviceRGB();
+        bitmapInfo = kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big;
+    } else if (depth == 1) {
+        colorSpace = CGColorSpaceCreateDeviceGray();
+        bitmapInfo = kCGImageAlphaNone;
+    } else {
+        return -1;
+    }
+    
+    CGContextRef context = CGBitmapContextCreate(bitmap, width, height, 8, rowBytes, colorSpace,
+                                                 bitmapInfo);
+    CGColorSpaceRelease(colorSpace);
+    if (!context)
+        return -1;
+    
+    CGFontRef cgFont = CTFontCopyGraphicsFont(face->font, NULL);
+    CGContextSetShouldSubpixelPositionFonts(context, true);
+    CGContextSetShouldSubpixelQuantizeFonts(context, true);
+    CGContextSetTextMatrix(context, CGAffineTransformIdentity);
+    CGContextSetFont(context, cgFont);
+    CGContextSetFontSize(context, CTFontGetSize(face->font));
+    CGContextSetGrayFillColor(context, 1, 1);
+    CGGlyph cgGlyph = glyph;
+    CGContextShowGlyphsAtPoint(context, x, y, &cgGlyph, 1);
+    CFRelease(cgFont);
+    CGContextRelease(context);
+    
+    return 0;
+}
+
+static const icTextBackend s_coreTextBackend = {
+    "CoreText",
+    icCTCreateFaceWithFile,
+    icCTReleaseFace,
+    icCTGetFaceMetrics,
+    icCTShape,
+    icCTGetGlyphBounds,
+    icCTRasterizeGlyph
+};
+
+const icTextBackend *icTextBackendCoreText(void)
+{
+    return &s_coreTextBackend;
+}
+
+#endif // __APPLE__
@@ -0,0 +1,271 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#include "icTextBackend.h"
+
+#if IC_ENABLE_FREETYPE_TEXT_BACKEND
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_ADVANCES_H
+
+#if IC_ENABLE_HARFBUZZ_SHAPING
+#include <hb.h>
+#include <hb-ft.h>
+#endif
+
+
+// Each face owns its FreeType library, as FreeType libraries must not be used concurrently.
+// The mutex serializes access to the face's glyph slot.
+struct _icTextFace {
+    FT_Library library;
+    FT_Face face;
+    pthread_mutex_t mutex;
+#if IC_ENABLE_HARFBUZZ_SHAPING
+    hb_font_t *hbFont;
+#endif
+};
+
+#define IC_FT_TO_FLOAT(v) ((float)(v) / 64.f)
+
+
+static icTextFace *icFTCreateFaceWithFile(const char *path, float sizeInPixels)
+{
+    icTextFace *face = (icTextFace *)calloc(1, sizeof(icTextFace));
+    if (FT_Init_FreeType(&face->library)) {
+        free(face);
+        return NULL;
+    }
+    if (FT_New_Face(face->library, path, 0, &face->face) ||
+        FT_Set_Char_Size(face->face, 0, (FT_F26Dot6)(sizeInPixels * 64.f), 72, 72)) {
+        if (face->face)
+            FT_Done_Face(face->face);
+        FT_Done_FreeType(face->library);
+        free(face);
+        return NULL;
+    }
+    pthread_mutex_init(&face->mutex, NULL);
+#if IC_ENABLE_HARFBUZZ_SHAPING
+    face->hbFont = hb_ft_font_create(face->face, NULL);
+#endif
+    return face;
+}
+
+static void icFTReleaseFace(icTextFace *face)
+{
+    if (!face)
+        return;
+#if IC_ENABLE_HARFBUZZ_SHAPING
+    hb_font_destroy(face->hbFont);
+#endif
+    pthread_mutex_destroy(&face->mutex);
+    FT_Done_Face(face->face);
+    FT_Done_FreeType(face->library);
+    free(face);
+}
+
+static void icFTGetFaceMetrics(icTextFace *face, icTextFaceMetrics *metrics)
+{
+    FT_Size_Metrics *sizeMetrics = &face->face->size->metrics;
+    metrics->ascent = IC_FT_TO_FLOAT(sizeMetrics->ascender);
+    metrics->descent = -IC_FT_TO_FLOAT(sizeMetrics->descender);
+    metrics->leading = IC_FT_TO_FLOAT(sizeMetrics->height) - metrics->ascent - metrics->descent;
+    if (metrics->leading < 0)
+        metrics->leading = 0;
+}
+
+#if IC_ENABLE_HARFBUZZ_SHAPING
+
+static size_t icFTShape(icTextFace *face, const uint16_t *characters, size_t length,
+                        icShapedGlyph *glyphs, size_t capacity)
+{
+    hb_buffer_t *buffer = hb_buffer_create();
+    hb_buffer_add_utf16(buffer, characters, (int)length, 0, (int)length);
+    hb_buffer_guess_segment_properties(buffer);
+    
+    pthread_mutex_lock(&face->mutex);
+    hb_shape(face->hbFont, buffer, NULL, 0);
+    pthread_mutex_unlock(&face->mutex);
+    
+    unsigned int glyphCount = 0;
+    hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+    hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(buffer, NULL);
+    
+    // HarfBuzz fonts created from FreeType faces use 26.6 fixed point pixel units
+    float penX = 0;
+    for (unsigned int i=0; i<glyphCount && i<capacity; i++) {
+        glyphs[i].glyph = (uint16_t)infos[i].codepoint;
+        glyphs[i].cluster = infos[i].cluster;
+        glyphs[i].x = penX + IC_FT_TO_FLOAT(positions[i].x_offset);
+        glyphs[i].y = IC_FT_TO_FLOAT(positions[i].y_offset);
+        glyphs[i].advance = IC_FT_TO_FLOAT(positions[i].x_advance);
+        penX += glyphs[i].advance;
+    }
+    
+    hb_buffer_destroy(buffer);
+    return glyphCount;
+}
+
+#else
+
+// Maps characters to glyphs one by one, positioning glyphs using their unhinted advances and
+// the face's kerning table
+static size_t icFTShape(icTextFace *face, const uint16_t *characters, size_t length,
+                        icShapedGlyph *glyphs, size_t capacity)
+{
+    FT_Face ftFace = face->face;
+    FT_Bool hasKerning = FT_HAS_KERNING(ftFace);
+    FT_UInt previousGlyph = 0;
+    float penX = 0;
+    size_t glyphCount = 0;
+    
+    pthread_mutex_lock(&face->mutex);
+    for (size_t i=0; i<length; i++) {
+        // Decode surrogate pairs
+        uint32_t codepoint = characters[i];
+        uint32_t cluster = (uint32_t)i;
+        if (codepoint >= 0xD800 && codepoint < 0xDC00 && i + 1 < length &&
+            characters[i+1] >= 0xDC00 && characters[i+1] < 0xE000) {
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (characters[i+1] - 0xDC00);
+            i++;
+        }
+        
+        FT_UInt glyph = FT_Get_Char_Index(ftFace, codepoint);
+        if (hasKerning && previousGlyph && glyph) {
+            FT_Vector kerning;
+            if (!FT_Get_Kerning(ftFace, previousGlyph, glyph, FT_KERNING_UNFITTED, &kerning))
+                penX += IC_FT_TO_FLOAT(kerning.x);
+        }
+        
+        FT_Fixed advance = 0;
+        FT_Get_Advance(ftFace, glyph, FT_LOAD_NO_HINTING, &advance);
+        
+        if (glyphCount < capacity) {
+            glyphs[glyphCount].glyph = (uint16_t)glyph;
+            glyphs[glyphCount].cluster = cluster;
+            glyphs[glyphCount].x = penX;
+            glyphs[glyphCount].y = 0;
+            glyphs[glyphCount].advance = (float)advance / 65536.f;
+        }
+        glyphCount++;
+        
+        penX += (float)advance / 65536.f;
+        previousGlyph = glyph;
+    }
+    pthread_mutex_unlock(&face->mutex);
+    
+    return glyphCount;
+}
+
+#endif // IC_ENABLE_HARFBUZZ_SHAPING
+
+static void icFTGetGlyphBounds(icTextFace *face, const uint16_t *glyphs, size_t count,
+                               icGlyphBounds *bounds)
+{
+    pthread_mutex_lock(&face->mutex);
+    for (size_t i=0; i<count; i++) {
+        // Unhinted outline bounds, as reported by CoreText
+        if (FT_Load_Glyph(face->face, glyphs[i], FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP)) {
+            memset(&bounds[i], 0, sizeof(icGlyphBounds));
+            continue;
+        }
+        FT_Glyph_Metrics *metrics = &face->face->glyph->metrics;
+        bounds[i].x = IC_FT_TO_FLOAT(metrics->horiBearingX);
+        bounds[i].y = IC_FT_TO_FLOAT(metrics->horiBearingY - metrics->height);
+        bounds[i].width = IC_FT_TO_FLOAT(metrics->width);
+        bounds[i].height = IC_FT_TO_FLOAT(metrics->height);
+    }
+    pthread_mutex_unlock(&face->mutex);
+}
+
+static int icFTRasterizeGlyph(icTextFace *face, uint16_t glyph, float x, float y,
+                              uint8_t *bitmap, size_t width, size_t height, size_t rowBytes,
+                              unsigned int depth)
+{
+    FT_Face ftFace = face->face;
+    
+    // Render at the subpixel offset of the pen position, place the result at its integral part
+    float originX = floorf(x), originY = floorf(y);
+    FT_Vector delta;
+    delta.x = (FT_Pos)((x - originX) * 64.f);
+    delta.y = (FT_Pos)((y - originY) * 64.f);
+    
+    pthread_mutex_lock(&face->mutex);
+    FT_Set_Transform(ftFace, NULL, &delta);
+    FT_Error error = FT_Load_Glyph(ftFace, glyph, FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
+    FT_Set_Transform(ftFace, NULL, NULL);
+    if (error || ftFace->glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+        pthread_mutex_unlock(&face->mutex);
+        return -1;
+    }
+    
+    FT_Bitmap *glyphBitmap = &ftFace->glyph->bitmap;
+    long left = (long)originX + ftFace->glyph->bitmap_left;
+    long top = (long)height - ((long)originY + ftFace->glyph->bitmap_top);
+    
+    for (unsigned int row=0; row<glyphBitmap->rows; row++) {
+        long dstY = top + (long)row;
+        if (dstY < 0 || dstY >= (long)height)
+            continue;
+        // Rows are stored bottom to top if the pitch is negative
+        const uint8_t *src = glyphBitmap->pitch >= 0 ?
+            glyphBitmap->buffer + (long)row * glyphBitmap->pitch :
+            glyphBitmap->buffer + (long)(glyphBitmap->rows - 1 - row) * -glyphBitmap->pitch;
+        uint8_t *dst = bitmap + dstY * rowBytes;
+        for (unsigned int col=0; col<glyphBitmap->width; col++) {
+            long dstX = left + (long)col;
+            if (dstX < 0 || dstX >= (long)width)
+                continue;
+            uint8_t *pixel = dst + dstX * depth;
+            for (unsigned int k=0; k<depth; k++) {
+                if (src[col] > pixel[k])
+                    pixel[k] = src[col];
+            }
+        }
+    }
+    pthread_mutex_unlock(&face->mutex);
+    
+    return 0;
+}
+
+static const icTextBackend s_freeTypeBackend = {
+    "FreeType",
+    icFTCreateFaceWithFile,
+    icFTReleaseFace,
+    icFTGetFaceMetrics,
+    icFTShape,
+    icFTGetGlyphBounds,
+    icFTRasterizeGlyph
+};
+
+const icTextBackend *icTextBackendFreeType(void)
+{
+    return &s_freeTypeBackend;
+}
+
+#endif // IC_ENABLE_FREETYPE_TEXT_BACKEND
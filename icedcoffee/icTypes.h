@@ -89,6 +89,17 @@ typedef enum _ICShaderValueType {
     ICShaderValueTypeSampler2D
 } ICShaderValueType;
 
+/**
+ @brief An integer handle identifying a uniform of a linked ICShaderProgram
+ 
+ Uniform handles are resolved when a program is linked and remain valid until the program
+ is linked again. See ICShaderProgram::uniformHandleForName:.
+ */
+typedef GLint ICShaderUniformHandle;
+
+/** @brief Returned by ICShaderProgram::uniformHandleForName: for unknown uniforms */
+#define ICShaderUniformHandleInvalid -1
+
 typedef enum _ICFrameUpdateMode {
     ICFrameUpdateModeSynchronized = 0,
     ICFrameUpdateModeOnDemand = 1
@@ -221,6 +232,13 @@ typedef struct _icV3F_C4F_T2F_G1F {
     GLfloat gamma;
 } icV3F_C4F_T2F_G1F;
 
+// Compact vertex used for font glyph rendering; color and gamma are passed to the glyph shader
+// as uniforms, texture coordinates are normalized unsigned shorts
+typedef struct _icV2F_T2US {
+    kmVec2 vect;                // 8 bytes
+    GLushort texCoords[2];      // 4 bytes
+} icV2F_T2US;
+
 typedef struct _icV3F_C4B_T2F_Quad {
     icV3F_C4B_T2F vertices[4];
 } icV3F_C4B_T2F_Quad;
@@ -233,6 +251,10 @@ typedef struct _icV3F_C4F_T2F_G1F_Quad {
     icV3F_C4F_T2F_G1F vertices[4];
 } icV3F_C4F_T2F_G1F_Quad;
 
+typedef struct _icV2F_T2US_Quad {
+    icV2F_T2US vertices[4];
+} icV2F_T2US_Quad;
+
 typedef struct _icUShort_QuadIndices {
     GLushort indices[6];
 } icUShort_QuadIndices;
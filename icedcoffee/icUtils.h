@@ -104,6 +104,23 @@ extern "C" {
                    kmMat4 *matProjection,
                    kmMat4 *matModelView);
     
+    /**
+     @brief Projects the corners of the given box using the given model-view-projection matrix
+     
+     @param mvp A pointer to a ``kmMat4`` defining the model-view-projection matrix
+     @param box A pointer to a ``kmAABB`` defining the box to project
+     @param outcode A pointer to a ``uint`` receiving a bit mask of the clip planes all corners
+     of the box are outside of, in the order -x, +x, -y, +y, -z, +z
+     @param ndcMin A pointer to a ``kmVec2`` receiving the minimum of the projected corners in
+     normalized device coordinates
+     @param ndcMax A pointer to a ``kmVec2`` receiving the maximum of the projected corners in
+     normalized device coordinates
+     
+     @return Returns ``NO`` if corners lie behind the camera, in which case the bounds returned in
+     ``ndcMin`` and ``ndcMax`` do not cover the whole box.
+     */
+    BOOL icProjectAABB(const kmMat4 *mvp, const kmAABB *box, uint *outcode, kmVec2 *ndcMin, kmVec2 *ndcMax);
+    
     /**
      @brief Computes an axis-aligned bounding box for the given vertices
      
@@ -142,6 +142,37 @@ BOOL icProject(kmVec3 *worldVect,
     return 1;
 }
 
+BOOL icProjectAABB(const kmMat4 *mvp, const kmAABB *box, uint *outcode, kmVec2 *ndcMin, kmVec2 *ndcMax)
+{
+    BOOL inFront = YES;
+    uint code = 0x3F;
+    kmVec2Fill(ndcMin, FLT_MAX, FLT_MAX);
+    kmVec2Fill(ndcMax, -FLT_MAX, -FLT_MAX);
+    
+    for (int i=0; i<8; i++) {
+        kmVec4 corner, c;
+        kmVec4Fill(&corner,
+                   i & 1 ? box->max.x : box->min.x,
+                   i & 2 ? box->max.y : box->min.y,
+                   i & 4 ? box->max.z : box->min.z,
+                   1);
+        kmVec4Transform(&c, &corner, mvp);
+        code &= (c.x < -c.w) | (c.x > c.w) << 1 | (c.y < -c.w) << 2 |
+                (c.y > c.w) << 3 | (c.z < -c.w) << 4 | (c.z > c.w) << 5;
+        if (c.w <= kmEpsilon) {
+            inFront = NO;
+        } else {
+            ndcMin->x = MIN(ndcMin->x, c.x / c.w);
+            ndcMin->y = MIN(ndcMin->y, c.y / c.w);
+            ndcMax->x = MAX(ndcMax->x, c.x / c.w);
+            ndcMax->y = MAX(ndcMax->y, c.y / c.w);
+        }
+    }
+    
+    *outcode = code;
+    return inFront;
+}
+
 kmAABB icComputeAABBFromVertices(kmVec3 *vertices, int count)
 {
     int i, j;
@@ -38,6 +38,8 @@
 #import "ICTestHostViewController.h"
 #import "ICNode.h"
 #import "ICNodeVisitorDrawing.h"
+#import "ICRenderCommandBuffer.h"
+#import "ICProfiler.h"
 #import "ICButton.h"
 #import "ICLabel.h"
 #import "ICTextField.h"
@@ -55,6 +57,7 @@
 #import "ICScheduler.h"
 #import "ICTableView.h"
 #import "ICTableViewCell.h"
+#import "ICTableViewDelegate.h"
 #import "ICTexture2D.h"
 #import "ICMutableTexture2D.h"
 #import "ICTextureCache.h"
@@ -63,11 +66,14 @@
 #import "ICScrollView.h"
 #import "icTypes.h"
 #import "ICBasicAnimation.h"
+#import "ICSpringTimingFunction.h"
+#import "ICKeyframeTimingFunction.h"
 #import "ICCombinedVertexIndexBuffer.h"
 
 // Font rendering
 #import "ICFont.h"
 #import "ICGlyphCache.h"
+#import "ICTextLayoutCache.h"
 #import "ICGlyphTextureAtlas.h"
 #import "ICTextureGlyph.h"
 #import "ICGlyphRun.h"
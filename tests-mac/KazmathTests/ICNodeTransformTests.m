@@ -0,0 +1,92 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import "ICNodeTransformTests.h"
+#import "icedcoffee/icedcoffee.h"
+
+@implementation ICNodeTransformTests
+
+- (void)assertVector:(kmVec3)v equalsX:(float)x y:(float)y z:(float)z
+{
+    STAssertEqualsWithAccuracy(v.x, x, 0.0001f, @"Unexpected x coordinate");
+    STAssertEqualsWithAccuracy(v.y, y, 0.0001f, @"Unexpected y coordinate");
+    STAssertEqualsWithAccuracy(v.z, z, 0.0001f, @"Unexpected z coordinate");
+}
+
+- (void)testSceneTransformChangesPropagateToChildren
+{
+    ICScene *scene = [ICScene scene];
+    ICNode *child = [[[ICNode alloc] init] autorelease];
+    [child setPosition:kmVec3Make(10, 20, 0)];
+    [scene addChild:child];
+    
+    kmVec3 origin = kmVec3Make(0, 0, 0);
+    [self assertVector:[child convertToWorldSpace:origin] equalsX:10 y:20 z:0];
+    
+    // Move the scene twice without picking or otherwise updating the scene's spatial index
+    // in between; each move must invalidate the child's cached world transform
+    [scene setPosition:kmVec3Make(100, 0, 0)];
+    [self assertVector:[child convertToWorldSpace:origin] equalsX:110 y:20 z:0];
+    
+    [scene setPosition:kmVec3Make(200, 50, 0)];
+    [self assertVector:[child convertToWorldSpace:origin] equalsX:210 y:70 z:0];
+    
+    kmVec3 local = [child convertToNodeSpace:kmVec3Make(210, 70, 0)];
+    [self assertVector:local equalsX:0 y:0 z:0];
+}
+
+- (void)testNestedNodeWorldTransform
+{
+    ICScene *scene = [ICScene scene];
+    ICNode *parent = [[[ICNode alloc] init] autorelease];
+    ICNode *child = [[[ICNode alloc] init] autorelease];
+    [parent addChild:child];
+    [scene addChild:parent];
+    
+    [parent setPosition:kmVec3Make(5, 5, 0)];
+    [child setPosition:kmVec3Make(1, 2, 3)];
+    [self assertVector:[child convertToWorldSpace:kmVec3Make(0, 0, 0)] equalsX:6 y:7 z:3];
+    
+    [scene setPosition:kmVec3Make(-5, 0, 0)];
+    [self assertVector:[child convertToWorldSpace:kmVec3Make(0, 0, 0)] equalsX:1 y:7 z:3];
+}
+
+- (void)testSingularTransformInverse
+{
+    ICScene *scene = [ICScene scene];
+    ICNode *node = [[[ICNode alloc] init] autorelease];
+    [scene addChild:node];
+    [node setPosition:kmVec3Make(10, 0, 0)];
+    
+    // A scale of zero cannot be inverted, so the inverse transforms fall back to identity
+    [node setScale:kmVec3Make(0, 0, 0)];
+    [self assertVector:[node convertToNodeSpace:kmVec3Make(3, 4, 5)] equalsX:3 y:4 z:5];
+    kmMat4 parentToNode = [node parentToNodeTransform];
+    STAssertTrue(kmMat4IsIdentity(&parentToNode), @"Expected identity for singular transform");
+    
+    // The inverse world transform must be recomputed once the transform is invertible again
+    [node setScale:kmVec3Make(1, 1, 1)];
+    [self assertVector:[node convertToNodeSpace:kmVec3Make(10, 0, 0)] equalsX:0 y:0 z:0];
+}
+
+@end
@@ -0,0 +1,176 @@
+//  
+//  Copyright (C) 2016 Tobias Lensing, Marcus Tillmanns
+//  http://icedcoffee-framework.org
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of
+//  this software and associated documentation files (the "Software"), to deal in
+//  the Software without restriction, including without limitation the rights to
+//  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+//  of the Software, and to permit persons to whom the Software is furnished to do
+//  so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//  
+
+#import "AppDelegate.h"
+
+// Measures the cost of processing animations and scheduling updates for a large number of nodes.
+// Results are logged to the console once kBenchmarkFrames frames have been drawn.
+
+#define kNumberOfNodes 10000
+#define kBenchmarkFrames 300
+
+@interface BenchmarkTarget : NSObject <ICUpdatable> {
+@public
+    NSUInteger _updateCount;
+}
+@end
+
+@implementation BenchmarkTarget
+
+- (void)update:(icTime)dt
+{
+    _updateCount++;
+}
+
+@end
+
+
+@implementation AppDelegate
+
+@synthesize window = _window;
+@synthesize hostViewController = _hostViewController;
+
+- (id)init
+{
+    if ((self = [super init])) {
+        _nodes = [[NSMutableArray alloc] initWithCapacity:kNumberOfNodes];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_nodes release];
+    self.hostViewController = nil;
+    
+    [super dealloc];
+}
+
+- (void)benchmarkScheduling
+{
+    ICScheduler *scheduler = self.hostViewController.scheduler;
+    NSMutableArray *targets = [NSMutableArray arrayWithCapacity:kNumberOfNodes];
+    for (NSUInteger i=0; i<kNumberOfNodes; i++) {
+        [targets addObject:[[[BenchmarkTarget alloc] init] autorelease]];
+    }
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSUInteger i = 0;
+    for (BenchmarkTarget *target in targets) {
+        [scheduler scheduleUpdateForTarget:target withPriority:(ICSchedulerPriority)(i++ % 3)];
+    }
+    CFAbsoluteTime scheduled = CFAbsoluteTimeGetCurrent();
+    [scheduler update:1.0/60.0];
+    CFAbsoluteTime updated = CFAbsoluteTimeGetCurrent();
+    // Unschedule in random order to defeat any benefit from unscheduling the list heads first
+    for (i=[targets count]; i>1; i--) {
+        [targets exchangeObjectAtIndex:i-1 withObjectAtIndex:arc4random_uniform((uint32_t)i)];
+    }
+    for (BenchmarkTarget *target in targets) {
+        [scheduler unscheduleUpdateForTarget:target];
+    }
+    CFAbsoluteTime unscheduled = CFAbsoluteTimeGetCurrent();
+    
+    NSLog(@"Scheduling %d targets: %.3f ms", kNumberOfNodes, (scheduled - start) * 1000);
+    NSLog(@"Updating %d targets (including animations): %.3f ms", kNumberOfNodes,
+          (updated - scheduled) * 1000);
+    NSLog(@"Unscheduling %d targets: %.3f ms", kNumberOfNodes, (unscheduled - updated) * 1000);
+}
+
+- (void)benchmarkRemovingAnimations
+{
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (ICNode *node in _nodes) {
+        [node removeAllAnimations];
+    }
+    NSLog(@"Removing %d animations: %.3f ms", kNumberOfNodes,
+          (CFAbsoluteTimeGetCurrent() - start) * 1000);
+}
+
+- (void)update:(icTime)dt
+{
+    if (++_frameCount < kBenchmarkFrames)
+        return;
+    
+    icProfilerFrame average = [self.hostViewController.profiler averageFrame];
+    NSLog(@"Average over %d frames with %d animated nodes:", kBenchmarkFrames, kNumberOfNodes);
+    NSLog(@"  Process animations: %.3f ms",
+          average.cpuTimes[ICProfilerCategoryAnimations] * 1000);
+    NSLog(@"  Update targets: %.3f ms",
+          average.cpuTimes[ICProfilerCategorySchedulerUpdate] * 1000);
+    NSLog(@"  Frame: %.3f ms", average.cpuTimes[ICProfilerCategoryFrame] * 1000);
+    
+    // The scheduler must not be updated from within its own update
+    [self.hostViewController.scheduler unscheduleUpdateForTarget:self];
+    [self performSelector:@selector(runBenchmarks) withObject:nil afterDelay:0];
+}
+
+- (void)runBenchmarks
+{
+    [self benchmarkScheduling];
+    [self benchmarkRemovingAnimations];
+}
+
+- (void)setUpScene
+{
+    ICScene *scene = [ICScene scene];
+    [self.hostViewController runWithScene:scene];
+    
+    CGSize size = NSSizeToCGSize([self.window.contentView bounds].size);
+    for (NSUInteger i=0; i<kNumberOfNodes; i++) {
+        ICSprite *node = [ICSprite sprite];
+        [node setSize:kmVec3Make(2, 2, 0)];
+        [scene addChild:node];
+        [_nodes addObject:node];
+        
+        kmVec3 from = kmVec3Make(arc4random_uniform((uint32_t)size.width),
+                                 arc4random_uniform((uint32_t)size.height), 0);
+        kmVec3 to = kmVec3Make(arc4random_uniform((uint32_t)size.width),
+                               arc4random_uniform((uint32_t)size.height), 0);
+        ICBasicAnimation *animation = [ICBasicAnimation animationWithKeyPath:@"position"];
+        animation.fromValue = [NSValue valueWithBytes:&from objCType:@encode(kmVec3)];
+        animation.toValue = [NSValue valueWithBytes:&to objCType:@encode(kmVec3)];
+        // Long enough for the animations to keep running until the benchmark is done
+        animation.duration = 3600;
+        [node addAnimation:animation];
+    }
+    
+    [self.hostViewController.scheduler scheduleUpdateForTarget:self];
+}
+
+- (void)applicationDidFinishLaunching:(NSNotification *)aNotification
+{
+    self.hostViewController = [ICHostViewController platformSpecificHostViewController];
+    self.hostViewController.profiler.enabled = YES;
+    
+    ICGLView *glView = [[ICGLView alloc] initWithFrame:self.window.frame
+                                          shareContext:nil
+                                    hostViewController:self.hostViewController];
+    
+    self.window.contentView = glView;
+    [self.window makeFirstResponder:self.window.contentView];
+    
+    [self setUpScene];
+}
+
+@end
@@ -25,6 +25,7 @@
 #import "icedcoffee/ICShaderProgram.h"
 #import "icedcoffee/ICShaderCache.h"
 #import "icedcoffee/icMacros.h"
+#import "icedcoffee/icGLState.h"
 
 
 NSString *__stencilMaskFSH = IC_SHADER_STRING
@@ -77,24 +78,24 @@ NSString *__stencilMaskFSH = IC_SHADER_STRING
 
 - (void)drawWithVisitor:(ICNodeVisitor *)visitor
 {
-    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-    glDepthMask(GL_FALSE);
-    glEnable(GL_STENCIL_TEST);
+    icGLColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    icGLDepthMask(GL_FALSE);
+    icGLEnable(IC_GL_STENCIL_TEST);
     
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    glStencilFunc(GL_ALWAYS, 1, 1);
+    icGLStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    icGLStencilFunc(GL_ALWAYS, 1, 1);
 
     // Draw mask into stencil buffer
     [super drawWithVisitor:visitor];
     
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glDepthMask(GL_TRUE);
-    glStencilFunc(GL_EQUAL, 1, 1);
+    icGLColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    icGLDepthMask(GL_TRUE);
+    icGLStencilFunc(GL_EQUAL, 1, 1);
 }
 
 - (void)childrenDidDrawWithVisitor:(ICNodeVisitor *)visitor
 {
-    glDisable(GL_STENCIL_TEST);
+    icGLDisable(IC_GL_STENCIL_TEST);
 }
 
 @end